@@ -0,0 +1,54 @@
+//
+//  ConsoleLog.cpp
+//  FieldViewer
+//
+//  The log functions for the command line tools. See ConsoleLog.h.
+//
+//  Created by Brian Collett on 10/19/26.
+//  Copyright (c) 2026 Brian Collett. All rights reserved.
+//
+#include <stdio.h>
+#include <stdarg.h>
+#include "FieldViewerApp.h"
+#include "ConsoleLog.h"
+
+static bool sQuiet = false;
+
+void SetConsoleQuiet(bool quiet)
+{
+  sQuiet = quiet;
+}
+bool IsConsoleQuiet(void)
+{
+  return sQuiet;
+}
+int oprintf(const char* format, ...) { // printf, black
+  if (sQuiet) return 0;
+  va_list args;
+  va_start (args, format);
+  int retCode = vfprintf(stdout, format, args);
+  va_end(args);
+  return retCode;
+}
+int iprintf(const char* format, ...) { // printf, blue
+  if (sQuiet) return 0;
+  va_list args;
+  va_start (args, format);
+  int retCode = vfprintf(stdout, format, args);
+  va_end(args);
+  return retCode;
+}
+int eprintf(const char* format, ...) { // fprintf(stderr, red
+  va_list args;
+  va_start (args, format);
+  int retCode = vfprintf(stderr, format, args);
+  va_end(args);
+  return retCode;
+}
+int wprintf(const char* format, ...) { // fprintf(stderr, green
+  va_list args;
+  va_start (args, format);
+  int retCode = vfprintf(stderr, format, args);
+  va_end(args);
+  return retCode;
+}
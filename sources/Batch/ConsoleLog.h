@@ -0,0 +1,21 @@
+//
+//  ConsoleLog.h
+//  FieldViewer
+//
+//  The library code logs through oprintf, iprintf, eprintf and wprintf
+//  (see FieldViewerApp.h). In the viewer they go to the log pane; the
+//  command line tools link ConsoleLog instead, which sends them to the
+//  terminal. Quiet turns off oprintf and iprintf, the progress
+//  messages. Errors and warnings always go to stderr.
+//
+//  Created by Brian Collett on 10/19/26.
+//  Copyright (c) 2026 Brian Collett. All rights reserved.
+//
+
+#ifndef __FieldViewer__ConsoleLog__
+#define __FieldViewer__ConsoleLog__
+
+void SetConsoleQuiet(bool quiet);
+bool IsConsoleQuiet(void);
+
+#endif /* defined(__FieldViewer__ConsoleLog__) */
@@ -0,0 +1,308 @@
+/*
+ *  FieldBatch.cpp
+ *  FieldViewer
+ *
+ *  FieldBatch is the command line slice renderer. It reads one or more
+ *  job files (see SliceJob.h), loads the model and field that each one
+ *  names and writes every slice in it as an image, plus raw float and
+ *  CSV arrays if asked. The planes are found, sampled and coloured by
+ *  FieldSlice, exactly as the viewer does it, but the colours are
+ *  worked out on the CPU and go straight into the file so there is no
+ *  window, no OpenGL context and no need for a display.
+ *
+ *  Usage: FieldBatch [-q] job ...
+ *
+ *  Each job also writes <output>slices.csv with one line per slice
+ *  giving its size, range and corners so that the raw arrays can be
+ *  put back in space. The exit status is the number of jobs that had
+ *  any failure.
+ *
+ *  Created by Brian Collett on 10/19/26.
+ *
+ */
+#include "wx/init.h"
+#include "wx/log.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <vector>
+
+#include "FieldViewerApp.h"
+#include "ConsoleLog.h"
+#include "GLAList.h"
+#include "GLACache.h"
+#include "CD3DField.h"
+#include "AnalyticField.h"
+#include "GridField.h"
+#include "ReadField.h"
+#include "FieldSlice.h"
+#include "ImageWriter.h"
+#include "SliceJob.h"
+//
+//  LoadField reads the model, if there is one, and then the field,
+//  either from the end of the model file or from a binary field or
+//  grid file.
+//  The model itself is not drawn but reading it checks it and gets us
+//  to the fields that follow its end line. An analytic field needs no
+//  files at all.
+//
+static EField* LoadField(const SliceJob& job)
+{
+  if (!job.mAnalytic.empty()) {
+    return AnalyticField::Make(job.mAnalytic.c_str(), job.mCost);
+  }
+  CD3Data* fData = new CD3Data();
+  bool ok = false;
+  if (!job.mModel.empty()) {
+    FILE* ifp = fopen(job.mModel.c_str(), "rt");
+    if (nullptr == ifp) {
+      eprintf("%s: unable to open model.\n", job.mModel.c_str());
+      delete fData;
+      return nullptr;
+    }
+    CGLAList list;
+    int64_t stamp[3];
+    GLACache::Stamp(ifp, stamp);
+    if (!GLACache::Load(&list, job.mModel.c_str(), ifp)) {
+      CTextScanner scan(ifp);
+      list.InstallScanner(&scan);
+      list.Create();
+      GLACache::Save(&list, job.mModel.c_str(), stamp, ifp);
+    }
+    iprintf("%s: %d primitives.\n", job.mModel.c_str(), list.GetNPrim());
+    if (job.mField.empty()) {
+      ok = ParseFieldSet(fData, ifp);
+      if (!ok) {
+        eprintf("%s: no fields after the model.\n", job.mModel.c_str());
+      }
+    }
+    fclose(ifp);
+  }
+  if (!job.mField.empty()) {
+    if (GridFile::IsGridFile(job.mField.c_str())) {
+      delete fData;
+      GridField* g = GridField::Read(job.mField.c_str());
+      if ((nullptr != g) && g->IsPacked()) {
+        g->Report();
+      }
+      return g;
+    }
+    FILE* ifp = fopen(job.mField.c_str(), "rb");
+    if (nullptr == ifp) {
+      eprintf("%s: unable to open field.\n", job.mField.c_str());
+      delete fData;
+      return nullptr;
+    }
+    ok = CD3ReadBinary(fData, ifp);
+    fclose(ifp);
+    if (!ok) {
+      eprintf("%s: CD3ReadBinary failed.\n", job.mField.c_str());
+    }
+  }
+  if (!ok) {
+    delete fData;
+    return nullptr;
+  }
+  return new CD3DField(fData);
+}
+//
+//  Raw arrays go out top row first like the image. The .f32 file is
+//  bare native floats, nAcross by nDown, NaN outside the field.
+//
+static bool WriteRaw(const std::string& path, const std::vector<double>& data,
+                     int nAcross, int nDown)
+{
+  FILE* ofp = fopen(path.c_str(), "wb");
+  if (nullptr == ofp) {
+    return false;
+  }
+  std::vector<float> row(nAcross);
+  for (int j = nDown - 1; j >= 0; j--) {
+    for (int i = 0; i < nAcross; i++) {
+      row[i] = (float) data[j * nAcross + i];
+    }
+    fwrite(&row[0], sizeof(float), nAcross, ofp);
+  }
+  bool ok = (ferror(ofp) == 0);
+  return (fclose(ofp) == 0) && ok;
+}
+static bool WriteCSV(const std::string& path, const std::vector<double>& data,
+                     const std::vector<Point3D>& pts, const char* comp)
+{
+  FILE* ofp = fopen(path.c_str(), "wt");
+  if (nullptr == ofp) {
+    return false;
+  }
+  fprintf(ofp, "x,y,z,%s\n", comp);
+  for (int i = 0; i < (int) data.size(); i++) {
+    const Point3D& p = pts[i];
+    if (isnan(data[i])) {
+      fprintf(ofp, "%.9g,%.9g,%.9g,\n", p.mX, p.mY, p.mZ);
+    } else {
+      fprintf(ofp, "%.9g,%.9g,%.9g,%.9g\n", p.mX, p.mY, p.mZ, data[i]);
+    }
+  }
+  bool ok = (ferror(ofp) == 0);
+  return (fclose(ofp) == 0) && ok;
+}
+//
+//  Render one slice. Returns false if any of its files failed.
+//
+static bool RenderSlice(EField* f, const SliceJob& job,
+                        const SliceSpec& s, FILE* index)
+{
+  FrameRect3D* frame = nullptr;
+  int err;
+  if (s.mZPlane) {
+    err = FieldSlice::PZPlaneFrame(f, s.mPoint, s.mTheta, s.mZMin, s.mZMax,
+                                   &frame);
+  } else {
+    err = FieldSlice::PlaneFrame(f, s.mPoint, s.mNormal, &frame);
+  }
+  if (err != 0) {
+    eprintf("%s: %s.\n", s.mName.c_str(), (err > 0) ?
+            "the plane must contain an axis" : "the plane misses the field");
+    return false;
+  }
+  if (!frame->IsValid() || (frame->GetWidth() <= 0.0)) {
+    eprintf("%s: the plane cuts the field in a line.\n", s.mName.c_str());
+    delete frame;
+    return false;
+  }
+  int nAcross = s.mSize;
+  int nDown = (int) floor(nAcross * frame->GetHeight() / frame->GetWidth()
+                          + 0.5);
+  if (nDown < 1) {
+    nDown = 1;
+  }
+  int n = nAcross * nDown;
+  std::vector<double> data(n);
+  std::vector<Point3D> pts;
+  if (job.mCSV) {
+    pts.resize(n);
+  }
+  double fMin, fMax;
+  FieldSlice::Sample(f, frame, s.mComponent, nAcross, nDown, &data[0],
+                     job.mCSV ? &pts[0] : nullptr, &fMin, &fMax);
+  if (fMin > fMax) {
+    eprintf("%s: no samples inside the field.\n", s.mName.c_str());
+    delete frame;
+    return false;
+  }
+  if (s.mFixRange) {
+    fMin = s.mVMin;
+    fMax = s.mVMax;
+  }
+  FieldMapper* fm = FieldSlice::NewFieldMapper(s.mLinear, fMin, fMax);
+  ColorMapper* cm = FieldSlice::NewColorMapper(s.mColours);
+  std::vector<unsigned char> rgb(3 * n);
+  FieldSlice::Colour(&data[0], n, fm, cm, &rgb[0]);
+  delete fm;
+  delete cm;
+  bool ok = true;
+  std::string base = job.mOutput + s.mName;
+  static const char* sExt[3] = { ".png", ".ppm", ".tif" };
+  std::string image = base + sExt[job.mFormat];
+  if (!ImageWriter::Write(image.c_str(), nAcross, nDown, &rgb[0],
+                          job.mFormat)) {
+    eprintf("%s: unable to write.\n", image.c_str());
+    ok = false;
+  }
+  if (job.mRaw && !WriteRaw(base + ".f32", data, nAcross, nDown)) {
+    eprintf("%s.f32: unable to write.\n", base.c_str());
+    ok = false;
+  }
+  if (job.mCSV && !WriteCSV(base + ".csv", data, pts,
+                            SliceJob::ComponentName(s.mComponent))) {
+    eprintf("%s.csv: unable to write.\n", base.c_str());
+    ok = false;
+  }
+  if (nullptr != index) {
+    fprintf(index, "%s,%s,%s,%s,%d,%d,%.9g,%.9g", s.mName.c_str(),
+            SliceJob::ComponentName(s.mComponent),
+            SliceJob::ColoursName(s.mColours), s.mLinear ? "linear" : "log",
+            nAcross, nDown, fMin, fMax);
+    const Point3D* c[4] = { &frame->TopLeft(), &frame->TopRight(),
+                            &frame->BottomRight(), &frame->BottomLeft() };
+    for (int k = 0; k < 4; k++) {
+      fprintf(index, ",%.9g,%.9g,%.9g", c[k]->mX, c[k]->mY, c[k]->mZ);
+    }
+    fprintf(index, "\n");
+  }
+  iprintf("%s: %s %d x %d, %g to %g\n", s.mName.c_str(),
+          SliceJob::ComponentName(s.mComponent), nAcross, nDown, fMin, fMax);
+  delete frame;
+  return ok;
+}
+//
+//  Run one job file. Returns false if anything at all failed.
+//
+static bool RunJob(const char* path)
+{
+  SliceJob job;
+  if (!job.Read(path)) {
+    return false;
+  }
+  EField* f = LoadField(job);
+  if (nullptr == f) {
+    return false;
+  }
+  std::string indexName = job.mOutput + "slices.csv";
+  FILE* index = fopen(indexName.c_str(), "wt");
+  if (nullptr == index) {
+    eprintf("%s: unable to write.\n", indexName.c_str());
+  } else {
+    fprintf(index, "name,component,colours,map,width,height,vmin,vmax,"
+            "tlx,tly,tlz,trx,try,trz,brx,bry,brz,blx,bly,blz\n");
+  }
+  bool ok = (nullptr != index);
+  for (size_t i = 0; i < job.mSlices.size(); i++) {
+    if (!RenderSlice(f, job, job.mSlices[i], index)) {
+      ok = false;
+    }
+  }
+  if (nullptr != index) {
+    fclose(index);
+  }
+  delete f;
+  return ok;
+}
+
+int main(int argc, char** argv)
+{
+  //
+  //  The geometry classes log through wx so it needs starting, but only
+  //  the base library; nothing here touches the GUI.
+  //
+  wxInitializer wxInit;
+  if (!wxInit.IsOk()) {
+    fprintf(stderr, "FieldBatch: unable to initialise wx.\n");
+    return -1;
+  }
+  int first = 1;
+  if ((argc > 1) && (strcmp(argv[1], "-q") == 0)) {
+    SetConsoleQuiet(true);
+    first = 2;
+  }
+  if (first >= argc) {
+    fprintf(stderr, "Usage: FieldBatch [-q] job ...\n");
+    return -1;
+  }
+  //
+  //  Rect3D and friends chatter through wxLogMessage; keep warnings.
+  //
+  delete wxLog::SetActiveTarget(new wxLogStderr());
+  wxLog::SetLogLevel(wxLOG_Warning);
+  CGLAList::InitClass(20);
+  int nFailed = 0;
+  for (int i = first; i < argc; i++) {
+    if (!RunJob(argv[i])) {
+      eprintf("%s: failed.\n", argv[i]);
+      nFailed++;
+    }
+  }
+  CGLAList::ReleaseClass();
+  return nFailed;
+}
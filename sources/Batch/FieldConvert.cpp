@@ -0,0 +1,241 @@
+/*
+ *  FieldConvert.cpp
+ *  FieldViewer
+ *
+ *  FieldConvert writes a field out as a grid file (see GridFile.h). The
+ *  field can come from the end of a .gla model, from a binary .bin
+ *  field or from another grid file, which is how an existing one gets
+ *  compressed or has grids added.
+ *
+ *  Usage: FieldConvert [-q] [-z] [-p bound] [-s spacing] [-n name]
+ *           [-g name priority spacing xmin ymin zmin xmax ymax zmax] ...
+ *           input output
+ *
+ *  The field is sampled at the nodes of each grid. The outer grid
+ *  covers the whole field, spacing -s apart, which is 1/200 of its
+ *  longest side unless said otherwise, and takes its name from -n or
+ *  the field. Each -g adds a grid of its own, usually a finer one round
+ *  some detail with a higher priority than the outer grid's 0. A grid
+ *  file given no -s or -g is copied as it is. -z deflates the node
+ *  data.
+ *
+ *  -p says how well the grids would pack in memory in the viewer, see
+ *  BrickStore.h, with an error bound or "lossless". It only reports;
+ *  the file always has the values as sampled.
+ *
+ *  Created by Brian Collett on 10/19/26.
+ *
+ */
+#include "wx/init.h"
+#include "wx/log.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <vector>
+
+#include "FieldViewerApp.h"
+#include "ConsoleLog.h"
+#include "GLAList.h"
+#include "GLACache.h"
+#include "CD3DField.h"
+#include "GridField.h"
+#include "ReadField.h"
+//
+//  The outer grid's spacing when -s is not given, as a fraction of the
+//  longest side of the field.
+//
+const int kFCDefaultSteps = 200;
+//
+//  LoadField reads whichever kind of file path is. A model is read, or
+//  fetched from its cache, only to get to the fields after its end
+//  line.
+//
+static EField* LoadField(const char* path)
+{
+  if (GridFile::IsGridFile(path)) {
+    return GridField::Read(path);
+  }
+  size_t len = strlen(path);
+  bool binary = (len > 4) && (strcmp(path + len - 4, ".bin") == 0);
+  FILE* ifp = fopen(path, binary ? "rb" : "rt");
+  if (nullptr == ifp) {
+    eprintf("%s: unable to open.\n", path);
+    return nullptr;
+  }
+  CD3Data* fData = new CD3Data();
+  bool ok;
+  if (binary) {
+    ok = CD3ReadBinary(fData, ifp);
+  } else {
+    CGLAList list;
+    int64_t stamp[3];
+    GLACache::Stamp(ifp, stamp);
+    if (!GLACache::Load(&list, path, ifp)) {
+      CTextScanner scan(ifp);
+      list.InstallScanner(&scan);
+      list.Create();
+      GLACache::Save(&list, path, stamp, ifp);
+    }
+    ok = ParseFieldSet(fData, ifp);
+  }
+  fclose(ifp);
+  if (!ok) {
+    eprintf("%s: no field in it.\n", path);
+    delete fData;
+    return nullptr;
+  }
+  return new CD3DField(fData);
+}
+//
+//  A -g grid as it was given.
+//
+struct ExtraGrid {
+  std::string mName;
+  int mPriority;
+  double mSpacing;
+  double mMin[3];
+  double mMax[3];
+};
+//
+//  Sample src on spec and add the result to out.
+//
+static bool AddGrid(EField* src, GridSpec& spec, const char* name,
+                    int priority, GridField* out)
+{
+  strncpy(spec.mName, name, kGFNameLength - 1);
+  spec.mName[kGFNameLength - 1] = 0;
+  spec.mPriority = priority;
+  std::vector<double> data;
+  GridField::Sample(src, spec, data);
+  iprintf("%s: %u x %u x %u nodes, spacing %g %g %g, priority %d\n",
+          spec.mName, spec.mN[0], spec.mN[1], spec.mN[2], spec.mDelta[0],
+          spec.mDelta[1], spec.mDelta[2], spec.mPriority);
+  return out->AddGrid(spec, data);
+}
+
+int main(int argc, char** argv)
+{
+  //
+  //  The geometry classes log through wx so it needs starting, but only
+  //  the base library; nothing here touches the GUI.
+  //
+  wxInitializer wxInit;
+  if (!wxInit.IsOk()) {
+    fprintf(stderr, "FieldConvert: unable to initialise wx.\n");
+    return -1;
+  }
+  bool compress = false;
+  double pack = -1.0;
+  double spacing = 0.0;
+  const char* name = nullptr;
+  std::vector<ExtraGrid> extras;
+  int i = 1;
+  bool ok = true;
+  for (; ok && (i < argc) && (argv[i][0] == '-'); i++) {
+    if (strcmp(argv[i], "-q") == 0) {
+      SetConsoleQuiet(true);
+    } else if (strcmp(argv[i], "-z") == 0) {
+      compress = true;
+    } else if ((strcmp(argv[i], "-p") == 0) && (i + 1 < argc)) {
+      i++;
+      pack = (strcmp(argv[i], "lossless") == 0) ? 0.0 : atof(argv[i]);
+      ok = (pack >= 0.0);
+    } else if ((strcmp(argv[i], "-s") == 0) && (i + 1 < argc)) {
+      spacing = atof(argv[++i]);
+      ok = (spacing > 0.0);
+    } else if ((strcmp(argv[i], "-n") == 0) && (i + 1 < argc)) {
+      name = argv[++i];
+    } else if ((strcmp(argv[i], "-g") == 0) && (i + 9 < argc)) {
+      ExtraGrid g;
+      g.mName = argv[i + 1];
+      g.mPriority = atoi(argv[i + 2]);
+      g.mSpacing = atof(argv[i + 3]);
+      for (int k = 0; k < 3; k++) {
+        g.mMin[k] = atof(argv[i + 4 + k]);
+        g.mMax[k] = atof(argv[i + 7 + k]);
+      }
+      extras.push_back(g);
+      i += 9;
+    } else {
+      ok = false;
+    }
+  }
+  if (!ok || (i + 2 != argc)) {
+    fprintf(stderr, "Usage: FieldConvert [-q] [-z] [-p bound] [-s spacing] "
+                    "[-n name]\n"
+                    "         [-g name priority spacing xmin ymin zmin "
+                    "xmax ymax zmax] input output\n");
+    return -1;
+  }
+  const char* input = argv[i];
+  const char* output = argv[i + 1];
+  //
+  //  Rect3D and friends chatter through wxLogMessage; keep warnings.
+  //
+  delete wxLog::SetActiveTarget(new wxLogStderr());
+  wxLog::SetLogLevel(wxLOG_Warning);
+  CGLAList::InitClass(20);
+  GridField::SetPacking(-1.0);          // we want the values as they are
+  EField* src = LoadField(input);
+  if (nullptr == src) {
+    CGLAList::ReleaseClass();
+    return 1;
+  }
+  GridField* grids = dynamic_cast<GridField*>(src);
+  if ((nullptr == grids) || (spacing > 0.0) || !extras.empty()) {
+    grids = new GridField();
+    const Real* min = src->GetBounds()->GetMin().mCoords;
+    const Real* max = src->GetBounds()->GetMax().mCoords;
+    if (spacing <= 0.0) {
+      double side = fmax(max[0] - min[0],
+                         fmax(max[1] - min[1], max[2] - min[2]));
+      spacing = side / kFCDefaultSteps;
+    }
+    double mid[3];
+    for (int k = 0; k < 3; k++) {
+      mid[k] = 0.5 * (min[k] + max[k]);
+    }
+    if (nullptr == name) {
+      name = src->FieldNameAt(Point3D(mid));
+    }
+    GridSpec spec;
+    memset(&spec, 0, sizeof(spec));
+    ok = GridFile::SetSpacing(spec, min, max, spacing) &&
+         AddGrid(src, spec, name, 0, grids);
+    for (size_t g = 0; ok && (g < extras.size()); g++) {
+      memset(&spec, 0, sizeof(spec));
+      ok = GridFile::SetSpacing(spec, extras[g].mMin, extras[g].mMax,
+                                extras[g].mSpacing) &&
+           AddGrid(src, spec, extras[g].mName.c_str(), extras[g].mPriority,
+                   grids);
+      if (!ok) {
+        eprintf("%s: bad bounds or spacing.\n", extras[g].mName.c_str());
+      }
+    }
+  }
+  ok = ok && grids->Write(output, compress, input);
+  //
+  //  Say how big each section came out.
+  //
+  GridFile file;
+  if (ok && file.Open(output)) {
+    for (int g = 0; g < file.GetNGrids(); g++) {
+      const GridSpec& s = file.GetSpec(g);
+      iprintf("%s: %llu bytes stored for %llu, %s\n", s.mName,
+              (unsigned long long) s.mStored, (unsigned long long) s.mSize,
+              (s.mCodec == kGFDeflate) ? "deflated" : "raw");
+    }
+  }
+  if (ok && (pack >= 0.0) && grids->Pack(pack)) {
+    grids->Report();
+  }
+  if (grids != src) {
+    delete grids;
+  }
+  delete src;
+  CGLAList::ReleaseClass();
+  return ok ? 0 : 1;
+}
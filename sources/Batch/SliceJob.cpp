@@ -0,0 +1,232 @@
+//
+//  SliceJob.cpp
+//  FieldViewer
+//
+//  A SliceJob is the contents of a batch job file. See SliceJob.h for
+//  the format.
+//
+//  Created by Brian Collett on 10/19/26.
+//  Copyright (c) 2026 Brian Collett. All rights reserved.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include "SliceJob.h"
+#include "AnalyticField.h"
+//
+//  Names for the components and colour maps, in enum order. The first
+//  name is the one we print; the rest are also accepted.
+//
+static const char* sCompNames[kSliceNComponent][3] = {
+  { "Ex", "x", nullptr },
+  { "Ey", "y", nullptr },
+  { "Ez", "z", nullptr },
+  { "Er", "radial", "r" },
+  { "E", "total", "mag" }
+};
+static const char* sColourNames[3] = { "grey", "heat", "rainbow" };
+static const char* sDelims = " \t\r\n";
+//
+//  ctors
+//
+SliceJob::SliceJob()
+{
+  mFormat = kImagePNG;
+  mRaw = false;
+  mCSV = false;
+  mCost = 0;
+  mCurrent.mZPlane = false;
+  mCurrent.mTheta = mCurrent.mZMin = mCurrent.mZMax = 0.0;
+  mCurrent.mSize = kSJDefaultSize;
+  mCurrent.mComponent = kSliceTotal;
+  mCurrent.mColours = kSliceHeat;
+  mCurrent.mLinear = true;
+  mCurrent.mFixRange = false;
+  mCurrent.mVMin = mCurrent.mVMax = 0.0;
+}
+//
+//  Read the whole file, one line at a time.
+//
+bool SliceJob::Read(const char* path)
+{
+  FILE* ifp = fopen(path, "rt");
+  if (nullptr == ifp) {
+    fprintf(stderr, "%s: unable to open job file.\n", path);
+    return false;
+  }
+  char line[1024];
+  int lineNo = 0;
+  bool ok = true;
+  while (fgets(line, sizeof(line), ifp) != nullptr) {
+    lineNo++;
+    char* hash = strchr(line, '#');
+    if (nullptr != hash) {
+      *hash = '\0';
+    }
+    char copy[sizeof(line)];
+    strcpy(copy, line);
+    if (!ParseLine(line)) {
+      copy[strcspn(copy, "\r\n")] = '\0';
+      fprintf(stderr, "%s:%d: cannot use \"%s\"\n", path, lineNo, copy);
+      ok = false;
+    }
+  }
+  fclose(ifp);
+  if (ok && mSlices.empty()) {
+    fprintf(stderr, "%s: no plane or zplane lines.\n", path);
+    ok = false;
+  }
+  if (ok && mModel.empty() && mField.empty() && mAnalytic.empty()) {
+    fprintf(stderr, "%s: needs a model or a field.\n", path);
+    ok = false;
+  }
+  return ok;
+}
+//
+//  ParseLine handles one directive. It is destructive, strtok chops
+//  the line up as it goes.
+//
+bool SliceJob::ParseLine(char* line)
+{
+  char* word = strtok(line, sDelims);
+  if (nullptr == word) {
+    return true;        // blank or comment
+  }
+  char* args[8];
+  int nArg = 0;
+  char* a;
+  while ((nArg < 8) && ((a = strtok(nullptr, sDelims)) != nullptr)) {
+    args[nArg++] = a;
+  }
+  double v[7];
+  if (strcasecmp(word, "model") == 0) {
+    if (nArg != 1) return false;
+    mModel = args[0];
+  } else if (strcasecmp(word, "field") == 0) {
+    if (nArg != 1) return false;
+    mField = args[0];
+  } else if (strcasecmp(word, "analytic") == 0) {
+    if ((nArg < 1) || (nArg > 2)) return false;
+    AnalyticField* f = AnalyticField::Make(args[0]);
+    if (nullptr == f) return false;
+    delete f;
+    mAnalytic = args[0];
+    mCost = (nArg == 2) ? atoi(args[1]) : 0;
+    return mCost >= 0;
+  } else if (strcasecmp(word, "output") == 0) {
+    if (nArg != 1) return false;
+    mOutput = args[0];
+  } else if (strcasecmp(word, "format") == 0) {
+    if (nArg != 1) return false;
+    if (strcasecmp(args[0], "png") == 0) {
+      mFormat = kImagePNG;
+    } else if (strcasecmp(args[0], "ppm") == 0) {
+      mFormat = kImagePPM;
+    } else if ((strcasecmp(args[0], "tiff") == 0) ||
+               (strcasecmp(args[0], "tif") == 0)) {
+      mFormat = kImageTIFF;
+    } else {
+      return false;
+    }
+  } else if (strcasecmp(word, "raw") == 0) {
+    return (nArg == 1) && ParseOnOff(args[0], &mRaw);
+  } else if (strcasecmp(word, "csv") == 0) {
+    return (nArg == 1) && ParseOnOff(args[0], &mCSV);
+  } else if (strcasecmp(word, "size") == 0) {
+    if (nArg != 1) return false;
+    mCurrent.mSize = atoi(args[0]);
+    return mCurrent.mSize > 0;
+  } else if (strcasecmp(word, "component") == 0) {
+    if (nArg != 1) return false;
+    for (int c = 0; c < kSliceNComponent; c++) {
+      for (int k = 0; (k < 3) && (nullptr != sCompNames[c][k]); k++) {
+        if (strcasecmp(args[0], sCompNames[c][k]) == 0) {
+          mCurrent.mComponent = c;
+          return true;
+        }
+      }
+    }
+    char* end;
+    long c = strtol(args[0], &end, 10);
+    if ((*end != '\0') || (c < 0) || (c >= kSliceNComponent)) {
+      return false;
+    }
+    mCurrent.mComponent = (int) c;
+  } else if ((strcasecmp(word, "colours") == 0) ||
+             (strcasecmp(word, "colors") == 0)) {
+    if (nArg != 1) return false;
+    for (int c = 0; c < 3; c++) {
+      if (strcasecmp(args[0], sColourNames[c]) == 0) {
+        mCurrent.mColours = c;
+        return true;
+      }
+    }
+    return false;
+  } else if (strcasecmp(word, "map") == 0) {
+    if (nArg != 1) return false;
+    if (strcasecmp(args[0], "linear") == 0) {
+      mCurrent.mLinear = true;
+    } else if (strcasecmp(args[0], "log") == 0) {
+      mCurrent.mLinear = false;
+    } else {
+      return false;
+    }
+  } else if (strcasecmp(word, "range") == 0) {
+    if ((nArg == 1) && (strcasecmp(args[0], "auto") == 0)) {
+      mCurrent.mFixRange = false;
+      return true;
+    }
+    if (nArg != 2) return false;
+    mCurrent.mVMin = atof(args[0]);
+    mCurrent.mVMax = atof(args[1]);
+    mCurrent.mFixRange = true;
+    return mCurrent.mVMax > mCurrent.mVMin;
+  } else if ((strcasecmp(word, "plane") == 0) ||
+             (strcasecmp(word, "zplane") == 0)) {
+    if (nArg != 7) return false;
+    for (int i = 0; i < 6; i++) {
+      char* end;
+      v[i] = strtod(args[i + 1], &end);
+      if (*end != '\0') return false;
+    }
+    SliceSpec s = mCurrent;
+    s.mName = args[0];
+    s.mZPlane = (strcasecmp(word, "zplane") == 0);
+    s.mPoint = Point3D(v[0], v[1], v[2]);
+    if (s.mZPlane) {
+      s.mTheta = v[3];
+      s.mZMin = v[4];
+      s.mZMax = v[5];
+      if (s.mZMax <= s.mZMin) return false;
+    } else {
+      s.mNormal = Vector3D(v[3], v[4], v[5]);
+    }
+    mSlices.push_back(s);
+  } else {
+    return false;       // unknown directive
+  }
+  return true;
+}
+bool SliceJob::ParseOnOff(const char* word, bool* value)
+{
+  if ((strcasecmp(word, "on") == 0) || (strcasecmp(word, "yes") == 0)) {
+    *value = true;
+  } else if ((strcasecmp(word, "off") == 0) || (strcasecmp(word, "no") == 0)) {
+    *value = false;
+  } else {
+    return false;
+  }
+  return true;
+}
+//
+//  Names.
+//
+const char* SliceJob::ComponentName(int c)
+{
+  return ((c >= 0) && (c < kSliceNComponent)) ? sCompNames[c][0] : "?";
+}
+const char* SliceJob::ColoursName(int c)
+{
+  return ((c >= 0) && (c < 3)) ? sColourNames[c] : "?";
+}
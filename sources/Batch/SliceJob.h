@@ -0,0 +1,110 @@
+//
+//  SliceJob.h
+//  FieldViewer
+//
+//  A SliceJob is the contents of a batch job file: which model and
+//  field to load, where to put the output and a list of slices to cut
+//  through the field. The file is plain text, one directive per line,
+//  with # starting a comment.
+//
+//    model      run42.gla         .gla model, fields after its end line
+//    field      run42.bin         optional binary or grid file instead
+//    analytic   coax [cost]       or an analytic field, see AnalyticField.h
+//    output     slices/run42_     prefix for every file written
+//    format     png | tiff | ppm  image format, png by default
+//    raw        on | off          also write <name>.f32, off by default
+//    csv        on | off          also write <name>.csv, off by default
+//    size       512               samples across each slice
+//    component  Ex | Ey | Ez | Er | E    or the dialog numbers 0-4
+//    colours    heat | rainbow | grey
+//    map        linear | log
+//    range      auto | vmin vmax
+//    plane      name  px py pz  nx ny nz
+//    zplane     name  px py pz  theta zmin zmax
+//
+//  The settings are sticky. Each plane or zplane line takes a copy of
+//  them as they stand, so one job can mix components and colour maps.
+//  plane wants a normal with at least one zero component, just like
+//  the Plot field dialog. zplane is the Plot Z plane dialog, theta in
+//  degrees.
+//
+//  Created by Brian Collett on 10/19/26.
+//  Copyright (c) 2026 Brian Collett. All rights reserved.
+//
+
+#ifndef __FieldViewer__SliceJob__
+#define __FieldViewer__SliceJob__
+
+#include <string>
+#include <vector>
+#include "Geometry/Geometry3d.h"
+#include "ImageWriter.h"
+#include "FieldSlice.h"
+
+//
+//  Default samples across a slice.
+//
+const int kSJDefaultSize = 400;
+//
+//  One slice and the settings that were in force when it was read.
+//
+struct SliceSpec {
+  std::string mName;
+  bool mZPlane;
+  Point3D mPoint;
+  Vector3D mNormal;     // plane only
+  double mTheta;        // zplane only, degrees
+  double mZMin, mZMax;  // zplane only
+  int mSize;
+  int mComponent;
+  int mColours;
+  bool mLinear;
+  bool mFixRange;
+  double mVMin, mVMax;
+};
+
+class SliceJob {
+public:
+  //
+  //  Instance vars.
+  //
+  std::string mModel;
+  std::string mField;
+  std::string mAnalytic;
+  int mCost;            // for the analytic field
+  std::string mOutput;
+  ImageFormat mFormat;
+  bool mRaw;
+  bool mCSV;
+  std::vector<SliceSpec> mSlices;
+protected:
+  //
+  //  The settings that the next slice will get.
+  //
+  SliceSpec mCurrent;
+public:
+  //
+  //  ctors
+  //
+  SliceJob();
+  virtual ~SliceJob() {};
+  //
+  //  Read a job file. Problems are reported on stderr with their line
+  //  number and make Read return false, but it carries on to the end
+  //  of the file so that they are all reported at once.
+  //
+  bool Read(const char* path);
+  //
+  //  Component and colour map names for messages and file headers.
+  //
+  static const char* ComponentName(int c);
+  static const char* ColoursName(int c);
+protected:
+  //
+  //  Helpers.
+  //
+  bool ParseLine(char* line);
+  static bool ParseOnOff(const char* word, bool* value);
+};
+
+#endif /* defined(__FieldViewer__SliceJob__) */
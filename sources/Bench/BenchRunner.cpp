@@ -0,0 +1,122 @@
+//
+//  BenchRunner.cpp
+//  FieldViewer
+//
+//  A BenchRunner times small pieces of code. See BenchRunner.h.
+//
+//  Created by Brian Collett on 10/19/26.
+//  Copyright (c) 2026 Brian Collett. All rights reserved.
+//
+#include <math.h>
+#include <time.h>
+#include <algorithm>
+#include <chrono>
+#include "BenchRunner.h"
+
+typedef std::chrono::steady_clock Clock;
+//
+//  ctors
+//
+BenchRunner::BenchRunner(int runs, double runTime)
+{
+  mRuns = (runs > 0) ? runs : 1;
+  mRunTime = runTime;
+}
+//
+//  The warm-up call also tells us roughly how long a call takes, which
+//  sets the number of repeats in each run.
+//
+const BenchResult& BenchRunner::Run(const char* name, const char* unit,
+                                    double items,
+                                    const std::function<void()>& fn)
+{
+  Clock::time_point t0 = Clock::now();
+  fn();
+  std::chrono::duration<double> once = Clock::now() - t0;
+  long reps = 1;
+  if (once.count() < mRunTime) {
+    reps = (once.count() > 0.0) ? (long) ceil(mRunTime / once.count()) : 1000000;
+    if (reps > 1000000) {
+      reps = 1000000;
+    }
+  }
+  std::vector<double> t(mRuns);
+  for (int r = 0; r < mRuns; r++) {
+    t0 = Clock::now();
+    for (long k = 0; k < reps; k++) {
+      fn();
+    }
+    std::chrono::duration<double> dt = Clock::now() - t0;
+    t[r] = dt.count() / reps;
+  }
+  BenchResult res;
+  res.mName = name;
+  res.mUnit = unit;
+  res.mItems = items;
+  res.mRuns = mRuns;
+  res.mReps = reps;
+  double sum = 0.0;
+  for (int r = 0; r < mRuns; r++) {
+    sum += t[r];
+  }
+  res.mMean = sum / mRuns;
+  double var = 0.0;
+  for (int r = 0; r < mRuns; r++) {
+    var += (t[r] - res.mMean) * (t[r] - res.mMean);
+  }
+  res.mStdDev = (mRuns > 1) ? sqrt(var / (mRuns - 1)) : 0.0;
+  std::sort(t.begin(), t.end());
+  res.mMin = t[0];
+  res.mMedian = (mRuns % 2) ? t[mRuns / 2]
+                            : 0.5 * (t[mRuns / 2 - 1] + t[mRuns / 2]);
+  mResults.push_back(res);
+  return mResults.back();
+}
+void BenchRunner::Report(FILE* ofp) const
+{
+  fprintf(ofp, "%-36s %12s %12s %8s %14s\n", "case", "median ms",
+          "min ms", "+/- %", "rate");
+  for (size_t i = 0; i < mResults.size(); i++) {
+    const BenchResult& r = mResults[i];
+    double spread = (r.mMedian > 0.0) ? 100.0 * r.mStdDev / r.mMedian : 0.0;
+    fprintf(ofp, "%-36s %12.4f %12.4f %8.2f %14.4g %s/s\n", r.mName.c_str(),
+            1.0e3 * r.mMedian, 1.0e3 * r.mMin, spread, r.Rate(),
+            r.mUnit.c_str());
+  }
+}
+//
+//  Names and units are ours so they never need escaping, but the label
+//  comes from the command line.
+//
+static void WriteString(FILE* ofp, const char* s)
+{
+  fputc('"', ofp);
+  for (; *s != '\0'; s++) {
+    if ((*s == '"') || (*s == '\\')) {
+      fputc('\\', ofp);
+      fputc(*s, ofp);
+    } else if ((unsigned char) *s >= ' ') {
+      fputc(*s, ofp);
+    }
+  }
+  fputc('"', ofp);
+}
+bool BenchRunner::WriteJSON(FILE* ofp, const char* label) const
+{
+  char date[32];
+  time_t now = time(nullptr);
+  strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+  fprintf(ofp, "{\n  \"suite\": \"FieldBench\",\n  \"label\": ");
+  WriteString(ofp, label);
+  fprintf(ofp, ",\n  \"date\": \"%s\",\n  \"results\": [", date);
+  for (size_t i = 0; i < mResults.size(); i++) {
+    const BenchResult& r = mResults[i];
+    fprintf(ofp, "%s\n    {\"name\": \"%s\", \"unit\": \"%s\", \"items\": %.17g, "
+            "\"runs\": %d, \"reps\": %ld, \"min_s\": %.6e, \"median_s\": %.6e, "
+            "\"mean_s\": %.6e, \"stddev_s\": %.6e, \"rate\": %.6e}",
+            (i == 0) ? "" : ",", r.mName.c_str(), r.mUnit.c_str(), r.mItems,
+            r.mRuns, r.mReps, r.mMin, r.mMedian, r.mMean, r.mStdDev, r.Rate());
+  }
+  fprintf(ofp, "\n  ]\n}\n");
+  return ferror(ofp) == 0;
+}
@@ -0,0 +1,80 @@
+//
+//  BenchRunner.h
+//  FieldViewer
+//
+//  A BenchRunner times small pieces of code and keeps the results so
+//  that they can be printed as a table and written out as JSON. Each
+//  case is run once to warm up, then timed kBenchRuns times. Every run
+//  repeats the code as often as it takes to fill kBenchRunTime so that
+//  the clock is never the thing being measured, and the time for one
+//  repeat is the run time divided by the repeats. We report the
+//  median, which a stray context switch cannot drag about, along with
+//  the min, mean and spread.
+//
+//  Created by Brian Collett on 10/19/26.
+//  Copyright (c) 2026 Brian Collett. All rights reserved.
+//
+
+#ifndef __FieldViewer__BenchRunner__
+#define __FieldViewer__BenchRunner__
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <functional>
+
+//
+//  Timed runs per case and the least time in seconds each run takes.
+//
+const int kBenchRuns = 9;
+const double kBenchRunTime = 0.05;
+
+struct BenchResult {
+  std::string mName;
+  std::string mUnit;      // what items counts, "points", "lexemes" ...
+  double mItems;          // items handled by one repeat
+  int mRuns;
+  long mReps;             // repeats in each run
+  double mMin;            // seconds for one repeat
+  double mMedian;
+  double mMean;
+  double mStdDev;
+  //
+  //  Items per second at the median time.
+  //
+  double Rate() const { return (mMedian > 0.0) ? mItems / mMedian : 0.0; };
+};
+
+class BenchRunner {
+protected:
+  //
+  //  Instance vars.
+  //
+  int mRuns;
+  double mRunTime;
+  std::vector<BenchResult> mResults;
+public:
+  //
+  //  ctors
+  //
+  BenchRunner(int runs = kBenchRuns, double runTime = kBenchRunTime);
+  virtual ~BenchRunner() {};
+  //
+  //  Time fn. items is how many unit things one call of fn handles.
+  //  The result is kept and also handed back.
+  //
+  const BenchResult& Run(const char* name, const char* unit, double items,
+                         const std::function<void()>& fn);
+  const std::vector<BenchResult>& GetResults() const { return mResults; };
+  //
+  //  A table for people, one line per case.
+  //
+  void Report(FILE* ofp) const;
+  //
+  //  Everything as one JSON object. label identifies the build or
+  //  version being measured so that files can be compared later.
+  //
+  bool WriteJSON(FILE* ofp, const char* label) const;
+};
+
+#endif /* defined(__FieldViewer__BenchRunner__) */
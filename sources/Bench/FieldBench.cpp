@@ -0,0 +1,655 @@
+/*
+ *  FieldBench.cpp
+ *  FieldViewer
+ *
+ *  FieldBench times the hot paths of the viewer away from the window:
+ *  symbol lookup, scanning and building a .gla model or loading it from
+ *  its cache, reading numbers,
+ *  mapping field values to colours, point queries and slice sampling.
+ *  The parsing cases run on a synthetic model made up here, the number
+ *  cases on files of nothing but numbers in the styles that models and
+ *  field sets are written in, and the field cases on
+ *  an analytic field, coax unless -analytic says otherwise, so that
+ *  they always mean the same thing. -cost makes the analytic field
+ *  dearer per point. -model and -field add cases on real files.
+ *
+ *  The analytic field, and the field of a -model, are also sampled onto
+ *  a grid and the field cases run again on it as a GridField, plain,
+ *  packed losslessly and packed to within -pack of the true values, to
+ *  show what packing costs. A grid file given to -field gets a packed
+ *  run as well.
+ *
+ *  Loading a field is timed both ways it can come in. The field set at
+ *  the end of a -model is parsed by ParseFieldSet, in MB of text, and
+ *  that field, the analytic one and a -field grid file are read back
+ *  from a deflated grid file, in MB of node data, on every thread and
+ *  then on one.
+ *
+ *  Usage: FieldBench [-l label] [-o out.json] [-r runs]
+ *                    [-analytic kind] [-cost n] [-pack bound]
+ *                    [-model file.gla] [-field file.bin|file.fvg]
+ *
+ *  A table goes to stderr and the JSON to the -o file, or stdout if
+ *  there is none. The label is copied into the JSON to say which build
+ *  was measured; make bench sets it from git.
+ *
+ *  Texture uploads need a GL context, so the colour map case times the
+ *  loop from FieldTexture::Update without the upload, and the sampling
+ *  case times FieldSlice::Sample, which is what FieldView::ViewType
+ *  spends its time in.
+ *
+ *  Created by Brian Collett on 10/19/26.
+ *
+ */
+#include "wx/init.h"
+#include "wx/log.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <unistd.h>
+#include <random>
+#include <vector>
+
+#include "FieldViewerApp.h"
+#include "Batch/ConsoleLog.h"
+#include "GLAList.h"
+#include "GLACache.h"
+#include "CD3DField.h"
+#include "AnalyticField.h"
+#include "GridField.h"
+#include "ReadField.h"
+#include "FieldSlice.h"
+#include "BenchRunner.h"
+//
+//  Sizes of the synthetic cases.
+//
+const int kFBModelLines = 20000;    // lines in the synthetic model
+const int kFBPoints = 65536;        // points per query case
+const int kFBQueryBatch = 1024;     // points per FieldAtPoints call
+const int kFBSliceSide = 1024;      // samples across a slice, 1 Mpixel
+const int kFBMapSize = 1 << 20;     // values per colour map case
+const int kFBGridSide = 128;        // nodes along the longest grid side
+const double kFBPackBound = 1.0e-4; // error bound of the packed grid
+const int kFBNumbers = 1 << 19;     // values per number case
+//
+//  The synthetic model is a mix of the commands a real one uses, a new
+//  colour every so often, all from a fixed seed. It goes in a named
+//  temporary file, since the cache is keyed by path, which the caller
+//  removes.
+//
+static FILE* MakeModel(int nLines, std::string& path)
+{
+  char name[] = "/tmp/FieldBenchXXXXXX";
+  int fd = mkstemp(name);
+  FILE* fp = (fd < 0) ? nullptr : fdopen(fd, "w+");
+  if (nullptr == fp) {
+    return nullptr;
+  }
+  path = name;
+  std::mt19937 rng(1234);
+  std::uniform_real_distribution<double> u(-10.0, 10.0);
+  for (int i = 0; i < nLines; i++) {
+    switch (i % 8) {
+      case 0:
+        fprintf(fp, "color %.3f %.3f %.3f\n", 0.5 + 0.05 * u(rng),
+                0.5 + 0.05 * u(rng), 0.5 + 0.05 * u(rng));
+        break;
+      case 1:
+      case 2:
+        fprintf(fp, "sphere %.4f %.4f %.4f %.4f\n", 0.1 + 0.01 * fabs(u(rng)),
+                u(rng), u(rng), u(rng));
+        break;
+      case 3:
+      case 4:
+        fprintf(fp, "line %.4f %.4f %.4f %.4f %.4f %.4f\n", u(rng), u(rng),
+                u(rng), u(rng), u(rng), u(rng));
+        break;
+      case 5:
+        fprintf(fp, "triangle %.4f %.4f %.4f %.4f %.4f %.4f %.4f %.4f %.4f\n",
+                u(rng), u(rng), u(rng), u(rng), u(rng), u(rng),
+                u(rng), u(rng), u(rng));
+        break;
+      case 6:
+        fprintf(fp, "translate %.4f %.4f 0\n", u(rng), u(rng));
+        break;
+      default:
+        fprintf(fp, "cylinder %.4f %.4f %.4f\n", -fabs(u(rng)), fabs(u(rng)),
+                0.05 + 0.01 * fabs(u(rng)));
+        break;
+    }
+  }
+  fprintf(fp, "end\n");
+  fflush(fp);
+  return fp;
+}
+//
+//  A file of n numbers, six to a line, in one printf format. Integer
+//  formats get integers.
+//
+static FILE* MakeNumbers(int n, const char* format)
+{
+  FILE* fp = tmpfile();
+  if (nullptr == fp) {
+    return nullptr;
+  }
+  std::mt19937 rng(4321);
+  std::uniform_real_distribution<double> u(-1.0, 1.0);
+  std::uniform_int_distribution<int> e(-12, 12);
+  bool isInt = (strchr(format, 'd') != nullptr);
+  for (int i = 0; i < n; i++) {
+    double v = u(rng) * pow(10.0, e(rng));
+    if (isInt) {
+      fprintf(fp, format, (int) (v * 1.0e-3));
+    } else {
+      fprintf(fp, format, v);
+    }
+    fputc(((i % 6) == 5) ? '\n' : ' ', fp);
+  }
+  fputc('\n', fp);
+  fflush(fp);
+  return fp;
+}
+//
+//  One pass of the scanner over the whole file. Returns the lexemes.
+//  map false reads it a line at a time as the scanner used to.
+//
+static long ScanAll(FILE* fp, bool map = true)
+{
+  rewind(fp);
+  CTextScanner scan(fp, map);
+  long n = 0;
+  while (scan.NextLex()->lex != LEof) {
+    n++;
+  }
+  return n;
+}
+static int ParseAll(FILE* fp)
+{
+  rewind(fp);
+  CTextScanner scan(fp);
+  CGLAList list(&scan);
+  list.Create();
+  return list.GetNPrim();
+}
+//
+//  Load the model at path from a cache in a directory of our own, which
+//  we remove afterwards.
+//
+static int CacheLoad(FILE* fp, const char* path)
+{
+  rewind(fp);
+  CGLAList list;
+  GLACache::Load(&list, path, fp);
+  return list.GetNPrim();
+}
+static void CacheCases(BenchRunner& bench, FILE* fp, const char* path,
+                       const char* what)
+{
+  char dir[] = "/tmp/FieldBenchCacheXXXXXX";
+  if (nullptr == mkdtemp(dir)) {
+    return;
+  }
+  GLACache::SetDirectory(dir);
+  rewind(fp);
+  int64_t stamp[3];
+  GLACache::Stamp(fp, stamp);
+  CTextScanner scan(fp);
+  CGLAList list(&scan);
+  list.Create();
+  if (GLACache::Save(&list, path, stamp, fp) &&
+      (CacheLoad(fp, path) == list.GetNPrim())) {
+    std::string name = std::string("glalist.cache.") + what;
+    bench.Run(name.c_str(), "prims", (double) list.GetNPrim(),
+              [fp, path]() { CacheLoad(fp, path); });
+  } else {
+    eprintf("%s: unable to cache.\n", path);
+  }
+  remove(GLACache::CachePath(path).c_str());
+  rmdir(dir);
+  GLACache::SetDirectory(nullptr);
+}
+static void ParseCases(BenchRunner& bench, FILE* fp, const char* what)
+{
+  std::string name = std::string("scanner.nextlex.") + what;
+  long nLex = ScanAll(fp);
+  bench.Run(name.c_str(), "lexemes", (double) nLex, [fp]() { ScanAll(fp); });
+  name += ".fgets";
+  bench.Run(name.c_str(), "lexemes", (double) nLex,
+            [fp]() { ScanAll(fp, false); });
+  name = std::string("glalist.create.") + what;
+  int nPrim = ParseAll(fp);
+  bench.Run(name.c_str(), "prims", (double) nPrim, [fp]() { ParseAll(fp); });
+  //
+  //  And on one thread, to show what the pieces buy on this machine.
+  //
+  name += ".serial";
+  CGLAList::SetThreads(1);
+  bench.Run(name.c_str(), "prims", (double) nPrim, [fp]() { ParseAll(fp); });
+  CGLAList::SetThreads(0);
+}
+//
+//  Reading numbers is most of the work in a model or a field set. Plain
+//  decimals are what models use, exponents and full precision are what
+//  COMSOL writes.
+//
+static void NumberCases(BenchRunner& bench)
+{
+  static const char* sFormats[][2] = {
+    { "integer", "%d" }, { "fixed", "%.4f" }, { "exponent", "%.6e" },
+    { "full", "%.17g" }
+  };
+  for (int k = 0; k < 4; k++) {
+    FILE* fp = MakeNumbers(kFBNumbers, sFormats[k][1]);
+    if (nullptr == fp) {
+      continue;
+    }
+    std::string name = std::string("scanner.numbers.") + sFormats[k][0];
+    bench.Run(name.c_str(), "numbers", (double) kFBNumbers,
+              [fp]() { ScanAll(fp); });
+    fclose(fp);
+  }
+}
+//
+//  The words a model uses, half of them in the table and half not,
+//  which is about how often a typo or a new command turns up.
+//
+static void SymbolCases(BenchRunner& bench)
+{
+  static const char* sNames[] = {
+    "COLOR", "POINT", "LINE", "POLYLINE", "SPHERE", "TRIANGLE", "BOX",
+    "TRANSLATE", "CYLINDER", "CAP", "END", "color", "point", "line",
+    "polyline", "sphere", "triangle", "box", "translate", "cylinder", "cap",
+    "end"
+  };
+  static const char* sMisses[] = {
+    "colour", "spheres", "lines", "cone", "torus", "fields", "grid", "mesh",
+    "Color", "Sphere", "tri", "cyl", "boxes", "polygon", "normal", "text",
+    "scale", "rotate", "vertex", "quad", "strip", "fan"
+  };
+  const int nName = sizeof(sNames) / sizeof(sNames[0]);
+  const int nMiss = sizeof(sMisses) / sizeof(sMisses[0]);
+  CSymbolTable* tab = new CSymbolTable();
+  for (int i = 0; i < nName; i++) {
+    tab->InsertName(sNames[i], (short) i);
+  }
+  std::vector<const char*> words;
+  for (int i = 0; i < nName; i++) {
+    words.push_back(sNames[i]);
+    words.push_back(sMisses[i % nMiss]);
+  }
+  static volatile long sSink;
+  bench.Run("symtab.lookup", "lookups", (double) words.size(), [tab, &words]() {
+    long found = 0;
+    for (size_t i = 0; i < words.size(); i++) {
+      if (tab->LookUpWord(words[i]) != nullptr) {
+        found++;
+      }
+    }
+    sSink = found;
+  });
+  delete tab;
+  //
+  //  The same words in the verb table, which ignores case.
+  //
+  std::vector<size_t> lengths;
+  for (size_t i = 0; i < words.size(); i++) {
+    lengths.push_back(strlen(words[i]));
+  }
+  bench.Run("keywords.find", "lookups", (double) words.size(),
+            [&words, &lengths]() {
+    long found = 0;
+    for (size_t i = 0; i < words.size(); i++) {
+      if (kGLAVerbTable.Find(words[i], lengths[i]) != nullptr) {
+        found++;
+      }
+    }
+    sSink = found;
+  });
+}
+//
+//  A smooth ramp with the odd hole in it, like a slice through a model
+//  with conductors in the way.
+//
+static void ColourCases(BenchRunner& bench)
+{
+  std::vector<double> data(kFBMapSize);
+  for (int i = 0; i < kFBMapSize; i++) {
+    data[i] = ((i % 97) == 0) ? NAN : sin(1.0e-4 * i) * 1.0e3;
+  }
+  for (int c = kSliceHeat; c <= kSliceRainbow; c++) {
+    FieldMapper* fm = FieldSlice::NewFieldMapper(true, -1.0e3, 1.0e3);
+    ColorMapper* cm = FieldSlice::NewColorMapper(c);
+    std::vector<RGBColour> tex(kFBMapSize);
+    std::string name = std::string("texture.map.") +
+                       ((c == kSliceHeat) ? "heat" : "rainbow");
+    bench.Run(name.c_str(), "texels", kFBMapSize, [&]() {
+      for (int i = 0; i < kFBMapSize; i++) {
+        tex[i] = cm->Map(fm->Map(data[i]));
+      }
+    });
+    std::vector<unsigned char> rgb(3 * kFBMapSize);
+    name = std::string("slice.colour.") +
+           ((c == kSliceHeat) ? "heat" : "rainbow");
+    bench.Run(name.c_str(), "texels", kFBMapSize, [&]() {
+      FieldSlice::Colour(&data[0], kFBMapSize, fm, cm, &rgb[0]);
+    });
+    delete fm;
+    delete cm;
+  }
+}
+//
+//  Field cases. Points are spread uniformly through the
+//  bounds so some fall in holes, as they do when the user probes.
+//
+static void FieldCases(BenchRunner& bench, EField* f, const char* what)
+{
+  const Real* min = f->GetBounds()->GetMin().mCoords;
+  const Real* max = f->GetBounds()->GetMax().mCoords;
+  std::mt19937 rng(5678);
+  std::vector<double> pts(3 * kFBPoints);
+  for (int i = 0; i < kFBPoints; i++) {
+    for (int k = 0; k < 3; k++) {
+      std::uniform_real_distribution<double> u(min[k], max[k]);
+      pts[3 * i + k] = u(rng);
+    }
+  }
+  std::vector<double> E(3 * kFBPoints);
+  std::string name = std::string("field.fieldat.") + what;
+  bench.Run(name.c_str(), "points", kFBPoints, [&]() {
+    for (int i = 0; i < kFBPoints; i++) {
+      Vector3D v = f->FieldAt(Point3D(pts[3 * i], pts[3 * i + 1],
+                                      pts[3 * i + 2]));
+      E[3 * i] = v.mX;
+    }
+  });
+  name = std::string("field.fieldatpoints.") + what;
+  bench.Run(name.c_str(), "points", kFBPoints, [&]() {
+    for (int i = 0; i < kFBPoints; i += kFBQueryBatch) {
+      f->FieldAtPoints(kFBQueryBatch, &pts[3 * i], &E[3 * i]);
+    }
+  });
+  //
+  //  Slice across the middle of the field in z, 1 Mpixel, so the
+  //  median time is the cost per megapixel.
+  //
+  FrameRect3D* frame = nullptr;
+  Point3D mid(0.5 * (min[0] + max[0]), 0.5 * (min[1] + max[1]),
+              0.5 * (min[2] + max[2]));
+  if (FieldSlice::PlaneFrame(f, mid, Vector3D(0.0, 0.0, 1.0), &frame) != 0) {
+    return;
+  }
+  std::vector<double> data(kFBSliceSide * kFBSliceSide);
+  name = std::string("slice.sample.") + what;
+  bench.Run(name.c_str(), "Mpixel", 1.0e-6 * data.size(), [&]() {
+    double fMin, fMax;
+    FieldSlice::Sample(f, frame, kSliceTotal, kFBSliceSide, kFBSliceSide,
+                       &data[0], nullptr, &fMin, &fMax);
+  });
+  delete frame;
+}
+//
+//  The field cases again on src sampled onto a grid, as it is and
+//  packed both ways.
+//
+//
+//  Read every grid in a grid file, on all the threads GridFile wants
+//  and then on one, to show what unpacking the chunks at once buys.
+//
+static bool ReadGrids(const std::string& path)
+{
+  GridFile file;
+  std::vector<double> data;
+  bool ok = file.Open(path.c_str());
+  for (int i = 0; ok && (i < file.GetNGrids()); i++) {
+    ok = file.ReadGrid(i, data);
+  }
+  return ok;
+}
+static void FileCases(BenchRunner& bench, const char* path, const char* what)
+{
+  GridFile file;
+  if (!file.Open(path)) {
+    eprintf("%s\n", file.GetError().c_str());
+    return;
+  }
+  double mb = 0.0;
+  for (int i = 0; i < file.GetNGrids(); i++) {
+    mb += file.GetSpec(i).mSize / 1.0e6;
+  }
+  file.Close();
+  std::string p(path);
+  std::string name = std::string("gridfile.read.") + what;
+  bench.Run(name.c_str(), "MB", mb, [p]() { ReadGrids(p); });
+  name += ".serial";
+  GridFile::SetThreads(1);
+  bench.Run(name.c_str(), "MB", mb, [p]() { ReadGrids(p); });
+  GridFile::SetThreads(0);
+}
+//
+//  The same for a grid we have just sampled, written deflated to a
+//  file of our own that we remove afterwards.
+//
+static void SampledFileCases(BenchRunner& bench, const GridSpec& spec,
+                             const std::vector<double>& data, const char* what)
+{
+  char path[] = "/tmp/FieldBenchGridXXXXXX";
+  int fd = mkstemp(path);
+  if (fd < 0) {
+    return;
+  }
+  close(fd);
+  std::vector<GridSpec> specs(1, spec);
+  std::vector<const double*> grids(1, &data[0]);
+  if (GridFile::Write(path, specs, grids, true, what)) {
+    FileCases(bench, path, what);
+  }
+  remove(path);
+}
+//
+//  The text parser the grid file stands in for. The model is parsed
+//  once to find where its field set starts and then only the field set
+//  is timed.
+//
+static void FieldSetCases(BenchRunner& bench, FILE* fp, const char* what)
+{
+  rewind(fp);
+  CTextScanner scan(fp);
+  CGLAList list(&scan);
+  list.Create();
+  off_t start = ftello(fp);
+  bool ok = (fseeko(fp, 0, SEEK_END) == 0);
+  off_t end = ftello(fp);
+  if (!ok || (start < 0) || (end <= start)) {
+    return;
+  }
+  std::string name = std::string("fieldset.parse.") + what;
+  bench.Run(name.c_str(), "MB", (end - start) / 1.0e6, [fp, start]() {
+    CD3Data* fData = new CD3Data();
+    fseeko(fp, start, SEEK_SET);
+    ParseFieldSet(fData, fp);
+    delete fData;
+  });
+}
+static void GridCases(BenchRunner& bench, EField* src, const char* what,
+                      double bound)
+{
+  const Real* min = src->GetBounds()->GetMin().mCoords;
+  const Real* max = src->GetBounds()->GetMax().mCoords;
+  double side = fmax(max[0] - min[0], fmax(max[1] - min[1], max[2] - min[2]));
+  GridSpec spec;
+  memset(&spec, 0, sizeof(spec));
+  strncpy(spec.mName, what, kGFNameLength - 1);
+  if (!GridFile::SetSpacing(spec, min, max, side / (kFBGridSide - 1))) {
+    return;
+  }
+  static const char* sKind[3] = { "grid.", "lossless.", "packed." };
+  for (int k = 0; k < 3; k++) {
+    std::vector<double> data;
+    GridField::Sample(src, spec, data);
+    if (k == 0) {
+      SampledFileCases(bench, spec, data, what);
+    }
+    GridField g;
+    g.AddGrid(spec, data);
+    if (k > 0) {
+      g.Pack((k == 1) ? 0.0 : bound);
+      g.Report();
+    }
+    std::string name = std::string(sKind[k]) + what;
+    FieldCases(bench, &g, name.c_str());
+  }
+}
+//
+//  Recorded fields come after the end of a model or from a binary or
+//  grid file.
+//
+static EField* LoadField(const char* path, bool binary)
+{
+  if (binary && GridFile::IsGridFile(path)) {
+    return GridField::Read(path);
+  }
+  FILE* ifp = fopen(path, binary ? "rb" : "rt");
+  if (nullptr == ifp) {
+    eprintf("%s: unable to open.\n", path);
+    return nullptr;
+  }
+  CD3Data* fData = new CD3Data();
+  bool ok;
+  if (binary) {
+    ok = CD3ReadBinary(fData, ifp);
+  } else {
+    CTextScanner scan(ifp);
+    CGLAList list(&scan);
+    list.Create();
+    ok = ParseFieldSet(fData, ifp);
+  }
+  fclose(ifp);
+  if (!ok) {
+    delete fData;
+    return nullptr;
+  }
+  return new CD3DField(fData);
+}
+
+int main(int argc, char** argv)
+{
+  wxInitializer wxInit;
+  if (!wxInit.IsOk()) {
+    fprintf(stderr, "FieldBench: unable to initialise wx.\n");
+    return -1;
+  }
+  //
+  //  Progress chatter from the library would only slow the cases down.
+  //
+  SetConsoleQuiet(true);
+  const char* label = "";
+  const char* out = nullptr;
+  const char* model = nullptr;
+  const char* field = nullptr;
+  const char* analytic = "coax";
+  int cost = 0;
+  double pack = kFBPackBound;
+  int runs = kBenchRuns;
+  for (int i = 1; i < argc; i++) {
+    bool more = (i + 1 < argc);
+    if (more && (strcmp(argv[i], "-l") == 0)) {
+      label = argv[++i];
+    } else if (more && (strcmp(argv[i], "-o") == 0)) {
+      out = argv[++i];
+    } else if (more && (strcmp(argv[i], "-r") == 0)) {
+      runs = atoi(argv[++i]);
+    } else if (more && (strcmp(argv[i], "-analytic") == 0)) {
+      analytic = argv[++i];
+    } else if (more && (strcmp(argv[i], "-cost") == 0)) {
+      cost = atoi(argv[++i]);
+    } else if (more && (strcmp(argv[i], "-pack") == 0)) {
+      pack = atof(argv[++i]);
+    } else if (more && (strcmp(argv[i], "-model") == 0)) {
+      model = argv[++i];
+    } else if (more && (strcmp(argv[i], "-field") == 0)) {
+      field = argv[++i];
+    } else {
+      fprintf(stderr, "Usage: FieldBench [-l label] [-o out.json] [-r runs] "
+              "[-analytic kind] [-cost n] [-pack bound] [-model file.gla] "
+              "[-field file.bin|file.fvg]\n");
+      return -1;
+    }
+  }
+  delete wxLog::SetActiveTarget(new wxLogStderr());
+  wxLog::SetLogLevel(wxLOG_Warning);
+  GridField::SetPacking(-1.0);          // we pack for ourselves
+  CGLAList::InitClass(20);
+  BenchRunner bench(runs);
+  SymbolCases(bench);
+  std::string modelPath;
+  FILE* fp = MakeModel(kFBModelLines, modelPath);
+  if (nullptr != fp) {
+    ParseCases(bench, fp, "synthetic");
+    CacheCases(bench, fp, modelPath.c_str(), "synthetic");
+    fclose(fp);
+    remove(modelPath.c_str());
+  }
+  NumberCases(bench);
+  ColourCases(bench);
+  AnalyticField* af = AnalyticField::Make(analytic, cost);
+  if (nullptr == af) {
+    eprintf("%s: not an analytic field.\n", analytic);
+  } else {
+    std::string what = std::string("analytic.") + analytic;
+    FieldCases(bench, af, what.c_str());
+    GridCases(bench, af, what.c_str(), pack);
+    delete af;
+  }
+  if (nullptr != model) {
+    fp = fopen(model, "rt");
+    if (nullptr == fp) {
+      eprintf("%s: unable to open.\n", model);
+    } else {
+      ParseCases(bench, fp, "model");
+      CacheCases(bench, fp, model, "model");
+      FieldSetCases(bench, fp, "model");
+      fclose(fp);
+    }
+    if (nullptr == field) {
+      EField* f = LoadField(model, false);
+      if (nullptr != f) {
+        FieldCases(bench, f, "model");
+        GridCases(bench, f, "model", pack);
+        delete f;
+      }
+    }
+  }
+  if (nullptr != field) {
+    EField* f = LoadField(field, true);
+    if (nullptr != f) {
+      FieldCases(bench, f, "recorded");
+      GridField* g = dynamic_cast<GridField*>(f);
+      if (nullptr != g) {
+        FileCases(bench, field, "recorded");
+      }
+      if ((nullptr != g) && g->Pack(pack)) {
+        g->Report();
+        FieldCases(bench, g, "recorded.packed");
+      }
+      delete f;
+    }
+  }
+  CGLAList::ReleaseClass();
+  bench.Report(stderr);
+  FILE* ofp = stdout;
+  if (nullptr != out) {
+    ofp = fopen(out, "wt");
+    if (nullptr == ofp) {
+      eprintf("%s: unable to write.\n", out);
+      return 1;
+    }
+  }
+  bool ok = bench.WriteJSON(ofp, label);
+  if (ofp != stdout) {
+    ok = (fclose(ofp) == 0) && ok;
+  }
+  return ok ? 0 : 1;
+}
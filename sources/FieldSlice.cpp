@@ -0,0 +1,305 @@
+//
+//  FieldSlice.cpp
+//  FieldViewer
+//
+//  FieldSlice holds the parts of a FieldView that have nothing to do
+//  with the screen. See FieldSlice.h.
+//
+//  Created by Brian Collett on 10/19/26.
+//  Copyright (c) 2026 Brian Collett. All rights reserved.
+//
+#include <math.h>
+#include <float.h>
+#include <vector>
+
+#include "FieldSlice.h"
+#include "RainbowMapper.h"
+#include "CoolWarmMapper.h"
+#include "LinFieldMapper.h"
+#include "LogFieldMapper.h"
+//
+//  Colour for samples outside the field.
+//
+static const unsigned char sNaNColour[3] = { 0, 0, 0 };
+//
+//  Find where a plane cuts the field bounds.
+//  The simple (if very long winded) method that I use here relies on
+//  the facts that the bounding box is oriented parallel to the axes
+//  and that at least one of the axes lies in the view plane. This allows
+//  us to figure out immediately which edges of the bounding box are
+//  transected by the view plane.
+//
+int FieldSlice::PlaneFrame(EField* f, const Point3D& p, const Vector3D& v,
+                           FrameRect3D** frame)
+{
+  int dir;    // Direction number, x = 0, y = 1, z = 2.
+  int dirn,dirnn;
+  //
+  //  Start by finding an axis that lies in the plane. That is easy because
+  //  if an axis lies in the plane then that component of the normal vector
+  //  will be zero. So we seek the first zero component.
+  //
+  for (dir = 0; dir < 3; dir++) {
+    if (v.mCoords[dir] == 0.0) {
+      break;
+    }
+  }
+  if (dir > 2) {
+    return 1;    //  NO axis lies in the plane. We have failed.
+  }
+  //
+  //  Now that we know which direction is key we construct the other
+  //  two in order.
+  //
+  dirn = (dir + 1) % 3;
+  dirnn = (dir + 2) % 3;
+  //
+  //  Now that we know which real axis vector lies in the plane we know
+  //  that the plane must intersect the two faces perpendicular to that
+  //  direction.
+  //  We need to test the edges of one of those two faces in order. We
+  //  stop when we have found two. We start by constructing the vertices
+  //  in order.
+  //
+  const Real* min = f->GetBounds()->GetMin().mCoords;
+  const Real* max = f->GetBounds()->GetMax().mCoords;
+  Point3D corner[4];
+  for (int i = 0; i < 4; i++) {
+    corner[i].mCoords[dir] = min[dir];
+    corner[i].mCoords[dirn] = (((i/2)&1)==0) ? min[dirn] : max[dirn];
+    corner[i].mCoords[dirnn] = ((((i+1)/2)&1)==0) ? min[dirnn] : max[dirnn];
+  }
+  int nIntersection = 0;
+  Point3D frameCorner[4];
+  for (int edge = 0; edge < 4; edge++) {
+    if (Intersect(p, v,
+                  corner[edge], corner[(edge+1)%4],
+                  frameCorner[nIntersection])) {
+      bool used = false;
+      for (int e = 0; e < nIntersection; e++) {
+        if (frameCorner[nIntersection] == frameCorner[e]) {
+          used = true;
+        }
+      }
+      if (!used) {
+        nIntersection++;
+        if (nIntersection >= 2) break;
+      }
+    }
+  }
+  if (nIntersection != 2) {
+    return -1;        // MUST have two intersections.
+  }
+  //
+  //  Right, we have two intersections. They are on the min side in the
+  //  dir direction. The other two intersections are on the max side
+  //  so we make them from these two. The order is chosen carefully
+  //  to make corners adjacent.
+  //
+  frameCorner[2] = frameCorner[1];
+  frameCorner[2].mCoords[dir] = max[dir];
+  frameCorner[3] = frameCorner[0];
+  frameCorner[3].mCoords[dir] = max[dir];
+  *frame = new FrameRect3D(frameCorner);
+  return 0;
+}
+//
+//  This one works for planes that are explicitly parallel to the z
+//  axis and are bounded in the z direction.
+//  This time we get ourselves a square at zMin and search that
+//  for our intersections.
+//
+int FieldSlice::PZPlaneFrame(EField* f, const Point3D& p, double theta,
+                             double zMin, double zMax, FrameRect3D** frame)
+{
+  const double degree = 3.141592653589 / 180.0;
+  //
+  //  We know <0,0,1> lies in the plane, figure out what else
+  //  does from the angle.
+  //
+  Vector3D norm(cos(theta * degree), sin(theta * degree), 0.0);
+  const Real* min = f->GetBounds()->GetMin().mCoords;
+  const Real* max = f->GetBounds()->GetMax().mCoords;
+  Point3D corner[4];
+  for (int i = 0; i < 4; i++) {
+    corner[i].mCoords[0] = (((i/2)&1)==0) ? min[0] : max[0];
+    corner[i].mCoords[1] = ((((i+1)/2)&1)==0) ? min[1] : max[1];
+    corner[i].mCoords[2] = zMin;
+  }
+  int nIntersection = 0;
+  Point3D frameCorner[4];
+  for (int edge = 0; edge < 4; edge++) {
+    if (Intersect(p, norm,
+                  corner[edge], corner[(edge+1)%4],
+                  frameCorner[nIntersection])) {
+      bool used = false;
+      for (int e = 0; e < nIntersection; e++) {
+        if (frameCorner[nIntersection] == frameCorner[e]) {
+          used = true;
+        }
+      }
+      if (!used) {
+        nIntersection++;
+        if (nIntersection >= 2) break;
+      }
+    }
+  }
+  if (nIntersection != 2) {
+    return -1;        // MUST have two intersections.
+  }
+  frameCorner[2] = frameCorner[1];
+  frameCorner[2].mCoords[2] = zMax;
+  frameCorner[3] = frameCorner[0];
+  frameCorner[3].mCoords[2] = zMax;
+  *frame = new FrameRect3D(frameCorner);
+  return 0;
+}
+//
+//  The legend is thinner than the frame and translated by 10% of the
+//  frame width.
+//
+FrameRect3D* FieldSlice::LegendFrame(FrameRect3D* frame)
+{
+  Point3D frameCorner[4];
+  Vector3D horiz = frame->GetHorizontal();
+  horiz.Normalize();
+  double displacement = frame->GetWidth() * 0.1;
+  double legendWidth = displacement * 1.3; // 3% of frame
+  frameCorner[0] = frame->TopRight() + horiz * displacement;
+  frameCorner[1] = frameCorner[0] + horiz * legendWidth;
+  frameCorner[3] = frame->BottomRight() + horiz * displacement;
+  frameCorner[2] = frameCorner[3] + horiz * legendWidth;
+  return new FrameRect3D(frameCorner);
+}
+//
+//  Sampling goes a row at a time through FieldAtPoints so that real
+//  fields can skip the per-point overhead.
+//
+void FieldSlice::Sample(EField* f, FrameRect3D* frame, int type,
+                        int nAcross, int nDown, double* data, Point3D* pts,
+                        double* fMin, double* fMax)
+{
+  double spacing = frame->GetWidth() / nAcross;
+  std::vector<double> row(3 * nAcross);
+  std::vector<double> fields(3 * nAcross);
+  *fMin = DBL_MAX;
+  *fMax = -DBL_MAX;
+  for (int j = 0; j < nDown; j++) {
+    double y = (j + 0.5) * spacing;
+    for (int i = 0; i < nAcross; i++) {
+      Point3D p = frame->Map2D((i + 0.5) * spacing, y);
+      row[3 * i] = p.mX;
+      row[3 * i + 1] = p.mY;
+      row[3 * i + 2] = p.mZ;
+      if (nullptr != pts) {
+        pts[j * nAcross + i] = p;
+      }
+    }
+    f->FieldAtPoints(nAcross, &row[0], &fields[0]);
+    double* out = data + j * nAcross;
+    for (int i = 0; i < nAcross; i++) {
+      double v = Component(&fields[3 * i], type);
+      out[i] = v;
+      if (!isnan(v)) {
+        if (v < *fMin) *fMin = v;
+        if (v > *fMax) *fMax = v;
+      }
+    }
+  }
+}
+double FieldSlice::Component(const double* field, int type)
+{
+  switch (type) {
+    case kSliceEx:
+      return field[0];
+
+    case kSliceEy:
+      return field[1];
+
+    case kSliceEz:
+      return field[2];
+
+    case kSliceRadial:     // Radial compopnent
+      return sqrt(field[0] * field[0] + field[1] * field[1]);
+
+    case kSliceTotal:     // Total field
+      return sqrt(field[0] * field[0] + field[1] * field[1] +
+                  field[2] * field[2]);
+
+    default:
+      break;
+  }
+  return NAN;
+}
+//
+//  Mapper factories.
+//
+FieldMapper* FieldSlice::NewFieldMapper(bool linear, double fMin, double fMax)
+{
+  if (linear) {
+    return new LinFieldMapper(fMin, fMax);
+  }
+  return new LogFieldMapper(fMin, fMax);
+}
+ColorMapper* FieldSlice::NewColorMapper(int colours)
+{
+  if (colours == kSliceHeat) {
+    return new CoolWarmMapper(1);
+  } else if (colours == kSliceRainbow) {
+    return new RainbowMapper(1);
+  }
+  return new ColorMapper();
+}
+//
+//  CPU colour mapping, the same sums as FieldTexture but to bytes.
+//
+void FieldSlice::Colour(const double* data, int n, FieldMapper* fm,
+                        ColorMapper* cm, unsigned char* rgb,
+                        const unsigned char* nan)
+{
+  if (nullptr == nan) {
+    nan = sNaNColour;
+  }
+  for (int i = 0; i < n; i++, rgb += 3) {
+    double v = fm->Map(data[i]);
+    if (isnan(v)) {
+      rgb[0] = nan[0];
+      rgb[1] = nan[1];
+      rgb[2] = nan[2];
+      continue;
+    }
+    RGBColour col = cm->Map(v);
+    for (int k = 0; k < 3; k++) {
+      double c = col._m._comps[k];
+      if (c < 0.0) c = 0.0;
+      if (c > 1.0) c = 1.0;
+      rgb[k] = (unsigned char) (255.0 * c + 0.5);
+    }
+  }
+}
+//
+//  Helper.
+//  Find the point of intersection of the plane defined by the point p
+//  & the normal vector v with the line segment defined by the ordered
+//  point pair p1 & p2. If the intersection is within the segment returns
+//  true and sets pi to the intersection point.
+//
+bool FieldSlice::Intersect(const Point3D& p, const Vector3D& n,
+                           const Point3D& p1, const Point3D& p2, Point3D& pi)
+{
+  Vector3D w = p1 - p;
+  Vector3D u = p2 - p1;
+  double angle = n.Dot(u);
+  if (angle == 0) {
+    return false;
+  }
+  float lambda = -n.Dot(w)/angle;
+  if (lambda < 0.0) {
+    return false;
+  }
+  if (lambda > 1.0) {
+    return false;
+  }
+  pi = p1 + u * lambda;
+  return true;
+}
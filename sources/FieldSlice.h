@@ -0,0 +1,99 @@
+//
+//  FieldSlice.h
+//  FieldViewer
+//
+//  FieldSlice holds the parts of a FieldView that have nothing to do
+//  with the screen: finding where a plane cuts the field bounds,
+//  sampling the field over that rectangle and turning the samples
+//  into colours. The FieldView uses it to fill its textures and the
+//  batch renderer uses it to write images without any window at all,
+//  so a slice looks the same whichever of the two made it.
+//
+//  All the routines are class routines. The caller owns everything
+//  that they hand back.
+//
+//  Created by Brian Collett on 10/19/26.
+//  Copyright (c) 2026 Brian Collett. All rights reserved.
+//
+
+#ifndef __FieldViewer__FieldSlice__
+#define __FieldViewer__FieldSlice__
+
+#include "Geometry/GeometricObjects.h"
+#include "EField.h"
+#include "ColorMapper.h"
+#include "FieldMapper.h"
+
+//
+//  Components that can be plotted. The numbers are the ones that the
+//  plane dialogs have always used.
+//
+enum SliceComponent {
+  kSliceEx = 0,
+  kSliceEy,
+  kSliceEz,
+  kSliceRadial,
+  kSliceTotal,
+  kSliceNComponent
+};
+//
+//  Colour maps, numbered like the document's colour cycle setting.
+//
+enum SliceColours {
+  kSliceGrey = 0,
+  kSliceHeat = 1,
+  kSliceRainbow = 2
+};
+
+class FieldSlice {
+public:
+  //
+  //  Plane finders. Each returns 0 and sets *frame to a new rectangle
+  //  on success. PlaneFrame wants a plane that contains at least one
+  //  axis and returns 1 if it does not and -1 if the plane misses the
+  //  field. PZPlaneFrame wants a plane parallel to z, given by the angle
+  //  of its normal in degrees, and bounds it in z.
+  //
+  static int PlaneFrame(EField* f, const Point3D& p, const Vector3D& v,
+                        FrameRect3D** frame);
+  static int PZPlaneFrame(EField* f, const Point3D& p, double theta,
+                          double zMin, double zMax, FrameRect3D** frame);
+  //
+  //  The legend sits in the same plane as the frame, a little to its
+  //  right.
+  //
+  static FrameRect3D* LegendFrame(FrameRect3D* frame);
+  //
+  //  Sample fills data with nAcross * nDown values of one component,
+  //  row by row from the bottom of the frame, at the centre of each
+  //  cell. If pts is not nullptr it gets the sample points too. The
+  //  range of the finite values goes into *fMin and *fMax; if there are
+  //  none they come back as DBL_MAX and -DBL_MAX.
+  //
+  static void Sample(EField* f, FrameRect3D* frame, int type,
+                     int nAcross, int nDown, double* data, Point3D* pts,
+                     double* fMin, double* fMax);
+  static double Component(const double* field, int type);
+  //
+  //  Mapper factories. linear picks LinFieldMapper over LogFieldMapper
+  //  and colours is one of the SliceColours.
+  //
+  static FieldMapper* NewFieldMapper(bool linear, double fMin, double fMax);
+  static ColorMapper* NewColorMapper(int colours);
+  //
+  //  Colour n samples into rgb, 3 bytes per sample. Samples that are
+  //  not numbers (outside the field) get the nan colour.
+  //
+  static void Colour(const double* data, int n, FieldMapper* fm,
+                     ColorMapper* cm, unsigned char* rgb,
+                     const unsigned char* nan = nullptr);
+  //
+  //  Helper.
+  //  Find the point of intersection of the plane defined by the point p
+  //  & the normal vector n with the line segment p1 to p2.
+  //
+  static bool Intersect(const Point3D& p, const Vector3D& n,
+                        const Point3D& p1, const Point3D& p2, Point3D& pi);
+};
+
+#endif /* defined(__FieldViewer__FieldSlice__) */
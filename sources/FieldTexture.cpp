@@ -18,6 +18,7 @@
 #include "assert.h"
 #include "Geometry/GeometricObjects.h"
 #include "FieldTexture.h"
+#include "Profiler.h"
 
 //
 //  ctors
@@ -35,6 +36,7 @@ FieldTexture::FieldTexture(int width , int height, double* f)
   mField = nullptr;
   mTData = nullptr;
   mValid = false;
+  mProxyName = 0;
   glGenTextures(1, &mTexName);
   if ((mWidth * mHeight > 0) && (f != nullptr)) {
     InstallField(f);
@@ -54,6 +56,10 @@ FieldTexture::~FieldTexture()
   if (mField != nullptr) {
     delete mField;
   }
+  if (mProxyName != 0) {
+    glDeleteTextures(1, &mProxyName);
+  }
+  glDeleteTextures(1, &mTexName);
 }
 //
 //  Install maps and field.
@@ -107,6 +113,7 @@ void FieldTexture::InstallField(double* f)
 void FieldTexture::Update(void)
 {
   int size = mWidth * mHeight;
+  gProfiler.Begin(kProfColourMap);
 //  double scale = 2.0 / double(size);
   for (int i = 0; i < size; i++) {
     double v = mField[i];
@@ -116,6 +123,8 @@ void FieldTexture::Update(void)
 //    mTData[i] = mCMap->Map(mFMap->Map(mField[i]));
 //    mTData[i] = mCMap->Map(scale * double(i) - 1.0);
   }
+  gProfiler.End(kProfColourMap);
+  ProfScope prof(kProfUpload);
   Call(glBindTexture(GL_TEXTURE_2D, mTexName));
   Call(glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR)); // Linear Filtering
   Call(glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR)); // Linear Filtering
@@ -125,6 +134,79 @@ void FieldTexture::Update(void)
   Call(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB,
                     mWidth, mHeight,
                     0, GL_RGB, GL_FLOAT, mTData));
+  UpdateProxy();
+}
+//
+//  UpdateProxy box filters the texture data down into the proxy.
+//
+void FieldTexture::UpdateProxy(void)
+{
+  if ((mWidth < kFTProxyMin) && (mHeight < kFTProxyMin)) {
+    return;
+  }
+  int pw = (mWidth + kFTProxyStep - 1) / kFTProxyStep;
+  int ph = (mHeight + kFTProxyStep - 1) / kFTProxyStep;
+  GLfloat* pData = new GLfloat[3 * pw * ph];
+  for (int py = 0; py < ph; py++) {
+    int yMax = (py + 1) * kFTProxyStep;
+    if (yMax > mHeight) yMax = mHeight;
+    for (int px = 0; px < pw; px++) {
+      int xMax = (px + 1) * kFTProxyStep;
+      if (xMax > mWidth) xMax = mWidth;
+      double r = 0.0, g = 0.0, b = 0.0;
+      int n = 0;
+      for (int y = py * kFTProxyStep; y < yMax; y++) {
+        const RGBColour* row = mTData + y * mWidth;
+        for (int x = px * kFTProxyStep; x < xMax; x++) {
+          r += row[x]._m._c.red;
+          g += row[x]._m._c.green;
+          b += row[x]._m._c.blue;
+          n++;
+        }
+      }
+      GLfloat* p = pData + 3 * (py * pw + px);
+      p[0] = GLfloat(r / n);
+      p[1] = GLfloat(g / n);
+      p[2] = GLfloat(b / n);
+    }
+  }
+  if (mProxyName == 0) {
+    glGenTextures(1, &mProxyName);
+  }
+  Call(glBindTexture(GL_TEXTURE_2D, mProxyName));
+  Call(glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR));
+  Call(glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR));
+  Call(glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+  Call(glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+  Call(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, pw, ph,
+                    0, GL_RGB, GL_FLOAT, pData));
+  delete[] pData;
+}
+//
+//  Load a ready-made RGBA image. If the size has not changed we can
+//  simply replace the contents of the existing texture.
+//
+void FieldTexture::InstallImage(int width, int height, const GLubyte* rgba)
+{
+  assert(width > 0);
+  assert(height > 0);
+  assert(rgba != nullptr);
+  Call(glBindTexture(GL_TEXTURE_2D, mTexName));
+  if (mValid && (width == mWidth) && (height == mHeight)) {
+    Call(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height,
+                         GL_RGBA, GL_UNSIGNED_BYTE, rgba));
+    return;
+  }
+  mWidth = width;
+  mHeight = height;
+  Call(glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MIN_FILTER,GL_LINEAR));
+  Call(glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_MAG_FILTER,GL_LINEAR));
+  Call(glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+  Call(glTexParameteri(GL_TEXTURE_2D,GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+  Call(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA,
+                    mWidth, mHeight,
+                    0, GL_RGBA, GL_UNSIGNED_BYTE, rgba));
+  mValid = true;
 }
 //
 //  Point mapped display removed 7/9/14
@@ -9,6 +9,8 @@
 //  which are supposed to be supported in OpenGL 2.
 //
 //  Created by Brian Collett on 3/10/14.
+//  BCollett 10/19/26 Keep a coarse copy of the texture to draw while the
+//  view is being dragged about.
 //  Copyright (c) 2014 Brian Collett. All rights reserved.
 //
 
@@ -17,6 +19,13 @@
 
 #include "ColorMapper.h"
 #include "FieldMapper.h"
+//
+//  The proxy texture averages kFTProxyStep x kFTProxyStep texels of the
+//  real one. Textures smaller than kFTProxyMin on both sides are cheap
+//  enough already and have no proxy.
+//
+const int kFTProxyStep = 4;
+const int kFTProxyMin = 64;
 
 class FieldTexture {
 protected:
@@ -33,6 +42,7 @@ protected:
   //  We need a texture name (a number) from OpenGL.
   //
   GLuint mTexName;
+  GLuint mProxyName;    // 0 if there is no proxy
   //
   //  Also have a ColorMapper and FieldMapper.
   //
@@ -57,17 +67,26 @@ public:
   //  Accessor.
   //
   GLuint Name(void) const { return mTexName; };
+  GLuint ProxyName(void) const
+    { return (0 != mProxyName) ? mProxyName : mTexName; };
   //
   //  Install map and field.
   //
   virtual void InstallCMap(ColorMapper* map);
   virtual void InstallFMap(FieldMapper* map);
   virtual void InstallField(double* f);
+  //
+  //  Alternatively load a ready-made RGBA image that the caller keeps.
+  //  This bypasses the maps altogether and is how a VolumeView gets its
+  //  ray-marched picture onto the screen.
+  //
+  virtual void InstallImage(int width, int height, const GLubyte* rgba);
 protected:
   //
   //  Helper should be called any time maps change.
   //
   virtual void Update(void);
+  void UpdateProxy(void);
 };
 
 #endif /* defined(__FieldViewer__FieldTexture__) */
@@ -10,6 +10,10 @@
 //  BCollett 3/18/14 Add planes explicitly parallel to z.
 //  BCollett 7/4/14 Have textures working properly. Connect to
 //  canvas so can get info about size of texture needed.
+//  BCollett 10/19/26 Plane finding and sampling moved out to FieldSlice
+//  so that the batch renderer can share them.
+//  BCollett 10/19/26 Save views in sessions and restore them, from their
+//  samples when the session has them.
 //  Copyright (c) 2014 Brian Collett. All rights reserved.
 //
 #include "wx/wxprec.h"
@@ -20,13 +24,13 @@
 
 #include <math.h>
 #include <float.h>
+#include <algorithm>
+#include <cmath>
 
 #include "FieldViewerDoc.h"
 #include "FieldView.h"
-#include "RainbowMapper.h"
-#include "CoolWarmMapper.h"
-#include "LinFieldMapper.h"
-#include "LogFieldMapper.h"
+#include "FieldSlice.h"
+#include "Profiler.h"
 //
 //  ctors
 //
@@ -41,6 +45,11 @@ Listable(), GeometryObject(kGeomView)
   mValid = false;
   mFixRange = false;
   mTex = nullptr;
+  mLTex = nullptr;
+  mFData = nullptr;
+  mPData = nullptr;
+  mType = 0;
+  mSpacing = 0.0;
 }
 
 FieldView::~FieldView()
@@ -58,86 +67,10 @@ FieldView::~FieldView()
 //
 int FieldView::ViewPlane(Point3D& p, Vector3D& v)
 {
-  int dir;    // Direction number, x = 0, y = 1, z = 2.
-  int dirn,dirnn;
-  //
-  //  We have to find the points of intersection of the specified plane
-  //  with the bounding box of the Field.
-  //  The simple (if very long winded) method that I use here relies on
-  //  the facts that the bounding box is oriented parallel to the axes
-  //  and that at least one of the axes lies in the view plane. This allows
-  //  us to figure out immediately which edges of the bounding box are
-  //  transected by the view plane.
-  //
-  //  Start by finding an axis that lies in the plane. That is easy because
-  //  if an axis lies in the plane then that component of the normal vector
-  //  will be zero. So we seek the first zero component.
-  //
-  for (dir = 0; dir < 3; dir++) {
-    if (v.mCoords[dir] == 0.0) {
-      break;
-    }
-  }
-  if (dir > 2) {
-    return 1;    //  NO axis lies in the plane. We have failed.
-  }
-  //
-  //  Now that we know which direction is key we construct the other
-  //  two in order.
-  //
-  dirn = (dir + 1) % 3;
-  dirnn = (dir + 2) % 3;
-  //
-  //  Now that we know which real axis vector lies in the plane we know
-  //  that the plane must intersect the two faces perpendicular to that
-  //  direction.
-  //  We need to test the edges of one of those two faces in order. We
-  //  stop when we have found two. We start by constructing the vertices
-  //  in order.
-  //
-  const Real* min = mField->GetBounds()->GetMin().mCoords;
-  const Real* max = mField->GetBounds()->GetMax().mCoords;
-  Point3D corner[4];
-  for (int i = 0; i < 4; i++) {
-    corner[i].mCoords[dir] = min[dir];
-    corner[i].mCoords[dirn] = (((i/2)&1)==0) ? min[dirn] : max[dirn];
-    corner[i].mCoords[dirnn] = ((((i+1)/2)&1)==0) ? min[dirnn] : max[dirnn];
-  }
-  int nIntersection = 0;
-  Point3D frameCorner[4];
-  for (int edge = 0; edge < 4; edge++) {
-    if (Intersect(p, v,
-                  corner[edge], corner[(edge+1)%4],
-                  frameCorner[nIntersection])) {
-      bool used = false;
-      for (int e = 0; e < nIntersection; e++) {
-        if (frameCorner[nIntersection] == frameCorner[e]) {
-          used = true;
-        }
-      }
-      if (!used) {
-        nIntersection++;
-        if (nIntersection >= 2) break;
-      }
-    }
-  }
-  if (nIntersection != 2) {
-    return -1;        // MUST have two intersections.
+  int err = FieldSlice::PlaneFrame(mField, p, v, &mFrame);
+  if (err != 0) {
+    return err;
   }
-  //
-  //  Right, we have two intersections. They are on the min side in the
-  //  dir direction. The other two intersections are on the max side
-  //  so we make them from these two. The order is chosen carefully
-  //  to make corners adjacent.
-  //
-  frameCorner[2] = frameCorner[1];
-  frameCorner[2].mCoords[dir] = max[dir];
-  frameCorner[3] = frameCorner[0];
-  frameCorner[3].mCoords[dir] = max[dir];
-  //
-  //  Now we can construct the FrameRect3D representing the intersection.
-  //
-  mFrame = new FrameRect3D(frameCorner);
   if (mFrame->IsValid()) {
     mValid = true;
   }
@@ -145,77 +78,18 @@ int FieldView::ViewPlane(Point3D& p, Vector3D& v)
 }
 //
 //  This one works for planes that are explicitly parallel to the z
-//  axis and are bounded in the z direction.
-//  This time we get ourselves a square at zMin and search that
-//  for our intersections.
+//  axis and are bounded in the z direction. These also get a legend.
 //
 int FieldView::ViewPlane(Point3D& p, double theta, double zMin, double zMax)
 {
-  const double degree = 3.141592653589 / 180.0;
-  //
-  //  We know <0,0,1> lies in the plane, figure out what else
-  //  does from the angle.
-  //
-  Vector3D norm(cos(theta * degree), sin(theta * degree), 0.0);
-  const Real* min = mField->GetBounds()->GetMin().mCoords;
-  const Real* max = mField->GetBounds()->GetMax().mCoords;
-  Point3D corner[4];
-  for (int i = 0; i < 4; i++) {
-    corner[i].mCoords[0] = (((i/2)&1)==0) ? min[0] : max[0];
-    corner[i].mCoords[1] = ((((i+1)/2)&1)==0) ? min[1] : max[1];
-    corner[i].mCoords[2] = zMin;
-  }
-  int nIntersection = 0;
-  Point3D frameCorner[4];
-  for (int edge = 0; edge < 4; edge++) {
-    if (Intersect(p, norm,
-                  corner[edge], corner[(edge+1)%4],
-                  frameCorner[nIntersection])) {
-      bool used = false;
-      for (int e = 0; e < nIntersection; e++) {
-        if (frameCorner[nIntersection] == frameCorner[e]) {
-          used = true;
-        }
-      }
-      if (!used) {
-        nIntersection++;
-        if (nIntersection >= 2) break;
-      }
-    }
-  }
-  if (nIntersection != 2) {
-    return -1;        // MUST have two intersections.
+  int err = FieldSlice::PZPlaneFrame(mField, p, theta, zMin, zMax, &mFrame);
+  if (err != 0) {
+    return err;
   }
-  //
-  //  Right, we have two intersections. They are on the min side in the
-  //  dir direction. The other two intersections are on the max side
-  //  so we make them from these two. The order is chosen carefully
-  //  to make corners adjacent.
-  //
-  frameCorner[2] = frameCorner[1];
-  frameCorner[2].mCoords[2] = zMax;
-  frameCorner[3] = frameCorner[0];
-  frameCorner[3].mCoords[2] = zMax;
-  //
-  //  Now we can construct the FrameRect3D representing the intersection.
-  //
-  mFrame = new FrameRect3D(frameCorner);
   if (mFrame->IsValid()) {
     mValid = true;
   }
-  //
-  //  Then we can construct the legend. It sits in the same plane as
-  //  the mFrame but is thinner and translated by 10% of the mFrame width.
-  //
-  Vector3D horiz = mFrame->GetHorizontal();
-  horiz.Normalize();
-  double displacement = mFrame->GetWidth() * 0.1;
-  double legendWidth = displacement * 1.3; // 3% of frame
-  frameCorner[0] = frameCorner[1] + horiz * displacement;
-  frameCorner[1] = frameCorner[0] + horiz * legendWidth;
-  frameCorner[3] = frameCorner[2] + horiz * displacement;
-  frameCorner[2] = frameCorner[3] + horiz * legendWidth;
-  mLegendFrame = new FrameRect3D(frameCorner);
+  mLegendFrame = FieldSlice::LegendFrame(mFrame);
   return 0;
 }
 
@@ -225,6 +99,8 @@ int FieldView::ViewPlane(Point3D& p, double theta, double zMin, double zMax)
 void FieldView::ViewType(int type, double spacing)
 {
   //  static char mBuff[128];
+  mType = type;
+  mSpacing = spacing;
   if (mFrame->IsValid()) {
     //
     //  Start by figuring out how big an aray we will need to hold the view.
@@ -237,108 +113,198 @@ void FieldView::ViewType(int type, double spacing)
       mNDown = (int) floor(mCanvas->Project(mFrame->GetHeight()));
     }
     mNAcross = (int) floor(mCanvas->Project(mFrame->GetWidth()));
-    mPData = new Point3D[mNAcross * mNDown];
-    mFData = new double[mNAcross * mNDown];
-    if (!mFixRange) {
-      mFMin = DBL_MAX;
-      mFMax = -DBL_MAX;
-    }
-    double width = mFrame->GetWidth();
-    spacing = width / mNAcross;
-    int i,j;
-    double x,y,v;
-    for (j = 0; j < mNDown; j++) {
-      y = (j + 0.5) * spacing;
-      for (i = 0; i < mNAcross; i++, x = ((i + 0.5) * spacing)) {
-        Point3D p = mFrame->Map2D(x, y);
-        //        printf("<%f,%f>->[%f,%f,%f]\n",x,y,
-        //               p.mX, p.mY, p.mZ);
-        Vector3D f = dynamic_cast<EField*>(mField)->FieldAt(p);
-        mPData[(int)(j * mNAcross + i)] = p;
-        switch (type) {
-          case 0:
-            v = f.mX;
-            break;
-            
-          case 1:
-            v = f.mY;
-            break;
-            
-          case 2:
-            v = f.mZ;
-            break;
-            
-          case 3:     // Radial compopnent
-            v = sqrt(f.mX * f.mX + f.mY * f.mY);
-            break;
-            
-          case 4:     // Total field
-            v = f.Length();
-            break;
-            
-          default:
-            break;
-        }
-        mFData[(int)(j * mNAcross + i)] = v;
-        if (!mFixRange) {
-          if (v < mFMin) mFMin = v;
-          if (v > mFMax) mFMax = v;
-        }
-      }
-    }
-    eprintf("fmin=%f, fmax=%f\n", mFMin, mFMax);
     //
-    //  And then build a texture to put in it.
+    //  An export can ask for more than a texture can hold. Keep the
+    //  shape and settle for the biggest texture we can have.
     //
-    assert(mNAcross > 0);
-    assert(mNDown > 0);
-    mTex = new FieldTexture(mNAcross, mNDown);
-    assert(nullptr != mTex);
-    FieldMapper* fm;
-    if (mDoc->IsLinear()) {
-      fm = new LinFieldMapper(mFMin, mFMax);
-    } else {
-      fm = new LogFieldMapper(mFMin, mFMax);
+    GLint maxTex = 0;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTex);
+    int big = (mNAcross > mNDown) ? mNAcross : mNDown;
+    if ((maxTex > 0) && (big > maxTex)) {
+      mNAcross = (int) floor(double(mNAcross) * maxTex / big);
+      mNDown = (int) floor(double(mNDown) * maxTex / big);
     }
-    //    ColorMapper* cm = new RainbowMapper(1);
-    ColorMapper* cm;
-    if (mDoc->GetNColorCycle() == 1) {
-      cm = new CoolWarmMapper(1);
-    } else if (mDoc->GetNColorCycle() == 2) {
-      cm = new RainbowMapper(1);
-    } else {
-      cm = new ColorMapper();
+    if (mNAcross < 1) {
+      mNAcross = 1;
     }
-    mTex->InstallCMap(cm);
-    mTex->InstallFMap(fm);
-    mTex->InstallField(mFData);
+    if (mNDown < 1) {
+      mNDown = 1;
+    }
+    gProfiler.Begin(kProfSample);
     //
-    //  Texture for the legend.
+    //  Nothing uses the sample points since the point display went, and
+    //  at export sizes they would cost far more than the field itself.
     //
-    double lData[400];
-    double max = (fabs(mFMax) > fabs(mFMin)) ? fabs(mFMax) : fabs(mFMin);
-    for (j = 0; j < 200; j++) {
-      y = max * double(j - 100) / 100.0;
-      for (i = 0; i < 2; i++) {
-        lData[(int)(j * 2 + i)] = y;
+    mPData = nullptr;
+    mFData = new double[mNAcross * mNDown];
+    double sMin, sMax;
+    FieldSlice::Sample(mField, mFrame, type, mNAcross, mNDown,
+                       mFData, nullptr, &sMin, &sMax);
+    if (!mFixRange) {
+      mFMin = sMin;
+      mFMax = sMax;
+      //
+      //  A plane that misses the field altogether comes back all NaN,
+      //  which draws clear whatever the range. Give the mappers
+      //  something they can divide by.
+      //
+      if (mFMin > mFMax) {
+        mFMin = -1.0;
+        mFMax = 1.0;
       }
     }
-    mLTex = new FieldTexture(2, 200);
-    if (mDoc->IsLinear()) {
-      fm = new LinFieldMapper(-max, max);
-    } else {
-      fm = new LogFieldMapper(-max, max);
+    gProfiler.End(kProfSample);
+    eprintf("fmin=%f, fmax=%f\n", mFMin, mFMax);
+    MakeTextures();
+  }
+}
+//
+//  Build the textures for mFData, which they take over, and the legend.
+//
+void FieldView::MakeTextures(void)
+{
+  assert(mNAcross > 0);
+  assert(mNDown > 0);
+  mTex = new FieldTexture(mNAcross, mNDown);
+  assert(nullptr != mTex);
+  FieldMapper* fm = FieldSlice::NewFieldMapper(mDoc->IsLinear(),
+                                               mFMin, mFMax);
+  ColorMapper* cm = FieldSlice::NewColorMapper(mDoc->GetNColorCycle());
+  mTex->InstallCMap(cm);
+  mTex->InstallFMap(fm);
+  mTex->InstallField(mFData);
+  //
+  //  Texture for the legend.
+  //
+  int i, j;
+  double y;
+  double* lData = new double[400];      // the texture owns it
+  double max = (fabs(mFMax) > fabs(mFMin)) ? fabs(mFMax) : fabs(mFMin);
+  for (j = 0; j < 200; j++) {
+    y = max * double(j - 100) / 100.0;
+    for (i = 0; i < 2; i++) {
+      lData[(int)(j * 2 + i)] = y;
     }
-    if (mDoc->GetNColorCycle() == 1) {
-      cm = new CoolWarmMapper(1);
-    } else if (mDoc->GetNColorCycle() == 2) {
-      cm = new RainbowMapper(1);
-    } else {
-      cm = new ColorMapper();
+  }
+  mLTex = new FieldTexture(2, 200);
+  fm = FieldSlice::NewFieldMapper(mDoc->IsLinear(), -max, max);
+  cm = FieldSlice::NewColorMapper(mDoc->GetNColorCycle());
+  mLTex->InstallCMap(cm);
+  mLTex->InstallFMap(fm);
+  mLTex->InstallField(lData);
+}
+
+//
+//  The textures own the field data so deleting them clears out the
+//  old sample.
+//
+void FieldView::Resample(void)
+{
+  if (!mValid || (nullptr == mTex) || (nullptr == mField)) {
+    return;
+  }
+  DropTextures();
+  bool fixRange = mFixRange;
+  mFixRange = true;
+  ViewType(mType, mSpacing);
+  mFixRange = fixRange;
+}
+//
+//  The frame stays where the user put it, even if the new field has
+//  different bounds. Samples outside the field just come back empty.
+//
+void FieldView::SetField(EField* f)
+{
+  mField = f;
+  if (!mValid || (nullptr == mTex)) {
+    return;
+  }
+  DropTextures();
+  ViewType(mType, mSpacing);
+}
+//
+//  The samples go back in as they were saved. The range, unless it was
+//  fixed, is found from them just as Sample would have found it.
+//
+bool FieldView::Restore(const SessionView& s)
+{
+  mFrame = new FrameRect3D(s.mCorners);
+  if (!mFrame->IsValid()) {
+    return false;
+  }
+  mValid = true;
+  if (s.mLegend) {
+    mLegendFrame = FieldSlice::LegendFrame(mFrame);
+  }
+  mType = s.mComponent;
+  mSpacing = s.mSpacing;
+  mFixRange = s.mFixRange;
+  if (mFixRange) {
+    mFMin = s.mVMin;
+    mFMax = s.mVMax;
+  }
+  if (s.mData.empty()) {
+    return true;
+  }
+  mNAcross = s.mNAcross;
+  mNDown = s.mNDown;
+  mFData = new double[s.mData.size()];
+  std::copy(s.mData.begin(), s.mData.end(), mFData);
+  if (!mFixRange) {
+    mFMin = DBL_MAX;
+    mFMax = -DBL_MAX;
+    for (size_t i = 0; i < s.mData.size(); i++) {
+      double v = mFData[i];
+      if (!std::isnan(v)) {
+        if (v < mFMin) mFMin = v;
+        if (v > mFMax) mFMax = v;
+      }
+    }
+    //
+    //  Every saved sample missed the field so there is no range to take
+    //  from them. Drop them and let the view be sampled again when the
+    //  field comes in.
+    //
+    if (mFMin > mFMax) {
+      delete [] mFData;
+      mFData = nullptr;
+      return true;
     }
-    mLTex->InstallCMap(cm);
-    mLTex->InstallFMap(fm);
-    mLTex->InstallField(lData);
+  }
+  MakeTextures();
+  return true;
+}
+void FieldView::AttachField(EField* f)
+{
+  mField = f;
+  if (mValid && (nullptr == mTex) && (nullptr != mField)) {
+    ViewType(mType, mSpacing);
+  }
+}
+void FieldView::Describe(SessionView* s) const
+{
+  s->mCorners[0] = mFrame->TopLeft();
+  s->mCorners[1] = mFrame->TopRight();
+  s->mCorners[2] = mFrame->BottomRight();
+  s->mCorners[3] = mFrame->BottomLeft();
+  s->mLegend = (nullptr != mLegendFrame);
+  s->mComponent = mType;
+  s->mSpacing = mSpacing;
+  s->mFixRange = mFixRange;
+  s->mVMin = mFMin;
+  s->mVMax = mFMax;
+  s->mNAcross = (nullptr != mFData) ? mNAcross : 0;
+  s->mNDown = (nullptr != mFData) ? mNDown : 0;
+  s->mCheck = 0;
+}
+void FieldView::DropTextures(void)
+{
+  delete mTex;
+  mTex = nullptr;
+  mFData = nullptr;
+  if (nullptr != mLTex) {
+    delete mLTex;
+    mLTex = nullptr;
   }
 }
 
@@ -358,6 +324,13 @@ void FieldView::Draw()
     }
     mFrame->Draw();
     //
+    //  A view restored without samples has nothing to show until its
+    //  field arrives.
+    //
+    if (nullptr == mTex) {
+      return;
+    }
+    //
     //  Draw our textured rectangle.
     //
     /*    iprintf("Coloring field with texture %d\n", mTex->Name());
@@ -374,10 +347,15 @@ void FieldView::Draw()
      Call(glVertex3dv(mFrame->TopRight().mCoords));
      Call(glTexCoord2f(0.0f, 1.0f));
      Call(glVertex3dv(mFrame->TopLeft().mCoords)); */
+    //
+    //  While the view is being dragged about use the coarse proxy.
+    //
+    GLuint texName = mCanvas->IsInteracting() ? mTex->ProxyName()
+                                              : mTex->Name();
     Call(glPolygonOffset(1.0f, 1.0f));
     Call(glEnable(GL_TEXTURE_2D));
     Call(glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE));
-    Call(glBindTexture(GL_TEXTURE_2D, mTex->Name()));
+    Call(glBindTexture(GL_TEXTURE_2D, texName));
     glBegin(GL_QUADS);
     glTexCoord2f(0.0f, 0.0f); glVertex3dv(mFrame->BottomLeft().mCoords);
     glTexCoord2f(1.0f, 0.0f); glVertex3dv(mFrame->BottomRight().mCoords);
@@ -409,6 +387,20 @@ void FieldView::Draw()
   }
 }
 //
+//  The frame and the legend are both flat rectangles so their corners
+//  are all we need to test.
+//
+void FieldView::DrawCulled(const Frustum& f)
+{
+  if (!mValid) {
+    return;
+  }
+  if (f.Visible(*mFrame) ||
+      ((nullptr != mLegendFrame) && f.Visible(*mLegendFrame))) {
+    Draw();
+  }
+}
+//
 //  Override Update.
 //
 void FieldView::Update()
@@ -422,33 +414,13 @@ void FieldView::Update()
 //
 bool FieldView::WriteToFile(FILE* ofp)
 {
-  return false;
-}
-//
-//  Helper.
-//  Find the point of intersection of the plane defined by the point p
-//  & the normal vector v with the line segment defined by the ordered
-//  point pair p1 & p2. If the intersection is within the segment returns
-//  true and sets pi to the intersection point.
-//
-bool FieldView::Intersect(const Point3D& p, const Vector3D& n,
-                          const Point3D& p1, const Point3D& p2, Point3D& pi)
-{
-  Vector3D w = p1 - p;
-  Vector3D u = p2 - p1;
-  double angle = n.Dot(u);
-  if (angle == 0) {
-    return false;
-  }
-  float lambda = -n.Dot(w)/angle;
-  if (lambda < 0.0) {
+  if (!mValid) {
     return false;
   }
-  if (lambda > 1.0) {
-    return false;
-  }
-  pi = p1 + u * lambda;
-  return true;
+  SessionView s;
+  Describe(&s);
+  Session::WriteView(ofp, s, nullptr);
+  return !ferror(ofp);
 }
 //
 //  Display data as coloured points.
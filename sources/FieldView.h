@@ -10,6 +10,8 @@
 //  BCollett 3/18/14 Add planes explicitly parallel to z.
 //  BCollett 7/4/14 Now textures work. To get size info connect
 //  FieldView to Canvas.
+//  BCollett 10/19/26 Views can be saved in a session and put back from
+//  it, with or without their samples.
 //  Copyright (c) 2014 Brian Collett. All rights reserved.
 //
 
@@ -23,6 +25,7 @@
 #include "GLViewerCanvas.h"
 #include "EField.h"
 #include "FieldTexture.h"
+#include "Session.h"
 
 class FieldView : public Listable, public GeometryObject {
 public:
@@ -59,6 +62,11 @@ public:
   Point3D* mPData;
   int mNAcross, mNDown;
   //
+  //  What ViewType was last asked for, so we can sample again.
+  //
+  int mType;
+  double mSpacing;
+  //
   //  ctors
   //
   FieldView(GLViewerCanvas* theCanvas, EField* f, FieldViewerDoc* d);
@@ -80,6 +88,31 @@ public:
   //
   void ViewType(int type, double spacing);
   //
+  //  Sample again at whatever size the canvas now wants, keeping the
+  //  data range so that the colours do not change.
+  //
+  void Resample(void);
+  //
+  //  Show a different field, usually the same one read in again, on the
+  //  same plane. Unless the range was fixed it is found afresh.
+  //
+  void SetField(EField* f);
+  //
+  //  Put back a view saved in a session. One with samples is ready to
+  //  draw straight away and needs no field. Returns false if the saved
+  //  corners are no use.
+  //
+  bool Restore(const SessionView& s);
+  //
+  //  Give a restored view its field. It keeps any samples it came with
+  //  and only samples now if it has none.
+  //
+  void AttachField(EField* f);
+  //
+  //  Fill in a SessionView for this view, all but the samples.
+  //
+  void Describe(SessionView* s) const;
+  //
   //  This allows the viewer to set the data range instead of inferring
   //  it.
   //
@@ -89,18 +122,24 @@ public:
 	//
 	virtual void Draw();
   //
+  //  Skip drawing when neither the view nor its legend is on screen.
+  //
+  virtual void DrawCulled(const Frustum& f);
+  //
   //  Override Update.
   //
   virtual void Update();
   //
-  //  All geometries must override WriteToFile.
+  //  All geometries must override WriteToFile. Ours writes the lines
+  //  that put the view back in a session, without the samples.
   //
   bool WriteToFile(FILE* ofp);
+protected:
   //
-  //  Helper.
+  //  Helpers.
   //
-  bool Intersect(const Point3D&, const Vector3D&,
-                 const Point3D&, const Point3D&, Point3D&);
+  void DropTextures(void);
+  void MakeTextures(void);
 };
 
 #endif /* defined(__FieldViewer__FieldView__) */
@@ -9,6 +9,7 @@
  *  documents.
  *
  *  Created by Brian Collett on 2/18/14.
+ *  BCollett 10/19/26 Open session files as well as models.
  *
  */
 
@@ -50,6 +51,15 @@ bool FieldViewerApp::OnInit(void)
                            _T("Model Doc"), _T("Model View"),
                            CLASSINFO(FieldViewerDoc),
                            CLASSINFO(GLViewerView));
+  //
+  //  A session opens its model and puts the views back, see Session.h.
+  //
+  (void) new wxDocTemplate(mDocManager,
+                           _T("Session"), _T("*.fvs"),
+                           _T(""), _T("fvs"),
+                           _T("Session Doc"), _T("Model View"),
+                           CLASSINFO(FieldViewerDoc),
+                           CLASSINFO(GLViewerView));
   
   //// Create the main frame window
   mFrame = new wxDocParentFrame((wxDocManager *) mDocManager,
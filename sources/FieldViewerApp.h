@@ -66,6 +66,9 @@ enum {
   bcID_TOOL_DOLLY,
   bcID_TOOL_ZOOM,
   bcID_TOOL_REGION,
+  bcID_TOOL_PROFILE,
+  bcID_TOOL_PROFLOG,
+  bcID_FILE_EXPORT,
   bcID_VIEW_HEDGEHOG,
   bcID_VIEW_ELINES,
   bcID_STATUS_BAR,
@@ -75,6 +78,7 @@ enum {
   bcID_TLISTVIEW,
   bcID_FILE_LOAD3D,
   bcID_FILE_LOAD2D,
+  bcID_FILE_SESSION,
   bcID_FIELD_SELPLANE,
   bcID_FIELD_SELPLANEZ,
   bcID_FIELD_DELETE,
@@ -83,6 +87,12 @@ enum {
   bcID_FIELD_R1,
   bcID_FIELD_R2,
   bcID_FIELD_R3,
+  bcID_FIELD_VOLUME,
+  bcID_FIELD_PROBE,
+  bcID_PROBE_SAVE,
+  bcID_HOVER_TIMER,
+  bcID_FRAME_TIMER,
+  bcID_WATCH_TIMER,
   bcID_CHOOSE_PLANE,
   bcID_CHOOSE_PLANEZ,
   bcID_PX,
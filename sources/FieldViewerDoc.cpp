@@ -11,6 +11,11 @@
  *  of the field.
  *  BCollett 7/17/14 Add support for Pointer click handling through the
  *  Pointer3D class.
+ *  BCollett 10/19/26 Watch the model and field files and read them in
+ *  again when they are rewritten.
+ *  BCollett 10/19/26 Read the model on a thread and show it as it comes.
+ *  BCollett 10/19/26 Save the camera and field views as a session and
+ *  put them back, from their samples if saved, when it is opened.
  *
  */
 
@@ -25,6 +30,8 @@
 #include "wx/wx.h"
 #include "wx/filename.h"
 #include "wx/filefn.h"
+#include "wx/choicdlg.h"
+#include "wx/numdlg.h"
 
 
 #endif
@@ -40,6 +47,7 @@
 #endif
 
 #include <stdio.h>
+#include <algorithm>
 
 #include "FieldViewerDoc.h"
 #include "GLViewerView.h"
@@ -50,9 +58,15 @@
 #include "Dialogs/ChoosePlaneDlg.h"
 #include "Dialogs/ChoosePZPlane.h"
 #include "GLAList.h"
+#include "GLACache.h"
 #include "CD3DField.h"
 #include "FieldView.h"
+#include "VolumeView.h"
+#include "LineProbe.h"
+#include "ProbeFrame.h"
 #include "ReadField.h"
+#include "Profiler.h"
+#include "FieldSlice.h"
 
 
 IMPLEMENT_DYNAMIC_CLASS(FieldViewerDoc, wxDocument)
@@ -62,6 +76,7 @@ IMPLEMENT_DYNAMIC_CLASS(FieldViewerDoc, wxDocument)
 //
 BEGIN_EVENT_TABLE(FieldViewerDoc, wxDocument)
 EVT_MENU(bcID_FILE_LOAD3D, FieldViewerDoc::OnMenuFileLoad3D)
+EVT_MENU(bcID_FILE_SESSION, FieldViewerDoc::OnMenuFileSession)
 EVT_MENU(bcID_FIELD_SELPLANE, FieldViewerDoc::OnMenuChoosePlane)
 EVT_MENU(bcID_FIELD_SELPLANEZ, FieldViewerDoc::OnMenuChoosePlaneZ)
 EVT_MENU(bcID_FIELD_DELETE, FieldViewerDoc::OnMenuFieldDelete)
@@ -70,6 +85,9 @@ EVT_MENU(bcID_FIELD_LOG, FieldViewerDoc::OnMenuFieldLog)
 EVT_MENU(bcID_FIELD_R1, FieldViewerDoc::OnMenuFieldR1)
 EVT_MENU(bcID_FIELD_R2, FieldViewerDoc::OnMenuFieldR2)
 EVT_MENU(bcID_FIELD_R3, FieldViewerDoc::OnMenuFieldR3)
+EVT_MENU(bcID_FIELD_VOLUME, FieldViewerDoc::OnMenuFieldVolume)
+EVT_MENU(bcID_FIELD_PROBE, FieldViewerDoc::OnMenuFieldProbe)
+EVT_TIMER(bcID_WATCH_TIMER, FieldViewerDoc::OnWatchTimer)
 END_EVENT_TABLE()
 
 //
@@ -88,14 +106,33 @@ FieldViewerDoc::FieldViewerDoc(void)
   mFViewEnd.mPrev = &mFViewBase;
   mFViewEnd.mNext = nullptr;
   mCurrentField = nullptr;
+  mVolume = nullptr;
+  mProbing = false;
+  mHaveProbeStart = false;
   mFieldMenu = nullptr;
   mLinearTransform = true;
   mRainbowLevel = 1;
+  mLoad = nullptr;
+  mLoadSize = 0.0;
+  mLoadMoves = 0;
+  mLoadTimed = false;
+  mSession = nullptr;
+  mWatchTimer.SetOwner(this, bcID_WATCH_TIMER);
 }
 FieldViewerDoc::~FieldViewerDoc(void)
 {
   Listable* next = nullptr;
+  mWatchTimer.Stop();
+  if (nullptr != mLoad) {
+    mLoadThread.join();
+    delete mLoad->mList;
+    delete mLoad->mData;
+    delete mLoad->mGrids;
+    delete mLoad;
+  }
   if (mList) delete mList;
+  if (mSession) delete mSession;
+  if (mVolume) delete mVolume;
   for (Listable* f = mFieldBase.mNext; f != &mFieldEnd; f = next) {
     next = f->mNext;
     delete f;
@@ -114,7 +151,7 @@ bool FieldViewerDoc::DoSaveDocument(const wxString& filename)
 {
 //    FieldViewerView *view = (FieldViewerView *)GetFirstView();
 //    return view->textsw->SaveFile(filename);
-  return true;
+  return SaveSession(filename.ToStdString(), true);
 }
 
 bool FieldViewerDoc::DoOpenDocument(const wxString& filename)
@@ -135,37 +172,34 @@ bool FieldViewerDoc::DoOpenDocument(const wxString& filename)
   //
   FILE* ifp = fopen(fullPath.GetFullName(), "rt");
  */
-  FILE* ifp = fopen(filename, "rt");
-  if (ifp == nullptr) {
-    return false;
-  }
-  //
-  //	Create a TextScanner to analyse the file.
-  //
-  CTextScanner scan(ifp);
-  //
-  //	Pass that to the display list. It will read the
-  //	file and create the OpenGL display list from the
-  //	contents of the file.
-  //
-  mList = new CGLAList(&scan);
-  mList->Create();
   //
-  //  Create will stop when it hits an end directive. The rest of
-  //  the file should contain a description of a nested set of fields.
+  //  A session names the model to open and brings the views with it.
   //
-  CD3Data* fData = new CD3Data();
-  if (ParseFieldSet(fData, ifp)) {
-    CD3DField* f = new CD3DField(fData);
-    mFieldBase.Append(f);
-    mModelView->FocusOn(f->GetBounds(), false);
-    UpdateAllViews();
-  } else {
-    wxLogMessage("Attempt to load model fields failed.");
-    fclose(ifp);
+  std::string path = filename.ToStdString();
+  if (Session::IsSession(path.c_str())) {
+    mSession = new Session();
+    if (!mSession->Read(path.c_str())) {
+      delete mSession;
+      mSession = nullptr;
+      return false;
+    }
+    path = mSession->mModel;
+  }
+  FILE* ifp = fopen(path.c_str(), "rt");
+  if (ifp == nullptr) {
+    if (nullptr != mSession) {
+      eprintf("%s: unable to open the session's model.\n", path.c_str());
+    }
     return false;
   }
   fclose(ifp);
+  mModelPath = path;
+  //
+  //  The model is read on the load thread. mList starts empty and the
+  //  batches are added to it as they are parsed, see ShowLoad.
+  //
+  mList = new CGLAList();
+  StartLoad(path, true, true);
   //
   //  At this point we can be certain that the frame exists. Create
   //  a field menu an install it.
@@ -174,6 +208,10 @@ bool FieldViewerDoc::DoOpenDocument(const wxString& filename)
   mFieldMenu->Append(bcID_FIELD_SELPLANE, wxT("Plot &field\tCtrl-F"));
   mFieldMenu->Append(bcID_FIELD_SELPLANEZ, wxT("Plot &Z plane\tCtrl-Z"));
   mFieldMenu->Append(bcID_FIELD_DELETE, wxT("Delete field\tCtrl-X"));
+  mFieldMenu->AppendCheckItem(bcID_FIELD_VOLUME, wxT("&Volume render\tCtrl-U"));
+  mFieldMenu->Check(bcID_FIELD_VOLUME, false);
+  mFieldMenu->AppendCheckItem(bcID_FIELD_PROBE, wxT("Line &probe\tCtrl-P"));
+  mFieldMenu->Check(bcID_FIELD_PROBE, false);
   mFieldMenu->AppendSeparator();
 //  mFieldMenu->AppendRadioItem(bcID_FIELD_LINEAR, wxT("L&inear map\tCtrl-I"));
 //  mFieldMenu->AppendRadioItem(bcID_FIELD_LOG, wxT("L&og map\tCtrl-G"));
@@ -186,35 +224,54 @@ bool FieldViewerDoc::DoOpenDocument(const wxString& filename)
   mFieldMenu->AppendRadioItem(bcID_FIELD_R2, wxT("Rainbow\tCtrl-B"));
   mFieldMenu->AppendRadioItem(bcID_FIELD_R3, wxT("Grey map\tCtrl-D"));
   mModelView->mFrame->InsertMenu(mFieldMenu, wxT("Field"),2);
+  if (nullptr != mSession) {
+    RestoreSession();
+  }
   return true;
 }
 //
 //  Load3DField is given a filename and tries to read that file in as
 //  a 3D field.
 //  Modified 3/13/14 to build from a binary file not a text file.
+//  A grid file, see GridFile.h, is read as a GridField instead.
 //
 bool FieldViewerDoc::Load3DField(const char* filename)
 {
-  CD3Data* fData = new CD3Data();
-  FILE* ifp = fopen(filename, "rb");
-  if (nullptr == ifp) {
-    wxLogMessage("Failed to open file.");
-    return false;
-  }
-  bool success = CD3ReadBinary(fData, ifp);
-  if (!success) {
-    wxLogMessage("CD3ReadBinary failed.");
-    return false;
+  ProfScope prof(kProfLoadField);
+  EField* f = nullptr;
+  if (GridFile::IsGridFile(filename)) {
+    GridField* g = GridField::Read(filename);
+    if (nullptr == g) {
+      wxLogMessage("Failed to read grid file.");
+      return false;
+    }
+    if (g->IsPacked()) {
+      g->Report();
+    }
+    f = g;
+  } else {
+    CD3Data* fData = new CD3Data();
+    FILE* ifp = fopen(filename, "rb");
+    if (nullptr == ifp) {
+      wxLogMessage("Failed to open file.");
+      return false;
+    }
+    bool success = CD3ReadBinary(fData, ifp);
+    if (!success) {
+      wxLogMessage("CD3ReadBinary failed.");
+      return false;
+    }
+    fclose(ifp);
+    //
+    //  So we have the field data. Build the bounding box and
+    //  package it all up as a CD3DField.
+    //
+    f = new CD3DField(fData);
   }
-  fclose(ifp);
-  //
-  //  So we have the field data. Build the bounding box and
-  //  package it all up as a GridField.
-  //
-  CD3DField* f = new CD3DField(fData);
   mFieldBase.Append(f);
   UpdateAllViews();
   mModelView->mFrame->EnableFileItem(bcID_FIELD_SELPLANE, true);
+  WatchFile(filename, f, false);
   return true;
 }
 //
@@ -230,29 +287,58 @@ bool FieldViewerDoc::Load2DField(const char* filename)
 //
 void FieldViewerDoc::Render(bool picking)
 {
-  GLuint viewNum = 0;
+  ProfScope prof(kProfRender);
   Listable* l;
   EField* f = nullptr;
   FieldView* v = nullptr;
+  //
+  //  Everything is culled against the camera of this paint. Until the
+  //  canvas has one the frustum is unset and lets everything through.
+  //  While the view is being dragged a big model is just outlined.
+  //
+  Frustum frustum;
+  double focalPixels = 0.0;
+  bool interacting = false;
+  if ((nullptr != mModelView) && (nullptr != mModelView->mGLWind)) {
+    GLdouble mv[16], proj[16];
+    GLint vp[4];
+    if (mModelView->mGLWind->GetCamera(mv, proj, vp)) {
+      frustum.Set(mv, proj);
+    }
+    focalPixels = mModelView->mGLWind->FocalPixels();
+    interacting = mModelView->mGLWind->IsInteracting();
+  }
   if (!picking) {
     if (mList != nullptr) {
-      mList->CallList();
+      ProfScope profModel(kProfModel, true);
+      if (interacting && (mList->GetNPrim() > kGLAProxyPrims)) {
+        mList->DrawProxy(&frustum);
+      } else {
+        mList->Draw(focalPixels, &frustum);
+      }
     }
     for (l = mFieldBase.mNext; l != &mFieldEnd; l = l->mNext) {
       if (nullptr != (f = dynamic_cast<EField*>(l))) {
-        f->GetBounds()->Draw();
+        if (frustum.Visible(*f->GetBounds())) {
+          f->GetBounds()->Draw();
+        }
       }
     }
   }
+  gProfiler.Begin(kProfFieldViews, true);
   for (l = mFViewBase.mNext; l != &mFViewEnd; l = l->mNext) {
     if (nullptr != (v = dynamic_cast<FieldView*>(l))) {
-      if (picking) {
-        iprintf("View %d\n",viewNum);
-        glLoadName(viewNum++);
-      }
-      v->Draw();
+      v->DrawCulled(frustum);
     }
   }
+  gProfiler.End(kProfFieldViews);
+  //
+  //  The volume goes last because it is pasted over everything else.
+  //
+  if (!picking && (nullptr != mVolume)) {
+    ProfScope profVolume(kProfVolume, true);
+    mVolume->Draw();
+  }
 }
 //
 //  Since FieldViewer can only LOOK AT fields and models
@@ -278,7 +364,7 @@ void FieldViewerDoc::OnMenuFileLoad3D(wxCommandEvent& WXUNUSED(event))
                               _("Load binary field file"),
                               "",
                               "",
-                              "COMSOL files (*.bin)|*.bin",
+                              "Field files (*.bin;*.fvg)|*.bin;*.fvg",
                               wxFD_OPEN|wxFD_FILE_MUST_EXIST);
   if (openFileDialog.ShowModal() == wxID_CANCEL) {
     return;     // the user changed their mind...
@@ -309,6 +395,74 @@ void FieldViewerDoc::OnMenuFileLoad2D(wxCommandEvent& WXUNUSED(event))
   }
 }
 //
+//  OnMenuFileSession saves the camera and the field views as a session.
+//  Keeping the samples makes the file bigger but lets the views show
+//  at once when it is opened, without going back to the field.
+//
+void FieldViewerDoc::OnMenuFileSession(wxCommandEvent& WXUNUSED(event))
+{
+  wxFileDialog saveFileDialog(mModelView->mFrame, _("Save session"), "",
+                              "session.fvs", "Session files (*.fvs)|*.fvs",
+                              wxFD_SAVE|wxFD_OVERWRITE_PROMPT);
+  if (saveFileDialog.ShowModal() == wxID_CANCEL) {
+    return;
+  }
+  int keep = wxMessageBox(wxT("Keep the sampled field in the session so that "
+                              "the views\nopen without sampling it again?"),
+                          wxT("Save session"), wxYES_NO | wxICON_QUESTION,
+                          mModelView->mFrame);
+  wxBusyCursor wait;
+  if (!SaveSession(saveFileDialog.GetPath().ToStdString(), keep == wxYES)) {
+    wxMessageBox(wxT("Unable to save the session."));
+  }
+}
+//
+//  The model and the fields added to it go in the order they were
+//  read, so that the first field is the same one when it is opened.
+//  We will only write over a file that is already a session.
+//
+bool FieldViewerDoc::SaveSession(const std::string& path, bool samples)
+{
+  FILE* fp = fopen(path.c_str(), "rb");
+  if (nullptr != fp) {
+    fclose(fp);
+    if (!Session::IsSession(path.c_str())) {
+      eprintf("%s: not a session, leaving it alone.\n", path.c_str());
+      return false;
+    }
+  }
+  Session s;
+  s.mModel = mModelPath;
+  for (size_t i = 0; i < mSources.size(); i++) {
+    if (!mSources[i].mModel) {
+      s.mFields.push_back(mSources[i].mPath);
+    }
+  }
+  if (nullptr != mSession) {
+    s.mFields = mSession->mFields;      // not read in yet
+  }
+  mModelView->mGLWind->GetView(&s.mCamera);
+  s.mHaveCamera = true;
+  s.mColours = (3 == mRainbowLevel) ? kSliceGrey : mRainbowLevel;
+  s.mLinear = mLinearTransform;
+  std::vector<const double*> data;
+  for (Listable* l = mFViewBase.mNext; l != &mFViewEnd; l = l->mNext) {
+    FieldView* v = dynamic_cast<FieldView*>(l);
+    if ((nullptr == v) || !v->mValid) {
+      continue;
+    }
+    SessionView sv;
+    v->Describe(&sv);
+    s.mViews.push_back(sv);
+    data.push_back((samples && (nullptr != v->mFData)) ? v->mFData : nullptr);
+  }
+  if (!s.Write(path.c_str(), data)) {
+    return false;
+  }
+  iprintf("Saved %d views to %s\n", (int) s.mViews.size(), path.c_str());
+  return true;
+}
+//
 //  OnChoosePlane allows the user to select a plane on which to render a
 //  a field.
 //
@@ -318,19 +472,24 @@ void FieldViewerDoc::OnMenuChoosePlane(wxCommandEvent& event)
   Vector3D v;
   int type;
   double spacing;
+  EField* f = dynamic_cast<EField*>(mFieldBase.mNext);
+  if (nullptr == f) {
+    wxMessageBox(wxT("There is no field to plot yet."));
+    return;
+  }
   //
   //	Extract the data from the dialog.
   //
   if (GetPlaneInfo(&p, &v, &type, &spacing)) {
     v.Normalize();
-    FieldView* fv = new FieldView(mModelView->mGLWind,
-                                  dynamic_cast<EField*>(mFieldBase.mNext),
+    FieldView* fv = new FieldView(mModelView->mGLWind, f,
                                   dynamic_cast<FieldViewerDoc*>(this));
 
     SelectField(fv);
     if (fv->ViewPlane(p, v) == 0) {
       fv->ViewType(type, spacing);
       mFViewBase.Append(fv);
+      IndexViews();
       UpdateAllViews();
     } else {
       wxMessageBox(wxT("Plane does not intersect bounds of field."));
@@ -343,6 +502,11 @@ void FieldViewerDoc::OnMenuChoosePlane(wxCommandEvent& event)
 //
 void FieldViewerDoc::OnMenuChoosePlaneZ(wxCommandEvent& WXUNUSED(event))
 {
+  EField* f = dynamic_cast<EField*>(mFieldBase.mNext);
+  if (nullptr == f) {
+    wxMessageBox(wxT("There is no field to plot yet."));
+    return;
+  }
 	ChoosePZPlaneDlg theDlg(mModelView->mFrame,
                           bcID_CHOOSE_PLANEZ,
                           wxT("Choose a plane section to plot"));
@@ -357,9 +521,7 @@ void FieldViewerDoc::OnMenuChoosePlaneZ(wxCommandEvent& WXUNUSED(event))
     double angle = theDlg.GetAngle();
     double zMin = theDlg.GetMinZ();
     double zMax = theDlg.GetMaxZ();
-    FieldView* fv = new FieldView(mModelView->mGLWind,
-                                  dynamic_cast<EField*>(mFieldBase.mNext),
-                                  this);
+    FieldView* fv = new FieldView(mModelView->mGLWind, f, this);
     SelectField(fv);
     if (theDlg.GetFixRange()) {
       fv->SetDataRange(theDlg.GetMinV(), theDlg.GetMaxV());
@@ -370,6 +532,7 @@ void FieldViewerDoc::OnMenuChoosePlaneZ(wxCommandEvent& WXUNUSED(event))
       iprintf("Spacing = %f\n", spacing);
       fv->ViewType(type, spacing);
       mFViewBase.Append(fv);
+      IndexViews();
       UpdateAllViews();
     } else {
       wxMessageBox(wxT("Plane does not intersect bounds of field."));
@@ -382,6 +545,7 @@ void FieldViewerDoc::OnMenuFieldDelete(wxCommandEvent& WXUNUSED(event))
     mCurrentField->Delete();
     delete mCurrentField;
     mCurrentField = nullptr;
+    IndexViews();
   }
   UpdateAllViews();
 }
@@ -426,6 +590,59 @@ void FieldViewerDoc::OnMenuFieldR3(wxCommandEvent& WXUNUSED(event))
   UpdateAllViews();
 }
 
+//
+//  Toggle the volume rendering. When turning it on we ask which
+//  quantity to show, using the same list as the plane dialogs.
+//
+void FieldViewerDoc::OnMenuFieldVolume(wxCommandEvent& WXUNUSED(event))
+{
+  if (nullptr != mVolume) {
+    delete mVolume;
+    mVolume = nullptr;
+    mFieldMenu->Check(bcID_FIELD_VOLUME, false);
+    UpdateAllViews();
+    return;
+  }
+  EField* f = dynamic_cast<EField*>(mFieldBase.mNext);
+  if (nullptr == f) {
+    mFieldMenu->Check(bcID_FIELD_VOLUME, false);
+    return;
+  }
+  wxString choices[5] = { wxT("Ex"), wxT("Ey"), wxT("Ez"),
+                          wxT("Radial"), wxT("|E|") };
+  int type = wxGetSingleChoiceIndex(wxT("Quantity to render"),
+                                    wxT("Volume render"),
+                                    5, choices, mModelView->mFrame);
+  if (type < 0) {
+    mFieldMenu->Check(bcID_FIELD_VOLUME, false);
+    return;
+  }
+  wxBusyCursor wait;
+  VolumeView* vv = new VolumeView(mModelView->mGLWind, f, this);
+  if (!vv->ViewType(type)) {
+    delete vv;
+    mFieldMenu->Check(bcID_FIELD_VOLUME, false);
+    wxMessageBox(wxT("Field has no values to render."));
+    return;
+  }
+  mVolume = vv;
+  mFieldMenu->Check(bcID_FIELD_VOLUME, true);
+  UpdateAllViews();
+}
+//
+//  Toggle line probing. While it is on, clicks on field planes pick
+//  the ends of the probe instead of just reporting the field.
+//
+void FieldViewerDoc::OnMenuFieldProbe(wxCommandEvent& WXUNUSED(event))
+{
+  mProbing = !mProbing;
+  mHaveProbeStart = false;
+  mFieldMenu->Check(bcID_FIELD_PROBE, mProbing);
+  if (mProbing) {
+    iprintf("Line probe: click the start point on a field plane.\n");
+  }
+}
+
 //
 //  These are dialog helpers. They run dialogs and extract their imformation
 //  so that the main dialog method can do its work _after_ the dialog box
@@ -473,22 +690,36 @@ Listable* FieldViewerDoc::SelectField(Listable* nextCurrent)
 }
 
 //
-//  Private helper for DoClick. It is given a view number and
-//  translates it to the corresponding Listable.
+//  Rebuild the view index and the picker over the view frames. View
+//  numbers start at 1 so that 0 can mean "not a view".
 //
-Listable* FieldViewerDoc::FindView(int num)
+void FieldViewerDoc::IndexViews(void)
 {
-  //
-  //  For each name we have to walk the list of views to
-  //  translate the name into a View*.
-  //
+  mViewIndex.clear();
+  mViewNames.clear();
+  mViewPicker.Clear();
   int viewNum = 1;
   for (Listable* l = mFViewBase.mNext; l != &mFViewEnd; l = l->mNext) {
-    if (viewNum++ == num) {
-      return l;
+    mViewIndex.push_back(l);
+    mViewNames[l] = viewNum;
+    FieldView* v = dynamic_cast<FieldView*>(l);
+    if ((nullptr != v) && (nullptr != v->mFrame)) {
+      mViewPicker.AddRect(v->mFrame, viewNum);
     }
+    viewNum++;
   }
-  return nullptr;
+  mViewPicker.Build();
+}
+//
+//  Private helper for DoClick. It is given a view number and
+//  translates it to the corresponding Listable.
+//
+Listable* FieldViewerDoc::FindView(int num)
+{
+  if ((num < 1) || (num > (int) mViewIndex.size())) {
+    return nullptr;
+  }
+  return mViewIndex[num - 1];
 }
 //
 //  This one does the opposite. It finds the number given the
@@ -496,37 +727,53 @@ Listable* FieldViewerDoc::FindView(int num)
 //
 int FieldViewerDoc::FindViewName(Listable* target)
 {
-  int viewNum = 1;
   if (target == nullptr) return 0;
-  for (Listable* l = mFViewBase.mNext; l != &mFViewEnd; l = l->mNext) {
-    if (l == target) {
-      return viewNum;
-    }
-    viewNum++;
-  }
-  return 0;
+  std::unordered_map<const Listable*, int>::const_iterator it =
+    mViewNames.find(target);
+  return (it == mViewNames.end()) ? 0 : it->second;
 }
 //
 //  Handler for clicks in the 3D view.
 //
-void FieldViewerDoc::DoClick(GLuint names[], Point3D start, Point3D end)
+void FieldViewerDoc::DoClick(Point3D start, Point3D end)
 {
+  ProfScope prof(kProfPick);
+  //
+  //  First we have to worry about what has been clicked. The hits come
+  //  back nearest first. Report the nearest piece of the model, if any.
+  //
+  std::vector<PickHit> hits;
+  if ((nullptr != mList) && (mList->GetPicker()->Pick(start, end, hits) > 0)) {
+    iprintf("Model hit at %f,%f,%f (line %d)\n", hits[0].mPoint.mX,
+            hits[0].mPoint.mY, hits[0].mPoint.mZ, hits[0].mID);
+  }
+  hits.clear();
+  mViewPicker.Pick(start, end, hits);
   //
-  //  First we have to worry about what has been clicked.
-  //  We should only have been called if _something_ was hit.
   //  If the current selection is not in the list then we select
-  //  the first item on the list.
+  //  the nearest view under the click.
   //
   int selName = FindViewName(mCurrentField);
   if (selName == 0) { // No sel or not in list
-    Listable* newSel = FindView(names[1]);
-    SelectField(newSel);
+    if (hits.empty()) return;
+    selName = hits[0].mID;
+    SelectField(FindView(selName));
   }
   FieldView* view = (FieldView*) mCurrentField;
   if (nullptr == view) return;
   //
-  //  Right, now we find the intersection of the selected view with the
-  //  the click line.
+  //  If the line crossed the selected view we already have the exact
+  //  point.
+  //
+  for (size_t i = 0; i < hits.size(); i++) {
+    if (hits[i].mID == selName) {
+      ClickAt(view, hits[i].mPoint);
+      return;
+    }
+  }
+  //
+  //  Otherwise we find the intersection of the plane of the selected
+  //  view with the the click line.
   //  Start by the vector u that points along the line and the vector
   //  w that points from the min corner of the plane to the start of the line.
   //
@@ -548,10 +795,476 @@ void FieldViewerDoc::DoClick(GLuint names[], Point3D start, Point3D end)
   }
   Real lambda = N/D;
   Point3D ip =  start + u * lambda;
+  ClickAt(view, ip);
+}
+//
+//  Private helper for DoClick. Report the field at a point on a view
+//  and pass it on to the probe if we are probing.
+//
+void FieldViewerDoc::ClickAt(FieldView* view, const Point3D& ip)
+{
+  if (nullptr == view->mField) {
+    iprintf("The field for this view is still being read.\n");
+    return;
+  }
   const char* name = view->mField->FieldNameAt(ip);
   iprintf("Click at %f,%f,%f in field \n%s\n", ip.mX, ip.mY,ip.mZ, name);
   Vector3D E = view->mField->FieldAt(ip);
   iprintf("E = %f,%f,%f\n", E.mX, E.mY, E.mZ);
-  
+  if (mProbing) {
+    ProbeClick(view->mField, ip);
+  }
+}
+//
+//  Hover readout. The view picker gives us the nearest view frame under
+//  the mouse and we report the field there.
+//
+bool FieldViewerDoc::Hover(const Point3D& start, const Point3D& end,
+                           char* buff, int len)
+{
+  ProfScope prof(kProfHover);
+  std::vector<PickHit> hits;
+  if (mViewPicker.Pick(start, end, hits) == 0) {
+    return false;
+  }
+  FieldView* best = dynamic_cast<FieldView*>(FindView(hits[0].mID));
+  if ((nullptr == best) || (nullptr == best->mField)) {
+    return false;
+  }
+  const Point3D& ip = hits[0].mPoint;
+  double p[3] = { ip.mX, ip.mY, ip.mZ };
+  double E[3];
+  best->mField->FieldAtPoints(1, p, E);
+  snprintf(buff, len, "(%.4g, %.4g, %.4g)  E = (%.4g, %.4g, %.4g)  |E| = %.4g  %s",
+           p[0], p[1], p[2], E[0], E[1], E[2],
+           sqrt(E[0] * E[0] + E[1] * E[1] + E[2] * E[2]),
+           best->mField->FieldNameAt(ip));
+  return true;
+}
+//
+//  The canvas has changed size under us, usually for an export. Every
+//  field view samples itself again to suit.
+//
+void FieldViewerDoc::Resample(void)
+{
+  Listable* l;
+  FieldView* v;
+  for (l = mFViewBase.mNext; l != &mFViewEnd; l = l->mNext) {
+    if (nullptr != (v = dynamic_cast<FieldView*>(l))) {
+      v->Resample();
+    }
+  }
+}
+//
+//  Private helper for DoClick when probing. The first point is just
+//  remembered. The second completes the probe, samples it and opens
+//  a plot window that takes ownership of the probe.
+//
+void FieldViewerDoc::ProbeClick(EField* f, const Point3D& ip)
+{
+  if (!mHaveProbeStart) {
+    mProbeStart = ip;
+    mHaveProbeStart = true;
+    iprintf("Line probe: click the end point.\n");
+    return;
+  }
+  mHaveProbeStart = false;
+  long n = wxGetNumberFromUser(wxT("Number of points along the probe"),
+                               wxT("Samples"), wxT("Line probe"),
+                               kLPDefaultSamples, 2, 100000,
+                               mModelView->mFrame);
+  if (n < 0) {
+    return;
+  }
+  LineProbe* probe = new LineProbe(f, mProbeStart, ip, (int) n);
+  if (!probe->Sample()) {
+    delete probe;
+    wxMessageBox(wxT("Probe does not pass through the field."));
+    return;
+  }
+  ProbeFrame* pf = new ProbeFrame(mModelView->mFrame, probe);
+  pf->Show(true);
 }
 
+//
+//  Loading and live reload.
+//  WatchFile remembers where a field came from and starts watching it.
+//
+void FieldViewerDoc::WatchFile(const char* path, EField* f, bool model)
+{
+  FieldSource source = { path, f, model };
+  mSources.push_back(source);
+  mWatcher.Watch(path);
+  if (!mWatchTimer.IsRunning()) {
+    mWatchTimer.Start(kWatchInterval);
+  }
+}
+//
+//  Every tick we show what has been loaded, take in a finished load,
+//  note the files that have changed since the last tick and start on
+//  the next, if we are free. mDone is read before ShowLoad looks at
+//  mGeometryDone, which the load thread sets first, so a load that we
+//  finish has always been merged.
+//
+void FieldViewerDoc::OnWatchTimer(wxTimerEvent& WXUNUSED(event))
+{
+  if (nullptr != mLoad) {
+    bool done = mLoad->mDone;
+    if (mLoad->mOpening) {
+      ShowLoad();
+    }
+    if (done) {
+      FinishLoad();
+    }
+  }
+  std::vector<std::string> changed;
+  mWatcher.Poll(changed);
+  for (size_t i = 0; i < changed.size(); i++) {
+    if (std::find(mLoadQueue.begin(), mLoadQueue.end(), changed[i]) ==
+        mLoadQueue.end()) {
+      mLoadQueue.push_back(changed[i]);
+    }
+  }
+  if ((nullptr == mLoad) && !mLoadQueue.empty()) {
+    std::string path = mLoadQueue.front();
+    mLoadQueue.erase(mLoadQueue.begin());
+    StartReload(path);
+  }
+}
+//
+//  Start reading a file on the load thread. Only a model file has
+//  geometry, and only when opening do we show it before it is done.
+//
+void FieldViewerDoc::StartLoad(const std::string& path, bool model,
+                               bool opening)
+{
+  mLoad = new Load;
+  mLoad->mPath = path;
+  mLoad->mModel = model;
+  mLoad->mOpening = opening;
+  mLoad->mList = nullptr;
+  if (model) {
+    mLoad->mList = new CGLAList();
+    mLoad->mList->HoldMessages(true);
+    if (opening) {
+      mLoad->mList->StreamTo(&mLoad->mStream);
+    }
+  }
+  mLoad->mData = new CD3Data();
+  mLoad->mGrids = nullptr;
+  mLoad->mEnd = 0;
+  mLoad->mStamp[0] = mLoad->mStamp[1] = mLoad->mStamp[2] = -1;
+  mLoad->mCached = false;
+  mLoad->mMerged = false;
+  mLoad->mOK = false;
+  mLoad->mGeometryDone = false;
+  mLoad->mDone = false;
+  if (opening) {
+    mLoadBounds.Clear();
+    wxULongLong size = wxFileName::GetSize(path);
+    mLoadSize = (size == wxInvalidSize) ? 0.0 : size.ToDouble();
+    mLoadMoves = mModelView->mGLWind->GetMoves();
+  }
+  mLoadTimed = model && gProfiler.IsEnabled();
+  if (mLoadTimed) {
+    gProfiler.Begin(kProfLoadModel);
+  }
+  mLoadThread = std::thread(RunLoad, mLoad);
+  mWatchTimer.Start(opening ? kLoadInterval : kWatchInterval);
+}
+void FieldViewerDoc::StartReload(const std::string& path)
+{
+  for (size_t i = 0; i < mSources.size(); i++) {
+    if (mSources[i].mPath == path) {
+      iprintf("Reloading %s\n", path.c_str());
+      StartLoad(path, mSources[i].mModel, false);
+      return;
+    }
+  }
+}
+//
+//  The load thread. Nothing here may go to the log: the list holds its
+//  parse messages until ShowLoad or FinishLoad flushes them, and a grid
+//  file's complaint comes back in mWhy. ParseFieldSet and CD3ReadBinary
+//  belong to the COMSOL reader, outside this tree, and what they print
+//  is up to them; we only report their failures, from FinishLoad.
+//
+void FieldViewerDoc::RunLoad(Load* l)
+{
+  FILE* ifp = fopen(l->mPath.c_str(), l->mModel ? "rt" : "rb");
+  if (nullptr == ifp) {
+    l->mGeometryDone = true;
+    l->mDone = true;
+    return;
+  }
+  if (l->mModel) {
+    //
+    //  If we have read this model before, and it has not changed, the
+    //  cache has the display list ready made.
+    //
+    GLACache::Stamp(ifp, l->mStamp);
+    l->mCached = GLACache::Load(l->mList, l->mPath.c_str(), ifp);
+    if (!l->mCached) {
+      //
+      //	Create a TextScanner to analyse the file.
+      //
+      CTextScanner scan(ifp);
+      //
+      //	Pass that to the display list. It will read the
+      //	file and create the OpenGL display list from the
+      //	contents of the file.
+      //
+      l->mList->InstallScanner(&scan);
+      l->mList->Create();
+      l->mEnd = ftell(ifp);
+      //
+      //  A streamed list is only complete once the main thread has
+      //  given back the batches, so it saves the cache itself.
+      //
+      if (!l->mOpening) {
+        GLACache::Save(l->mList, l->mPath.c_str(), l->mStamp, ifp);
+      }
+    }
+    l->mGeometryDone = true;
+    //
+    //  Create will stop when it hits an end directive. The rest of
+    //  the file should contain a description of a nested set of fields.
+    //
+    l->mOK = ParseFieldSet(l->mData, ifp);
+  } else if (GridFile::IsGridFile(l->mPath.c_str())) {
+    l->mGeometryDone = true;
+    l->mGrids = GridField::Read(l->mPath.c_str(), nullptr, &l->mWhy);
+    l->mOK = (nullptr != l->mGrids);
+  } else {
+    l->mGeometryDone = true;
+    l->mOK = CD3ReadBinary(l->mData, ifp);
+  }
+  fclose(ifp);
+  l->mDone = true;
+}
+//
+//  While the document opens, move the batches that have been parsed
+//  into mList, keep the camera on them and say how far we have got.
+//  Once the geometry is done the load's list, which has the picker and
+//  the rest of the batches, takes over from mList. We look at
+//  mGeometryDone before taking from the stream so that we cannot miss
+//  a batch put there just before it was set.
+//
+void FieldViewerDoc::ShowLoad(void)
+{
+  bool geometryDone = mLoad->mGeometryDone;
+  std::vector<GLABatch> batches;
+  mLoad->mStream.Take(batches);
+  bool more = !batches.empty();
+  for (size_t b = 0; b < batches.size(); b++) {
+    if (!batches[b].mBounds.IsEmpty()) {
+      mLoadBounds.AddPoint(batches[b].mBounds.GetMin());
+      mLoadBounds.AddPoint(batches[b].mBounds.GetMax());
+    }
+  }
+  mList->AddBatches(batches);
+  if (geometryDone && !mLoad->mMerged) {
+    mLoad->mList->AddBatches(*mList);
+    delete mList;
+    mList = mLoad->mList;
+    mLoad->mList = nullptr;
+    mLoad->mMerged = true;
+    mList->FlushMessages();
+    if (!mLoad->mCached) {
+      GLACache::Save(mList, mLoad->mPath.c_str(), mLoad->mStamp, mLoad->mEnd);
+    }
+    if (mLoadBounds.IsEmpty() && !mList->GetBounds()->IsEmpty()) {
+      mLoadBounds.AddPoint(mList->GetBounds()->GetMin());
+      mLoadBounds.AddPoint(mList->GetBounds()->GetMax());
+    }
+    more = true;
+  }
+  wxString name = wxFileName(mLoad->mPath).GetFullName();
+  if (!mLoad->mMerged) {
+    double parsed = (double) mLoad->mStream.GetParsed();
+    int percent = (mLoadSize > 0.0) ? (int) (100.0 * parsed / mLoadSize) : 0;
+    mModelView->mFrame->SetStatusText(
+      wxString::Format(wxT("Reading %s: %d%%, %d primitives"), name,
+                       (percent < 100) ? percent : 100, mList->GetNPrim()));
+  } else {
+    mModelView->mFrame->SetStatusText(
+      wxString::Format(wxT("Reading fields from %s"), name));
+  }
+  if (!more) {
+    return;
+  }
+  if (!mLoadBounds.IsEmpty() &&
+      (mModelView->mGLWind->GetMoves() == mLoadMoves)) {
+    mModelView->FocusOn(&mLoadBounds, false);
+  }
+  UpdateAllViews();
+}
+//
+//  Take in a finished load. When opening, the geometry is already in
+//  place and the model's field joins it. Otherwise the new geometry and
+//  field are swapped in; the camera is left where it is and the field
+//  views stay on their planes, sampling the new field. If the file
+//  could not be read we keep what we had.
+//
+void FieldViewerDoc::FinishLoad(void)
+{
+  Load* l = mLoad;
+  mLoadThread.join();
+  mLoad = nullptr;
+  mWatchTimer.Start(kWatchInterval);
+  if (mLoadTimed) {
+    gProfiler.End(kProfLoadModel);
+    mLoadTimed = false;
+  }
+  if (l->mOpening) {
+    CD3DField* f = nullptr;
+    if (l->mOK) {
+      f = new CD3DField(l->mData);
+      mFieldBase.Append(f);
+      if (mModelView->mGLWind->GetMoves() == mLoadMoves) {
+        mModelView->FocusOn(f->GetBounds(), false);
+      }
+    } else {
+      wxLogMessage("Attempt to load model fields failed.");
+      delete l->mData;
+    }
+    WatchFile(l->mPath.c_str(), f, true);
+    mModelView->mFrame->SetStatusText(wxT(""));
+    delete l;
+    if (nullptr != mSession) {
+      FinishSession();
+    }
+    UpdateAllViews();
+    return;
+  }
+  if (nullptr != l->mList) {
+    l->mList->FlushMessages();
+  }
+  if (!l->mOK) {
+    if (!l->mWhy.empty()) {
+      eprintf("%s\n", l->mWhy.c_str());
+    }
+    eprintf("Could not read %s again, keeping the old one.\n",
+            l->mPath.c_str());
+    delete l->mList;
+    delete l->mData;
+    delete l;
+    return;
+  }
+  if (l->mModel) {
+    delete mList;
+    mList = l->mList;
+  }
+  EField* f = l->mGrids;
+  if (nullptr == f) {
+    f = new CD3DField(l->mData);
+  } else {
+    delete l->mData;
+    if (l->mGrids->IsPacked()) {
+      l->mGrids->Report();
+    }
+  }
+  for (size_t i = 0; i < mSources.size(); i++) {
+    if (mSources[i].mPath == l->mPath) {
+      ReplaceField(mSources[i].mField, f);
+      mSources[i].mField = f;
+      break;
+    }
+  }
+  iprintf("Reloaded %s\n", l->mPath.c_str());
+  delete l;
+  UpdateAllViews();
+}
+//
+//  Put newField where oldField was in the list and point everything
+//  that showed oldField at it before oldField goes. If the model's
+//  fields could not be read when it was opened there is no oldField.
+//
+void FieldViewerDoc::ReplaceField(EField* oldField, EField* newField)
+{
+  if (nullptr == oldField) {
+    mFieldBase.Append(newField);
+    return;
+  }
+  oldField->Append(newField);
+  oldField->Delete();
+  for (Listable* l = mFViewBase.mNext; l != &mFViewEnd; l = l->mNext) {
+    FieldView* v = dynamic_cast<FieldView*>(l);
+    if ((nullptr != v) && (v->mField == oldField)) {
+      v->SetField(newField);
+    }
+  }
+  if ((nullptr != mVolume) && (mVolume->mField == oldField)) {
+    int type = mVolume->mType;
+    delete mVolume;
+    mVolume = new VolumeView(mModelView->mGLWind, newField, this);
+    if (!mVolume->ViewType(type)) {
+      delete mVolume;
+      mVolume = nullptr;
+      mFieldMenu->Check(bcID_FIELD_VOLUME, false);
+    }
+  }
+  delete oldField;
+}
+//
+//  Put back what we can of a session before the model is in: the
+//  camera, the colour map and the views. Views that brought their
+//  samples show straight away; the rest wait for the field.
+//
+void FieldViewerDoc::RestoreSession(void)
+{
+  Session* s = mSession;
+  if (s->mHaveCamera) {
+    mModelView->mGLWind->SetView(s->mCamera);
+  }
+  mLinearTransform = s->mLinear;
+  mFieldMenu->Check(bcID_FIELD_LINEAR, mLinearTransform);
+  mFieldMenu->Check(bcID_FIELD_LOG, !mLinearTransform);
+  mRainbowLevel = (kSliceGrey == s->mColours) ? 3 : s->mColours;
+  mFieldMenu->Check(bcID_FIELD_R1 + mRainbowLevel - 1, true);
+  int restored = 0;
+  int shown = 0;
+  for (size_t i = 0; i < s->mViews.size(); i++) {
+    FieldView* fv = new FieldView(mModelView->mGLWind, nullptr, this);
+    if (!fv->Restore(s->mViews[i])) {
+      eprintf("View %d of the session is not a rectangle, leaving it out.\n",
+              (int) i + 1);
+      delete fv;
+      continue;
+    }
+    restored++;
+    if (nullptr != fv->mTex) {
+      shown++;
+    }
+    mFViewBase.Append(fv);
+  }
+  iprintf("Restored %d views, %d of them from their samples.\n",
+          restored, shown);
+  s->mViews.clear();
+  IndexViews();
+  UpdateAllViews();
+}
+//
+//  The model's fields are in. Read the other field files the session
+//  had, in order, then give the restored views the first field. Any
+//  view without samples is sampled now.
+//
+void FieldViewerDoc::FinishSession(void)
+{
+  Session* s = mSession;
+  mSession = nullptr;
+  for (size_t i = 0; i < s->mFields.size(); i++) {
+    if (!Load3DField(s->mFields[i].c_str())) {
+      eprintf("%s: could not read the session's field.\n",
+              s->mFields[i].c_str());
+    }
+  }
+  EField* f = dynamic_cast<EField*>(mFieldBase.mNext);
+  for (Listable* l = mFViewBase.mNext; l != &mFViewEnd; l = l->mNext) {
+    FieldView* v = dynamic_cast<FieldView*>(l);
+    if ((nullptr != v) && (nullptr == v->mField)) {
+      v->AttachField(f);
+    }
+  }
+  delete s;
+}
@@ -11,6 +11,10 @@
  *  of the field.
  *  BCollett 7/17/14 Add support for Pointer click handling through the
  *  Pointer3D class.
+ *  BCollett 10/19/26 Watch the model and field files and read them in
+ *  again when they are rewritten.
+ *  BCollett 10/19/26 Read the model on a thread and show it as it comes.
+ *  BCollett 10/19/26 Save and open sessions.
  *
  */
 #ifndef _FieldViewerDoc_H
@@ -18,14 +22,33 @@
 
 #include "wx/docview.h"
 #include "wx/cmdproc.h"
+#include "wx/timer.h"
+#include <vector>
+#include <string>
+#include <atomic>
+#include <thread>
+#include <unordered_map>
 #include "Listable.h"
 #include "GLAList.h"
 #include "Model3D.h"
 #include "Fields/EField.h"
+#include "Fields/GridField.h"
+#include "COMSOLData3D.h"
+#include "Geometry/Picker.h"
+#include "FileWatcher.h"
+#include "Session.h"
 //#include "FieldView.h"
 
 class GLViewerView;
+class VolumeView;
+class FieldView;
 
+//
+//  How often, in ms, we ask whether the files have changed, and how
+//  often we show more of a model that is being read.
+//
+const int kWatchInterval = 500;
+const int kLoadInterval = 100;
 
 class FieldViewerDoc: public wxDocument, public Model3D
 {
@@ -46,6 +69,25 @@ private:
   Listable mFViewBase;
   Listable mFViewEnd;
   //
+  //  Index of the views so that view numbers and views can be turned
+  //  into each other without walking the list, and a picker over their
+  //  frames. IndexViews rebuilds all three whenever the list changes.
+  //
+  std::vector<Listable*> mViewIndex;
+  std::unordered_map<const Listable*, int> mViewNames;
+  CPicker mViewPicker;
+  //
+  //  At most one volume rendering of the field.
+  //
+  VolumeView* mVolume;
+  //
+  //  Line probe state. While probing the first click on a field plane
+  //  sets the start of the probe and the second sets the end.
+  //
+  bool mProbing;
+  bool mHaveProbeStart;
+  Point3D mProbeStart;
+  //
   //  One field can be 'selected' at any time.
   //
   Listable* mCurrentField;
@@ -60,6 +102,64 @@ private:
   wxMenu* mFieldMenu;
   bool mLinearTransform;
   int mRainbowLevel;
+  //
+  //  Loading and live reload. Files are read on mLoadThread, one at a
+  //  time, into a new list and field data. When the document opens,
+  //  the model's batches are streamed into mList as they fill so that
+  //  the model appears as it is parsed, and the fields follow once the
+  //  geometry is done. A reload is only swapped in once it is complete.
+  //  We remember which file each field came from, the model file's
+  //  field carrying the geometry with it, and watch them all. Files
+  //  that change while another is being read wait in mLoadQueue.
+  //
+  struct FieldSource {
+    std::string mPath;
+    EField* mField;
+    bool mModel;
+  };
+  struct Load {
+    std::string mPath;
+    bool mModel;
+    bool mOpening;              // streaming the model as it is parsed
+    CGLAList* mList;
+    CD3Data* mData;
+    GridField* mGrids;          // instead of mData for a grid file
+    std::string mWhy;           // why mGrids could not be read
+    GLAStream mStream;
+    long mEnd;                  // just past the end directive
+    int64_t mStamp[3];          // the model as we read it, for the cache
+    bool mCached;               // the geometry came from the GLACache
+    bool mMerged;               // mList has taken over the streamed batches
+    bool mOK;
+    std::atomic<bool> mGeometryDone;
+    std::atomic<bool> mDone;
+  };
+  std::vector<FieldSource> mSources;
+  FileWatcher mWatcher;
+  wxTimer mWatchTimer;
+  std::vector<std::string> mLoadQueue;
+  Load* mLoad;
+  std::thread mLoadThread;
+  //
+  //  While the model streams in we keep the camera on what has arrived
+  //  so far, until the user moves it. mLoadMoves is the canvas's count
+  //  of moves when the load started.
+  //
+  Frame3D mLoadBounds;
+  double mLoadSize;
+  unsigned long mLoadMoves;
+  //
+  //  The profiler is not safe to use from the load thread, so a model
+  //  load is timed on this one, from StartLoad to the tick on which
+  //  FinishLoad takes it in, and only if profiling was on at the start.
+  //
+  bool mLoadTimed;
+  //
+  //  The model file, for sessions, and a session that is being opened.
+  //  mSession holds on to the field files until the model is in.
+  //
+  std::string mModelPath;
+  Session* mSession;
 public:
   //
   //  ctors.
@@ -79,12 +179,16 @@ public:
   //
   void OnMenuFileLoad3D(wxCommandEvent& WXUNUSED(event));
   void OnMenuFileLoad2D(wxCommandEvent& WXUNUSED(event));
+  void OnMenuFileSession(wxCommandEvent& WXUNUSED(event));
   void OnMenuFieldDelete(wxCommandEvent& WXUNUSED(event));
   void OnMenuFieldLinear(wxCommandEvent& WXUNUSED(event));
   void OnMenuFieldLog(wxCommandEvent& WXUNUSED(event));
   void OnMenuFieldR1(wxCommandEvent& WXUNUSED(event));
   void OnMenuFieldR2(wxCommandEvent& WXUNUSED(event));
   void OnMenuFieldR3(wxCommandEvent& WXUNUSED(event));
+  void OnMenuFieldVolume(wxCommandEvent& WXUNUSED(event));
+  void OnMenuFieldProbe(wxCommandEvent& WXUNUSED(event));
+  void OnWatchTimer(wxTimerEvent& WXUNUSED(event));
   
   //
   //  OnChoosePlane allows the user to select a plane on which to render a
@@ -102,7 +206,10 @@ public:
   //  intersected something in our model.
   //
   virtual void Render(bool picking);
-  virtual void DoClick(GLuint names[], Point3D start, Point3D end);
+  virtual void DoClick(Point3D start, Point3D end);
+  virtual bool Hover(const Point3D& start, const Point3D& end,
+                     char* buff, int len);
+  virtual void Resample(void);
   
 protected:
   virtual bool DoOpenDocument(const wxString& filename);
@@ -119,6 +226,11 @@ protected:
   //
   virtual bool Load2DField(const char* filename);
   //
+  //  Save everything a session needs to put the document back, with or
+  //  without the samples the views hold.
+  //
+  bool SaveSession(const std::string& path, bool samples);
+  //
   //  Helper to maintain current field.
   //  Return previous current field.
   //
@@ -126,8 +238,28 @@ protected:
   //
   //  Helpers for DoClick.
   //
+  void IndexViews(void);
   Listable* FindView(int num);
   int FindViewName(Listable* target);
+  void ClickAt(FieldView* view, const Point3D& ip);
+  void ProbeClick(EField* f, const Point3D& ip);
+  //
+  //  Helpers for loading and live reload. RunLoad is the body of the
+  //  load thread and must not touch the windows.
+  //
+  void WatchFile(const char* path, EField* f, bool model);
+  void StartLoad(const std::string& path, bool model, bool opening);
+  void StartReload(const std::string& path);
+  void ShowLoad(void);
+  void FinishLoad(void);
+  void ReplaceField(EField* oldField, EField* newField);
+  static void RunLoad(Load* l);
+  //
+  //  Helpers for opening a session. RestoreSession runs as the model
+  //  starts loading and FinishSession once it is in.
+  //
+  void RestoreSession(void);
+  void FinishSession(void);
   //
   //
   //  These are dialog helpers. They run dialogs and extract their imformation
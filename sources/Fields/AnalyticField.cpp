@@ -0,0 +1,256 @@
+//
+//  AnalyticField.cpp
+//  FieldViewer
+//
+//  Analytic fields are fields that we can write down. See
+//  AnalyticField.h.
+//
+//  Created by Brian Collett on 10/19/26.
+//  Copyright (c) 2026 Brian Collett. All rights reserved.
+//
+#include <cmath>
+#include <strings.h>
+#include "AnalyticField.h"
+//
+//  Names for Make, in AnalyticKind order.
+//
+static const char* sKindNames[kAFNKind] = {
+  "uniform", "charge", "dipole", "coax", "plates"
+};
+//
+//  ctors
+//
+AnalyticField::AnalyticField(const Point3D& min, const Point3D& max,
+                             int cost) : EField()
+{
+  mBounds.Set(min, max);
+  mBounds.AddFlags(kGFWire);
+  mBounds.SetColor(1.0, 1.0, 1.0);
+  SetCost(cost);
+}
+AnalyticField::~AnalyticField()
+{
+}
+//
+//  The standard settings keep everything well inside the box so that
+//  slices through the middle cut the interesting part.
+//
+AnalyticField* AnalyticField::Make(AnalyticKind kind, int cost)
+{
+  Point3D min(-1.0, -1.0, -1.0);
+  Point3D max(1.0, 1.0, 1.0);
+  Point3D origin(0.0, 0.0, 0.0);
+  switch (kind) {
+    case kAFUniform:
+      return new UniformField(min, max, Vector3D(0.0, 0.0, 1.0), cost);
+    case kAFPointCharge:
+      return new PointChargeField(min, max, origin, 1.0, 0.05, cost);
+    case kAFDipole:
+      return new DipoleField(min, max, origin, Vector3D(0.0, 0.0, 1.0), 0.05,
+                             cost);
+    case kAFCoax:
+      return new CoaxField(min, max, 0.0, 0.0, 0.2, 0.9, 1.0, cost);
+    case kAFPlates:
+      return new ParallelPlateField(min, max, -0.5, 0.5, 1.0, cost);
+    default:
+      return nullptr;
+  }
+}
+AnalyticField* AnalyticField::Make(const char* name, int cost)
+{
+  for (int k = 0; k < kAFNKind; k++) {
+    if (strcasecmp(name, sKindNames[k]) == 0) {
+      return Make((AnalyticKind) k, cost);
+    }
+  }
+  return nullptr;
+}
+const char* AnalyticField::KindName(int kind)
+{
+  return ((kind >= 0) && (kind < kAFNKind)) ? sKindNames[kind] : "?";
+}
+//
+//  Override.
+//  Field operations.
+//
+Vector3D AnalyticField::FieldAt(const Vector3D& p) const
+{
+  double field[3];
+  At(p.mCoords, field);
+  return Vector3D(field);
+}
+Vector3D AnalyticField::FieldAt(const Point3D& p) const
+{
+  double field[3];
+  At(p.mCoords, field);
+  return Vector3D(field);
+}
+void AnalyticField::FieldAtPoints(int n, const double* pts,
+                                  double* fields) const
+{
+  for (int i = 0; i < n; i++, pts += 3, fields += 3) {
+    At(pts, fields);
+  }
+}
+//
+//  And ones for names.
+//
+const char* AnalyticField::FieldNameAt(const Vector3D& p) const
+{
+  return Inside(p.mCoords) ? Name() : sNoName;
+}
+const char* AnalyticField::FieldNameAt(const Point3D& p) const
+{
+  return Inside(p.mCoords) ? Name() : sNoName;
+}
+//
+//  Helpers.
+//
+bool AnalyticField::Inside(const double* p) const
+{
+  const Real* min = mBounds.GetMin().mCoords;
+  const Real* max = mBounds.GetMax().mCoords;
+  return (p[0] >= min[0]) && (p[0] <= max[0]) &&
+         (p[1] >= min[1]) && (p[1] <= max[1]) &&
+         (p[2] >= min[2]) && (p[2] <= max[2]);
+}
+void AnalyticField::At(const double* p, double* E) const
+{
+  if (!Inside(p) || !Evaluate(p, E)) {
+    E[0] = E[1] = E[2] = NAN;
+    return;
+  }
+  if (mCost > 0) {
+    E[0] += Burn(p);
+  }
+}
+//
+//  Burn does mCost rounds of a sum that the compiler cannot see through
+//  and hands back zero, or NaN if p was not finite.
+//
+double AnalyticField::Burn(const double* p) const
+{
+  double s = p[0] + p[1] + p[2];
+  double t = s;
+  for (int k = 0; k < mCost; k++) {
+    t = t * 0.5 + s * 0.25;
+  }
+  return (t - t) * s;
+}
+//
+//  Uniform.
+//
+UniformField::UniformField(const Point3D& min, const Point3D& max,
+                           const Vector3D& E, int cost) :
+AnalyticField(min, max, cost)
+{
+  mE = E;
+}
+bool UniformField::Evaluate(const double* p, double* E) const
+{
+  E[0] = mE.mX;
+  E[1] = mE.mY;
+  E[2] = mE.mZ;
+  return true;
+}
+//
+//  Point charge.
+//
+PointChargeField::PointChargeField(const Point3D& min, const Point3D& max,
+                                   const Point3D& centre, double q,
+                                   double rMin, int cost) :
+AnalyticField(min, max, cost)
+{
+  mCentre = centre;
+  mQ = q;
+  mRMin = rMin;
+}
+bool PointChargeField::Evaluate(const double* p, double* E) const
+{
+  double d[3] = { p[0] - mCentre.mX, p[1] - mCentre.mY, p[2] - mCentre.mZ };
+  double r2 = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+  if (r2 < mRMin * mRMin) {
+    return false;
+  }
+  double s = mQ / (r2 * sqrt(r2));
+  E[0] = s * d[0];
+  E[1] = s * d[1];
+  E[2] = s * d[2];
+  return true;
+}
+//
+//  Dipole, E = (3 (p.r) r / r^2 - p) / r^3.
+//
+DipoleField::DipoleField(const Point3D& min, const Point3D& max,
+                         const Point3D& centre, const Vector3D& moment,
+                         double rMin, int cost) :
+AnalyticField(min, max, cost)
+{
+  mCentre = centre;
+  mMoment = moment;
+  mRMin = rMin;
+}
+bool DipoleField::Evaluate(const double* p, double* E) const
+{
+  double d[3] = { p[0] - mCentre.mX, p[1] - mCentre.mY, p[2] - mCentre.mZ };
+  double r2 = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+  if (r2 < mRMin * mRMin) {
+    return false;
+  }
+  const Real* m = mMoment.mCoords;
+  double r3 = r2 * sqrt(r2);
+  double pr = 3.0 * (m[0] * d[0] + m[1] * d[1] + m[2] * d[2]) / r2;
+  for (int k = 0; k < 3; k++) {
+    E[k] = (pr * d[k] - m[k]) / r3;
+  }
+  return true;
+}
+//
+//  Coax.
+//
+CoaxField::CoaxField(const Point3D& min, const Point3D& max, double x,
+                     double y, double a, double b, double v, int cost) :
+AnalyticField(min, max, cost)
+{
+  mAxisX = x;
+  mAxisY = y;
+  mA = a;
+  mB = b;
+  mV = v;
+}
+bool CoaxField::Evaluate(const double* p, double* E) const
+{
+  double dx = p[0] - mAxisX;
+  double dy = p[1] - mAxisY;
+  double r2 = dx * dx + dy * dy;
+  if ((r2 < mA * mA) || (r2 > mB * mB)) {
+    return false;
+  }
+  double s = mV / (r2 * log(mB / mA));    // E_r / r
+  E[0] = s * dx;
+  E[1] = s * dy;
+  E[2] = 0.0;
+  return true;
+}
+//
+//  Parallel plates.
+//
+ParallelPlateField::ParallelPlateField(const Point3D& min,
+                                       const Point3D& max, double z0,
+                                       double z1, double v, int cost) :
+AnalyticField(min, max, cost)
+{
+  mZ0 = (z0 < z1) ? z0 : z1;
+  mZ1 = (z0 < z1) ? z1 : z0;
+  mV = (z0 < z1) ? v : -v;
+}
+bool ParallelPlateField::Evaluate(const double* p, double* E) const
+{
+  if ((p[2] < mZ0) || (p[2] > mZ1) || (mZ1 <= mZ0)) {
+    return false;
+  }
+  E[0] = 0.0;
+  E[1] = 0.0;
+  E[2] = -mV / (mZ1 - mZ0);
+  return true;
+}
@@ -0,0 +1,171 @@
+//
+//  AnalyticField.h
+//  FieldViewer
+//
+//  Analytic fields are fields that we can write down, so they need no
+//  COMSOL data and give the same answer on every machine. They are
+//  for checking the sampling, colour mapping and probing code against
+//  known answers and for timing it without shipping huge field files.
+//
+//  Each one lives in a box that the caller chooses and is NaN outside
+//  the box and wherever the field is undefined, inside a conductor or
+//  too close to a point charge, just as a COMSOL field has holes where
+//  the model has metal.
+//
+//  The cost is a number of extra rounds of arithmetic done for every
+//  point so that a cheap analytic field can stand in for an expensive
+//  interpolated one. It never changes the answer.
+//
+//  Created by Brian Collett on 10/19/26.
+//  Copyright (c) 2026 Brian Collett. All rights reserved.
+//
+
+#ifndef __FieldViewer__AnalyticField__
+#define __FieldViewer__AnalyticField__
+
+#include "EField.h"
+
+//
+//  The kinds we can make by name, see AnalyticField::Make.
+//
+enum AnalyticKind {
+  kAFUniform = 0,
+  kAFPointCharge,
+  kAFDipole,
+  kAFCoax,
+  kAFPlates,
+  kAFNKind
+};
+
+class AnalyticField : public EField {
+protected:
+  //
+  //  Instance vars.
+  //
+  int mCost;
+public:
+  //
+  //  ctors
+  //
+  AnalyticField(const Point3D& min, const Point3D& max, int cost = 0);
+  virtual ~AnalyticField();
+  //
+  //  Make one of the kinds with its standard settings in the box from
+  //  -1 to 1 on each axis. Returns nullptr for an unknown name.
+  //
+  static AnalyticField* Make(AnalyticKind kind, int cost = 0);
+  static AnalyticField* Make(const char* name, int cost = 0);
+  static const char* KindName(int kind);
+  //
+  //  Cost accessors.
+  //
+  void SetCost(int cost) { mCost = (cost > 0) ? cost : 0; };
+  int GetCost(void) const { return mCost; };
+  //
+  //  Override.
+  //  Field operations.
+  //
+  virtual Vector3D FieldAt(const Vector3D& p) const;
+  virtual Vector3D FieldAt(const Point3D& p) const;
+  virtual void FieldAtPoints(int n, const double* pts, double* fields) const;
+  virtual bool IsThreadSafe(void) const { return true; };
+  //
+  //  And ones for names.
+  //
+  virtual const char* FieldNameAt(const Vector3D& p) const;
+  virtual const char* FieldNameAt(const Point3D& p) const;
+protected:
+  //
+  //  Evaluate fills E at p, which is inside the box, and returns false
+  //  where the field is undefined.
+  //
+  virtual bool Evaluate(const double* p, double* E) const = 0;
+  virtual const char* Name(void) const = 0;
+  //
+  //  Helpers.
+  //
+  bool Inside(const double* p) const;
+  void At(const double* p, double* E) const;
+  double Burn(const double* p) const;
+};
+//
+//  E everywhere in the box.
+//
+class UniformField : public AnalyticField {
+protected:
+  Vector3D mE;
+public:
+  UniformField(const Point3D& min, const Point3D& max, const Vector3D& E,
+               int cost = 0);
+protected:
+  virtual bool Evaluate(const double* p, double* E) const;
+  virtual const char* Name(void) const { return "Uniform"; };
+};
+//
+//  A point charge at centre. q is the charge over 4 pi epsilon0, so
+//  E = q / r^2. Undefined within rMin of the charge.
+//
+class PointChargeField : public AnalyticField {
+protected:
+  Point3D mCentre;
+  double mQ;
+  double mRMin;
+public:
+  PointChargeField(const Point3D& min, const Point3D& max,
+                   const Point3D& centre, double q, double rMin,
+                   int cost = 0);
+protected:
+  virtual bool Evaluate(const double* p, double* E) const;
+  virtual const char* Name(void) const { return "Point charge"; };
+};
+//
+//  An ideal dipole at centre with moment p, again over 4 pi epsilon0.
+//  Undefined within rMin of the centre.
+//
+class DipoleField : public AnalyticField {
+protected:
+  Point3D mCentre;
+  Vector3D mMoment;
+  double mRMin;
+public:
+  DipoleField(const Point3D& min, const Point3D& max, const Point3D& centre,
+              const Vector3D& moment, double rMin, int cost = 0);
+protected:
+  virtual bool Evaluate(const double* p, double* E) const;
+  virtual const char* Name(void) const { return "Dipole"; };
+};
+//
+//  A coaxial line along z through (x, y) with the inner conductor of
+//  radius a at voltage v and the outer one of radius b at ground. The
+//  field is radial, v / (r ln(b/a)), and undefined inside the inner
+//  conductor and outside the outer one.
+//
+class CoaxField : public AnalyticField {
+protected:
+  double mAxisX, mAxisY;
+  double mA, mB;
+  double mV;
+public:
+  CoaxField(const Point3D& min, const Point3D& max, double x, double y,
+            double a, double b, double v, int cost = 0);
+protected:
+  virtual bool Evaluate(const double* p, double* E) const;
+  virtual const char* Name(void) const { return "Coax"; };
+};
+//
+//  Infinite plates normal to z at z0 and z1 with v across them, so
+//  E = -v / (z1 - z0) in z between them and nothing outside the gap.
+//
+class ParallelPlateField : public AnalyticField {
+protected:
+  double mZ0, mZ1;
+  double mV;
+public:
+  ParallelPlateField(const Point3D& min, const Point3D& max, double z0,
+                     double z1, double v, int cost = 0);
+protected:
+  virtual bool Evaluate(const double* p, double* E) const;
+  virtual const char* Name(void) const { return "Parallel plates"; };
+};
+
+#endif /* defined(__FieldViewer__AnalyticField__) */
@@ -0,0 +1,295 @@
+//
+//  BrickStore.cpp
+//  FieldViewer
+//
+//  Grid node data packed in bricks. See BrickStore.h.
+//
+//  Created by Brian Collett on 10/19/26.
+//  Copyright (c) 2026 Brian Collett. All rights reserved.
+//
+
+#include <string.h>
+#include <math.h>
+#include <atomic>
+#include "BrickStore.h"
+//
+//  How a brick is packed, its first byte.
+//
+enum {
+  kBSXor = 0,                           // bits that changed, lossless
+  kBSStep                               // rounded to a step, differences
+};
+//
+//  Values further than this many steps from zero are kept losslessly,
+//  so that a difference always fits in a varint with room to spare.
+//
+static const double kBSMaxSteps = 4503599627370496.0;   // 2^52
+//
+//  The unpacked brick cache, one for each thread. A brick goes in slot
+//  x + 5y + 25z of its place in the grid, plus something for its store,
+//  so a row of bricks along any axis, which is what a slice works
+//  through, never has two in the same slot.
+//
+struct BrickSlot {
+  uint64_t mId;                         // 0 when empty
+  size_t mBrick;
+  size_t mStride[3];
+  std::vector<double> mData;
+};
+static thread_local BrickSlot tCache[kBSCacheSlots];
+static std::atomic<uint64_t> sNextId(1);
+//
+//  ctors
+//
+BrickStore::BrickStore()
+{
+  for (int k = 0; k < 3; k++) {
+    mN[k] = 0;
+    mNB[k] = 0;
+  }
+  mBound = 0.0;
+  mMaxError = 0.0;
+  mId = sNextId++;
+}
+BrickStore::~BrickStore()
+{
+}
+//
+//  Each brick is unpacked again as soon as it is packed, so that the
+//  report gives the error we really made and not just the bound.
+//
+bool BrickStore::Pack(const uint32_t* n, const double* data, double bound)
+{
+  for (int k = 0; k < 3; k++) {
+    if (n[k] == 0) {
+      return false;
+    }
+    mN[k] = n[k];
+    mNB[k] = (n[k] > 1) ? (n[k] - 2) / kBSCells + 1 : 1;
+  }
+  mBound = (bound > 0.0) ? bound : 0.0;
+  mMaxError = 0.0;
+  mPacked.clear();
+  mStart.clear();
+  size_t nBricks = (size_t) mNB[0] * mNB[1] * mNB[2];
+  std::vector<double> v;
+  std::vector<double> back;
+  std::vector<unsigned char> out;
+  for (size_t b = 0; b < nBricks; b++) {
+    uint32_t first[3], count[3];
+    BrickNodes(b, first, count);
+    v.resize(3 * (size_t) count[0] * count[1] * count[2]);
+    double* to = &v[0];
+    for (uint32_t k = 0; k < count[2]; k++) {
+      for (uint32_t j = 0; j < count[1]; j++) {
+        size_t row = (first[1] + j) + (size_t) mN[1] * (first[2] + k);
+        size_t node = first[0] + (size_t) mN[0] * row;
+        memcpy(to, data + 3 * node, 3 * count[0] * sizeof(double));
+        to += 3 * count[0];
+      }
+    }
+    mStart.push_back(mPacked.size());
+    Encode(v, mBound, out);
+    mPacked.insert(mPacked.end(), out.begin(), out.end());
+    back.resize(v.size());
+    Decode(&out[0], v.size(), &back[0]);
+    for (size_t i = 0; i < v.size(); i++) {
+      double err = fabs(back[i] - v[i]);
+      if (err > mMaxError) {
+        mMaxError = err;
+      }
+    }
+  }
+  mStart.push_back(mPacked.size());
+  std::vector<unsigned char>(mPacked).swap(mPacked);     // drop the slack
+  return true;
+}
+//
+//  Cell looks in this thread's cache before it unpacks anything.
+//
+const double* BrickStore::Cell(const long* cell, size_t* stride) const
+{
+  size_t bb[3];
+  long local[3];
+  for (int k = 0; k < 3; k++) {
+    bb[k] = (size_t) cell[k] / kBSCells;
+    if (bb[k] >= mNB[k]) {
+      bb[k] = mNB[k] - 1;
+    }
+    local[k] = cell[k] - (long) (bb[k] * kBSCells);
+  }
+  size_t b = bb[0] + mNB[0] * (bb[1] + mNB[1] * bb[2]);
+  BrickSlot& slot = tCache[(bb[0] + 5 * bb[1] + 25 * bb[2] + 41 * mId) %
+                          kBSCacheSlots];
+  if ((slot.mId != mId) || (slot.mBrick != b)) {
+    uint32_t first[3], count[3];
+    BrickNodes(b, first, count);
+    Unpack(b, slot.mData);
+    slot.mId = mId;
+    slot.mBrick = b;
+    slot.mStride[0] = 3;
+    slot.mStride[1] = 3 * (size_t) count[0];
+    slot.mStride[2] = slot.mStride[1] * count[1];
+  }
+  for (int k = 0; k < 3; k++) {
+    stride[k] = slot.mStride[k];
+  }
+  return &slot.mData[local[0] * stride[0] + local[1] * stride[1] +
+                     local[2] * stride[2]];
+}
+//
+//  For the report.
+//
+uint64_t BrickStore::GetRawSize(void) const
+{
+  return (uint64_t) mN[0] * mN[1] * mN[2] * 3 * sizeof(double);
+}
+uint64_t BrickStore::GetPackedSize(void) const
+{
+  return mPacked.size() + mStart.size() * sizeof(uint64_t);
+}
+//
+//  Helpers.
+//  A brick starts on a multiple of kBSCells nodes and runs one node
+//  past its last cell, so it shares a face with the next brick.
+//
+void BrickStore::BrickNodes(size_t b, uint32_t* first, uint32_t* count) const
+{
+  size_t bb[3];
+  bb[0] = b % mNB[0];
+  bb[1] = (b / mNB[0]) % mNB[1];
+  bb[2] = b / ((size_t) mNB[0] * mNB[1]);
+  for (int k = 0; k < 3; k++) {
+    first[k] = (uint32_t) bb[k] * kBSCells;
+    count[k] = 1;
+    if (mN[k] > 1) {
+      uint32_t cells = mN[k] - 1 - first[k];
+      count[k] = ((cells < kBSCells) ? cells : kBSCells) + 1;
+    }
+  }
+}
+void BrickStore::Expand(double* data) const
+{
+  std::vector<double> v;
+  for (size_t b = 0; b + 1 < mStart.size(); b++) {
+    uint32_t first[3], count[3];
+    BrickNodes(b, first, count);
+    Unpack(b, v);
+    const double* from = &v[0];
+    for (uint32_t k = 0; k < count[2]; k++) {
+      for (uint32_t j = 0; j < count[1]; j++) {
+        size_t row = (first[1] + j) + (size_t) mN[1] * (first[2] + k);
+        size_t node = first[0] + (size_t) mN[0] * row;
+        memcpy(data + 3 * node, from, 3 * count[0] * sizeof(double));
+        from += 3 * count[0];
+      }
+    }
+  }
+}
+void BrickStore::Unpack(size_t b, std::vector<double>& out) const
+{
+  uint32_t first[3], count[3];
+  BrickNodes(b, first, count);
+  out.resize(3 * (size_t) count[0] * count[1] * count[2]);
+  Decode(&mPacked[(size_t) mStart[b]], out.size(), &out[0]);
+}
+//
+//  Each component is predicted from the same component of the node
+//  before. Stepped values go out as varints of the zigzagged difference
+//  plus one, 0 standing for NaN. Otherwise each pair of values gets a
+//  byte holding how many low bytes of each differ from the one before.
+//
+void BrickStore::Encode(const std::vector<double>& v, double bound,
+                        std::vector<unsigned char>& out)
+{
+  double step = 2.0 * bound;
+  bool stepped = (step > 0.0);
+  for (size_t i = 0; stepped && (i < v.size()); i++) {
+    stepped = isnan(v[i]) || (fabs(v[i]) < kBSMaxSteps * step);
+  }
+  out.clear();
+  if (stepped) {
+    out.push_back(kBSStep);
+    unsigned char bytes[sizeof(double)];
+    memcpy(bytes, &step, sizeof(step));
+    out.insert(out.end(), bytes, bytes + sizeof(step));
+    int64_t last[3] = { 0, 0, 0 };
+    for (size_t i = 0; i < v.size(); i++) {
+      uint64_t u = 0;
+      if (!isnan(v[i])) {
+        int64_t q = llround(v[i] / step);
+        int64_t d = q - last[i % 3];
+        last[i % 3] = q;
+        u = (((uint64_t) d << 1) ^ (uint64_t) (d >> 63)) + 1;
+      }
+      while (u >= 0x80) {
+        out.push_back((unsigned char) (u | 0x80));
+        u >>= 7;
+      }
+      out.push_back((unsigned char) u);
+    }
+    return;
+  }
+  out.push_back(kBSXor);
+  uint64_t last[3] = { 0, 0, 0 };
+  for (size_t i = 0; i < v.size(); i += 2) {
+    uint64_t x[2] = { 0, 0 };
+    int len[2] = { 0, 0 };
+    for (size_t j = 0; (j < 2) && (i + j < v.size()); j++) {
+      uint64_t bits;
+      memcpy(&bits, &v[i + j], sizeof(bits));
+      x[j] = bits ^ last[(i + j) % 3];
+      last[(i + j) % 3] = bits;
+      for (uint64_t t = x[j]; t != 0; t >>= 8) {
+        len[j]++;
+      }
+    }
+    out.push_back((unsigned char) (len[0] | (len[1] << 4)));
+    for (int j = 0; j < 2; j++) {
+      for (int k = 0; k < len[j]; k++) {
+        out.push_back((unsigned char) (x[j] >> (8 * k)));
+      }
+    }
+  }
+}
+void BrickStore::Decode(const unsigned char* in, size_t n, double* v)
+{
+  if (*in++ == kBSStep) {
+    double step;
+    memcpy(&step, in, sizeof(step));
+    in += sizeof(step);
+    int64_t last[3] = { 0, 0, 0 };
+    for (size_t i = 0; i < n; i++) {
+      uint64_t u = 0;
+      int shift = 0;
+      unsigned char c;
+      do {
+        c = *in++;
+        u |= (uint64_t) (c & 0x7f) << shift;
+        shift += 7;
+      } while (c & 0x80);
+      if (u == 0) {
+        v[i] = NAN;
+        continue;
+      }
+      u--;
+      int64_t d = (int64_t) (u >> 1) ^ -(int64_t) (u & 1);
+      last[i % 3] += d;
+      v[i] = last[i % 3] * step;
+    }
+    return;
+  }
+  uint64_t last[3] = { 0, 0, 0 };
+  for (size_t i = 0; i < n; i += 2) {
+    unsigned char lens = *in++;
+    for (size_t j = 0; (j < 2) && (i + j < n); j++) {
+      int len = (j == 0) ? (lens & 0x0f) : (lens >> 4);
+      uint64_t x = 0;
+      for (int k = 0; k < len; k++) {
+        x |= (uint64_t) *in++ << (8 * k);
+      }
+      last[(i + j) % 3] ^= x;
+      memcpy(&v[i + j], &last[(i + j) % 3], sizeof(double));
+    }
+  }
+}
@@ -0,0 +1,94 @@
+//
+//  BrickStore.h
+//  FieldViewer
+//
+//  A BrickStore holds the node data of one grid compressed in memory,
+//  for fields too big to keep as plain doubles. The grid is cut into
+//  bricks of kBSCells cells a side and each brick is packed on its own,
+//  so a lookup only has to unpack the brick round the point it wants.
+//  Bricks share their boundary nodes, which costs a little space but
+//  means the eight corners of any cell are always in one brick.
+//
+//  With an error bound every value is rounded to a multiple of twice
+//  the bound, so it comes back within the bound, and the differences
+//  from one node to the next are stored in as few bytes as they need.
+//  With a bound of 0 nothing is lost: each value is stored as the bits
+//  that differ from the one before it, which is much less of a saving.
+//  A brick holding infinities, or values too big for the bound, is
+//  kept losslessly whatever the bound.
+//
+//  Unpacked bricks are kept in a small cache for each thread, so that
+//  the threads sampling a field never wait for one another and the
+//  run of points along a slice finds its brick ready nearly every
+//  time.
+//
+//  Created by Brian Collett on 10/19/26.
+//  Copyright (c) 2026 Brian Collett. All rights reserved.
+//
+
+#ifndef __FieldViewer__BrickStore__
+#define __FieldViewer__BrickStore__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+const uint32_t kBSCells = 8;            // cells along each side of a brick
+const int kBSCacheSlots = 128;          // unpacked bricks kept per thread
+
+class BrickStore {
+protected:
+  //
+  //  Instance vars.
+  //  mStart has the offset of each brick in mPacked and one more for
+  //  the end. mId tells our bricks apart from other stores' in the
+  //  caches, even after we are gone and another store has our address.
+  //
+  uint32_t mN[3];                       // nodes along each axis
+  uint32_t mNB[3];                      // bricks along each axis
+  double mBound;
+  double mMaxError;
+  std::vector<unsigned char> mPacked;
+  std::vector<uint64_t> mStart;
+  uint64_t mId;
+public:
+  //
+  //  ctors
+  //
+  BrickStore();
+  virtual ~BrickStore();
+  //
+  //  Pack a grid of n[0] x n[1] x n[2] nodes of (Ex, Ey, Ez), x varying
+  //  fastest. bound is the largest error allowed, 0 for none.
+  //
+  bool Pack(const uint32_t* n, const double* data, double bound);
+  //
+  //  Find the cell whose lowest corner is node cell[0..2] and return
+  //  the unpacked values at that corner, with the steps in doubles to
+  //  the next node along each axis in stride. The pointer is good until
+  //  this thread asks for another brick.
+  //
+  const double* Cell(const long* cell, size_t* stride) const;
+  //
+  //  Unpack the whole grid into data, which has room for it.
+  //
+  void Expand(double* data) const;
+  //
+  //  For the report.
+  //
+  uint64_t GetRawSize(void) const;
+  uint64_t GetPackedSize(void) const;
+  double GetBound(void) const { return mBound; };
+  double GetMaxError(void) const { return mMaxError; };
+protected:
+  //
+  //  Helpers.
+  //
+  void BrickNodes(size_t b, uint32_t* first, uint32_t* count) const;
+  void Unpack(size_t b, std::vector<double>& out) const;
+  static void Encode(const std::vector<double>& v, double bound,
+                     std::vector<unsigned char>& out);
+  static void Decode(const unsigned char* in, size_t n, double* v);
+};
+
+#endif /* defined(__FieldViewer__BrickStore__) */
@@ -45,6 +45,19 @@ Vector3D CD3DField::FieldAt(const Point3D& p) const
   return Vector3D(field);
 }
 //
+//  The batched version still looks up one point at a time. The grid
+//  belongs to the COMSOL reader, which has no batched lookup, so all
+//  this saves over FieldAt is a virtual call and the Vector3D
+//  temporaries per point.
+//
+void CD3DField::FieldAtPoints(int n, const double* pts, double* fields) const
+{
+  for (int i = 0; i < n; i++, pts += 3, fields += 3) {
+    fields[0] = fields[1] = fields[2] = NAN;
+    CD3GetEAtPoint(mData, pts, fields);
+  }
+}
+//
 //  Add ones for names.
 //
 const char* CD3DField::FieldNameAt(const Vector3D& p) const
@@ -34,6 +34,7 @@ public:
   //
   virtual Vector3D FieldAt(const Vector3D& p) const;
   virtual Vector3D FieldAt(const Point3D& p) const;
+  virtual void FieldAtPoints(int n, const double* pts, double* fields) const;
   //
   //  And ones for names.
   //
@@ -29,6 +29,18 @@ Vector3D EField::FieldAt(const Point3D& p) const
   return Vector3D(nan(""),nan(""),nan(""));
 }
 //
+//  Batched query.
+//
+void EField::FieldAtPoints(int n, const double* pts, double* fields) const
+{
+  for (int i = 0; i < n; i++, pts += 3, fields += 3) {
+    Vector3D f = FieldAt(Point3D(pts[0], pts[1], pts[2]));
+    fields[0] = f.mX;
+    fields[1] = f.mY;
+    fields[2] = f.mZ;
+  }
+}
+//
 //  Andones for names
 //
 const char* EField::FieldNameAt(const Vector3D& p) const
@@ -48,6 +48,18 @@ public:
   virtual Vector3D FieldAt(const Vector3D& p) const;
   virtual Vector3D FieldAt(const Point3D& p) const;
   //
+  //  Batched query. pts holds n (x,y,z) triples and fields gets n
+  //  (Ex,Ey,Ez) triples back, NaN where a point is outside the field.
+  //  This base version just calls FieldAt for each point; real fields
+  //  should override it to skip the per-point overhead.
+  //
+  virtual void FieldAtPoints(int n, const double* pts, double* fields) const;
+  //
+  //  True if FieldAt may be called from several threads at once. Fields
+  //  that cannot promise it are sampled on one thread.
+  //
+  virtual bool IsThreadSafe(void) const { return false; };
+  //
   //  And ones for names.
   //
   virtual const char* FieldNameAt(const Vector3D& p) const;
@@ -0,0 +1,387 @@
+//
+//  GridField.cpp
+//  FieldViewer
+//
+//  A field held as nested regular grids. See GridField.h.
+//
+//  Created by Brian Collett on 10/19/26.
+//  Copyright (c) 2026 Brian Collett. All rights reserved.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "FieldViewerApp.h"
+#include "GridField.h"
+//
+//  Class variables.
+//
+double GridField::sPacking = -1.0;
+bool GridField::sHavePacking = false;
+//
+//  ctors
+//
+GridField::GridField() : EField()
+{
+  mBounds.AddFlags(kGFWire);
+  mBounds.SetColor(1.0, 1.0, 1.0);
+}
+GridField::~GridField()
+{
+  for (size_t i = 0; i < mGrids.size(); i++) {
+    delete mGrids[i].mPack;
+  }
+}
+//
+//  Reading a single grid only touches its own section of the file.
+//  Packing each grid as soon as it is read means that only one is ever
+//  held unpacked.
+//
+GridField* GridField::Read(const char* path, const char* name,
+                           std::string* why)
+{
+  GridFile file;
+  if (!file.Open(path)) {
+    return Fail(nullptr, file.GetError(), why);
+  }
+  int first = 0;
+  int last = file.GetNGrids();
+  if (nullptr != name) {
+    first = file.Find(name);
+    if (first < 0) {
+      return Fail(nullptr, std::string(path) + ": there is no grid called " +
+                           name + ".", why);
+    }
+    last = first + 1;
+  }
+  if (first == last) {
+    return Fail(nullptr, std::string(path) + ": there are no grids in it.",
+                why);
+  }
+  GridField* f = new GridField();
+  std::vector<double> data;
+  double packing = GetPacking();
+  for (int i = first; i < last; i++) {
+    if (!file.ReadGrid(i, data)) {
+      return Fail(f, file.GetError(), why);
+    }
+    if (!f->AddGrid(file.GetSpec(i), data) ||
+        ((packing >= 0.0) && !f->Pack(packing))) {
+      return Fail(f, std::string(path) + ": unable to keep the grids.", why);
+    }
+  }
+  return f;
+}
+bool GridField::Write(const char* path, bool compress,
+                      const char* source) const
+{
+  std::vector<GridSpec> specs;
+  std::vector<const double*> data;
+  std::vector<std::vector<double> > expanded(mGrids.size());
+  for (size_t i = 0; i < mGrids.size(); i++) {
+    specs.push_back(mGrids[i].mSpec);
+    if (nullptr != mGrids[i].mPack) {
+      Expand(mGrids[i], expanded[i]);
+      data.push_back(&expanded[i][0]);
+    } else {
+      data.push_back(&mGrids[i].mData[0]);
+    }
+  }
+  return GridFile::Write(path, specs, data, compress, source);
+}
+//
+//  A new grid goes after any with the same or a higher priority and
+//  the bounds grow to take it in.
+//
+bool GridField::AddGrid(const GridSpec& spec, std::vector<double>& data)
+{
+  if ((GridFile::NodeCount(spec) == 0) ||
+      (data.size() != GridFile::NodeCount(spec) * 3)) {
+    return false;
+  }
+  size_t at = 0;
+  while ((at < mGrids.size()) &&
+         (mGrids[at].mSpec.mPriority >= spec.mPriority)) {
+    at++;
+  }
+  mGrids.insert(mGrids.begin() + at, Grid());
+  mGrids[at].mSpec = spec;
+  mGrids[at].mData.swap(data);
+  mGrids[at].mPack = nullptr;
+  double min[3], max[3];
+  for (int k = 0; k < 3; k++) {
+    min[k] = spec.mMin[k];
+    max[k] = spec.mMax[k];
+    for (size_t i = 0; i < mGrids.size(); i++) {
+      min[k] = fmin(min[k], mGrids[i].mSpec.mMin[k]);
+      max[k] = fmax(max[k], mGrids[i].mSpec.mMax[k]);
+    }
+  }
+  mBounds.Set(Point3D(min), Point3D(max));
+  return true;
+}
+//
+//  Sample asks for a row of nodes at a time so that fields with a
+//  batched FieldAtPoints go through it.
+//
+void GridField::Sample(const EField* src, const GridSpec& spec,
+                       std::vector<double>& data)
+{
+  uint32_t nx = spec.mN[0];
+  data.resize((size_t) GridFile::NodeCount(spec) * 3);
+  std::vector<double> pts(nx * 3);
+  double* out = &data[0];
+  for (uint32_t k = 0; k < spec.mN[2]; k++) {
+    double z = spec.mMin[2] + k * spec.mDelta[2];
+    for (uint32_t j = 0; j < spec.mN[1]; j++) {
+      double y = spec.mMin[1] + j * spec.mDelta[1];
+      for (uint32_t i = 0; i < nx; i++) {
+        pts[i * 3] = spec.mMin[0] + i * spec.mDelta[0];
+        pts[i * 3 + 1] = y;
+        pts[i * 3 + 2] = z;
+      }
+      //
+      //  Keep the last node exactly on the bounds, the sum above may
+      //  land just outside them.
+      //
+      if (nx > 1) {
+        pts[(nx - 1) * 3] = spec.mMax[0];
+      }
+      if ((j > 0) && (j == spec.mN[1] - 1)) {
+        for (uint32_t i = 0; i < nx; i++) {
+          pts[i * 3 + 1] = spec.mMax[1];
+        }
+      }
+      if ((k > 0) && (k == spec.mN[2] - 1)) {
+        for (uint32_t i = 0; i < nx; i++) {
+          pts[i * 3 + 2] = spec.mMax[2];
+        }
+      }
+      src->FieldAtPoints((int) nx, &pts[0], out);
+      out += nx * 3;
+    }
+  }
+}
+//
+//  Packing.
+//
+bool GridField::IsPacked(void) const
+{
+  for (size_t i = 0; i < mGrids.size(); i++) {
+    if (nullptr != mGrids[i].mPack) {
+      return true;
+    }
+  }
+  return false;
+}
+bool GridField::Pack(double bound)
+{
+  for (size_t i = 0; i < mGrids.size(); i++) {
+    Grid& g = mGrids[i];
+    if (nullptr != g.mPack) {
+      continue;
+    }
+    BrickStore* pack = new BrickStore();
+    if (!pack->Pack(g.mSpec.mN, &g.mData[0], bound)) {
+      delete pack;
+      return false;
+    }
+    g.mPack = pack;
+    std::vector<double>().swap(g.mData);
+  }
+  return true;
+}
+void GridField::Report(void) const
+{
+  uint64_t raw = 0;
+  uint64_t held = 0;
+  for (size_t i = 0; i < mGrids.size(); i++) {
+    const Grid& g = mGrids[i];
+    uint64_t size = g.mData.size() * sizeof(double);
+    if (nullptr == g.mPack) {
+      iprintf("%s: %.1f MB, not packed\n", g.mSpec.mName, size / 1.0e6);
+      raw += size;
+      held += size;
+      continue;
+    }
+    raw += g.mPack->GetRawSize();
+    held += g.mPack->GetPackedSize();
+    iprintf("%s: %.1f MB packed to %.1f MB, %.1f to 1, ", g.mSpec.mName,
+            g.mPack->GetRawSize() / 1.0e6, g.mPack->GetPackedSize() / 1.0e6,
+            (double) g.mPack->GetRawSize() / g.mPack->GetPackedSize());
+    if (g.mPack->GetBound() > 0.0) {
+      iprintf("bound %g, largest error %g\n", g.mPack->GetBound(),
+              g.mPack->GetMaxError());
+    } else {
+      iprintf("lossless\n");
+    }
+  }
+  if ((mGrids.size() > 1) && (held > 0)) {
+    iprintf("All grids: %.1f MB held for %.1f MB, %.1f to 1\n", held / 1.0e6,
+            raw / 1.0e6, (double) raw / held);
+  }
+}
+void GridField::SetPacking(double bound)
+{
+  sPacking = bound;
+  sHavePacking = true;
+}
+double GridField::GetPacking(void)
+{
+  if (sHavePacking) {
+    return sPacking;
+  }
+  sHavePacking = true;
+  sPacking = -1.0;
+  const char* env = getenv("FIELDVIEWER_PACK");
+  if ((nullptr == env) || (env[0] == 0)) {
+    return sPacking;
+  }
+  char* end;
+  double bound = strtod(env, &end);
+  if (strcmp(env, "lossless") == 0) {
+    sPacking = 0.0;
+  } else if ((*end == 0) && (bound >= 0.0)) {
+    sPacking = bound;
+  }
+  return sPacking;
+}
+//
+//  Override.
+//  Field operations.
+//
+Vector3D GridField::FieldAt(const Vector3D& p) const
+{
+  double field[3] = { NAN, NAN, NAN };
+  const Grid* g = GridAt(p.mCoords);
+  if (nullptr != g) {
+    Interpolate(*g, p.mCoords, field);
+  }
+  return Vector3D(field);
+}
+Vector3D GridField::FieldAt(const Point3D& p) const
+{
+  double field[3] = { NAN, NAN, NAN };
+  const Grid* g = GridAt(p.mCoords);
+  if (nullptr != g) {
+    Interpolate(*g, p.mCoords, field);
+  }
+  return Vector3D(field);
+}
+void GridField::FieldAtPoints(int n, const double* pts, double* fields) const
+{
+  for (int i = 0; i < n; i++, pts += 3, fields += 3) {
+    const Grid* g = GridAt(pts);
+    if (nullptr != g) {
+      Interpolate(*g, pts, fields);
+    } else {
+      fields[0] = fields[1] = fields[2] = NAN;
+    }
+  }
+}
+//
+//  And ones for names.
+//
+const char* GridField::FieldNameAt(const Vector3D& p) const
+{
+  const Grid* g = GridAt(p.mCoords);
+  return (nullptr != g) ? g->mSpec.mName : sNoName;
+}
+const char* GridField::FieldNameAt(const Point3D& p) const
+{
+  const Grid* g = GridAt(p.mCoords);
+  return (nullptr != g) ? g->mSpec.mName : sNoName;
+}
+//
+//  Helpers.
+//
+const GridField::Grid* GridField::GridAt(const double* p) const
+{
+  for (size_t i = 0; i < mGrids.size(); i++) {
+    const GridSpec& s = mGrids[i].mSpec;
+    if ((p[0] >= s.mMin[0]) && (p[0] <= s.mMax[0]) &&
+        (p[1] >= s.mMin[1]) && (p[1] <= s.mMax[1]) &&
+        (p[2] >= s.mMin[2]) && (p[2] <= s.mMax[2])) {
+      return &mGrids[i];
+    }
+  }
+  return nullptr;
+}
+GridField* GridField::Fail(GridField* f, const std::string& error,
+                           std::string* why)
+{
+  delete f;
+  if (nullptr != why) {
+    *why = error;
+  } else {
+    eprintf("%s\n", error.c_str());
+  }
+  return nullptr;
+}
+void GridField::Expand(const Grid& g, std::vector<double>& data) const
+{
+  data.resize((size_t) GridFile::NodeCount(g.mSpec) * 3);
+  g.mPack->Expand(&data[0]);
+}
+//
+//  Trilinear interpolation in the cell that holds p. A corner that
+//  carries no weight is skipped, so that a point on a face or a node
+//  next to a hole in the field is not lost to the hole. A packed grid
+//  hands us the cell's corner in an unpacked brick instead.
+//
+void GridField::Interpolate(const Grid& g, const double* p, double* field)
+{
+  const GridSpec& s = g.mSpec;
+  long cell[3];
+  double t[3];
+  for (int k = 0; k < 3; k++) {
+    cell[k] = 0;
+    t[k] = 0.0;
+    if (s.mN[k] < 2) {
+      continue;
+    }
+    double u = (p[k] - s.mMin[k]) / s.mDelta[k];
+    long i = (long) floor(u);
+    if (i < 0) {
+      i = 0;
+    } else if (i > (long) s.mN[k] - 2) {
+      i = (long) s.mN[k] - 2;
+    }
+    t[k] = u - i;
+    cell[k] = i;
+  }
+  size_t stride[3];
+  const double* data;
+  if (nullptr != g.mPack) {
+    data = g.mPack->Cell(cell, stride);
+  } else {
+    stride[0] = 3;
+    stride[1] = 3 * (size_t) s.mN[0];
+    stride[2] = stride[1] * s.mN[1];
+    data = &g.mData[cell[0] * stride[0] + cell[1] * stride[1] +
+                    cell[2] * stride[2]];
+  }
+  size_t step[3];
+  for (int k = 0; k < 3; k++) {
+    step[k] = (s.mN[k] < 2) ? 0 : stride[k];
+  }
+  field[0] = field[1] = field[2] = 0.0;
+  for (int c = 0; c < 8; c++) {
+    double w = 1.0;
+    size_t at = 0;
+    for (int k = 0; k < 3; k++) {
+      if (c & (1 << k)) {
+        w *= t[k];
+        at += step[k];
+      } else {
+        w *= 1.0 - t[k];
+      }
+    }
+    if (w == 0.0) {
+      continue;
+    }
+    field[0] += w * data[at];
+    field[1] += w * data[at + 1];
+    field[2] += w * data[at + 2];
+  }
+}
@@ -0,0 +1,119 @@
+//
+//  GridField.h
+//  FieldViewer
+//
+//  A GridField is a field held as one or more regular grids of node
+//  values, the contents of a GridFile. Where grids overlap the one with
+//  the highest priority is used, so nested grids work the way COMSOL's
+//  nested fields do. Between nodes the field is interpolated linearly
+//  along each axis and the name of a point is the name of its grid.
+//
+//  A grid's node data can be packed into a BrickStore to save memory,
+//  at some cost in lookup speed and, with an error bound, accuracy.
+//  Read packs each grid as it comes in if packing is on, which it is
+//  when $FIELDVIEWER_PACK is set to "lossless" or to an error bound in
+//  field units, or after a call to SetPacking.
+//
+//  Created by Brian Collett on 10/19/26.
+//  Copyright (c) 2026 Brian Collett. All rights reserved.
+//
+
+#ifndef __FieldViewer__GridField__
+#define __FieldViewer__GridField__
+
+#include <string>
+#include <vector>
+#include "EField.h"
+#include "GridFile.h"
+#include "BrickStore.h"
+
+class GridField : public EField {
+protected:
+  //
+  //  Instance vars.
+  //  mGrids is kept in priority order, highest first, so the first grid
+  //  that holds a point is the one to use. A packed grid has mPack and
+  //  no mData.
+  //
+  struct Grid {
+    GridSpec mSpec;
+    std::vector<double> mData;
+    BrickStore* mPack;
+  };
+  std::vector<Grid> mGrids;
+  //
+  //  Class vars.
+  //
+  static double sPacking;
+  static bool sHavePacking;
+public:
+  //
+  //  ctors
+  //
+  GridField();
+  virtual ~GridField();
+  //
+  //  Read every grid in a grid file, or only the one called name.
+  //  Returns nullptr if it cannot, having put the reason in why or, if
+  //  there is no why, on the log. Give a why when reading on a thread
+  //  of your own.
+  //
+  static GridField* Read(const char* path, const char* name = nullptr,
+                         std::string* why = nullptr);
+  //
+  //  Write all our grids to a grid file.
+  //
+  bool Write(const char* path, bool compress, const char* source) const;
+  //
+  //  Add a grid, taking over data, which must hold a value for every
+  //  node in spec.
+  //
+  bool AddGrid(const GridSpec& spec, std::vector<double>& data);
+  //
+  //  Fill data with the values of src at every node of spec.
+  //
+  static void Sample(const EField* src, const GridSpec& spec,
+                     std::vector<double>& data);
+  //
+  //  Pack every grid that is not packed yet, with the largest error
+  //  allowed, 0 for none. Report says on the log how well it went.
+  //
+  bool Pack(double bound);
+  bool IsPacked(void) const;
+  void Report(void) const;
+  //
+  //  How Read packs grids, an error bound, 0 for lossless or negative
+  //  for not at all. A $FIELDVIEWER_PACK that is neither is ignored.
+  //
+  static void SetPacking(double bound);
+  static double GetPacking(void);
+  //
+  //  The grids.
+  //
+  int GetNGrids(void) const { return (int) mGrids.size(); };
+  const GridSpec& GetSpec(int i) const { return mGrids[i].mSpec; };
+  //
+  //  Override.
+  //  Field operations.
+  //
+  virtual Vector3D FieldAt(const Vector3D& p) const;
+  virtual Vector3D FieldAt(const Point3D& p) const;
+  virtual void FieldAtPoints(int n, const double* pts, double* fields) const;
+  virtual bool IsThreadSafe(void) const { return true; };
+  //
+  //  And ones for names.
+  //
+  virtual const char* FieldNameAt(const Vector3D& p) const;
+  virtual const char* FieldNameAt(const Point3D& p) const;
+protected:
+  //
+  //  Helpers.
+  //
+  static GridField* Fail(GridField* f, const std::string& error,
+                         std::string* why);
+  const Grid* GridAt(const double* p) const;
+  void Expand(const Grid& g, std::vector<double>& data) const;
+  static void Interpolate(const Grid& g, const double* p, double* field);
+};
+
+#endif /* defined(__FieldViewer__GridField__) */
@@ -0,0 +1,482 @@
+//
+//  GridFile.cpp
+//  FieldViewer
+//
+//  Our own container for nested grids of field data. See GridFile.h.
+//
+//  Created by Brian Collett on 10/19/26.
+//  Copyright (c) 2026 Brian Collett. All rights reserved.
+//
+
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <zlib.h>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include "FieldViewerApp.h"
+#include "GridFile.h"
+
+static const char sMagic[8] = { 'F', 'V', 'G', 'R', 'I', 'D', 'S', 0 };
+static const uint32_t kGridFileOrder = 0x01020304;
+static const uint64_t kGFChunkBytes = kGFChunkNodes * 3 * sizeof(double);
+//
+//  Class vars.
+//
+int GridFile::sThreads = 0;
+//
+//  The chunks of size bytes of node data, and the size of chunk c.
+//
+static size_t ChunkCount(uint64_t size)
+{
+  return (size_t) ((size + kGFChunkBytes - 1) / kGFChunkBytes);
+}
+static uint64_t ChunkSize(uint64_t size, size_t c)
+{
+  return std::min(kGFChunkBytes, size - c * kGFChunkBytes);
+}
+//
+//  RunChunks calls work(c) for every chunk c on up to GetThreads()
+//  threads, which take chunks off a shared counter. The work for a
+//  chunk only ever touches that chunk's share of the data, so nothing
+//  needs a lock.
+//
+template<class Work>
+static void RunChunks(size_t nChunk, Work work)
+{
+  std::atomic<size_t> next(0);
+  auto run = [&]() {
+    size_t c;
+    while ((c = next++) < nChunk) {
+      work(c);
+    }
+  };
+  size_t nThreads = std::min((size_t) GridFile::GetThreads(), nChunk);
+  std::vector<std::thread> threads;
+  for (size_t t = 1; t < nThreads; t++) {
+    threads.push_back(std::thread(run));
+  }
+  run();
+  for (size_t t = 0; t < threads.size(); t++) {
+    threads[t].join();
+  }
+}
+//
+//  The adler32 of each chunk is worked out on its own and the sums are
+//  combined, which gives the same answer as one pass over the lot.
+//
+static uint32_t CheckSum(const double* data, uint64_t size)
+{
+  const Bytef* p = (const Bytef*) data;
+  size_t nChunk = ChunkCount(size);
+  std::vector<uLong> sums(nChunk);
+  RunChunks(nChunk, [&](size_t c) {
+    sums[c] = adler32(adler32(0L, Z_NULL, 0), p + c * kGFChunkBytes,
+                      (uInt) ChunkSize(size, c));
+  });
+  uLong sum = adler32(0L, Z_NULL, 0);
+  for (size_t c = 0; c < nChunk; c++) {
+    sum = adler32_combine(sum, sums[c], (z_off_t) ChunkSize(size, c));
+  }
+  return (uint32_t) sum;
+}
+static uint64_t AlignUp(uint64_t n)
+{
+  return (n + kGFAlign - 1) / kGFAlign * kGFAlign;
+}
+//
+//  ctors
+//
+GridFile::GridFile()
+{
+  mFile = nullptr;
+  mFileSize = 0;
+  memset(&mHead, 0, sizeof(mHead));
+}
+GridFile::~GridFile()
+{
+  Close();
+}
+//
+//  Open checks everything it can before anyone reads a grid, so that
+//  ReadGrid only has to worry about the data itself.
+//
+bool GridFile::Open(const char* path)
+{
+  Close();
+  mError.clear();
+  mFile = fopen(path, "rb");
+  if (nullptr == mFile) {
+    return Fail("%s: unable to open.", path);
+  }
+  struct stat st;
+  bool ok = (fstat(fileno(mFile), &st) == 0) &&
+            (fread(&mHead, sizeof(mHead), 1, mFile) == 1) &&
+            (memcmp(mHead.mMagic, sMagic, sizeof(sMagic)) == 0);
+  if (!ok) {
+    Close();
+    return Fail("%s: not a grid file.", path);
+  }
+  mFileSize = (uint64_t) st.st_size;
+  if (mHead.mOrder != kGridFileOrder) {
+    Close();
+    return Fail("%s: written with the other byte order.", path);
+  }
+  if ((mHead.mVersion != kGridFileVersion) ||
+      (mHead.mHeadSize != sizeof(GridFileHeader)) ||
+      (mHead.mSpecSize != sizeof(GridSpec)) || (mHead.mAlign != kGFAlign)) {
+    Close();
+    return Fail("%s: grid file version %u, we read version %u.", path,
+                mHead.mVersion, kGridFileVersion);
+  }
+  mHead.mSource[kGFSourceLength - 1] = 0;
+  ok = ((uint64_t) mHead.mNGrids <=
+        (mFileSize - sizeof(GridFileHeader)) / sizeof(GridSpec));
+  if (ok) {
+    mTable.resize(mHead.mNGrids);
+    ok = (mHead.mNGrids == 0) ||
+         (fread(&mTable[0], sizeof(GridSpec), mTable.size(), mFile) ==
+          mTable.size());
+  }
+  for (size_t i = 0; ok && (i < mTable.size()); i++) {
+    mTable[i].mName[kGFNameLength - 1] = 0;
+    ok = CheckSpec(mTable[i]);
+  }
+  if (!ok) {
+    Close();
+    return Fail("%s: the grid table is damaged.", path);
+  }
+  return true;
+}
+void GridFile::Close(void)
+{
+  if (nullptr != mFile) {
+    fclose(mFile);
+    mFile = nullptr;
+  }
+  mTable.clear();
+  mFileSize = 0;
+}
+int GridFile::Find(const char* name) const
+{
+  for (size_t i = 0; i < mTable.size(); i++) {
+    if (strcmp(mTable[i].mName, name) == 0) {
+      return (int) i;
+    }
+  }
+  return -1;
+}
+//
+//  The table has the offset of every section so reading one grid is a
+//  single seek.
+//
+bool GridFile::ReadGrid(int i, std::vector<double>& data)
+{
+  if ((nullptr == mFile) || (i < 0) || (i >= GetNGrids())) {
+    return Fail("There is no grid %d.", i);
+  }
+  const GridSpec& s = mTable[i];
+  data.resize((size_t) (s.mSize / sizeof(double)));
+  bool ok = (fseeko(mFile, (off_t) s.mOffset, SEEK_SET) == 0);
+  if (ok && (s.mCodec == kGFRaw)) {
+    ok = (fread(&data[0], 1, (size_t) s.mSize, mFile) == s.mSize);
+  } else if (ok) {
+    std::vector<unsigned char> packed((size_t) s.mStored);
+    ok = (fread(&packed[0], 1, packed.size(), mFile) == packed.size()) &&
+         Decode(packed, &data[0], s.mSize);
+  }
+  ok = ok && (CheckSum(&data[0], s.mSize) == s.mCheck);
+  if (!ok) {
+    data.clear();
+    return Fail("Grid %s is damaged.", s.mName);
+  }
+  return true;
+}
+//
+//  Write lays the sections out first and goes back for the header and
+//  the table once it knows where they went. A section that will not
+//  deflate to less than it started as is stored raw.
+//
+bool GridFile::Write(const char* path, const std::vector<GridSpec>& specs,
+                     const std::vector<const double*>& data, bool compress,
+                     const char* source)
+{
+  if (specs.size() != data.size()) {
+    return false;
+  }
+  GridFileHeader head;
+  memset(&head, 0, sizeof(head));
+  memcpy(head.mMagic, sMagic, sizeof(sMagic));
+  head.mVersion = kGridFileVersion;
+  head.mOrder = kGridFileOrder;
+  head.mHeadSize = sizeof(GridFileHeader);
+  head.mSpecSize = sizeof(GridSpec);
+  head.mAlign = kGFAlign;
+  head.mNGrids = (uint32_t) specs.size();
+  if (nullptr != source) {
+    strncpy(head.mSource, source, kGFSourceLength - 1);
+  }
+  std::vector<GridSpec> table(specs);
+  char pid[32];
+  snprintf(pid, sizeof(pid), ".%d", (int) getpid());
+  std::string tmpPath = std::string(path) + pid;
+  FILE* fp = fopen(tmpPath.c_str(), "wb");
+  if (nullptr == fp) {
+    eprintf("%s: unable to create.\n", path);
+    return false;
+  }
+  bool ok = true;
+  uint64_t at = AlignUp(sizeof(head) + table.size() * sizeof(GridSpec));
+  std::vector<unsigned char> packed;
+  for (size_t i = 0; ok && (i < table.size()); i++) {
+    GridSpec& s = table[i];
+    s.mName[kGFNameLength - 1] = 0;
+    s.mSize = NodeCount(s) * 3 * sizeof(double);
+    s.mCheck = CheckSum(data[i], s.mSize);
+    s.mOffset = at;
+    s.mCodec = kGFRaw;
+    s.mStored = s.mSize;
+    const void* out = data[i];
+    if (compress && Encode(data[i], s.mSize, packed) &&
+        (packed.size() < s.mSize)) {
+      s.mCodec = kGFDeflate;
+      s.mStored = packed.size();
+      out = &packed[0];
+    }
+    ok = (fseeko(fp, (off_t) at, SEEK_SET) == 0) &&
+         (fwrite(out, 1, (size_t) s.mStored, fp) == s.mStored);
+    at = AlignUp(at + s.mStored);
+  }
+  ok = ok && (fseeko(fp, 0, SEEK_SET) == 0) &&
+       (fwrite(&head, sizeof(head), 1, fp) == 1) &&
+       (table.empty() ||
+        (fwrite(&table[0], sizeof(GridSpec), table.size(), fp) == table.size()));
+  ok = (fclose(fp) == 0) && ok;
+  if (ok) {
+    ok = (rename(tmpPath.c_str(), path) == 0);
+  }
+  if (!ok) {
+    eprintf("%s: unable to write.\n", path);
+    remove(tmpPath.c_str());
+  }
+  return ok;
+}
+bool GridFile::IsGridFile(const char* path)
+{
+  FILE* fp = fopen(path, "rb");
+  if (nullptr == fp) {
+    return false;
+  }
+  char magic[sizeof(sMagic)];
+  bool ok = (fread(magic, sizeof(magic), 1, fp) == 1) &&
+            (memcmp(magic, sMagic, sizeof(sMagic)) == 0);
+  fclose(fp);
+  return ok;
+}
+//
+//  The spacing on each axis is nudged so that a whole number of steps
+//  spans the bounds exactly. An axis with no extent gets one node.
+//
+bool GridFile::SetSpacing(GridSpec& spec, const double* min, const double* max,
+                          double delta)
+{
+  if (!(delta > 0.0)) {
+    return false;
+  }
+  for (int k = 0; k < 3; k++) {
+    double span = max[k] - min[k];
+    if (!(span >= 0.0) || (span / delta >= 1.0e9)) {
+      return false;
+    }
+    uint32_t steps = (uint32_t) floor(span / delta + 0.5);
+    spec.mMin[k] = min[k];
+    spec.mMax[k] = max[k];
+    spec.mN[k] = steps + 1;
+    spec.mDelta[k] = (steps > 0) ? span / steps : delta;
+  }
+  return true;
+}
+uint64_t GridFile::NodeCount(const GridSpec& spec)
+{
+  return (uint64_t) spec.mN[0] * spec.mN[1] * spec.mN[2];
+}
+void GridFile::SetThreads(int nThreads)
+{
+  sThreads = (nThreads > 0) ? nThreads : 0;
+}
+int GridFile::GetThreads(void)
+{
+  int nThreads = sThreads;
+  if (nThreads == 0) {
+    nThreads = (int) std::thread::hardware_concurrency();
+  }
+  return (nThreads > 0) ? nThreads : 1;
+}
+//
+//  Helpers.
+//
+bool GridFile::Fail(const char* format, ...)
+{
+  char buff[512];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(buff, sizeof(buff), format, args);
+  va_end(args);
+  mError = buff;
+  return false;
+}
+//
+//  CheckSpec is everything Open knows about a table entry. The counts
+//  must multiply out without overflow, the spacing must be something
+//  that Interpolate can divide by and mMax must be where SetSpacing
+//  would have put it. The section must lie inside the file and not
+//  unpack to more than deflate could ever have packed into it.
+//
+bool GridFile::CheckSpec(const GridSpec& s) const
+{
+  for (int k = 0; k < 3; k++) {
+    if ((s.mN[k] == 0) || !isfinite(s.mMin[k]) || !isfinite(s.mMax[k]) ||
+        !isfinite(s.mDelta[k]) || !(s.mDelta[k] > 0.0)) {
+      return false;
+    }
+    double steps = (double) (s.mN[k] - 1);
+    double expect = s.mMin[k] + steps * s.mDelta[k];
+    double slack = (s.mN[k] > 1) ?
+                   1.0e-9 * (fabs(s.mMin[k]) + fabs(expect)) + DBL_MIN :
+                   0.5 * s.mDelta[k];
+    if (!(s.mMax[k] >= s.mMin[k]) || !(fabs(s.mMax[k] - expect) <= slack)) {
+      return false;
+    }
+  }
+  uint64_t plane = (uint64_t) s.mN[0] * s.mN[1];
+  if (plane > UINT64_MAX / 3 / sizeof(double) / s.mN[2]) {
+    return false;
+  }
+  if ((s.mSize != NodeCount(s) * 3 * sizeof(double)) || (s.mStored == 0) ||
+      (s.mOffset > mFileSize) || (s.mStored > mFileSize - s.mOffset)) {
+    return false;
+  }
+  if (s.mCodec == kGFRaw) {
+    return s.mStored == s.mSize;
+  }
+  return (s.mCodec == kGFDeflate) && (s.mSize / kGFMaxRatio <= s.mStored);
+}
+//
+//  A deflated section is the deflated size of each chunk followed by
+//  the chunks. They are packed into buffers of their own, all at once,
+//  and joined up after.
+//
+bool GridFile::Encode(const double* data, uint64_t size,
+                      std::vector<unsigned char>& out)
+{
+  size_t nChunk = ChunkCount(size);
+  std::vector<std::vector<unsigned char> > chunks(nChunk);
+  std::atomic<bool> ok(true);
+  RunChunks(nChunk, [&](size_t c) {
+    if (!EncodeChunk(data + c * (kGFChunkBytes / sizeof(double)),
+                     ChunkSize(size, c), chunks[c])) {
+      ok = false;
+    }
+  });
+  if (!ok) {
+    return false;
+  }
+  std::vector<uint64_t> lengths(nChunk);
+  uint64_t total = nChunk * sizeof(uint64_t);
+  for (size_t c = 0; c < nChunk; c++) {
+    lengths[c] = chunks[c].size();
+    total += lengths[c];
+  }
+  out.resize((size_t) total);
+  memcpy(&out[0], &lengths[0], nChunk * sizeof(uint64_t));
+  size_t at = nChunk * sizeof(uint64_t);
+  for (size_t c = 0; c < nChunk; c++) {
+    memcpy(&out[at], &chunks[c][0], chunks[c].size());
+    at += chunks[c].size();
+  }
+  return true;
+}
+//
+//  The sizes have to add up to the section exactly before any chunk is
+//  unpacked, so a damaged list can never send one outside it.
+//
+bool GridFile::Decode(const std::vector<unsigned char>& in, double* data,
+                      uint64_t size)
+{
+  size_t nChunk = ChunkCount(size);
+  uint64_t at = nChunk * sizeof(uint64_t);
+  if (in.size() < at) {
+    return false;
+  }
+  std::vector<uint64_t> start(nChunk + 1);
+  memcpy(&start[0], &in[0], nChunk * sizeof(uint64_t));
+  for (size_t c = 0; c < nChunk; c++) {
+    uint64_t length = start[c];
+    if (length > in.size() - at) {
+      return false;
+    }
+    start[c] = at;
+    at += length;
+  }
+  start[nChunk] = at;
+  if (at != in.size()) {
+    return false;
+  }
+  std::atomic<bool> ok(true);
+  RunChunks(nChunk, [&](size_t c) {
+    if (!DecodeChunk(&in[(size_t) start[c]], start[c + 1] - start[c],
+                     data + c * (kGFChunkBytes / sizeof(double)),
+                     ChunkSize(size, c))) {
+      ok = false;
+    }
+  });
+  return ok;
+}
+//
+//  The bytes of a double that change least, the sign, exponent and top
+//  of the mantissa, are much alike from node to node. Putting byte k of
+//  every value together gives deflate long runs to work with.
+//
+bool GridFile::EncodeChunk(const double* data, uint64_t size,
+                           std::vector<unsigned char>& out)
+{
+  uint64_t n = size / sizeof(double);
+  const unsigned char* in = (const unsigned char*) data;
+  std::vector<unsigned char> planes((size_t) size);
+  for (uint64_t j = 0; j < n; j++) {
+    for (size_t b = 0; b < sizeof(double); b++) {
+      planes[b * n + j] = in[j * sizeof(double) + b];
+    }
+  }
+  uLongf len = compressBound((uLong) size);
+  out.resize(len);
+  if (compress2(&out[0], &len, &planes[0], (uLong) size, Z_BEST_SPEED) != Z_OK) {
+    return false;
+  }
+  out.resize(len);
+  return true;
+}
+bool GridFile::DecodeChunk(const unsigned char* in, uint64_t length,
+                           double* data, uint64_t size)
+{
+  uint64_t n = size / sizeof(double);
+  std::vector<unsigned char> planes((size_t) size);
+  uLongf len = (uLongf) size;
+  if ((uncompress(&planes[0], &len, in, (uLong) length) != Z_OK) ||
+      (len != size)) {
+    return false;
+  }
+  unsigned char* out = (unsigned char*) data;
+  for (uint64_t j = 0; j < n; j++) {
+    for (size_t b = 0; b < sizeof(double); b++) {
+      out[j * sizeof(double) + b] = planes[b * n + j];
+    }
+  }
+  return true;
+}
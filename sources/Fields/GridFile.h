@@ -0,0 +1,179 @@
+//
+//  GridFile.h
+//  FieldViewer
+//
+//  A GridFile is our own container for field data: a set of regular
+//  grids of E field values, each with its own bounds and spacing, that
+//  may sit inside one another. A grid with a higher priority wins where
+//  grids overlap, so a fine grid round a detail nests inside a coarse
+//  one round the whole apparatus. See GridField for the field itself
+//  and FieldConvert for making these from the files COMSOL gives us.
+//  They are usually named .fvg.
+//
+//  The file is
+//
+//    GridFileHeader                 magic, version and sizes
+//    GridSpec[mNGrids]              the table, one entry per grid
+//    node data for each grid        at mOffset, kGFAlign aligned
+//
+//  Each grid's node data is nx * ny * nz (Ex, Ey, Ez) doubles, x
+//  varying fastest, NaN where there is no field. It is either stored as
+//  it is, so that the section can be used straight from the file, or
+//  with its bytes shuffled into planes and deflated, which packs real
+//  fields down several times. The table says which, and where each
+//  section starts and how long it is, so a reader can go straight to
+//  any one grid without touching the others.
+//
+//  A deflated section is cut into chunks of kGFChunkNodes nodes, each
+//  shuffled and deflated on its own, and starts with the deflated size
+//  of every chunk as a uint64_t. So once the section is in, where each
+//  chunk goes is known and they are all unpacked at once, one to a
+//  thread, straight into the grid's array.
+//
+//  Numbers are in the byte order of the machine that wrote the file and
+//  the header records it. A file from a machine with the other order is
+//  refused rather than swapped.
+//
+//  Created by Brian Collett on 10/19/26.
+//  Copyright (c) 2026 Brian Collett. All rights reserved.
+//
+
+#ifndef __FieldViewer__GridFile__
+#define __FieldViewer__GridFile__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+//
+//  Bump the version whenever the header, the table or the way the node
+//  data is stored change.
+//
+const uint32_t kGridFileVersion = 2;
+const uint32_t kGFAlign = 4096;         // sections start on a page
+const uint32_t kGFChunkNodes = 1 << 16; // nodes per deflated chunk
+const int kGFNameLength = 48;
+const int kGFSourceLength = 256;
+//
+//  Deflate never packs better than about 1032 to 1, so a section that
+//  claims to unpack to more than this many times its size is damaged.
+//
+const uint64_t kGFMaxRatio = 1032;
+//
+//  How a section is stored.
+//
+enum GridCodec {
+  kGFRaw = 0,
+  kGFDeflate                            // byte planes, then zlib
+};
+//
+//  A table entry. mMax is mMin + (mN - 1) * mDelta, kept so that the
+//  bounds are exact. mCheck is the adler32 of the node data as it is
+//  in memory, whatever the codec.
+//
+struct GridSpec {
+  char mName[kGFNameLength];
+  double mMin[3];
+  double mMax[3];
+  double mDelta[3];
+  uint32_t mN[3];
+  int32_t mPriority;
+  uint32_t mCodec;
+  uint32_t mCheck;
+  uint64_t mOffset;                     // of the section in the file
+  uint64_t mStored;                     // bytes in the file
+  uint64_t mSize;                       // bytes in memory
+};
+struct GridFileHeader {
+  char mMagic[8];
+  uint32_t mVersion;
+  uint32_t mOrder;
+  uint32_t mHeadSize;                   // sizeof(GridFileHeader)
+  uint32_t mSpecSize;                   // sizeof(GridSpec)
+  uint32_t mAlign;
+  uint32_t mNGrids;
+  char mSource[kGFSourceLength];        // what it was made from
+};
+
+class GridFile {
+protected:
+  //
+  //  Instance vars.
+  //
+  FILE* mFile;
+  uint64_t mFileSize;
+  GridFileHeader mHead;
+  std::vector<GridSpec> mTable;
+  std::string mError;
+  //
+  //  Class vars.
+  //
+  static int sThreads;
+public:
+  //
+  //  ctors
+  //
+  GridFile();
+  virtual ~GridFile();
+  //
+  //  Open reads the header and the table and checks that every section
+  //  lies inside the file. If it, or ReadGrid, fails GetError says why.
+  //  Nothing goes to the log, so a GridFile can be read on any thread.
+  //
+  bool Open(const char* path);
+  void Close(void);
+  const std::string& GetError(void) const { return mError; };
+  //
+  //  The table.
+  //
+  int GetNGrids(void) const { return (int) mTable.size(); };
+  const GridSpec& GetSpec(int i) const { return mTable[i]; };
+  int Find(const char* name) const;
+  const char* GetSource(void) const { return mHead.mSource; };
+  //
+  //  Read one grid's node data, decoding it if need be.
+  //
+  bool ReadGrid(int i, std::vector<double>& data);
+  //
+  //  Write a whole file. data[i] holds the node data for specs[i], whose
+  //  name, bounds, spacing, counts and priority must be filled in; the
+  //  rest is worked out here. The file is written beside path and
+  //  renamed into place, so a reader never sees half of one.
+  //
+  static bool Write(const char* path, const std::vector<GridSpec>& specs,
+                    const std::vector<const double*>& data, bool compress,
+                    const char* source);
+  //
+  //  True if the file at path starts like one of ours.
+  //
+  static bool IsGridFile(const char* path);
+  //
+  //  Fill in the counts and the exact maximum for a grid from its
+  //  bounds and spacing. False if the spacing is not positive.
+  //
+  static bool SetSpacing(GridSpec& spec, const double* min, const double* max,
+                         double delta);
+  static uint64_t NodeCount(const GridSpec& spec);
+  //
+  //  Threads used on the chunks of a section, 0 for one per core.
+  //
+  static void SetThreads(int nThreads);
+  static int GetThreads(void);
+protected:
+  //
+  //  Helpers.
+  //
+  bool Fail(const char* format, ...);
+  bool CheckSpec(const GridSpec& s) const;
+  static bool Encode(const double* data, uint64_t size,
+                     std::vector<unsigned char>& out);
+  static bool Decode(const std::vector<unsigned char>& in, double* data,
+                     uint64_t size);
+  static bool EncodeChunk(const double* data, uint64_t size,
+                          std::vector<unsigned char>& out);
+  static bool DecodeChunk(const unsigned char* in, uint64_t length,
+                          double* data, uint64_t size);
+};
+
+#endif /* defined(__FieldViewer__GridFile__) */
@@ -0,0 +1,199 @@
+//
+//  FileWatcher.cpp
+//  FieldViewer
+//
+//  Tells the document when its files are rewritten. See FileWatcher.h.
+//
+//  Created by Brian Collett on 10/19/26.
+//  Copyright (c) 2026 Brian Collett. All rights reserved.
+//
+
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+#include "FileWatcher.h"
+
+#ifdef __linux__
+//
+//  The directory events that can mean a file has new contents. A file
+//  renamed into place arrives as IN_MOVED_TO and touch gives IN_ATTRIB.
+//
+static const uint32_t kFWEvents = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE |
+                                  IN_ATTRIB;
+#endif
+//
+//  ctors
+//
+FileWatcher::FileWatcher()
+{
+#ifdef __linux__
+  mNotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#else
+  mNotify = -1;
+#endif
+}
+FileWatcher::~FileWatcher()
+{
+  if (mNotify >= 0) {
+    close(mNotify);
+  }
+}
+//
+//  Each file is watched through its directory. inotify hands back the
+//  same watch for a directory that is already watched.
+//
+bool FileWatcher::Watch(const char* path)
+{
+  for (size_t i = 0; i < mEntries.size(); i++) {
+    if (mEntries[i].mPath == path) {
+      return true;
+    }
+  }
+  Entry e;
+  if (!Stamp(path, e.mStamp)) {
+    return false;
+  }
+  e.mPath = path;
+  e.mWatch = -1;
+  e.mHeard = false;
+  e.mChanging = false;
+  size_t slash = e.mPath.rfind('/');
+  std::string dir;
+  if (slash == std::string::npos) {
+    dir = ".";
+    e.mName = e.mPath;
+  } else {
+    dir = (slash == 0) ? "/" : e.mPath.substr(0, slash);
+    e.mName = e.mPath.substr(slash + 1);
+  }
+#ifdef __linux__
+  if (mNotify >= 0) {
+    e.mWatch = inotify_add_watch(mNotify, dir.c_str(), kFWEvents);
+  }
+#endif
+  mEntries.push_back(e);
+  return true;
+}
+void FileWatcher::Forget(const char* path)
+{
+  for (size_t i = 0; i < mEntries.size(); i++) {
+    if (mEntries[i].mPath != path) {
+      continue;
+    }
+    int watch = mEntries[i].mWatch;
+    mEntries.erase(mEntries.begin() + i);
+#ifdef __linux__
+    bool shared = false;
+    for (size_t j = 0; j < mEntries.size(); j++) {
+      shared = shared || (mEntries[j].mWatch == watch);
+    }
+    if ((watch >= 0) && !shared) {
+      inotify_rm_watch(mNotify, watch);
+    }
+#endif
+    return;
+  }
+}
+void FileWatcher::Clear(void)
+{
+  while (!mEntries.empty()) {
+    std::string path = mEntries.back().mPath;
+    Forget(path.c_str());
+  }
+}
+//
+//  With inotify we only look at files that we have heard about, that
+//  are settling down or that we could not get a watch for. Without it
+//  we look at everything.
+//
+int FileWatcher::Poll(std::vector<std::string>& changed)
+{
+  int n = 0;
+  Drain();
+  for (size_t i = 0; i < mEntries.size(); i++) {
+    Entry& e = mEntries[i];
+    if ((e.mWatch >= 0) && !e.mHeard && !e.mChanging) {
+      continue;
+    }
+    e.mHeard = false;
+    int64_t now[3];
+    if (!Stamp(e.mPath.c_str(), now)) {
+      //
+      //  Gone, perhaps for a moment while a new one is moved in. Keep
+      //  looking until it comes back.
+      //
+      e.mHeard = true;
+      continue;
+    }
+    if (SameStamp(now, e.mStamp)) {
+      e.mChanging = false;
+    } else if (e.mChanging && SameStamp(now, e.mNext)) {
+      memcpy(e.mStamp, now, sizeof(now));
+      e.mChanging = false;
+      changed.push_back(e.mPath);
+      n++;
+    } else {
+      memcpy(e.mNext, now, sizeof(now));
+      e.mChanging = true;
+    }
+  }
+  return n;
+}
+//
+//  Helpers.
+//  Drain reads everything inotify has for us and marks the files it
+//  mentions. If the queue overflowed we no longer know what changed and
+//  look at everything.
+//
+void FileWatcher::Drain(void)
+{
+#ifdef __linux__
+  if (mNotify < 0) {
+    return;
+  }
+  char buff[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+  ssize_t len;
+  while ((len = read(mNotify, buff, sizeof(buff))) > 0) {
+    const char* p = buff;
+    while (p < buff + len) {
+      const struct inotify_event* ev = (const struct inotify_event*) p;
+      p += sizeof(struct inotify_event) + ev->len;
+      for (size_t i = 0; i < mEntries.size(); i++) {
+        Entry& e = mEntries[i];
+        if (ev->mask & IN_Q_OVERFLOW) {
+          e.mHeard = true;
+        } else if (e.mWatch == ev->wd) {
+          if (ev->mask & IN_IGNORED) {
+            e.mWatch = -1;          // the directory went, so look instead
+          } else if ((ev->len > 0) && (e.mName == ev->name)) {
+            e.mHeard = true;
+          }
+        }
+      }
+    }
+  }
+#endif
+}
+bool FileWatcher::Stamp(const char* path, int64_t* stamp)
+{
+  struct stat st;
+  if ((stat(path, &st) != 0) || !S_ISREG(st.st_mode)) {
+    return false;
+  }
+  stamp[0] = st.st_size;
+  stamp[1] = st.st_mtime;
+#ifdef __APPLE__
+  stamp[2] = st.st_mtimespec.tv_nsec;
+#else
+  stamp[2] = st.st_mtim.tv_nsec;
+#endif
+  return true;
+}
+bool FileWatcher::SameStamp(const int64_t* a, const int64_t* b)
+{
+  return (a[0] == b[0]) && (a[1] == b[1]) && (a[2] == b[2]);
+}
@@ -0,0 +1,81 @@
+//
+//  FileWatcher.h
+//  FieldViewer
+//
+//  A FileWatcher keeps an eye on a handful of files and says when one
+//  of them has been rewritten, so that the document can read it again.
+//
+//  On Linux it asks inotify about the directories the files are in, so
+//  that it sees a file written in place and one renamed over the old
+//  one, and only looks at the files it has heard about. Elsewhere it
+//  just looks at the size and modification time of every file each time
+//  it is polled.
+//
+//  Nothing happens behind the owner's back. Poll is called, usually from
+//  a timer, and a file is only reported once its size and time have
+//  stayed the same from one poll to the next, so a file that is still
+//  being written is not read half way through.
+//
+//  Created by Brian Collett on 10/19/26.
+//  Copyright (c) 2026 Brian Collett. All rights reserved.
+//
+
+#ifndef __FieldViewer__FileWatcher__
+#define __FieldViewer__FileWatcher__
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+class FileWatcher {
+protected:
+  //
+  //  What we know about each file. mStamp is the size and modification
+  //  time when it was last reported, or when it was first watched, and
+  //  mNext is a different one that it will be reported with if it holds
+  //  until the next poll.
+  //
+  struct Entry {
+    std::string mPath;
+    std::string mName;          // within its directory, for inotify
+    int mWatch;                 // inotify watch on the directory, or -1
+    bool mHeard;                // inotify said something happened to it
+    bool mChanging;             // mNext is valid
+    int64_t mStamp[3];
+    int64_t mNext[3];
+  };
+  std::vector<Entry> mEntries;
+  int mNotify;                  // inotify descriptor, or -1
+public:
+  //
+  //  ctors
+  //
+  FileWatcher();
+  virtual ~FileWatcher();
+  //
+  //  Start or stop watching a file. Watching a file twice is harmless.
+  //  Watch returns false if the file is not there to be watched.
+  //
+  bool Watch(const char* path);
+  void Forget(const char* path);
+  void Clear(void);
+  bool IsEmpty(void) const { return mEntries.empty(); };
+  //
+  //  Append the paths of the files that have changed since they were
+  //  last reported and return how many there were.
+  //
+  int Poll(std::vector<std::string>& changed);
+  //
+  //  True if we are being told about changes rather than looking.
+  //
+  bool UsesNotify(void) const { return mNotify >= 0; };
+protected:
+  //
+  //  Helpers.
+  //
+  void Drain(void);
+  static bool Stamp(const char* path, int64_t* stamp);
+  static bool SameStamp(const int64_t* a, const int64_t* b);
+};
+
+#endif /* defined(__FieldViewer__FileWatcher__) */
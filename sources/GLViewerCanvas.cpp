@@ -23,12 +23,18 @@
  */
 #include <stdio.h>
 #include <math.h>
+#include <string.h>
+#include <vector>
+#include "wx/dcmemory.h"
+#include "wx/dcscreen.h"
 #include "FieldViewerApp.h"
 #include "GLViewerView.h"
 #include "GLViewerFrame.h"
 #include "GLViewerCanvas.h"
 
 #include "GeometricObjects.h"
+#include "OffscreenTarget.h"
+#include "Profiler.h"
 //
 extern "C" {
 #include  "trackball.h"
@@ -43,6 +49,9 @@ EVT_SIZE(GLViewerCanvas::OnSize)
 EVT_PAINT(GLViewerCanvas::OnPaint)
 EVT_ERASE_BACKGROUND(GLViewerCanvas::OnEraseBackground)
 EVT_MOUSE_EVENTS(GLViewerCanvas::OnMouse)
+EVT_MOUSE_CAPTURE_LOST(GLViewerCanvas::OnCaptureLost)
+EVT_TIMER(bcID_HOVER_TIMER, GLViewerCanvas::OnHoverTimer)
+EVT_TIMER(bcID_FRAME_TIMER, GLViewerCanvas::OnFrameTimer)
 END_EVENT_TABLE()
 //
 //  Constructor
@@ -61,7 +70,9 @@ GLViewerCanvas::GLViewerCanvas(GLViewerView* theView,
                              size,
                              style|wxFULL_REPAINT_ON_RESIZE,
                              name),
-                  GLMouseResponder()
+                  GLMouseResponder(),
+                  mHoverTimer(this, bcID_HOVER_TIMER),
+                  mFrameTimer(this, bcID_FRAME_TIMER)
 {
   //
   //  Connect to a context
@@ -81,6 +92,15 @@ GLViewerCanvas::GLViewerCanvas(GLViewerView* theView,
   mFar = 250.0f;
   trackball(mSpinQuat, 0.0f, 0.0f, 0.0f, 0.0f);
   mInitialized = false;	// True only after OpenGL is up an running.
+  mHaveCamera = false;
+  mInteracting = false;
+  mMoves = 0;
+  mHoverX = mHoverY = 0;
+  mRedrawPending = false;
+  mShowProfile = false;
+  mProfTex = nullptr;
+  mProfW = mProfH = 0;
+  mExportHeight = 0;
   //
   // Create tools.
   //
@@ -105,6 +125,11 @@ GLViewerCanvas::~GLViewerCanvas()
   //
   //	Super takes care of deleting menus and menu bars.
   //
+  mHoverTimer.Stop();
+  mFrameTimer.Stop();
+  if (nullptr != mProfTex) {
+    delete mProfTex;
+  }
   delete mPtrTool;
   delete mSpinTool;
   delete mPanTool;
@@ -119,6 +144,44 @@ void GLViewerCanvas::GetSize(wxSize& theSize)
   theSize = GetClientSize();
 }
 //
+//  The camera as of the last paint.
+//
+bool GLViewerCanvas::GetCamera(GLdouble mv[16], GLdouble proj[16],
+                               GLint vp[4]) const
+{
+  if (!mHaveCamera) {
+    return false;
+  }
+  for (int i = 0; i < 16; i++) {
+    mv[i] = mMVMatrix[i];
+    proj[i] = mProjMatrix[i];
+  }
+  for (int i = 0; i < 4; i++) {
+    vp[i] = mViewport[i];
+  }
+  return true;
+}
+//
+//  Unproject a window point onto the near and far planes. GL's y runs
+//  bottom up so we flip it first.
+//
+bool GLViewerCanvas::ScreenRay(int x, int y, Point3D& start, Point3D& end) const
+{
+  if (!mHaveCamera) {
+    return false;
+  }
+  GLdouble realy = mViewport[3] - GLdouble(y) - 1.0;
+  if ((gluUnProject(GLdouble(x), realy, 0.0,
+                    mMVMatrix, mProjMatrix, mViewport,
+                    &start.mX, &start.mY, &start.mZ) == GL_FALSE) ||
+      (gluUnProject(GLdouble(x), realy, 1.0,
+                    mMVMatrix, mProjMatrix, mViewport,
+                    &end.mX, &end.mY, &end.mZ) == GL_FALSE)) {
+    return false;
+  }
+  return true;
+}
+//
 //  This is  little utility to set the view parameters to give
 //  an optimal view of a particular region of space. We pass in
 //  a Frame3D but add a flag that tells us whether to keep the
@@ -189,6 +252,36 @@ void GLViewerCanvas::FocusOn(Frame3D* box, bool keepCenter)
   Refresh(false);
 }
 //
+//  The camera for a session. mCentre is in rotated coordinates, like
+//  everything else here, so it goes in and out as it is.
+//
+void GLViewerCanvas::GetView(GLViewState* state) const
+{
+  for (int i = 0; i < 3; i++) {
+    state->mLookAt[i] = mCentre.mCoords[i];
+  }
+  for (int i = 0; i < 4; i++) {
+    state->mSpin[i] = mSpinQuat[i];
+  }
+  state->mAngle = mViewAngle;
+  state->mDist = mCamDist;
+  state->mNearDist = mNear;
+  state->mFarDist = mFar;
+}
+void GLViewerCanvas::SetView(const GLViewState& state)
+{
+  mCentre.Set(state.mLookAt[0], state.mLookAt[1], state.mLookAt[2]);
+  for (int i = 0; i < 4; i++) {
+    mSpinQuat[i] = state.mSpin[i];
+  }
+  mViewAngle = state.mAngle;
+  mCamDist = state.mDist;
+  mNear = state.mNearDist;
+  mFar = state.mFarDist;
+  mMoves++;
+  RequestRedraw();
+}
+//
 //  Paint has to establish the view params and then render
 //  the model.
 //
@@ -196,6 +289,8 @@ void GLViewerCanvas::OnPaint( wxPaintEvent& WXUNUSED(event) )
 {
   // must always be here
   wxPaintDC dc(this);
+  mRedrawPending = false;
+  ProfScope prof(kProfPaint);
   
   SetCurrent(*mContext);
   /*
@@ -214,16 +309,66 @@ void GLViewerCanvas::OnPaint( wxPaintEvent& WXUNUSED(event) )
   glClearColor( 0.1f, 0.1f, 0.1f, 1.0f );
   glClear( GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT );
   
+	glPushMatrix();
+  SetCamera(nullptr);
+  DrawScene();
+
+  if (mRegionActive) {
+    int w, h;
+    GetClientSize(&w, &h);
+
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    gluOrtho2D(0, w, h, 0);
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+    
+    
+    glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
+    glBegin(GL_LINE_STRIP);
+    glVertex2f( mRBStart[0], mRBStart[1]);
+    glVertex2f( mRBEnd[0], mRBStart[1]);
+    glVertex2f( mRBEnd[0], mRBEnd[1]);
+    glVertex2f( mRBStart[0], mRBEnd[1]);
+    glVertex2f( mRBStart[0], mRBStart[1]);
+    glEnd();
+  }
+  if (mShowProfile) {
+    DrawProfile();
+  }
+
+  glPopMatrix();
   //
-  //  Adjust the direction vectors according to the current
-  //  spin.
+  // Flush makes sure that all commands are finished before we display.
   //
-	//
-	//	Set up viewing system based on current view parameters.
-	//
-	glPushMatrix();
+  glFlush();
+  //
+  // Swap buffers displays the latest view.
+  //
+  SwapBuffers();
+  mSincePaint.Start();
+}
+
+//
+//  Set up the projection and model view for the current view
+//  parameters. window, if given, is left, right, bottom and top of the
+//  part of the view to draw, in the -1 to 1 range of the whole view,
+//  which is how an export draws one tile of a big picture.
+//
+void GLViewerCanvas::SetCamera(const GLdouble* window)
+{
 	glMatrixMode(GL_PROJECTION);
 	glLoadIdentity();
+  if (nullptr != window) {
+    //
+    //  Stretch the part of the view we want over the whole viewport.
+    //
+    GLdouble w = window[1] - window[0];
+    GLdouble h = window[3] - window[2];
+    glTranslated(-(window[0] + window[1]) / w,
+                 -(window[2] + window[3]) / h, 0.0);
+    glScaled(2.0 / w, 2.0 / h, 1.0);
+  }
 	gluPerspective(mViewAngle, mAspect, mNear, mFar);
 	glMatrixMode(GL_MODELVIEW);
 	glLoadIdentity();
@@ -243,7 +388,19 @@ void GLViewerCanvas::OnPaint( wxPaintEvent& WXUNUSED(event) )
   //
   glRotatef(-120.0, 1.0f, 1.0f, 1.0f);
   glRotatef(180.0, 0.0f, 0.0f, 1.0f);
-
+  //
+  //  Keep a copy of the camera for anyone who wants to cast rays.
+  //
+  glGetDoublev(GL_MODELVIEW_MATRIX, mMVMatrix);
+  glGetDoublev(GL_PROJECTION_MATRIX, mProjMatrix);
+  glGetIntegerv(GL_VIEWPORT, mViewport);
+  mHaveCamera = true;
+}
+//
+//  The axes and the model, in the camera set up by SetCamera.
+//
+void GLViewerCanvas::DrawScene()
+{
   glDisable(GL_LIGHTING);
   //
   //	Put in a set of axes just so that we have something to look at.
@@ -295,37 +452,6 @@ void GLViewerCanvas::OnPaint( wxPaintEvent& WXUNUSED(event) )
   //	Get view to display model.
   //
   mModel->Render(false);
-
-  if (mRegionActive) {
-    int w, h;
-    GetClientSize(&w, &h);
-
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
-    gluOrtho2D(0, w, h, 0);
-    glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
-    
-    
-    glColor4f(1.0f, 1.0f, 1.0f, 1.0f);
-    glBegin(GL_LINE_STRIP);
-    glVertex2f( mRBStart[0], mRBStart[1]);
-    glVertex2f( mRBEnd[0], mRBStart[1]);
-    glVertex2f( mRBEnd[0], mRBEnd[1]);
-    glVertex2f( mRBStart[0], mRBEnd[1]);
-    glVertex2f( mRBStart[0], mRBStart[1]);
-    glEnd();
-  }
-
-  glPopMatrix();
-  //
-  // Flush makes sure that all commands are finished before we display.
-  //
-  glFlush();
-  //
-  // Swap buffers displays the latest view.
-  //
-  SwapBuffers();
 }
 
 //
@@ -346,9 +472,40 @@ void GLViewerCanvas::OnEraseBackground(wxEraseEvent& WXUNUSED(event))
 //
 //	Mouse event passes most of its work to tools.
 //
+//
+//  We hold the mouse while a button is down so that the release comes
+//  back to us even if it happens outside the window, and every drag
+//  gets its EndDrag.
+//
 void GLViewerCanvas::OnMouse(wxMouseEvent& event)
 {
+  if ((event.ButtonDown() || event.ButtonDClick()) && !HasCapture()) {
+    CaptureMouse();
+  }
+  //
+  //  The field views and a big model draw proxies while we interact, so
+  //  a release that somehow never reached us must not leave them that
+  //  way. A move with no button down means the drag is over.
+  //
+  if (mInteracting && event.Moving()) {
+    EndDrag();
+  }
 	CMouseTool::DispatchToolEvent(event, mCTool);
+  if (event.ButtonUp() && HasCapture()) {
+    ReleaseMouse();
+  }
+}
+//
+//  Something else took the mouse, a dialog or another application, so
+//  the drag is over and no release is coming.
+//
+void GLViewerCanvas::OnCaptureLost(wxMouseCaptureLostEvent& WXUNUSED(event))
+{
+  if (mRegionActive) {
+    mRegionActive = false;
+    Refresh(false);
+  }
+  EndDrag();
 }
 //
 //	Mouse movement helpers.
@@ -356,87 +513,15 @@ void GLViewerCanvas::OnMouse(wxMouseEvent& event)
 void GLViewerCanvas::LeftClick(int x, int y)
 {
   if (mCTool == mPtrTool) {
-    //
-    //  First we get info about the viewport and translate the y coord
-    //  from the screen's top down to the GL's bottom up structure.
-    //
-    GLint viewport[4];
-    GLdouble mvmatrix[16],projmatrix[16];
-    GLint realy;            // GL's mapping is upside-down from ours.
-    glGetIntegerv(GL_VIEWPORT, viewport);
-    realy = viewport[3] - GLint(y) - 1;
-//    iprintf("Mouse at %d, %d\n",x,realy);
-    //
-    //  This is the dread picking code!
-    //  Start by setting up a buffer to store the hits.
-    //
-    GLuint pickBuff[100];
-    GLint nHit = -1;
-    glSelectBuffer(99, pickBuff+1);
-    (void) glRenderMode(GL_SELECT);
-    glInitNames();
-    glPushName(0);
-    glPushMatrix();
-    //
-    //  We do the projection matrix twice. First time for the coord
-    //  transform and then again for the picking operation.
-    //
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
-    gluPerspective(mViewAngle, mAspect, mNear, mFar);
-    glGetDoublev(GL_PROJECTION_MATRIX, projmatrix);
-    glLoadIdentity();
-    gluPickMatrix(x, realy, 0.1, 0.1, viewport);
-    gluPerspective(mViewAngle, mAspect, mNear, mFar);
-    glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
-    Point3D eye = mCentre + mCamDir * mCamDist;
-    gluLookAt(eye.mX, eye.mY, eye.mZ,
-              mCentre.mX, mCentre.mY, mCentre.mZ,
-              mUp.mX, mUp.mY, mUp.mZ);
-    //
-    //  Rotate by current spin.
-    //
-    GLfloat m[4][4];
-    build_rotmatrix( m, mSpinQuat );
-    glMultMatrixf( &m[0][0] );
-    // 	glTranslatef(mCentre[0], mCentre[1], mCentre[2]);
-    //
-    //  Rotate to my view direction.
-    //
-    glRotatef(-120.0, 1.0f, 1.0f, 1.0f);
-    glRotatef(180.0, 0.0f, 0.0f, 1.0f);
-    glGetDoublev(GL_MODELVIEW_MATRIX, mvmatrix);
-    //
-    //	Get view to display model.
-    //
-    mModel->Render(true);
-    
-    glPopMatrix();
-    //
-    // Flush makes sure that all commands are finished before we display.
-    //
-    glFlush();
-    nHit = glRenderMode(GL_RENDER);
-    pickBuff[0] = nHit;
-//    iprintf("Found %d hits\n", nHit);
-    //
-    //  Use the same setup to translate the hit point to 3D coordinates.
-    //
-    Point3D start, end;     // Returned world coords.
     //
     //  A mouse click can really only tell us about a line in 3D space
     //  since we can't tell where along that line the click occurs.
+    //  The model works out what lies along the line for itself.
     //
-    gluUnProject(GLdouble(x), GLdouble(realy), 0.0, // Screen space pt
-                 mvmatrix, projmatrix, viewport,    // Transform info
-                 &start.mX, &start.mY, &start.mZ);  // World space pt
-//    iprintf("At z=0 would be %f, %f, %f\n", start.mX, start.mY, start.mZ);
-    gluUnProject(GLdouble(x), GLdouble(realy), 1.0,
-                 mvmatrix, projmatrix, viewport,
-                 &end.mX, &end.mY, &end.mZ);  // World space pt
-//    iprintf("At z=1.0 would be %f, %f, %f\n", end.mX, end.mY, end.mZ);
-    mModel->DoClick(&pickBuff[0], start, end);
+    Point3D start, end;     // Returned world coords.
+    if (ScreenRay(x, y, start, end)) {
+      mModel->DoClick(start, end);
+    }
   }
 }
 
@@ -456,7 +541,9 @@ void GLViewerCanvas::Pan(float dx, float dy)
 //  mCentre += mUp * 10.0 * dy;    // re-use of static var by multiply
   mCentre += mRight * xSpan * dx; // Have to do in two stages because of
   mCentre += mUp * ySpan * dy;    // re-use of static var by multiply
-	Refresh(false);
+	mInteracting = true;
+	mMoves++;
+	RequestRedraw();
 }
 void GLViewerCanvas::Dolly(float dy)
 {
@@ -467,7 +554,9 @@ void GLViewerCanvas::Dolly(float dy)
 	mCamDist -= dy * mCamDist;
   mNear -= dy * mNear;
   mFar -= dy * mFar;
-	Refresh(false);
+	mInteracting = true;
+	mMoves++;
+	RequestRedraw();
 }
 void GLViewerCanvas::Zoom(float dy)
 {
@@ -476,14 +565,18 @@ void GLViewerCanvas::Zoom(float dy)
 	//	which to change the view angle.
 	//
 	mViewAngle -= dy * mViewAngle;
-	Refresh(false);
+	mInteracting = true;
+	mMoves++;
+	RequestRedraw();
 }
 void GLViewerCanvas::Spin(float quaternion[4])
 {
 	add_quats(quaternion,  mSpinQuat, mSpinQuat);
 	
 	/* orientation has changed, redraw mesh */
-	Refresh(false);
+	mInteracting = true;
+	mMoves++;
+	RequestRedraw();
 }
 void GLViewerCanvas::StartRegion(float xs, float ys){
   mRBStart[0] = xs;
@@ -497,7 +590,7 @@ void GLViewerCanvas::Region(float xe, float ye){
   mRBEnd[0] = xe;
   mRBEnd[1] = ye;
   iprintf("Box %f,%f to %f,%f\n", mRBStart[0],mRBStart[1], mRBEnd[0], mRBEnd[1]);
-  Refresh(false);
+  RequestRedraw();
 }
 void GLViewerCanvas::EndRegion(float xe, float ye){
   mRBEnd[0] = xe;
@@ -506,6 +599,251 @@ void GLViewerCanvas::EndRegion(float xe, float ye){
   Refresh(false);
 }
 //
+//  The drag is over so the next paint can be done properly.
+//
+void GLViewerCanvas::EndDrag(void)
+{
+  if (mInteracting) {
+    mInteracting = false;
+    RequestRedraw();
+  }
+}
+//
+//  If a frame interval has already gone by since the last paint then
+//  paint straight away, otherwise let the timer do it when the time is
+//  up. Requests that arrive while the timer runs only set the flag.
+//
+void GLViewerCanvas::RequestRedraw(void)
+{
+  mRedrawPending = true;
+  if (mFrameTimer.IsRunning()) {
+    return;
+  }
+  long wait = kFrameInterval - mSincePaint.Time();
+  if (wait <= 0) {
+    Refresh(false);
+  } else {
+    mFrameTimer.StartOnce((int) wait);
+  }
+}
+void GLViewerCanvas::OnFrameTimer(wxTimerEvent& WXUNUSED(event))
+{
+  if (mRedrawPending) {
+    Refresh(false);
+  }
+}
+//
+//  Hover just notes where the mouse is and makes sure that the timer
+//  will come round to look at it.
+//
+void GLViewerCanvas::Hover(int x, int y)
+{
+  mHoverX = x;
+  mHoverY = y;
+  if (!mHoverTimer.IsRunning()) {
+    mHoverTimer.StartOnce(kHoverInterval);
+  }
+}
+//
+//  Ask the model what lies under the mouse and put the answer in the
+//  status bar. This works from the cached camera and never repaints.
+//
+void GLViewerCanvas::OnHoverTimer(wxTimerEvent& WXUNUSED(event))
+{
+  if ((nullptr == mModel) || mInteracting) {
+    return;
+  }
+  Point3D start, end;
+  if (!ScreenRay(mHoverX, mHoverY, start, end)) {
+    return;
+  }
+  char buff[256];
+  if (!mModel->Hover(start, end, buff, sizeof(buff))) {
+    buff[0] = 0;
+  }
+  mView->mFrame->SetStatusText(wxString(buff));
+}
+//
+//  Profiler overlay.
+//
+void GLViewerCanvas::ShowProfiler(bool show)
+{
+  mShowProfile = show;
+  gProfiler.SetEnabled(show);
+  mProfW = mProfH = 0;
+  mProfAge.Start(kProfOverlayInterval);    // Due now
+  RequestRedraw();
+}
+//
+//  DrawProfile is called at the end of a paint with the context current.
+//  Every so often it renders the profiler report into a bitmap, then it
+//  draws that bitmap in the top left corner in window coordinates.
+//
+void GLViewerCanvas::DrawProfile()
+{
+  if ((nullptr == mProfTex) || (mProfAge.Time() >= kProfOverlayInterval)) {
+    char buff[2048];
+    gProfiler.Report(buff, sizeof(buff));
+    wxArrayString lines = wxSplit(wxString(buff), '\n');
+    wxFont font(wxFontInfo(10).Family(wxFONTFAMILY_TELETYPE));
+    wxScreenDC sdc;
+    sdc.SetFont(font);
+    int lineH = 0, w = 0;
+    for (size_t i = 0; i < lines.GetCount(); i++) {
+      wxSize sz = sdc.GetTextExtent(lines[i]);
+      if (sz.GetWidth() > w) w = sz.GetWidth();
+      if (sz.GetHeight() > lineH) lineH = sz.GetHeight();
+    }
+    mProfW = w + 8;
+    mProfH = lineH * (int) lines.GetCount() + 8;
+    wxBitmap bmp(mProfW, mProfH, 24);
+    wxMemoryDC dc(bmp);
+    dc.SetBackground(*wxBLACK_BRUSH);
+    dc.Clear();
+    dc.SetFont(font);
+    dc.SetTextForeground(*wxGREEN);
+    for (size_t i = 0; i < lines.GetCount(); i++) {
+      dc.DrawText(lines[i], 4, 4 + lineH * (int) i);
+    }
+    dc.SelectObject(wxNullBitmap);
+    //
+    //  wxImage rows run top to bottom, and so does our ortho projection,
+    //  so the texture goes on the right way up.
+    //
+    wxImage img = bmp.ConvertToImage();
+    const unsigned char* rgb = img.GetData();
+    std::vector<GLubyte> rgba(4 * mProfW * mProfH);
+    for (int i = 0; i < mProfW * mProfH; i++) {
+      rgba[4 * i] = rgb[3 * i];
+      rgba[4 * i + 1] = rgb[3 * i + 1];
+      rgba[4 * i + 2] = rgb[3 * i + 2];
+      rgba[4 * i + 3] = 200;
+    }
+    if (nullptr == mProfTex) {
+      mProfTex = new FieldTexture();
+    }
+    mProfTex->InstallImage(mProfW, mProfH, &rgba[0]);
+    mProfAge.Start();
+  }
+  int w, h;
+  GetClientSize(&w, &h);
+  glMatrixMode(GL_PROJECTION);
+  glLoadIdentity();
+  gluOrtho2D(0, w, h, 0);
+  glMatrixMode(GL_MODELVIEW);
+  glLoadIdentity();
+  glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT);
+  glDisable(GL_DEPTH_TEST);
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  glEnable(GL_TEXTURE_2D);
+  glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+  glBindTexture(GL_TEXTURE_2D, mProfTex->Name());
+  glBegin(GL_QUADS);
+  glTexCoord2f(0.0f, 0.0f); glVertex2i(8, 8);
+  glTexCoord2f(1.0f, 0.0f); glVertex2i(8 + mProfW, 8);
+  glTexCoord2f(1.0f, 1.0f); glVertex2i(8 + mProfW, 8 + mProfH);
+  glTexCoord2f(0.0f, 1.0f); glVertex2i(8, 8 + mProfH);
+  glEnd();
+  glPopAttrib();
+}
+//
+//  ExportImage draws the picture in tiles of at most kExportTile on a
+//  side into an offscreen buffer. Each tile gets the part of the
+//  projection that covers it so the tiles join without seams. A band of
+//  tiles across the image is read back and handed to the ImageWriter a
+//  row at a time, top band first, so we never hold more than one band.
+//  While this goes on Project answers for the export height, which is
+//  what the field views and level of detail size themselves by.
+//
+bool GLViewerCanvas::ExportImage(const char* path, int width, int height,
+                                 ImageFormat format)
+{
+  if ((nullptr == mModel) || !mInitialized || (width <= 0) || (height <= 0)) {
+    return false;
+  }
+  if (!ImageWriter::Fits(width, height, format)) {
+    eprintf("Cannot write a %d x %d image in that format.\n", width, height);
+    return false;
+  }
+  SetCurrent(*mContext);
+  int tile = OffscreenTarget::MaxSize();
+  if (tile <= 0) {
+    eprintf("This OpenGL has no framebuffer objects, cannot export.\n");
+    return false;
+  }
+  if (tile > kExportTile) {
+    tile = kExportTile;
+  }
+  int tileW = (width < tile) ? width : tile;
+  int tileH = (height < tile) ? height : tile;
+  OffscreenTarget target;
+  if (!target.Create(tileW, tileH)) {
+    eprintf("Unable to make a %d x %d offscreen buffer.\n", tileW, tileH);
+    return false;
+  }
+  ImageWriter writer;
+  if (!writer.Open(path, width, height, format)) {
+    eprintf("Unable to open %s.\n", path);
+    return false;
+  }
+  iprintf("Exporting %d x %d in tiles of %d x %d\n", width, height,
+          tileW, tileH);
+  GLfloat aspect = mAspect;
+  mAspect = (GLfloat) width / height;
+  mExportHeight = height;
+  mModel->Resample();
+  size_t stride = (size_t) 3 * width;
+  std::vector<unsigned char> band(stride * tileH);
+  std::vector<unsigned char> pix((size_t) 3 * tileW * tileH);
+  target.Bind();
+  bool ok = true;
+  for (int top = 0; ok && (top < height); top += tileH) {
+    int bandH = ((height - top) < tileH) ? (height - top) : tileH;
+    int bottom = height - top - bandH;      // GL rows count up
+    for (int left = 0; left < width; left += tileW) {
+      int w = ((width - left) < tileW) ? (width - left) : tileW;
+      GLdouble window[4] = {
+        2.0 * left / width - 1.0, 2.0 * (left + w) / width - 1.0,
+        2.0 * bottom / height - 1.0, 2.0 * (bottom + bandH) / height - 1.0
+      };
+      glViewport(0, 0, w, bandH);
+      glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+      glPushMatrix();
+      SetCamera(window);
+      DrawScene();
+      glPopMatrix();
+      target.Read(w, bandH, &pix[0]);
+      for (int j = 0; j < bandH; j++) {
+        memcpy(&band[stride * (bandH - 1 - j) + 3 * left],
+               &pix[(size_t) 3 * w * j], 3 * w);
+      }
+    }
+    for (int j = 0; ok && (j < bandH); j++) {
+      ok = writer.WriteRow(&band[stride * j]);
+    }
+  }
+  OffscreenTarget::Unbind();
+  if (!writer.Close()) {
+    ok = false;
+  }
+  //
+  //  Back to the screen. The camera copies are for the last tile so
+  //  nobody may use them until the next paint.
+  //
+  mAspect = aspect;
+  mExportHeight = 0;
+  mHaveCamera = false;
+  mModel->Resample();
+  ResetProjectionMode();
+  Refresh(false);
+  if (!ok) {
+    eprintf("Unable to write %s.\n", path);
+  }
+  return ok;
+}
+//
 //	Setup/Takedown helpers.
 //
 void GLViewerCanvas::InitGL()
@@ -616,14 +954,21 @@ void GLViewerCanvas::ResetProjectionMode()
 }
 
 //
-//  This transforms a rectangle into view space.
+//  This transforms a rectangle into view space. During an export the
+//  view is the exported image.
 //
 double GLViewerCanvas::Project(double dist)
+{
+  double range = 0.5 * (mNear + mFar);
+  return dist * FocalPixels() / range;
+}
+double GLViewerCanvas::FocalPixels(void)
 {
   int w, h;
   GetClientSize(&w, &h);
-  double range = 0.5 * (mNear + mFar);
-  double wHeight = 2.0 * range * tan(0.5 * mViewAngle / ToDegrees);
-  return dist * double(h) / wHeight;
+  if (mExportHeight > 0) {
+    h = mExportHeight;
+  }
+  return double(h) / (2.0 * tan(0.5 * mViewAngle / ToDegrees));
 }
 
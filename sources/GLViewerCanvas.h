@@ -33,6 +33,7 @@
 #endif
 
 #include "wx/glcanvas.h"
+#include "wx/stopwatch.h"
 //
 //  Need the app to get all of wxwidgets.
 //
@@ -40,6 +41,8 @@
 #include "GLMouseTools.h"
 #include "Model3D.h"
 #include "GeometricObjects.h"
+#include "FieldTexture.h"
+#include "ImageWriter.h"
 
 //
 //  Enum for the different types of tool.
@@ -52,6 +55,36 @@ enum GLTool {
   kGLToolZoom,
   kGLToolRegion
 };
+//
+//  Minimum time between hover readouts in ms, about one display frame.
+//
+const int kHoverInterval = 16;
+//
+//  Minimum time in ms from the end of one paint to the start of the
+//  next one that we asked for ourselves.
+//
+const int kFrameInterval = 16;
+//
+//  How often in ms the profiler overlay picks up new numbers.
+//
+const int kProfOverlayInterval = 500;
+//
+//  Largest side of a tile when exporting an image. Bigger images are
+//  drawn a tile at a time.
+//
+const int kExportTile = 2048;
+//
+//  The user's view of the scene, as much of the camera as a session
+//  needs to put it back.
+//
+struct GLViewState {
+  double mLookAt[3];      // mCentre
+  double mSpin[4];        // mSpinQuat
+  double mAngle;          // mViewAngle
+  double mDist;           // mCamDist
+  double mNearDist;
+  double mFarDist;
+};
 
 class GLViewerView;
 //
@@ -85,6 +118,40 @@ protected:
   GLfloat mFar;           // Far plane of view frustum (must be > mNear)
   GLuint mTexNum;
   bool mInitialized;      // True once GL is properly set up
+  //
+  //  Copies of the matrices and viewport used for the last paint so
+  //  that the model can work out rays without going back to GL.
+  //
+  GLdouble mMVMatrix[16];
+  GLdouble mProjMatrix[16];
+  GLint mViewport[4];
+  bool mHaveCamera;       // True once the copies above are valid
+  bool mInteracting;      // True while a tool is dragging the view
+  unsigned long mMoves;   // Times the user has moved the camera
+  //
+  //  Mouse moves only record the position. The timer picks up the
+  //  latest one so that we query the model at most once per frame.
+  //
+  wxTimer mHoverTimer;
+  int mHoverX;
+  int mHoverY;
+  //
+  //  Redraw requests are held back until a frame interval has passed
+  //  since the last paint. However many come in, one paint shows the
+  //  latest camera and the ones in between are never drawn.
+  //
+  wxTimer mFrameTimer;
+  wxStopWatch mSincePaint;
+  bool mRedrawPending;
+  //
+  //  Profiler overlay. The text is drawn into a bitmap with wx and
+  //  pasted over the corner of the view as a texture.
+  //
+  bool mShowProfile;
+  FieldTexture* mProfTex;
+  int mProfW;
+  int mProfH;
+  wxStopWatch mProfAge;
 
   //
   //	We keep the tools.
@@ -103,6 +170,10 @@ protected:
   GLfloat mRBStart[2];
   GLfloat mRBEnd[2];
   bool mRegionActive;
+  //
+  //  Height of the image being exported, 0 when drawing to the screen.
+  //
+  int mExportHeight;
 public:
   GLViewerCanvas(GLViewerView* theView,
                  wxWindow* parent,
@@ -122,13 +193,45 @@ public:
   GLfloat GetFarDist(void) { return mFar; };
   virtual void GetSize(wxSize& theSize);
   //
+  //  The camera as of the last paint. Returns false if we have not yet
+  //  painted.
+  //
+  bool GetCamera(GLdouble mv[16], GLdouble proj[16], GLint vp[4]) const;
+  //
+  //  The line in world space under window point x, y (wx coordinates)
+  //  from the near to the far plane, using the camera of the last paint.
+  //
+  bool ScreenRay(int x, int y, Point3D& start, Point3D& end) const;
+  //
+  //  True while the user is dragging the view about. Expensive views
+  //  can use this to draw something quicker until the drag ends, which
+  //  it does on any button release, on losing the mouse or at the
+  //  first move with no button down.
+  //
+  bool IsInteracting(void) const { return mInteracting; };
+  //
+  //  Counts the user's camera moves, but not FocusOn, so that the model
+  //  can tell whether the user has taken over the view.
+  //
+  unsigned long GetMoves(void) const { return mMoves; };
+  //
+  //  Save and restore the camera. SetView counts as a move by the user
+  //  so that a model still loading does not focus away from it.
+  //
+  void GetView(GLViewState* state) const;
+  void SetView(const GLViewState& state);
+  //
   //  Install click responder.
   //
   void Install(Model3D* m) { mModel = m; };
   //
-  //  This transforms a distance into view space.
+  //  This transforms a distance into view space. Project sizes it half
+  //  way between the near and far planes; FocalPixels is the pixels
+  //  that a unit spans one unit in front of the camera, so that a
+  //  caller can size things at their own depth.
   //
   double Project(double dist);
+  double FocalPixels(void);
   //
   //  This is  little utility to set the view parameters to give
   //  an optimal view of a particular region of space. We pass in
@@ -154,6 +257,26 @@ public:
   virtual void StartRegion(float xs, float ys);
   virtual void Region(float x, float y);
   virtual void EndRegion(float xe, float ye);
+  virtual void EndDrag(void);
+  virtual void Hover(int x, int y);
+  //
+  //  Ask for a repaint soon. Use this rather than Refresh for anything
+  //  that can happen many times a second.
+  //
+  void RequestRedraw(void);
+  //
+  //  Turn the profiler and its overlay on and off.
+  //
+  void ShowProfiler(bool show);
+  bool IsProfiling(void) const { return mShowProfile; };
+  //
+  //  Draw the scene as it stands into an image file of any size,
+  //  without the rubber band or profiler overlays. Field views are
+  //  sampled again to suit the bigger picture and put back afterwards.
+  //  Returns false if the image could not be drawn or written.
+  //
+  bool ExportImage(const char* path, int width, int height,
+                   ImageFormat format);
 
 protected:
   //
@@ -163,10 +286,16 @@ protected:
   void OnSize(wxSizeEvent& event);
   void OnEraseBackground(wxEraseEvent& event);
   void OnMouse(wxMouseEvent& event);
+  void OnCaptureLost(wxMouseCaptureLostEvent& event);
+  void OnHoverTimer(wxTimerEvent& event);
+  void OnFrameTimer(wxTimerEvent& event);
   
 private:
   void InitGL();
+  void DrawProfile();
   void ResetProjectionMode();
+  void SetCamera(const GLdouble* window);
+  void DrawScene();
   
   DECLARE_EVENT_TABLE()
 };
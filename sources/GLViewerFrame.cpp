@@ -20,9 +20,12 @@
  *
  */
 #include <string.h>
+#include <math.h>
 #include "wx/filename.h"
+#include "wx/filedlg.h"
 #include "FieldViewerApp.h"
 #include "GLViewerFrame.h"
+#include "Profiler.h"
 
 #define BC_ADD_TOOLBAR
 
@@ -47,6 +50,9 @@ EVT_MENU(bcID_TOOL_PAN, GLViewerFrame::OnMenuToolPan)
 EVT_MENU(bcID_TOOL_DOLLY, GLViewerFrame::OnMenuToolDolly)
 EVT_MENU(bcID_TOOL_ZOOM, GLViewerFrame::OnMenuToolZoom)
 EVT_MENU(bcID_TOOL_REGION, GLViewerFrame::OnMenuToolRegion)
+EVT_MENU(bcID_TOOL_PROFILE, GLViewerFrame::OnMenuToolProfile)
+EVT_MENU(bcID_TOOL_PROFLOG, GLViewerFrame::OnMenuToolProfileLog)
+EVT_MENU(bcID_FILE_EXPORT, GLViewerFrame::OnMenuFileExport)
 END_EVENT_TABLE()
 //
 //  Class variables hold bitmaps.
@@ -118,6 +124,10 @@ bool GLViewerFrame::Create(const wxDocument* doc,
 //  mFileMenu->Enable(bcID_FILE_SELPLANE, false);
   mFileMenu->Append(wxID_SAVE, wxT("&Save...\tCtrl-S"));
   mFileMenu->Append(wxID_SAVEAS, wxT("Save &As...\tCtrl-Shift-S"));
+  mFileMenu->Append(bcID_FILE_EXPORT, wxT("&Export Image...\tCtrl-E"),
+                    wxT("Save the view as a PNG or TIFF of any size"));
+  mFileMenu->Append(bcID_FILE_SESSION, wxT("Save Sess&ion..."),
+                    wxT("Save the camera and field views to open again later"));
   mFileMenu->AppendSeparator();
   mFileMenu->Append(wxID_EXIT, wxT("E&xit\tCtrl-Q"));
   mFileMenu->Enable(wxID_SAVEAS, false);
@@ -144,6 +154,12 @@ bool GLViewerFrame::Create(const wxDocument* doc,
   mToolMenu->Check(bcID_TOOL_DOLLY, false);
   mToolMenu->Check(bcID_TOOL_ZOOM, false);
   mToolMenu->Check(bcID_TOOL_REGION, false);
+  mToolMenu->AppendSeparator();
+  mToolMenu->AppendCheckItem(bcID_TOOL_PROFILE, wxT("Show pro&filer\tCtrl-Shift-P"),
+                             wxT("Time each stage of drawing"));
+  mToolMenu->Append(bcID_TOOL_PROFLOG, wxT("Save profile &log..."),
+                    wxT("Write every timing so far as CSV"));
+  mToolMenu->Check(bcID_TOOL_PROFILE, false);
   //
   // Make the "Help" menu
   //
@@ -311,3 +327,57 @@ void GLViewerFrame::OnMenuToolRegion(wxCommandEvent& WXUNUSED(event))
   mToolMenu->Check(bcID_TOOL_ZOOM, false);
   mToolMenu->Check(bcID_TOOL_REGION, true);
 }
+//
+//  Profiler handlers.
+//
+void GLViewerFrame::OnMenuToolProfile(wxCommandEvent& event)
+{
+  mCanvas->ShowProfiler(event.IsChecked());
+}
+void GLViewerFrame::OnMenuToolProfileLog(wxCommandEvent& WXUNUSED(event))
+{
+  wxFileDialog saveFileDialog(this, _("Save profile log"), "", "profile.csv",
+                              "CSV files (*.csv)|*.csv",
+                              wxFD_SAVE|wxFD_OVERWRITE_PROMPT);
+  if (saveFileDialog.ShowModal() == wxID_CANCEL) {
+    return;
+  }
+  if (!gProfiler.WriteLog(saveFileDialog.GetPath())) {
+    wxMessageBox(wxT("Unable to write profile log."));
+  }
+}
+//
+//  Export the view as an image. We ask for the width and keep the shape
+//  of the window; the format comes from the name chosen.
+//
+void GLViewerFrame::OnMenuFileExport(wxCommandEvent& WXUNUSED(event))
+{
+  wxSize sz = mCanvas->GetClientSize();
+  if ((sz.GetWidth() <= 0) || (sz.GetHeight() <= 0)) {
+    return;
+  }
+  long w = wxGetNumberFromUser(wxT("Width of the image in pixels. The height\n"
+                                   "follows from the shape of the view."),
+                               wxT("Width"), wxT("Export image"),
+                               4 * sz.GetWidth(), 16, 100000, this);
+  if (w < 0) {
+    return;
+  }
+  long h = (long) floor(double(w) * sz.GetHeight() / sz.GetWidth() + 0.5);
+  if (h < 1) {
+    h = 1;
+  }
+  wxFileDialog saveFileDialog(this, _("Export image"), "", "view.png",
+                              "PNG files (*.png)|*.png|"
+                              "TIFF files (*.tif)|*.tif;*.tiff",
+                              wxFD_SAVE|wxFD_OVERWRITE_PROMPT);
+  if (saveFileDialog.ShowModal() == wxID_CANCEL) {
+    return;
+  }
+  wxString path = saveFileDialog.GetPath();
+  wxBusyCursor wait;
+  if (!mCanvas->ExportImage(path.c_str(), (int) w, (int) h,
+                            ImageWriter::FormatFor(path.c_str()))) {
+    wxMessageBox(wxT("Unable to export the image."));
+  }
+}
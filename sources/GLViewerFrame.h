@@ -134,6 +134,9 @@ protected:
   void OnMenuToolDolly(wxCommandEvent& event);
   void OnMenuToolZoom(wxCommandEvent& event);
   void OnMenuToolRegion(wxCommandEvent& event);
+  void OnMenuToolProfile(wxCommandEvent& event);
+  void OnMenuToolProfileLog(wxCommandEvent& event);
+  void OnMenuFileExport(wxCommandEvent& event);
   //
   //	Then the event table that makes it all work and add the RTTI info
   //  so that we can be created by name.
@@ -0,0 +1,131 @@
+/*
+ *  Frustum.cpp
+ *  FieldViewer
+ *
+ *	A Frustum is the part of space that the camera can see, stored as
+ *	six inward facing planes. It lets the renderer throw away whole
+ *	groups, field views and chunks of a model that are off screen.
+ *
+ *  Created by Brian Collett on 10/19/26.
+ *  Copyright (c) 2026 Brian Collett. All rights reserved.
+ *
+ */
+#include <math.h>
+#include "Geometry3d.h"
+//
+//	Constructors.
+//
+Frustum::Frustum()
+{
+  mValid = false;
+}
+Frustum::Frustum(const double mv[16], const double proj[16])
+{
+  Set(mv, proj);
+}
+//
+//  Set multiplies the matrices and pulls the planes out of the rows of
+//  the result (Gribb and Hartmann). The planes are normalised so that
+//  the sphere test can use real distances. Depth is just the third row
+//  of the modelview, turned round since the camera looks down -z.
+//
+void Frustum::Set(const double mv[16], const double proj[16])
+{
+  double m[16];
+  for (int c = 0; c < 4; c++) {
+    for (int r = 0; r < 4; r++) {
+      m[4 * c + r] = proj[r] * mv[4 * c] + proj[4 + r] * mv[4 * c + 1] +
+                     proj[8 + r] * mv[4 * c + 2] + proj[12 + r] * mv[4 * c + 3];
+    }
+  }
+  for (int k = 0; k < 4; k++) {
+    mDepth[k] = -mv[4 * k + 2];
+  }
+  for (int i = 0; i < 3; i++) {
+    for (int k = 0; k < 4; k++) {
+      mPlanes[2 * i][k] = m[4 * k + 3] + m[4 * k + i];
+      mPlanes[2 * i + 1][k] = m[4 * k + 3] - m[4 * k + i];
+    }
+  }
+  mValid = true;
+  for (int p = 0; p < 6; p++) {
+    double len = sqrt(mPlanes[p][0] * mPlanes[p][0] +
+                      mPlanes[p][1] * mPlanes[p][1] +
+                      mPlanes[p][2] * mPlanes[p][2]);
+    if (len <= 0.0) {
+      mValid = false;
+      return;
+    }
+    for (int k = 0; k < 4; k++) {
+      mPlanes[p][k] /= len;
+    }
+  }
+}
+//
+//  For each plane test the corner furthest along its normal. If that is
+//  outside then so is the whole box. If the nearest corner is inside
+//  every plane then the whole box is inside.
+//
+FrustumTest Frustum::ClassifyBox(const double box[6]) const
+{
+  if (!mValid) {
+    return kFrustumInside;
+  }
+  FrustumTest result = kFrustumInside;
+  for (int p = 0; p < 6; p++) {
+    const double* pl = mPlanes[p];
+    double far = pl[3], near = pl[3];
+    for (int i = 0; i < 3; i++) {
+      if (pl[i] >= 0.0) {
+        far += pl[i] * box[i + 3];
+        near += pl[i] * box[i];
+      } else {
+        far += pl[i] * box[i];
+        near += pl[i] * box[i + 3];
+      }
+    }
+    if (far < 0.0) {
+      return kFrustumOutside;
+    }
+    if (near < 0.0) {
+      result = kFrustumPartial;
+    }
+  }
+  return result;
+}
+FrustumTest Frustum::Classify(const Frame3D& f) const
+{
+  if (f.IsEmpty()) {
+    return kFrustumOutside;
+  }
+  double box[6] = { f.XMin(), f.YMin(), f.ZMin(),
+                    f.XMax(), f.YMax(), f.ZMax() };
+  return ClassifyBox(box);
+}
+FrustumTest Frustum::ClassifySphere(const double c[3], double radius) const
+{
+  if (!mValid) {
+    return kFrustumInside;
+  }
+  FrustumTest result = kFrustumInside;
+  for (int p = 0; p < 6; p++) {
+    const double* pl = mPlanes[p];
+    double d = pl[0] * c[0] + pl[1] * c[1] + pl[2] * c[2] + pl[3];
+    if (d < -radius) {
+      return kFrustumOutside;
+    }
+    if (d < radius) {
+      result = kFrustumPartial;
+    }
+  }
+  return result;
+}
+bool Frustum::Visible(const Rect3D& r) const
+{
+  Frame3D f;
+  f.AddPoint(r.TopLeft());
+  f.AddPoint(r.TopRight());
+  f.AddPoint(r.BottomRight());
+  f.AddPoint(r.BottomLeft());
+  return Visible(f);
+}
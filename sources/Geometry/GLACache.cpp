@@ -0,0 +1,272 @@
+/*
+ *  GLACache.cpp
+ *  FieldViewer
+ *
+ *  A GLACache keeps what CGLAList::Create made of a .gla model in a
+ *  binary file. See GLACache.h.
+ *
+ *  Created by Brian Collett on 10/19/26.
+ *  Copyright (c) 2026 Brian Collett. All rights reserved.
+ *
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include "GLACache.h"
+#include "GLAList.h"
+//
+//  Every cache file starts with this, then the model's full path, then
+//  whatever CGLAList::Write puts there. mSizes packs the sizes of the
+//  types the list writes so that a cache from a different build is not
+//  misread; mOrder catches a different byte order.
+//
+struct GLACacheHeader {
+  char mMagic[4];
+  uint32_t mVersion;
+  uint32_t mOrder;
+  uint32_t mChunk;              // kGLAChunkSize, which shapes the batches
+  uint32_t mSizes;
+  uint32_t mPathLen;
+  int64_t mStamp[3];            // size, mtime seconds and nanoseconds
+  int64_t mEnd;                 // just past the end directive
+};
+static const char sMagic[4] = { 'G', 'L', 'A', 'C' };
+static const uint32_t kGLACacheOrder = 0x01020304;
+static const uint32_t kGLACacheSizes = sizeof(GLfloat) | (sizeof(GLuint) << 8) |
+                                       (sizeof(Real) << 16);
+//
+//  Class variables.
+//
+std::string GLACache::sDirectory;
+bool GLACache::sHaveDirectory = false;
+//
+//  The directory.
+//
+void GLACache::SetDirectory(const char* dir)
+{
+  if (nullptr == dir) {
+    sHaveDirectory = false;
+    return;
+  }
+  sDirectory = dir;
+  sHaveDirectory = true;
+}
+const std::string& GLACache::GetDirectory(void)
+{
+  if (sHaveDirectory) {
+    return sDirectory;
+  }
+  sHaveDirectory = true;
+  const char* env = getenv("FIELDVIEWER_CACHE");
+  if (nullptr != env) {
+    sDirectory = env;
+    return sDirectory;
+  }
+  const char* home = getenv("HOME");
+  sDirectory.clear();
+#ifdef __APPLE__
+  if (nullptr != home) {
+    sDirectory = std::string(home) + "/Library/Caches/FieldViewer";
+  }
+#else
+  const char* xdg = getenv("XDG_CACHE_HOME");
+  if ((nullptr != xdg) && (xdg[0] == '/')) {
+    sDirectory = std::string(xdg) + "/FieldViewer";
+  } else if (nullptr != home) {
+    sDirectory = std::string(home) + "/.cache/FieldViewer";
+  }
+#endif
+  return sDirectory;
+}
+//
+//  The file name is a 64 bit FNV-1a hash of the full path. Two paths
+//  with the same hash just take turns; the path in the header stops
+//  either from reading the other's cache.
+//
+std::string GLACache::CachePath(const char* path)
+{
+  const std::string& dir = GetDirectory();
+  if (dir.empty()) {
+    return dir;
+  }
+  std::string full = FullPath(path);
+  uint64_t hash = 14695981039346656037ULL;
+  for (size_t i = 0; i < full.size(); i++) {
+    hash ^= (unsigned char) full[i];
+    hash *= 1099511628211ULL;
+  }
+  char name[32];
+  snprintf(name, sizeof(name), "/%016llx.glc", (unsigned long long) hash);
+  return dir + name;
+}
+//
+//  Load checks everything it can before it touches the list.
+//
+bool GLACache::Load(CGLAList* list, const char* path, FILE* ifp)
+{
+  std::string cachePath = CachePath(path);
+  int64_t stamp[3];
+  if (cachePath.empty() || !Stamp(ifp, stamp)) {
+    return false;
+  }
+  FILE* fp = fopen(cachePath.c_str(), "rb");
+  if (nullptr == fp) {
+    return false;
+  }
+  struct stat st;
+  GLACacheHeader head;
+  std::string full = FullPath(path);
+  bool ok = (fstat(fileno(fp), &st) == 0) &&
+            (fread(&head, sizeof(head), 1, fp) == 1) &&
+            (memcmp(head.mMagic, sMagic, 4) == 0) &&
+            (head.mVersion == kGLACacheVersion) &&
+            (head.mOrder == kGLACacheOrder) &&
+            (head.mChunk == (uint32_t) kGLAChunkSize) &&
+            (head.mSizes == kGLACacheSizes) &&
+            (head.mStamp[0] == stamp[0]) && (head.mStamp[1] == stamp[1]) &&
+            (head.mStamp[2] == stamp[2]) &&
+            (head.mEnd >= 0) && (head.mEnd <= stamp[0]) &&
+            (head.mPathLen == full.size());
+  if (ok) {
+    std::string cached(head.mPathLen, ' ');
+    ok = ((head.mPathLen == 0) ||
+          (fread(&cached[0], 1, head.mPathLen, fp) == head.mPathLen)) &&
+         (cached == full) &&
+         list->Read(fp, (long) st.st_size);
+  }
+  fclose(fp);
+  if (ok) {
+    ok = (fseek(ifp, (long) head.mEnd, SEEK_SET) == 0);
+  }
+  return ok;
+}
+bool GLACache::Stamp(FILE* ifp, int64_t* stamp)
+{
+  struct stat st;
+  if ((fstat(fileno(ifp), &st) != 0) || !S_ISREG(st.st_mode)) {
+    stamp[0] = stamp[1] = stamp[2] = -1;
+    return false;
+  }
+  StatStamp(st, stamp);
+  return true;
+}
+//
+//  Save writes to a temporary file and renames it into place so that a
+//  reader never sees half a cache. The model may have been read some
+//  time ago, so make sure that it is still the one that we read.
+//
+bool GLACache::Save(const CGLAList* list, const char* path,
+                    const int64_t* stamp, FILE* ifp)
+{
+  return Save(list, path, stamp, ftell(ifp));
+}
+bool GLACache::Save(const CGLAList* list, const char* path,
+                    const int64_t* stamp, long end)
+{
+  std::string cachePath = CachePath(path);
+  GLACacheHeader head;
+  if (cachePath.empty() || (end < 0) || (stamp[0] < 0) ||
+      !SourceStamp(path, head.mStamp) ||
+      (head.mStamp[0] != stamp[0]) || (head.mStamp[1] != stamp[1]) ||
+      (head.mStamp[2] != stamp[2]) || !MakeDirectory(GetDirectory())) {
+    return false;
+  }
+  std::string full = FullPath(path);
+  memcpy(head.mMagic, sMagic, 4);
+  head.mVersion = kGLACacheVersion;
+  head.mOrder = kGLACacheOrder;
+  head.mChunk = kGLAChunkSize;
+  head.mSizes = kGLACacheSizes;
+  head.mPathLen = (uint32_t) full.size();
+  head.mEnd = end;
+  char pid[32];
+  snprintf(pid, sizeof(pid), ".%d", (int) getpid());
+  std::string tmpPath = cachePath + pid;
+  FILE* fp = fopen(tmpPath.c_str(), "wb");
+  if (nullptr == fp) {
+    return false;
+  }
+  bool ok = (fwrite(&head, sizeof(head), 1, fp) == 1) &&
+            (fwrite(full.c_str(), 1, full.size(), fp) == full.size()) &&
+            list->Write(fp);
+  ok = (fclose(fp) == 0) && ok;
+  if (ok) {
+    ok = (rename(tmpPath.c_str(), cachePath.c_str()) == 0);
+  }
+  if (!ok) {
+    remove(tmpPath.c_str());
+  }
+  return ok;
+}
+//
+//  Helpers.
+//
+std::string GLACache::FullPath(const char* path)
+{
+  char full[PATH_MAX];
+  if (nullptr != realpath(path, full)) {
+    return full;
+  }
+  return path;
+}
+bool GLACache::SourceStamp(const char* path, int64_t* stamp)
+{
+  struct stat st;
+  if ((stat(path, &st) != 0) || !S_ISREG(st.st_mode)) {
+    return false;
+  }
+  StatStamp(st, stamp);
+  return true;
+}
+void GLACache::StatStamp(const struct stat& st, int64_t* stamp)
+{
+  stamp[0] = st.st_size;
+  stamp[1] = st.st_mtime;
+#ifdef __APPLE__
+  stamp[2] = st.st_mtimespec.tv_nsec;
+#else
+  stamp[2] = st.st_mtim.tv_nsec;
+#endif
+}
+bool GLACache::MakeDirectory(const std::string& dir)
+{
+  for (size_t i = 1; i <= dir.size(); i++) {
+    if ((i == dir.size()) || (dir[i] == '/')) {
+      std::string part = dir.substr(0, i);
+      if ((mkdir(part.c_str(), 0755) != 0) && (errno != EEXIST)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+//
+//  Frames go as a flag and two corners.
+//
+bool GLACacheWriteFrame(FILE* fp, const Frame3D& f)
+{
+  double v[7] = { f.IsEmpty() ? 1.0 : 0.0,
+                  f.GetMin().mX, f.GetMin().mY, f.GetMin().mZ,
+                  f.GetMax().mX, f.GetMax().mY, f.GetMax().mZ };
+  return fwrite(v, sizeof(double), 7, fp) == 7;
+}
+bool GLACacheReadFrame(FILE* fp, Frame3D& f)
+{
+  double v[7];
+  if (fread(v, sizeof(double), 7, fp) != 7) {
+    return false;
+  }
+  if (v[0] != 0.0) {
+    f.Clear();
+    return true;
+  }
+  if (!(v[1] <= v[4]) || !(v[2] <= v[5]) || !(v[3] <= v[6])) {
+    return false;
+  }
+  f.Set(Point3D(v[1], v[2], v[3]), Point3D(v[4], v[5], v[6]));
+  return true;
+}
@@ -0,0 +1,128 @@
+/*
+ *  GLACache.h
+ *  FieldViewer
+ *
+ *  A GLACache keeps what CGLAList::Create made of a .gla model, the
+ *  batches, the bounds and the picker, in a binary file so that the
+ *  next time the same model is opened it can be read straight back
+ *  instead of scanned and parsed again.
+ *
+ *  Cache files live in one directory, named by a hash of the model's
+ *  full path. Each starts with the model's path, size and modification
+ *  time and the cache is only used while all three still match, so
+ *  editing or replacing the model throws its cache away. The stamp is
+ *  taken from the open model before it is parsed, and a list is only
+ *  saved if the model still has that stamp, so a model rewritten while
+ *  it was being read never gets the old geometry cached for it. The format
+ *  version and the sizes of the types we write are checked too, and
+ *  anything that does not look right is simply ignored and rewritten.
+ *
+ *  A model file may go on to describe fields after its end directive.
+ *  The cache remembers where that was so Load can leave the FILE there
+ *  just as Create would have.
+ *
+ *  The directory is $FIELDVIEWER_CACHE if that is set, otherwise the
+ *  usual per-user cache directory. Setting it to "" turns caching off.
+ *
+ *  Created by Brian Collett on 10/19/26.
+ *  Copyright (c) 2026 Brian Collett. All rights reserved.
+ *
+ */
+#ifndef _GLACache_H
+#define _GLACache_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+#include "Geometry3d.h"
+
+class CGLAList;
+//
+//  Bump this whenever CGLAList::Write or CPicker::Write change what
+//  they write.
+//
+const uint32_t kGLACacheVersion = 2;
+
+class GLACache {
+protected:
+  static std::string sDirectory;
+  static bool sHaveDirectory;
+public:
+  //
+  //  Where the cache files go. nullptr goes back to the default and ""
+  //  turns the cache off.
+  //
+  static void SetDirectory(const char* dir);
+  static const std::string& GetDirectory(void);
+  //
+  //  Fill list from the cache for the model at path and move ifp, which
+  //  is open on the model, to just after its end directive. Returns
+  //  false, leaving list and ifp alone, if there is no good cache.
+  //
+  static bool Load(CGLAList* list, const char* path, FILE* ifp);
+  //
+  //  The size and modification time of the model open on ifp. Take it
+  //  before reading the model and hand it to Save. If it cannot be had
+  //  stamp is filled with -1, which Save will never accept.
+  //
+  static bool Stamp(FILE* ifp, int64_t* stamp);
+  //
+  //  Write the cache for a list that Create has just read from ifp.
+  //  ifp must still be just after the end directive. Nothing is saved
+  //  if the model at path no longer has stamp.
+  //
+  static bool Save(const CGLAList* list, const char* path,
+                   const int64_t* stamp, FILE* ifp);
+  //
+  //  Or for a list that was put together after the file was read, given
+  //  where its end directive finished.
+  //
+  static bool Save(const CGLAList* list, const char* path,
+                   const int64_t* stamp, long end);
+  //
+  //  The cache file for a model, "" if caching is off.
+  //
+  static std::string CachePath(const char* path);
+protected:
+  //
+  //  Helpers.
+  //
+  static std::string FullPath(const char* path);
+  static bool SourceStamp(const char* path, int64_t* stamp);
+  static void StatStamp(const struct stat& st, int64_t* stamp);
+  static bool MakeDirectory(const std::string& dir);
+};
+//
+//  Little helpers for the Write and Read methods of the things we
+//  cache. end is the size of the file being read, so that a damaged
+//  count can never make us allocate more than the file holds.
+//
+template<class T>
+bool GLACacheWrite(FILE* fp, const std::vector<T>& v)
+{
+  uint64_t n = v.size();
+  if (fwrite(&n, sizeof(n), 1, fp) != 1) {
+    return false;
+  }
+  return (n == 0) || (fwrite(&v[0], sizeof(T), v.size(), fp) == v.size());
+}
+template<class T>
+bool GLACacheRead(FILE* fp, long end, std::vector<T>& v)
+{
+  uint64_t n;
+  if (fread(&n, sizeof(n), 1, fp) != 1) {
+    return false;
+  }
+  long here = ftell(fp);
+  if ((here < 0) || (n > (uint64_t) (end - here) / sizeof(T))) {
+    return false;
+  }
+  v.resize((size_t) n);
+  return (n == 0) || (fread(&v[0], sizeof(T), v.size(), fp) == v.size());
+}
+bool GLACacheWriteFrame(FILE* fp, const Frame3D& f);
+bool GLACacheReadFrame(FILE* fp, Frame3D& f);
+
+#endif // _GLACache_H
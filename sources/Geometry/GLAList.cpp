@@ -27,6 +27,14 @@
  *	BCollett 9/10/99 add spheres and boxes.
  *	BCollett 1/26/04 Redesign with argument list and class symbol table.
  *  BCollett 3/14/14 Add support for caps and fields for FieldViewer.
+ *  BCollett 10/19/26 Collect geometry into per-colour batches of vertex
+ *  and index arrays, with spheres and cylinders as instances of shared
+ *  meshes. Each kind of primitive is drawn with one call per colour.
+ *  BCollett 10/19/26 Split batches into bounded chunks for culling.
+ *  BCollett 10/19/26 Write and Read for GLACache.
+ *  BCollett 10/19/26 Parse big files in pieces on several threads.
+ *  BCollett 10/19/26 Look verbs up in a compile time keyword table.
+ *  BCollett 10/19/26 Arguments are doubles in a buffer that grows.
  */
 
 // For compilers that support precompilation, includes "wx/wx.h".
@@ -41,8 +49,15 @@
 #endif
 
 #include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
 #include "FieldViewerApp.h"
 #include "GLAList.h"
+#include "GLACache.h"
 #include "../Scanner/CTextScanner.h"
 
 #ifdef DEBUG
@@ -53,61 +68,40 @@
 static char gMsgBuff[1024];
 #endif
 //
-//	Class variables.
+//	Class variables. The verb list needs a home since the keyword
+//	table points into it.
 //
-CSymbolTable* CGLAList::gSymTab = NULL;
-GLfloat* CGLAList::gArguments = NULL;
-int CGLAList::gMaxNArgs = 0;
+constexpr CKeyword GLAVerbs::kWords[];
+int CGLAList::sArgReserve = 0;
+int CGLAList::sThreads = 0;
 //
 //	Class initialiser makes sure that class vars get set up.
 //
 bool CGLAList::InitClass(int nArg) {
-	//
-	//	Build a symbol table and initialise it with the OpenGL
-	//	commands that we recognise.
-	//
-	gSymTab = new CSymbolTable();
-	if (NULL == gSymTab) {
-		return false;
-	}
-	gSymTab->InsertName("COLOR", kGLColor);
-	gSymTab->InsertName("POINT", kGLPoint);
-	gSymTab->InsertName("LINE", kGLLine);
-	gSymTab->InsertName("POLYLINE", kGLPolyLine);
-	gSymTab->InsertName("SPHERE", kGLSphere);
-	gSymTab->InsertName("TRIANGLE", kGLTriangle);
-	gSymTab->InsertName("BOX", kGLBox);
-	gSymTab->InsertName("TRANSLATE", kGLTranslate);
-	gSymTab->InsertName("CYLINDER", kGLCylinder);
-	gSymTab->InsertName("CAP", kGLCap);
-	gSymTab->InsertName("cap", kGLCap);
-	gSymTab->InsertName("cylinder", kGLCylinder);
-	gSymTab->InsertName("color", kGLColor);
-	gSymTab->InsertName("point", kGLPoint);
-	gSymTab->InsertName("line", kGLLine);
-	gSymTab->InsertName("polyline", kGLPolyLine);
-	gSymTab->InsertName("sphere", kGLSphere);
-	gSymTab->InsertName("triangle", kGLTriangle);
-	gSymTab->InsertName("box", kGLBox);
-	gSymTab->InsertName("translate", kGLTranslate);
-	gSymTab->InsertName("END", kGLEnd);
-	gSymTab->InsertName("end", kGLEnd);
 	//
 	//	Get space for arguments and save number.
 	//
-	gArguments = new GLfloat[nArg];
-	if (NULL == gArguments) {
-		return false;
-	}
-	gMaxNArgs = nArg;
+	sArgReserve = (nArg > 0) ? nArg : 0;
 	return true;
 }
 //
 //	ReleaseClass frees the class storage.
 //
 void CGLAList::ReleaseClass() {
-	delete gSymTab;
-	delete[] gArguments;
+	CGLAMesh::ReleaseMeshes();
+}
+//
+//	Thread count for Create.
+//
+void CGLAList::SetThreads(int nThreads) {
+	sThreads = (nThreads > 0) ? nThreads : 0;
+}
+int CGLAList::GetThreads() {
+	int nThreads = sThreads;
+	if (nThreads == 0) {
+		nThreads = (int) std::thread::hardware_concurrency();
+	}
+	return (nThreads > 0) ? nThreads : 1;
 }
 //
 //	Constructor must be passed a TextScanner. It may be NULL
@@ -116,6 +110,13 @@ void CGLAList::ReleaseClass() {
 //
 CGLAList::CGLAList(CTextScanner* newScan) : CDisplayList(kDLCompile) {
 	mScan = newScan;
+	mArguments.reserve(sArgReserve);
+	mLineBase = 0;
+	mHoldMessages = false;
+	mStream = NULL;
+	mStreamMark = 0;
+	mOffset[0] = mOffset[1] = mOffset[2] = 0.0;
+	mCurBatch = -1;
 }
 //
 //	Destructor does nothing as we own no storage..
@@ -134,75 +135,88 @@ bool CGLAList::Create() {
 	if (mScan == NULL) {	// Quit if there is no scanner
 		return false;
 	}
+	mPicker.Clear();
+	mOffset[0] = mOffset[1] = mOffset[2] = 0.0;
+	mBatches.clear();
+	mCurBatch = -1;
+	if (!CreateParallel()) {
+		ParseCommands();
+	}
+	mPicker.Build(GetThreads());
+	ReleaseScanner();
+	return true;
+}
+//
+//	ParseCommands is the body of Create, and of each piece when
+//	CreateParallel splits the work up.
+//
+bool CGLAList::ParseCommands() {
 	// 
 	//	Work through the file.
 	//	Each line should begin with a command and then be
 	//	followed by a set of numeric arguments.
 	//
 	Lexeme* cLex;
-	CSymbol* cSym = NULL;
+	const CKeyword* verb = NULL;
   bool finished = false;
-	Start();
-	while ((cLex = mScan->NextLex())->lex != LEof) {
+	mStreamMark = (mStream != NULL) ? mScan->Offset() : 0;
+	while ((cLex = mScan->NextKeyword(kGLAVerbTable, &verb))->lex != LEof) {
     if (cLex->lex == LNewLine || cLex->lex==LSpace) continue;
 		if (cLex->lex == LWord) {	// Hope we have a command
 #ifdef DEBUG
-eprintf("Word %s ", cLex->sVal);
-wxLogMessage(gMsgBuff);
+Report("Word %s ", cLex->sVal);
 #endif
-			cSym = gSymTab->LookUpWord(cLex->sVal);
+			if (verb == NULL) {		// complain while we still have the word
+        Report("CGLAList.Create: %s is an unrecognised GLA verb.\r\n", cLex->sVal);
+			}
 			//
 			//	Now read in the arguments.
 			//
 			int nArg = GetArgList();
 #ifdef DEBUG
-      eprintf("Found %d arguments",nArg);
-      wxLogMessage(gMsgBuff);
+      Report("Found %d arguments",nArg);
 				for (int ii = 0; ii < nArg; ++ii) {
-          eprintf(" %f", gArguments[ii]);
-          wxLogMessage(gMsgBuff);
+          Report(" %f", mArguments[ii]);
 				}
-      wxLogMessage("\r\n");
+      Report("\r\n");
 #endif
-			if (cSym != NULL) {
+			if (verb != NULL) {
 				//
 				//	Found a valid command, dispatch a function
 				//	to handle it.
 				//
 #ifdef DEBUG
-        eprintf("matches symbol %d\r\n",cSym->mSym);
-        wxLogMessage(gMsgBuff);
+        Report("matches symbol %d\r\n",verb->mSym);
 #endif
-				switch (cSym->mSym) {
+				switch (verb->mSym) {
 					case kGLColor:
 						if (nArg >= 3) {
 							GLfloat color[4];
-							color[0] = gArguments[0];
-							color[1] = gArguments[1];
-							color[2] = gArguments[2];
+							color[0] = mArguments[0];
+							color[1] = mArguments[1];
+							color[2] = mArguments[2];
 							if (nArg > 3) {
-								color[3] = gArguments[3];
+								color[3] = mArguments[3];
 							} else {
 								color[3] = 1.0f;
 							}
-							glMaterialfv(GL_FRONT, GL_AMBIENT, color);
-							glMaterialfv(GL_FRONT, GL_SPECULAR, color);
-              glColor3fv(color);
+							SetColour(color);
 						}
 						break;
 
 					case kGLPoint:
 						if (nArg >= 3) {
-							glBegin(GL_POINTS);
-							glVertex3fv(gArguments);
-							glEnd();
-							mBounds->AddPoint3fv(&gArguments[0]);
+							GLuint index = AddVertex(&mArguments[0]);
+							mBatches[mCurBatch].mPoints.push_back(index);
+							mBounds->AddPoint3dv(&mArguments[0]);
 						}
 						break;
 
 					case kGLTranslate:
 						if (nArg >= 3) {
-							glTranslatef(gArguments[0],gArguments[1],gArguments[2]);
+							mOffset[0] += mArguments[0];
+							mOffset[1] += mArguments[1];
+							mOffset[2] += mArguments[2];
 						}
 						break;
 
@@ -239,39 +253,305 @@ wxLogMessage(gMsgBuff);
             break;
             
 					default:
-            eprintf("CGLAList.Create: Unimplemented GLA verb %s.\r\n", cSym->mName);
+            Report("CGLAList.Create: Unimplemented GLA verb %s.\r\n", verb->mName);
 						break;
 				}
-			} else {
-        eprintf("CGLAList.Create: %s is an unrecognised GLA verb.\r\n", cLex->sVal);
 			}
 		} else {	// Did not find a command
 			//
 			//	Print a message.
 			//
-      eprintf("CGLAList.Create: Cound not find a command on line %lu.\r\n", mScan->LineNumber());
-      eprintf("%s", mScan->GetLine());
+      Report("CGLAList.Create: Cound not find a command on line %lu.\r\n", LineNumber());
+      Report("%s", mScan->GetLine());
 		}
     if (finished) break;
+		CheckChunk();
 		//
 		//	Eat tokens til we get to the
 		//	end of the line (or a premature EOF)
 		//
 		while ((cLex = mScan->NextLex())->lex != LNewLine && cLex->lex != LEof);
 		} // end while
-	End();
-	ReleaseScanner();
+	if (mStream != NULL) {
+		mStream->AddParsed(mScan->Offset() - mStreamMark);
+	}
+	return finished;
+}
+//
+//	Big files are parsed in pieces. Only a few commands carry anything
+//	on from one line to the next, color and translate, and end, which
+//	stops everything. So a quick first pass over each piece, the
+//	survey, notes just those. Running through the surveys in order then
+//	tells us the colour, offset and first line number that each piece
+//	starts with and which piece the end is in. Then the pieces are
+//	parsed for real, each into its own list, and the lists are joined
+//	up in order. Both passes run on all the threads at once, taking
+//	pieces off a shared counter, and a piece only ever writes to its
+//	own survey and list so they need no locks.
+//
+//	Nothing here touches OpenGL; the batches are only drawn later on
+//	the GL thread just as if we had parsed them on one thread.
+//
+struct GLASurvey {
+	const char* mFirst;			// the piece of text
+	const char* mLast;
+	bool mHasColour;			// the last color in the piece
+	GLfloat mColour[4];
+	std::vector<double> mTranslates;	// dx dy dz for each translate
+	const char* mEnd;			// just after the end line, if there is one
+};
+//
+//	RunPieces calls work(p) for every piece p on up to nThreads threads.
+//
+template<class Work>
+static void RunPieces(int nPiece, int nThreads, Work work) {
+	std::atomic<int> next(0);
+	auto run = [&]() {
+		int p;
+		while ((p = next++) < nPiece) {
+			work(p);
+		}
+	};
+	std::vector<std::thread> threads;
+	for (int t = 1; t < std::min(nThreads, nPiece); t++) {
+		threads.push_back(std::thread(run));
+	}
+	run();
+	for (size_t t = 0; t < threads.size(); t++) {
+		threads[t].join();
+	}
+}
+bool CGLAList::CreateParallel() {
+	int nThreads = GetThreads();
+	size_t length = 0;
+	const char* text = mScan->Rest(&length);
+	if ((nThreads < 2) || (text == NULL) || (length < kGLAParallelBytes) ||
+	    (mScan->LineNumber() != 0)) {
+		return false;
+	}
+	//
+	//	Cut the text into pieces that end at the end of a line, a few
+	//	for each thread so that one slow piece does not hold up the rest.
+	//
+	const char* end = text + length;
+	size_t pieceLen = std::max(length / (4 * nThreads), kGLAPieceBytes);
+	std::vector<GLASurvey> surveys;
+	for (const char* first = text; first < end; ) {
+		const char* last = end;
+		if ((size_t) (end - first) > pieceLen) {
+			last = (const char*) memchr(first + pieceLen, '\n',
+			                            end - (first + pieceLen));
+			last = (last == NULL) ? end : last + 1;
+		}
+		surveys.push_back(GLASurvey());
+		surveys.back().mFirst = first;
+		surveys.back().mLast = last;
+		first = last;
+	}
+	int nPiece = (int) surveys.size();
+	std::vector<CGLAList*> pieces(nPiece);
+	for (int p = 0; p < nPiece; p++) {
+		pieces[p] = new CGLAList();
+		pieces[p]->mHoldMessages = true;
+		pieces[p]->mStream = mStream;
+	}
+	RunPieces(nPiece, nThreads, [&](int p) {
+		CTextScanner scan(surveys[p].mFirst, surveys[p].mLast - surveys[p].mFirst);
+		pieces[p]->InstallScanner(&scan);
+		pieces[p]->Survey(surveys[p]);
+		pieces[p]->mScan = NULL;
+		pieces[p]->mMessages.clear();		// pass two will find them again
+	});
+	//
+	//	Carry the colour, offset and line count from piece to piece.
+	//	Translates are added one at a time, just as ParseCommands would,
+	//	so the offsets come out exactly the same.
+	//
+	const char* stop = end;
+	bool hasColour = false;
+	GLfloat colour[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+	double offset[3] = { 0.0, 0.0, 0.0 };
+	unsigned long lines = 0;
+	for (int p = 0; p < nPiece; p++) {
+		GLASurvey& survey = surveys[p];
+		CGLAList* piece = pieces[p];
+		piece->mLineBase = lines;
+		for (int i = 0; i < 3; i++) {
+			piece->mOffset[i] = offset[i];
+		}
+		if (hasColour) {
+			piece->SetColour(colour);
+		}
+		if (survey.mEnd != NULL) {
+			stop = survey.mEnd;
+			nPiece = p + 1;
+			break;
+		}
+		lines += std::count(survey.mFirst, survey.mLast, '\n');
+		for (size_t t = 0; t < survey.mTranslates.size(); t++) {
+			offset[t % 3] += survey.mTranslates[t];
+		}
+		if (survey.mHasColour) {
+			hasColour = true;
+			std::copy(survey.mColour, survey.mColour + 4, colour);
+		}
+	}
+	RunPieces(nPiece, nThreads, [&](int p) {
+		CTextScanner scan(surveys[p].mFirst, surveys[p].mLast - surveys[p].mFirst);
+		pieces[p]->InstallScanner(&scan);
+		pieces[p]->ParseCommands();
+		pieces[p]->mScan = NULL;
+	});
+	//
+	//	Join the pieces up in order, dropping the batches that only hold
+	//	a piece's starting colour, and tell the user what went wrong.
+	//
+	for (int p = 0; p < (int) pieces.size(); p++) {
+		CGLAList* piece = pieces[p];
+		if (p < nPiece) {
+			for (size_t b = 0; b < piece->mBatches.size(); b++) {
+				if (piece->mBatches[b].NPrim() > 0) {
+					mBatches.push_back(std::move(piece->mBatches[b]));
+				}
+			}
+			if (!piece->mBounds->IsEmpty()) {
+				mBounds->AddPoint(piece->mBounds->GetMin());
+				mBounds->AddPoint(piece->mBounds->GetMax());
+			}
+			mPicker.Append(piece->mPicker);
+			for (size_t m = 0; m < piece->mMessages.size(); m++) {
+				Report("%s", piece->mMessages[m].c_str());
+			}
+		}
+		delete piece;
+	}
+	mCurBatch = -1;
+	mScan->SkipTo(stop);
+	return true;
+}
+//
+//	Survey reads just the commands that matter to the next piece. The
+//	rest of each line is skipped without being scanned.
+//
+void CGLAList::Survey(GLASurvey& survey) {
+	Lexeme* cLex;
+	const CKeyword* verb;
+	survey.mHasColour = false;
+	survey.mEnd = NULL;
+	while ((cLex = mScan->NextKeyword(kGLAVerbTable, &verb))->lex != LEof) {
+		if (cLex->lex == LNewLine || cLex->lex == LSpace) {
+			continue;
+		}
+		if ((verb != NULL) &&
+		    ((verb->mSym == kGLColor) || (verb->mSym == kGLTranslate))) {
+			int nArg = GetArgList();
+			if ((nArg >= 3) && (verb->mSym == kGLColor)) {
+				survey.mHasColour = true;
+				for (int i = 0; i < 4; i++) {
+					survey.mColour[i] = (i < nArg) ? mArguments[i] : 1.0f;
+				}
+			} else if (nArg >= 3) {
+				survey.mTranslates.insert(survey.mTranslates.end(), mArguments.begin(),
+				                          mArguments.begin() + 3);
+			}
+			while ((cLex = mScan->NextLex())->lex != LNewLine && cLex->lex != LEof);
+			continue;
+		}
+		mScan->CleanLine();
+		if ((verb != NULL) && (verb->mSym == kGLEnd)) {
+			size_t rest;
+			survey.mEnd = mScan->Rest(&rest);
+			return;
+		}
+	}
+}
+//
+//	Cache support. Each batch goes out as its colour, its arrays and its
+//	bounds, then the bounds of the whole list and the picker.
+//
+bool CGLAList::Write(FILE* fp) const {
+	uint64_t nBatch = mBatches.size();
+	if (fwrite(&nBatch, sizeof(nBatch), 1, fp) != 1) {
+		return false;
+	}
+	for (size_t b = 0; b < mBatches.size(); b++) {
+		const GLABatch& batch = mBatches[b];
+		GLfloat head[5] = { batch.mColour[0], batch.mColour[1],
+		                    batch.mColour[2], batch.mColour[3],
+		                    batch.mHasColour ? 1.0f : 0.0f };
+		if ((fwrite(head, sizeof(GLfloat), 5, fp) != 5) ||
+		    !GLACacheWrite(fp, batch.mVerts) || !GLACacheWrite(fp, batch.mLines) ||
+		    !GLACacheWrite(fp, batch.mTris) || !GLACacheWrite(fp, batch.mPoints) ||
+		    !GLACacheWrite(fp, batch.mSpheres) ||
+		    !GLACacheWrite(fp, batch.mCylinders) ||
+		    !GLACacheWriteFrame(fp, batch.mBounds)) {
+			return false;
+		}
+	}
+	return GLACacheWriteFrame(fp, *mBounds) && mPicker.Write(fp);
+}
+//
+//	Read checks that every index is inside its batch's vertices so that
+//	a damaged cache cannot make Draw read past them.
+//
+bool CGLAList::Read(FILE* fp, long end) {
+	uint64_t nBatch;
+	Frame3D bounds;
+	mBatches.clear();
+	mCurBatch = -1;
+	mPicker.Clear();
+	bool ok = (fread(&nBatch, sizeof(nBatch), 1, fp) == 1) &&
+	          (nBatch <= (uint64_t) end / 64);		// a batch takes over 64 bytes
+	if (ok) {
+		mBatches.resize((size_t) nBatch);
+	}
+	for (size_t b = 0; ok && (b < mBatches.size()); b++) {
+		GLABatch& batch = mBatches[b];
+		GLfloat head[5];
+		ok = (fread(head, sizeof(GLfloat), 5, fp) == 5) &&
+		     GLACacheRead(fp, end, batch.mVerts) &&
+		     GLACacheRead(fp, end, batch.mLines) &&
+		     GLACacheRead(fp, end, batch.mTris) &&
+		     GLACacheRead(fp, end, batch.mPoints) &&
+		     GLACacheRead(fp, end, batch.mSpheres) &&
+		     GLACacheRead(fp, end, batch.mCylinders) &&
+		     GLACacheReadFrame(fp, batch.mBounds) &&
+		     (batch.mSpheres.size() % 5 == 0) && (batch.mCylinders.size() % 5 == 0);
+		for (int i = 0; i < 4; i++) {
+			batch.mColour[i] = head[i];
+		}
+		batch.mHasColour = (head[4] != 0.0f);
+		GLuint nVert = (GLuint) (batch.mVerts.size() / 3);
+		const std::vector<GLuint>* index[3] = { &batch.mLines, &batch.mTris,
+		                                        &batch.mPoints };
+		for (int k = 0; ok && (k < 3); k++) {
+			for (size_t i = 0; ok && (i < index[k]->size()); i++) {
+				ok = ((*index[k])[i] < nVert);
+			}
+		}
+	}
+	ok = ok && GLACacheReadFrame(fp, bounds) && mPicker.Read(fp, end);
+	if (!ok) {
+		mBatches.clear();
+		mPicker.Clear();
+		return false;
+	}
+	mBounds->Set(bounds);
 	return true;
 }
 //
 //	Functions to install and release the scanner. Create automatically
 //	releases the scanner when it is finished with it. These are for
-//	completeness.
+//	completeness. Releasing syncs the scanner's FILE so that whoever
+//	reads on after the end directive starts in the right place.
 //
 void CGLAList::InstallScanner(CTextScanner* newScan) {
 	mScan = newScan;
 }
 void CGLAList::ReleaseScanner() {
+	if (mScan != NULL) {
+		mScan->Sync();
+	}
 	mScan = NULL;
 }
 //
@@ -281,13 +561,15 @@ void CGLAList::ReleaseScanner() {
 //
 int CGLAList::GetArgList() {
 	//
-	//	Reads three space separated numbers into the three slots
-	//	in thePoint.
+	//	Reads space separated numbers, as many as there are, into
+	//	mArguments.
 	//
 	Lexeme* cLex;
 	int argNum = 0;
+	mArguments.clear();
 	while ((cLex = mScan->NextLex())->lex == LReal || (cLex->lex == LInteger)) {
-		gArguments[argNum++] = (float) cLex->nVal;
+		mArguments.push_back(cLex->nVal);
+		argNum++;
 		//
 		//	Ignore any separators
 		//
@@ -297,28 +579,315 @@ int CGLAList::GetArgList() {
 		}
 	}
 	if (cLex->lex != LNewLine) {
-wxLogMessage("CGLAList.Create: Expected end of line!\n");
+		Report("CGLAList.Create: Expected end of line!\n");
 		return -argNum;
 	}
 	mScan->ReturnSym();
 	return argNum;
 }
 //
+//	The line we are on in the whole file, which is where a piece starts
+//	plus where we are in it.
+//
+unsigned long CGLAList::LineNumber() {
+	return mLineBase + mScan->LineNumber();
+}
+//
+//	Report prints a message, or keeps it for later if we are a piece
+//	that is being parsed on some other thread.
+//
+void CGLAList::Report(const char* format, ...) {
+	char buff[1024];
+	va_list args;
+	va_start(args, format);
+	vsnprintf(buff, sizeof(buff), format, args);
+	va_end(args);
+	if (mHoldMessages) {
+		mMessages.push_back(buff);
+	} else {
+		eprintf("%s", buff);
+	}
+}
+void CGLAList::FlushMessages() {
+	for (size_t m = 0; m < mMessages.size(); m++) {
+		eprintf("%s", mMessages[m].c_str());
+	}
+	mMessages.clear();
+}
+//
+//	Batch helpers.
+//	SetColour switches to the batch for a colour, making one if this
+//	is a new colour. There are rarely more than a handful of colours
+//	so a linear search is fine. Search backwards so that we find the
+//	newest chunk of a colour, the one that still has room.
+//
+void CGLAList::SetColour(const GLfloat* colour) {
+	for (int b = (int) mBatches.size() - 1; b >= 0; b--) {
+		const GLfloat* c = mBatches[b].mColour;
+		if (mBatches[b].mHasColour && (c[0] == colour[0]) &&
+		    (c[1] == colour[1]) && (c[2] == colour[2]) && (c[3] == colour[3])) {
+			mCurBatch = b;
+			return;
+		}
+	}
+	mBatches.push_back(GLABatch());
+	mCurBatch = (int) mBatches.size() - 1;
+	GLABatch& nb = mBatches[mCurBatch];
+	for (int i = 0; i < 4; i++) {
+		nb.mColour[i] = colour[i];
+	}
+	nb.mHasColour = true;
+}
+//
+//	CurBatch returns the batch that geometry is going into. Geometry
+//	that comes before any color command goes in an uncoloured batch.
+//
+GLABatch& CGLAList::CurBatch() {
+	if (mCurBatch < 0) {
+		mBatches.push_back(GLABatch());
+		mCurBatch = (int) mBatches.size() - 1;
+		mBatches[mCurBatch].mHasColour = false;
+	}
+	return mBatches[mCurBatch];
+}
+//
+//	CheckChunk is called between commands, never inside one, so that
+//	indices never cross from one batch to the next. A full batch is
+//	never touched again, since SetColour only ever finds the newest
+//	batch of a colour, so it can go straight to the stream.
+//
+void CGLAList::CheckChunk() {
+	if ((mCurBatch < 0) || (mBatches[mCurBatch].NPrim() < kGLAChunkSize)) {
+		return;
+	}
+	GLABatch nb;
+	for (int i = 0; i < 4; i++) {
+		nb.mColour[i] = mBatches[mCurBatch].mColour[i];
+	}
+	nb.mHasColour = mBatches[mCurBatch].mHasColour;
+	if (mStream != NULL) {
+		mStream->Put(mBatches[mCurBatch]);
+		mBatches.erase(mBatches.begin() + mCurBatch);
+		size_t here = mScan->Offset();
+		mStream->AddParsed(here - mStreamMark);
+		mStreamMark = here;
+	}
+	mBatches.push_back(nb);
+	mCurBatch = (int) mBatches.size() - 1;
+}
+//
+//	Empty batches are not worth keeping.
+//
+void CGLAList::AddBatches(std::vector<GLABatch>& batches) {
+	for (size_t b = 0; b < batches.size(); b++) {
+		if (batches[b].NPrim() > 0) {
+			mBatches.push_back(std::move(batches[b]));
+		}
+	}
+	batches.clear();
+	mCurBatch = -1;
+}
+void GLAStream::Put(GLABatch& batch) {
+	std::lock_guard<std::mutex> lock(mLock);
+	mBatches.push_back(std::move(batch));
+}
+void GLAStream::Take(std::vector<GLABatch>& batches) {
+	std::lock_guard<std::mutex> lock(mLock);
+	for (size_t b = 0; b < mBatches.size(); b++) {
+		batches.push_back(std::move(mBatches[b]));
+	}
+	mBatches.clear();
+}
+//
+//	AddVertex applies the current translation.
+//
+GLuint CGLAList::AddVertex(const double* v) {
+	GLABatch& batch = CurBatch();
+	std::vector<GLfloat>& verts = batch.mVerts;
+	GLuint index = (GLuint) (verts.size() / 3);
+	double p[3] = { mOffset[0] + v[0], mOffset[1] + v[1], mOffset[2] + v[2] };
+	verts.push_back(GLfloat(p[0]));
+	verts.push_back(GLfloat(p[1]));
+	verts.push_back(GLfloat(p[2]));
+	batch.mBounds.AddPoint3dv(p);
+	return index;
+}
+//
+//	Draw works through the batches. Lines, triangles and points come
+//	straight from the batch arrays. Spheres and cylinders are first
+//	sorted into bins by level of detail; then each bin binds its
+//	shared mesh once and just moves it about.
+//	Chunks that are off screen are skipped whole. In a chunk that is
+//	only partly on screen each sphere and cylinder is tested too.
+//	ScreenSize is how many pixels size spans at a depth of depth; one
+//	that reaches the camera, or that we cannot size, gets full detail.
+//
+static double ScreenSize(double focalPixels, double size, double depth) {
+	return (depth > size) ? focalPixels * size / depth : 0.0;
+}
+void CGLAList::Draw(double focalPixels, const Frustum* frustum) {
+	if ((nullptr == frustum) || !frustum->IsValid()) {
+		focalPixels = 0.0;
+	}
+	std::map<int, std::vector<int> >::iterator bin;
+	for (int b = 0; b < (int) mBatches.size(); b++) {
+		const GLABatch& batch = mBatches[b];
+		FrustumTest test = kFrustumInside;
+		if (nullptr != frustum) {
+			test = frustum->Classify(batch.mBounds);
+			if (test == kFrustumOutside) {
+				continue;
+			}
+		}
+		const Frustum* partial = (test == kFrustumPartial) ? frustum : nullptr;
+		if (batch.mHasColour) {
+			glMaterialfv(GL_FRONT, GL_AMBIENT, batch.mColour);
+			glMaterialfv(GL_FRONT, GL_SPECULAR, batch.mColour);
+			glColor3fv(batch.mColour);
+		}
+		if (!batch.mVerts.empty()) {
+			Call(glEnableClientState(GL_VERTEX_ARRAY));
+			Call(glVertexPointer(3, GL_FLOAT, 0, &batch.mVerts[0]));
+			if (!batch.mLines.empty()) {
+				Call(glDrawElements(GL_LINES, (GLsizei) batch.mLines.size(),
+				                    GL_UNSIGNED_INT, &batch.mLines[0]));
+			}
+			if (!batch.mTris.empty()) {
+				Call(glDrawElements(GL_TRIANGLES, (GLsizei) batch.mTris.size(),
+				                    GL_UNSIGNED_INT, &batch.mTris[0]));
+			}
+			if (!batch.mPoints.empty()) {
+				Call(glDrawElements(GL_POINTS, (GLsizei) batch.mPoints.size(),
+				                    GL_UNSIGNED_INT, &batch.mPoints[0]));
+			}
+			Call(glDisableClientState(GL_VERTEX_ARRAY));
+		}
+		const std::vector<GLfloat>& s = batch.mSpheres;
+		if (!s.empty()) {
+			for (bin = mLODBins.begin(); bin != mLODBins.end(); ++bin) {
+				bin->second.clear();
+			}
+			for (int i = 0; i < (int) s.size(); i += 5) {
+				double c[3] = { s[i], s[i + 1], s[i + 2] };
+				if (nullptr != partial) {
+					if (partial->ClassifySphere(c, s[i + 3]) == kFrustumOutside) {
+						continue;
+					}
+				}
+				double pixels = (focalPixels > 0.0) ?
+				    ScreenSize(focalPixels, s[i + 3], frustum->Depth(c)) : 0.0;
+				int slices = CGLAMesh::LODSlices(pixels, (int) s[i + 4]);
+				mLODBins[slices].push_back(i);
+			}
+			for (bin = mLODBins.begin(); bin != mLODBins.end(); ++bin) {
+				if (bin->second.empty()) continue;
+				const CGLAMesh* mesh = CGLAMesh::Sphere(bin->first);
+				mesh->Bind();
+				for (size_t k = 0; k < bin->second.size(); k++) {
+					const GLfloat* p = &s[bin->second[k]];
+					glPushMatrix();
+					glTranslatef(p[0], p[1], p[2]);
+					glScalef(p[3], p[3], p[3]);
+					mesh->DrawBound();
+					glPopMatrix();
+				}
+				CGLAMesh::Unbind();
+			}
+		}
+		const std::vector<GLfloat>& c = batch.mCylinders;
+		if (!c.empty()) {
+			for (bin = mLODBins.begin(); bin != mLODBins.end(); ++bin) {
+				bin->second.clear();
+			}
+			for (int i = 0; i < (int) c.size(); i += 5) {
+				if (nullptr != partial) {
+					double box[6] = { c[i] - c[i + 4], c[i + 1] - c[i + 4], c[i + 2],
+					                  c[i] + c[i + 4], c[i + 1] + c[i + 4], c[i + 3] };
+					if (partial->ClassifyBox(box) == kFrustumOutside) {
+						continue;
+					}
+				}
+				//
+				//	Size the radius at the middle of the axis, but count
+				//	anywhere along it as the nearest it could be.
+				//
+				double pixels = 0.0;
+				if (focalPixels > 0.0) {
+					double mid[3] = { c[i], c[i + 1], 0.5 * (c[i + 2] + c[i + 3]) };
+					double depth = frustum->Depth(mid) - 0.5 * fabs(c[i + 3] - c[i + 2]);
+					pixels = ScreenSize(focalPixels, c[i + 4], depth);
+				}
+				int slices = CGLAMesh::LODSlices(pixels, 20);
+				mLODBins[slices].push_back(i);
+			}
+			for (bin = mLODBins.begin(); bin != mLODBins.end(); ++bin) {
+				if (bin->second.empty()) continue;
+				const CGLAMesh* mesh = CGLAMesh::Cylinder(bin->first);
+				mesh->Bind();
+				for (size_t k = 0; k < bin->second.size(); k++) {
+					const GLfloat* p = &c[bin->second[k]];
+					glPushMatrix();
+					glTranslatef(p[0], p[1], p[2]);
+					glScalef(p[4], p[4], p[3] - p[2]);
+					mesh->DrawBound();
+					glPopMatrix();
+				}
+				CGLAMesh::Unbind();
+			}
+		}
+	}
+}
+int CGLAList::GetNPrim() const {
+	int n = 0;
+	for (int b = 0; b < (int) mBatches.size(); b++) {
+		n += mBatches[b].NPrim();
+	}
+	return n;
+}
+//
+//	DrawProxy draws twelve edges per chunk whatever is in it.
+//
+void CGLAList::DrawProxy(const Frustum* frustum) {
+	static const GLuint edges[24] = { 0,1, 1,3, 3,2, 2,0, 4,5, 5,7, 7,6, 6,4,
+	                                  0,4, 1,5, 2,6, 3,7 };
+	GLfloat corners[24];
+	Call(glEnableClientState(GL_VERTEX_ARRAY));
+	Call(glVertexPointer(3, GL_FLOAT, 0, corners));
+	for (int b = 0; b < (int) mBatches.size(); b++) {
+		const GLABatch& batch = mBatches[b];
+		const Frame3D& f = batch.mBounds;
+		if (f.IsEmpty() ||
+		    ((nullptr != frustum) && !frustum->Visible(f))) {
+			continue;
+		}
+		if (batch.mHasColour) {
+			glColor3fv(batch.mColour);
+		}
+		for (int c = 0; c < 8; c++) {
+			corners[3 * c] = GLfloat((c & 1) ? f.XMax() : f.XMin());
+			corners[3 * c + 1] = GLfloat((c & 2) ? f.YMax() : f.YMin());
+			corners[3 * c + 2] = GLfloat((c & 4) ? f.ZMax() : f.ZMin());
+		}
+		glDrawElements(GL_LINES, 24, GL_UNSIGNED_INT, edges);
+	}
+	Call(glDisableClientState(GL_VERTEX_ARRAY));
+}
+//
 //	BuildLine reads two float triplets in and uses them to construct
 //	an OpenGL line.
 //
 bool CGLAList::BuildLine(int nArg) {
 	bool valid = false;
 	if (nArg >= 6) {
-		glBegin(GL_LINES);
-		glVertex3fv(&gArguments[0]);
-		glVertex3fv(&gArguments[3]);
-		glEnd();
-		mBounds->AddPoint3fv(&gArguments[0]);
-		mBounds->AddPoint3fv(&gArguments[3]);
+		GLuint a = AddVertex(&mArguments[0]);
+		GLuint b = AddVertex(&mArguments[3]);
+		mBatches[mCurBatch].mLines.push_back(a);
+		mBatches[mCurBatch].mLines.push_back(b);
+		mBounds->AddPoint3dv(&mArguments[0]);
+		mBounds->AddPoint3dv(&mArguments[3]);
 		valid = true;
 	} else {
-wxLogMessage("LINE needs 6 floats to make two end points.\n");
+		Report("LINE needs 6 floats to make two end points.\n");
 	}
 	return valid;
 }
@@ -332,44 +901,62 @@ bool CGLAList::BuildPolyLine(int nArg) {
 	//	First thing is the number of points in the line.
 	//
 	if (nArg > 1) {
-		int nPoint = (int) gArguments[0];
+		//
+		//	Lines can have any number of points now, so keep a silly
+		//	count from overflowing before we compare it.
+		//
+		double count = mArguments[0];
+		int nPoint = ((count >= 0.0) && (count <= nArg)) ? (int) count : -1;
 		if (nArg - 1 != 3 * nPoint) {
-      eprintf("Not enough arguments. To make %d points need %d args.\n",
-              nPoint,3*nPoint);
+      Report("Not enough arguments. To make %g points need %g args.\n",
+              count, 3 * count);
 			return false;
 		}
-		glBegin(GL_LINE_STRIP);
-		for (int p = 1; p <3*nPoint; ++p) {
-			glVertex3fv(&gArguments[p]);
-			mBounds->AddPoint3fv(&gArguments[p]);
+		//
+		//	Consecutive points share their vertex; only the indices are
+		//	doubled up.
+		//
+		for (int p = 0; p < nPoint; ++p) {
+			GLuint index = AddVertex(&mArguments[1 + 3 * p]);
+			if (p > 0) {
+				mBatches[mCurBatch].mLines.push_back(index - 1);
+				mBatches[mCurBatch].mLines.push_back(index);
+			}
+			mBounds->AddPoint3dv(&mArguments[1 + 3 * p]);
 		}
-		glEnd();
 		return true;
 	} else {
-wxLogMessage("Polyline command does not have number of points.\r\n");
+		Report("Polyline command does not have number of points.\r\n");
 	}
 	return false;
 }
 //
 //	BuildSphere reads in a radius and centre position and
-//	accepts a number of slices if there is one.
-//	It creates a GLUSphere and moves it into position.
+//	accepts a number of slices if there is one. The slices are now
+//	the finest level of detail that the sphere will be drawn at.
 //
 bool CGLAList::BuildSphere(int nArg) {
 	if (nArg >= 4) {
-		float radius = gArguments[0];
-		glPushMatrix();
-		 glTranslatef(gArguments[1],gArguments[2],gArguments[3]);
-		 GLUquadricObj *glq = gluNewQuadric();
-		 if (nArg >= 5) {
-			gluSphere(glq, radius, (int) gArguments[4], (int) gArguments[4]);
-		 } else {
-			gluSphere(glq, radius, 20, 20);
-		 }
-		glPopMatrix();
+		double radius = mArguments[0];
+		int slices = (nArg >= 5) ? (int) mArguments[4] : 20;
+		double centre[3] = { mOffset[0] + mArguments[1],
+		                     mOffset[1] + mArguments[2],
+		                     mOffset[2] + mArguments[3] };
+		mPicker.AddSphere(centre, radius, (int) LineNumber());
+		GLABatch& batch = CurBatch();
+		std::vector<GLfloat>& s = batch.mSpheres;
+		for (int i = 0; i < 3; i++) {
+			s.push_back(GLfloat(centre[i]));
+		}
+		double lo[3] = { centre[0] - radius, centre[1] - radius, centre[2] - radius };
+		double hi[3] = { centre[0] + radius, centre[1] + radius, centre[2] + radius };
+		batch.mBounds.AddPoint3dv(lo);
+		batch.mBounds.AddPoint3dv(hi);
+		s.push_back(GLfloat(radius));
+		s.push_back(GLfloat(slices));
 		return true;
 	} else {
-wxLogMessage("Need at least 4 args for sphere: radius and centre.\r\n");
+		Report("Need at least 4 args for sphere: radius and centre.\r\n");
 	}
 	return false;
 }
@@ -380,47 +967,27 @@ wxLogMessage("Need at least 4 args for sphere: radius and centre.\r\n");
 bool CGLAList::BuildBox(int nArg) {
 	if (nArg >= 6) {
 		//
-		//	Bottom cap.
-		//
-		glBegin(GL_LINE_LOOP);
-		glVertex3f(gArguments[0], gArguments[1], gArguments[2]);
-		glVertex3f(gArguments[0], gArguments[4], gArguments[2]);
-		glVertex3f(gArguments[3], gArguments[4], gArguments[2]);
-		glVertex3f(gArguments[3], gArguments[1], gArguments[2]);
-		glEnd();
-		//
-		//	Top cap.
-		//
-		glBegin(GL_LINE_LOOP);
-		glVertex3f(gArguments[0], gArguments[1], gArguments[5]);
-		glVertex3f(gArguments[0], gArguments[4], gArguments[5]);
-		glVertex3f(gArguments[3], gArguments[4], gArguments[5]);
-		glVertex3f(gArguments[3], gArguments[1], gArguments[5]);
-		glEnd();
+		//	Eight corners and the twelve edges that join them. Bit 0 of
+		//	the corner number picks x, bit 1 y and bit 2 z.
 		//
-		//	And four pillars.
-		//
-		glBegin(GL_LINES);
-		glVertex3f(gArguments[0], gArguments[1], gArguments[2]);
-		glVertex3f(gArguments[0], gArguments[1], gArguments[5]);
-		glEnd();
-		glBegin(GL_LINES);
-		glVertex3f(gArguments[0], gArguments[4], gArguments[2]);
-		glVertex3f(gArguments[0], gArguments[4], gArguments[5]);
-		glEnd();
-		glBegin(GL_LINES);
-		glVertex3f(gArguments[3], gArguments[4], gArguments[2]);
-		glVertex3f(gArguments[3], gArguments[4], gArguments[5]);
-		glEnd();
-		glBegin(GL_LINES);
-		glVertex3f(gArguments[3], gArguments[1], gArguments[2]);
-		glVertex3f(gArguments[3], gArguments[1], gArguments[5]);
-		glEnd();
-		mBounds->AddPoint3fv(&gArguments[0]);
-		mBounds->AddPoint3fv(&gArguments[3]);
+		static const int edges[24] = { 0,1, 1,3, 3,2, 2,0, 4,5, 5,7, 7,6, 6,4,
+		                               0,4, 1,5, 2,6, 3,7 };
+		GLuint base = 0;
+		for (int c = 0; c < 8; c++) {
+			double v[3] = { mArguments[(c & 1) ? 3 : 0],
+			                mArguments[(c & 2) ? 4 : 1],
+			                mArguments[(c & 4) ? 5 : 2] };
+			GLuint index = AddVertex(v);
+			if (c == 0) base = index;
+		}
+		for (int e = 0; e < 24; e++) {
+			mBatches[mCurBatch].mLines.push_back(base + edges[e]);
+		}
+		mBounds->AddPoint3dv(&mArguments[0]);
+		mBounds->AddPoint3dv(&mArguments[3]);
 		return true;
 	}else {
-wxLogMessage("Need at least 6 args for box (2 points).\r\n");
+		Report("Need at least 6 args for box (2 points).\r\n");
 	}
 	return false;
 }
@@ -432,17 +999,21 @@ wxLogMessage("Need at least 6 args for box (2 points).\r\n");
 //
 bool CGLAList::BuildTriangle(int nArg) {
 	if (nArg >= 9) {
-		glBegin(GL_TRIANGLES);
-		glVertex3fv(&gArguments[0]);
-		glVertex3fv(&gArguments[3]);
-		glVertex3fv(&gArguments[6]);
-		glEnd();
-		mBounds->AddPoint3fv(&gArguments[0]);
-		mBounds->AddPoint3fv(&gArguments[3]);
-		mBounds->AddPoint3fv(&gArguments[6]);
+		for (int i = 0; i < 9; i += 3) {
+			GLuint index = AddVertex(&mArguments[i]);
+			mBatches[mCurBatch].mTris.push_back(index);
+		}
+		mBounds->AddPoint3dv(&mArguments[0]);
+		mBounds->AddPoint3dv(&mArguments[3]);
+		mBounds->AddPoint3dv(&mArguments[6]);
+		double v[9];
+		for (int i = 0; i < 9; i++) {
+			v[i] = mOffset[i % 3] + mArguments[i];
+		}
+		mPicker.AddTriangle(v, (int) LineNumber());
 		return true;
 	}else {
-wxLogMessage("Need at least 9 args for triangle (3 points).\r\n");
+		Report("Need at least 9 args for triangle (3 points).\r\n");
 	}
 	return false;
 }
@@ -457,17 +1028,20 @@ bool CGLAList::BuildCylinder(int nArg) {
     //  This one is not too bad because it builds its cylinder
     //  with the axis along z.
     //
-    float bottom = gArguments[0];
-    float top = gArguments[1];
-    float radius = gArguments[2];
-    GLUquadricObj *glq = gluNewQuadric();
-    glPushMatrix();
-    glTranslatef(0, 0, bottom);
-//    if (mFlags & kGFWire) { // Wire Frame
-      gluQuadricDrawStyle(glq, GLU_LINE);
-//    }
-    gluCylinder(glq, radius, radius, top - bottom, 20, 20);
-    glPopMatrix();
+    double bottom = mArguments[0];
+    double top = mArguments[1];
+    double radius = mArguments[2];
+    GLfloat c[5] = { GLfloat(mOffset[0]), GLfloat(mOffset[1]),
+                     GLfloat(mOffset[2] + bottom), GLfloat(mOffset[2] + top),
+                     GLfloat(radius) };
+    GLABatch& batch = CurBatch();
+    batch.mCylinders.insert(batch.mCylinders.end(), c, c + 5);
+    double lo[3] = { c[0] - radius, c[1] - radius, fmin(c[2], c[3]) };
+    double hi[3] = { c[0] + radius, c[1] + radius, fmax(c[2], c[3]) };
+    batch.mBounds.AddPoint3dv(lo);
+    batch.mBounds.AddPoint3dv(hi);
+    mPicker.AddCylinder(mOffset[0], mOffset[1], mOffset[2] + bottom,
+                        mOffset[2] + top, radius, (int) LineNumber());
   } else if (nArg >= 6) {
     //
     //  This is more complex because it has to re-orient the
@@ -475,7 +1049,7 @@ bool CGLAList::BuildCylinder(int nArg) {
     //  the cylinder along the new z.
     //
 	}else {
-    wxLogMessage("Need at least 3 args for cylinder.\r\n");
+    Report("Need at least 3 args for cylinder.\r\n");
 	}
 	return false;
 }
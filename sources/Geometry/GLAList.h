@@ -19,54 +19,190 @@
 *	This gets text from a TextScanner that it expects to be ready 
 *	for use.
 *	BCollett 1/26/04 Redesign with argument list and class symbol table.
+*	BCollett 10/19/26 Collect geometry into per-colour vertex and index
+*	arrays instead of a display list of glBegin/glEnd pairs.
+*	BCollett 10/19/26 Parse big files in pieces on several threads.
+*	BCollett 10/19/26 Look verbs up in a compile time keyword table.
+*	BCollett 10/19/26 Arguments are doubles in a buffer that grows.
+*	BCollett 10/19/26 Hand full batches to a GLAStream while parsing.
 */
 #ifndef _H_GLAList_H
 #define _H_GLAList_H
 #pragma once
 
+#include <string>
+#include <atomic>
+#include <mutex>
 //#include "GLBAse/OpenGLApp.h"
-#include "../Scanner/CSymbolTable.h"
+#include "../Scanner/CKeywordTable.h"
 #include "../Scanner/CTextScanner.h"
 #include "GeometricObjects.h"
+#include "Picker.h"
+#include "GLAMesh.h"
+
+//
+//	The verbs that can be found in a .gla file, each with its command
+//	and its name. This is the only list of them; the GLCommand enum and
+//	the keyword table are both made from it, so a new verb goes here
+//	and in the switch in CGLAList::ParseCommands. Names are lower case
+//	and match in any case.
+//
+#define GLA_VERBS(VERB) \
+	VERB(kGLColor, "color") \
+	VERB(kGLLine, "line") \
+	VERB(kGLPoint, "point") \
+	VERB(kGLPolyLine, "polyline") \
+	VERB(kGLSphere, "sphere") \
+	VERB(kGLBox, "box") \
+	VERB(kGLTriangle, "triangle") \
+	VERB(kGLTranslate, "translate") \
+	VERB(kGLCylinder, "cylinder") \
+	VERB(kGLCap, "cap") \
+	VERB(kGLEnd, "end")		/* end of geometry. Allows sharing geom file with other. */
 
 //
 //	Enum for the different kinds of OpenGL command that can be
 //	found in a .gla file.
 //
 typedef enum {
-	kGLColor = 0,
-	kGLLine,
-	kGLPoint,
-	kGLPolyLine,
-	kGLSphere,
-	kGLBox,
-	kGLTriangle,
-	kGLTriStrip,
-	kGLTranslate,
-  kGLCylinder,
-  kGLCap,
-  kGLEnd,     // end of geometry. Allows sharing geom file with other.
-	kGLError 
+#define GLA_VERB_ENUM(sym, name) sym,
+	GLA_VERBS(GLA_VERB_ENUM)
+#undef GLA_VERB_ENUM
+	kGLError
 } GLCommand;
+//
+//	The keyword table for the verbs, see CKeywordTable.h.
+//
+struct GLAVerbs {
+	static constexpr CKeyword kWords[] = {
+#define GLA_VERB_KEYWORD(sym, name) { name, sym },
+		GLA_VERBS(GLA_VERB_KEYWORD)
+#undef GLA_VERB_KEYWORD
+	};
+	static constexpr const CKeyword* Words() { return kWords; };
+	static constexpr int kNWords = kGLError;
+	static constexpr int kNSlots = 32;
+};
+constexpr CKeywordTable kGLAVerbTable = CKMakeTable<GLAVerbs>();
+
+//
+//	Geometry is collected into batches by colour as the file is read.
+//	Lines, triangles and points share a vertex array and each has its own
+//	index array so that each kind can be drawn with a single call.
+//	Spheres and cylinders are kept as instances of the shared meshes
+//	and the level of detail for each is picked as it is drawn.
+//	A batch is closed off once it holds kGLAChunkSize primitives and
+//	another of the same colour started, so that each batch is a chunk
+//	of nearby geometry whose bounds can be culled against the frustum.
+//
+const int kGLAChunkSize = 1024;
+//
+//	Models with fewer primitives than this draw quickly enough that
+//	there is no point in showing a proxy while the view is dragged.
+//
+const int kGLAProxyPrims = 50000;
+//
+//	A mapped file with at least this much text left is parsed in pieces
+//	on several threads, see CGLAList::CreateParallel. Each piece is at
+//	least kGLAPieceBytes long and ends at the end of a line.
+//
+const size_t kGLAParallelBytes = 1 << 20;
+const size_t kGLAPieceBytes = 1 << 18;
+struct GLASurvey;
+
+struct GLABatch {
+	GLfloat mColour[4];
+	bool mHasColour;				// False until a color command
+	std::vector<GLfloat> mVerts;
+	std::vector<GLuint> mLines;		// Index pairs
+	std::vector<GLuint> mTris;		// Index triples
+	std::vector<GLuint> mPoints;
+	std::vector<GLfloat> mSpheres;		// x y z r maxSlices
+	std::vector<GLfloat> mCylinders;	// x y zMin zMax r
+	Frame3D mBounds;				// Translated, unlike CDisplayList's
+	int NPrim() const {
+		return (int) (mLines.size() / 2 + mTris.size() / 3 + mPoints.size() +
+		              mSpheres.size() / 5 + mCylinders.size() / 5);
+	};
+};
+//
+//	A list that is being made on one thread can be shown on another as
+//	it grows. Each batch that fills up is moved out of the list into a
+//	GLAStream, where the other thread can Take it, and the stream counts
+//	how many bytes of text have been parsed. The batches that are still
+//	filling, the bounds and the picker stay in the list until Create
+//	has finished. The pieces of a parallel parse share their parent's
+//	stream.
+//
+class GLAStream {
+protected:
+	std::mutex mLock;
+	std::vector<GLABatch> mBatches;
+	std::atomic<size_t> mParsed;
+public:
+	GLAStream() : mParsed(0) {};
+	void Put(GLABatch& batch);
+	void Take(std::vector<GLABatch>& batches);
+	void AddParsed(size_t n) { mParsed += n; };
+	size_t GetParsed() const { return mParsed; };
+};
 
 class CGLAList : public CDisplayList {
 protected:
 	//
 	//	Class variables.
-	//	Class owns a symbol table to translate the keywords and
-	//	a large array in which to store the arguments.
-	//	These should be filled in by calling InitClass(nArg)
-	//	before creating any class members.
+	//	InitClass(nArg) should be called before creating any class
+	//	members. nArg is how many arguments each list makes room for
+	//	to start with. The verbs are looked up in kGLAVerbTable, which
+	//	needs no setting up.
 	//
-	static CSymbolTable* gSymTab;
-	static GLfloat* gArguments;
-	static int gMaxNArgs;
+	static int sArgReserve;
+	static int sThreads;			// 0 for one per core
 	//
 	//	Instance variables.
 	//
 	//COpenGLApp* mApp;		// Owning app, so we can print!
 	CTextScanner* mScan;	//  our scanner (when valid)
 	//
+	//	The arguments of the current line. The buffer only ever grows, so
+	//	once it has room for the longest line so far no line allocates,
+	//	and a line can have as many arguments as it likes.
+	//
+	std::vector<double> mArguments;
+	//
+	//	A list that parses a piece of a file counts its lines on from
+	//	mLineBase and holds on to its messages until the pieces are
+	//	put back together, since only one thread may print them. The
+	//	pieces pass theirs on through Report, so a list that is itself
+	//	holding keeps them all.
+	//
+	unsigned long mLineBase;
+	bool mHoldMessages;
+	std::vector<std::string> mMessages;
+	//
+	//	Where full batches go while we parse, if anywhere, and how far
+	//	into the text we were when we last said.
+	//
+	GLAStream* mStream;
+	size_t mStreamMark;
+	//
+	//	The solid pieces of the model are also added to a picker so that
+	//	clicks can be resolved without GL_SELECT. Ids are the line numbers
+	//	in the .gla file. mOffset tracks translate commands.
+	//
+	CPicker mPicker;
+	double mOffset[3];
+	//
+	//	The batches and the one that geometry is currently going into.
+	//
+	std::vector<GLABatch> mBatches;
+	int mCurBatch;
+	//
+	//	Scratch space for Draw. Instances sorted by slices so each
+	//	mesh is only bound once per batch.
+	//
+	std::map<int, std::vector<int> > mLODBins;
+	//
 public:
 	//
 	//	Constructor and destructor.
@@ -80,16 +216,70 @@ public:
 	//
 	virtual bool Create();
 	//
+	//	Draw the batches. This replaces CallList for a CGLAList.
+	//	focalPixels is the number of screen pixels that a unit spans one
+	//	unit in front of the camera, see GLViewerCanvas::FocalPixels.
+	//	Each sphere and cylinder is sized at its own distance from the
+	//	camera, which the frustum knows, to set its level of detail.
+	//	Zero, or no frustum, draws everything at full detail. Chunks,
+	//	spheres and cylinders entirely outside the frustum are skipped.
+	//
+	virtual void Draw(double focalPixels = 0.0,
+	                  const Frustum* frustum = NULL);
+	//
+	//	DrawProxy just outlines the bounds of each chunk in its colour.
+	//	It is what we show while the view is being dragged about.
+	//
+	virtual void DrawProxy(const Frustum* frustum = NULL);
+	int GetNBatch() const { return (int) mBatches.size(); };
+	int GetNPrim() const;
+	//
 	//	Have a pair of functions to control our onership of the
 	//	scanner.
 	//
 	void InstallScanner(CTextScanner* newScan);
 	void ReleaseScanner();
 	//
+	//	Access to the picker, valid once Create has finished.
+	//
+	const CPicker* GetPicker() const { return &mPicker; };
+	//
+	//	A list that is made on some other thread can hold on to its
+	//	messages too. FlushMessages prints them and must be called on
+	//	the thread that owns the log.
+	//
+	void HoldMessages(bool hold) { mHoldMessages = hold; };
+	void FlushMessages();
+	//
+	//	Send each batch to stream as soon as it is full. NULL stops it.
+	//	The stream must last until Create returns.
+	//
+	void StreamTo(GLAStream* stream) { mStream = stream; };
+	//
+	//	Move batches, ones taken from a stream or all of another list's,
+	//	onto the end of ours. Only the batches move; the bounds and the
+	//	picker stay as they were.
+	//
+	void AddBatches(std::vector<GLABatch>& batches);
+	void AddBatches(CGLAList& other) { AddBatches(other.mBatches); };
+	//
+	//	Write what Create made to a GLACache file and read it back
+	//	instead of calling Create. end is the size of the file. Read
+	//	leaves the list empty if it fails.
+	//
+	bool Write(FILE* fp) const;
+	bool Read(FILE* fp, long end);
+	//
 	//	Class routines to init and destroy the class.
 	//
 	static bool InitClass(int);
 	static void ReleaseClass();
+	//
+	//	How many threads Create may use. 0, the default, is one per
+	//	core and 1 always parses on the calling thread.
+	//
+	static void SetThreads(int nThreads);
+	static int GetThreads();
 protected:
 	//
 	//	Helper functions used internally.
@@ -98,6 +288,28 @@ protected:
 	//	it puts into the argument array.
 	//
 	int GetArgList();
+	//
+	//	ParseCommands is the body of Create. It works through the text
+	//	in the scanner and returns true if it stopped at an end directive.
+	//	CreateParallel does the same job in pieces and returns false if
+	//	the text is not worth splitting. Survey makes a first quick pass
+	//	over a piece for the commands whose effects carry on to the next.
+	//
+	bool ParseCommands();
+	bool CreateParallel();
+	void Survey(GLASurvey& survey);
+	unsigned long LineNumber();
+	void Report(const char* format, ...);
+	//
+	//	Batch helpers. SetColour switches to (or makes) the batch for a
+	//	colour, CurBatch returns the current batch and AddVertex puts a
+	//	translated vertex in it and returns its index. CheckChunk starts
+	//	a new batch of the same colour when the current one is full.
+	//
+	void SetColour(const GLfloat* colour);
+	GLABatch& CurBatch();
+	void CheckChunk();
+	GLuint AddVertex(const double* v);
 	bool BuildPoint(int nArg);
 	//
 	//	BuildLine reads two float triplets in and uses them to construct
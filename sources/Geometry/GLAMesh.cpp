@@ -0,0 +1,155 @@
+/*
+ *	GLAMesh.cpp
+ *
+ *	A CGLAMesh is a small indexed mesh held in client-side vertex
+ *	arrays. The GLA loader uses one shared unit sphere and one shared
+ *	unit cylinder for every instance in a model and places them with
+ *	the modelview matrix.
+ *
+ *	BCollett 10/19/26
+ */
+#include <math.h>
+#include "GLAMesh.h"
+
+#ifdef UseOpenGL
+//
+//	Class variables.
+//
+std::map<int, CGLAMesh*> CGLAMesh::gSpheres;
+std::map<int, CGLAMesh*> CGLAMesh::gCylinders;
+//
+//	Constructor and destructor.
+//
+CGLAMesh::CGLAMesh(GLenum mode) {
+	mMode = mode;
+}
+CGLAMesh::~CGLAMesh() {
+}
+//
+//	Drawing.
+//
+void CGLAMesh::Bind() const {
+	Call(glEnableClientState(GL_VERTEX_ARRAY));
+	Call(glVertexPointer(3, GL_FLOAT, 0, &mVerts[0]));
+	if (!mNorms.empty()) {
+		Call(glEnableClientState(GL_NORMAL_ARRAY));
+		Call(glNormalPointer(GL_FLOAT, 0, &mNorms[0]));
+	}
+}
+void CGLAMesh::DrawBound() const {
+	glDrawElements(mMode, (GLsizei) mIndex.size(), GL_UNSIGNED_INT, &mIndex[0]);
+}
+void CGLAMesh::Unbind() {
+	Call(glDisableClientState(GL_NORMAL_ARRAY));
+	Call(glDisableClientState(GL_VERTEX_ARRAY));
+}
+void CGLAMesh::Draw() const {
+	Bind();
+	Call(DrawBound());
+	Unbind();
+}
+//
+//	Shared meshes are built the first time that they are asked for.
+//	Spheres use as many stacks as slices, like the old gluSphere calls.
+//
+const CGLAMesh* CGLAMesh::Sphere(int slices) {
+	if (slices < 3) slices = 3;
+	std::map<int, CGLAMesh*>::iterator it = gSpheres.find(slices);
+	if (it != gSpheres.end()) {
+		return it->second;
+	}
+	CGLAMesh* m = new CGLAMesh(GL_TRIANGLES);
+	m->BuildSphere(slices, slices);
+	gSpheres[slices] = m;
+	return m;
+}
+const CGLAMesh* CGLAMesh::Cylinder(int slices) {
+	if (slices < 3) slices = 3;
+	std::map<int, CGLAMesh*>::iterator it = gCylinders.find(slices);
+	if (it != gCylinders.end()) {
+		return it->second;
+	}
+	CGLAMesh* m = new CGLAMesh(GL_LINES);
+	m->BuildCylinder(slices, slices);
+	gCylinders[slices] = m;
+	return m;
+}
+int CGLAMesh::LODSlices(double pixels, int maxSlices) {
+	if (pixels <= 0.0) {
+		return maxSlices;
+	}
+	double want = 2.0 * 3.14159265358979 * pixels / kGLALODPixels;
+	int level = 0;
+	while ((level < kGLANLOD - 1) && (kGLALODSlices[level] < want)) {
+		level++;
+	}
+	return (kGLALODSlices[level] < maxSlices) ? kGLALODSlices[level] : maxSlices;
+}
+void CGLAMesh::ReleaseMeshes() {
+	std::map<int, CGLAMesh*>::iterator it;
+	for (it = gSpheres.begin(); it != gSpheres.end(); ++it) {
+		delete it->second;
+	}
+	for (it = gCylinders.begin(); it != gCylinders.end(); ++it) {
+		delete it->second;
+	}
+	gSpheres.clear();
+	gCylinders.clear();
+}
+//
+//	BuildSphere makes a latitude/longitude sphere. The poles are
+//	repeated per slice to keep the indexing simple.
+//
+void CGLAMesh::BuildSphere(int slices, int stacks) {
+	const double pi = 3.14159265358979;
+	for (int j = 0; j <= stacks; j++) {
+		double phi = pi * j / stacks;
+		double z = cos(phi);
+		double r = sin(phi);
+		for (int i = 0; i <= slices; i++) {
+			double theta = 2.0 * pi * i / slices;
+			GLfloat v[3] = { GLfloat(r * cos(theta)), GLfloat(r * sin(theta)),
+			                 GLfloat(z) };
+			mVerts.insert(mVerts.end(), v, v + 3);
+			mNorms.insert(mNorms.end(), v, v + 3);
+		}
+	}
+	for (int j = 0; j < stacks; j++) {
+		for (int i = 0; i < slices; i++) {
+			GLuint a = j * (slices + 1) + i;
+			GLuint b = a + slices + 1;
+			GLuint tri[6] = { a, b, a + 1, a + 1, b, b + 1 };
+			mIndex.insert(mIndex.end(), tri, tri + 6);
+		}
+	}
+}
+//
+//	BuildCylinder makes the same wire frame as gluCylinder in GLU_LINE
+//	style, a ring at each stack and a line down each slice.
+//
+void CGLAMesh::BuildCylinder(int slices, int stacks) {
+	const double pi = 3.14159265358979;
+	for (int j = 0; j <= stacks; j++) {
+		GLfloat z = GLfloat(j) / stacks;
+		for (int i = 0; i < slices; i++) {
+			double theta = 2.0 * pi * i / slices;
+			GLfloat v[3] = { GLfloat(cos(theta)), GLfloat(sin(theta)), z };
+			GLfloat n[3] = { v[0], v[1], 0.0f };
+			mVerts.insert(mVerts.end(), v, v + 3);
+			mNorms.insert(mNorms.end(), n, n + 3);
+		}
+	}
+	for (int j = 0; j <= stacks; j++) {
+		for (int i = 0; i < slices; i++) {
+			GLuint a = j * slices + i;
+			GLuint b = j * slices + (i + 1) % slices;
+			mIndex.push_back(a);
+			mIndex.push_back(b);
+			if (j < stacks) {
+				mIndex.push_back(a);
+				mIndex.push_back(a + slices);
+			}
+		}
+	}
+}
+#endif
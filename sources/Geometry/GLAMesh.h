@@ -0,0 +1,85 @@
+/*
+ *	GLAMesh.h
+ *
+ *	A CGLAMesh is a small indexed mesh held in client-side vertex
+ *	arrays. The GLA loader uses one shared unit sphere and one shared
+ *	unit cylinder for every instance in a model and places them with
+ *	the modelview matrix, so there is no per-instance tessellation
+ *	and no GLU quadric to leak.
+ *	The unit sphere has radius 1 about the origin. The unit cylinder
+ *	has radius 1 and runs from z = 0 to z = 1. It is a wire frame
+ *	because that is how the GLA cylinder has always been drawn.
+ *	Each shape comes in a handful of levels of detail. LODSlices picks
+ *	the coarsest level that still looks round at a given size on screen
+ *	so that wire grids with thousands of spheres stay cheap to spin.
+ *
+ *	BCollett 10/19/26
+ */
+#ifndef _H_GLAMesh_H
+#define _H_GLAMesh_H
+
+#include <vector>
+#include <map>
+#include "GeometricObjects.h"
+
+//
+//	Levels of detail, as numbers of slices, coarsest first. A level is
+//	good enough when each slice spans no more than kGLALODPixels of
+//	the outline on screen.
+//
+const int kGLANLOD = 5;
+const int kGLALODSlices[kGLANLOD] = { 6, 10, 16, 24, 32 };
+const double kGLALODPixels = 6.0;
+
+class CGLAMesh {
+protected:
+	//
+	//	Class variables. Shared meshes keyed on number of slices.
+	//
+	static std::map<int, CGLAMesh*> gSpheres;
+	static std::map<int, CGLAMesh*> gCylinders;
+	//
+	//	Instance variables.
+	//
+	GLenum mMode;			// GL_TRIANGLES or GL_LINES
+	std::vector<GLfloat> mVerts;
+	std::vector<GLfloat> mNorms;
+	std::vector<GLuint> mIndex;
+public:
+	//
+	//	Constructor and destructor.
+	//
+	CGLAMesh(GLenum mode);
+	virtual ~CGLAMesh();
+	//
+	//	Bind sets up the arrays, DrawBound draws one copy with the
+	//	current matrix and Unbind tidies up. Draw does all three.
+	//	Drawing many instances is Bind, then DrawBound per instance.
+	//
+	void Bind() const;
+	void DrawBound() const;
+	static void Unbind();
+	void Draw() const;
+	int GetNVert() const { return (int) mVerts.size() / 3; };
+	//
+	//	Class routines to get the shared meshes and to free them.
+	//
+	static const CGLAMesh* Sphere(int slices);
+	static const CGLAMesh* Cylinder(int slices);
+	static void ReleaseMeshes();
+	//
+	//	LODSlices returns the number of slices to use for something of
+	//	radius pixels on screen. It is one of the kGLALODSlices levels
+	//	but never more than maxSlices, which is what the file asked for.
+	//	A radius of zero or less means we do not know, so use maxSlices.
+	//
+	static int LODSlices(double pixels, int maxSlices);
+protected:
+	//
+	//	Builders.
+	//
+	void BuildSphere(int slices, int stacks);
+	void BuildCylinder(int slices, int stacks);
+};
+
+#endif // _H_GLAMesh_H
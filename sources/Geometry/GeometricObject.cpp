@@ -140,6 +140,18 @@ long GeometryObject::AddFlags(long f) {
 	Update();
 	return mFlags;
 }
+/*
+ *	DrawCulled works out our bounds and draws only if they are at least
+ *	partly in the frustum. Objects that do not know their bounds are
+ *	always drawn.
+ */
+void GeometryObject::DrawCulled(const Frustum& f) {
+	Frame3D bounds;
+	AddToBounds(&bounds);
+	if (bounds.IsEmpty() || f.Visible(bounds)) {
+		Draw();
+	}
+}
 /*
  *	RunMaterial is a helper for the Update routines. It outputs
  *	the material properties in OpenGL form.
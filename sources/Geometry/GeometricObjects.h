@@ -247,6 +247,12 @@ public:
 	//
 	virtual void Draw() { mList.CallList(); };
 	//
+	//	DrawCulled draws only if some part of us might be on screen.
+	//	The default asks AddToBounds for a box each time; objects that
+	//	contain many others should keep their bounds and override.
+	//
+	virtual void DrawCulled(const Frustum& f);
+	//
 	//	It can call on this helper to incorporate the material
 	//	property info.
 	//
@@ -301,6 +307,7 @@ protected:
 	int mNumElem;		// Number of geometry objects in group
 	int mNumSlots;		// Number of slots for objects
 	GeometryObject** mElems;	// Array of pointers to objects
+	Frame3D mBounds;	// Everything in the group, kept by Update
 public:
 	//
 	//	Constructor/Destructor
@@ -320,6 +327,11 @@ public:
 	//
 #ifdef UseOpenGL
 	virtual void Update();
+	//
+	//	Cull the whole group on its bounds. A group that is partly on
+	//	screen passes the test on down to its members.
+	//
+	virtual void DrawCulled(const Frustum& f);
 #else
 	virtual void Update() {};
 #endif
@@ -307,6 +307,12 @@ public:
   //  runing from 0->Width in one direction and 0->height in the other.
   //
   Point3D Map2D(double x, double y);
+  //
+  //  Intersect the line start + t * (end - start) with the rect. Returns
+  //  true and sets t if the line crosses the plane inside the rect.
+  //
+  bool IntersectLine(const Point3D& start, const Point3D& end,
+                     double* t) const;
 protected:
   //
   //  Internal helpers.
@@ -448,6 +454,54 @@ protected:
 	//	Internal Helpers.
 	//
 };
+/*
+ *  A Frustum is the region of space that a camera can see, held as six
+ *  planes with their normals pointing inward. It is built from the
+ *  modelview and projection matrices in OpenGL (column major) order and
+ *  used to skip drawing things that are entirely off screen.
+ *  Classify returns kFrustumOutside, kFrustumInside, or kFrustumPartial
+ *  so that a caller walking a tree of bounds can stop testing the
+ *  children of anything that is entirely inside. Depth gives how far a
+ *  point is in front of the camera, for sizing things on screen.
+ */
+enum FrustumTest {
+  kFrustumOutside = 0,
+  kFrustumPartial,
+  kFrustumInside
+};
 
-#endif
+class Frustum {
+protected:
+  //
+  //  Each plane is a, b, c, d with ax + by + cz + d >= 0 inside.
+  //
+  double mPlanes[6][4];
+  double mDepth[4];       // row of the modelview matrix giving -z eye
+  bool mValid;
+public:
+  //
+  //  An unset Frustum is infinite and everything is inside it.
+  //
+  Frustum();
+  Frustum(const double mv[16], const double proj[16]);
+  void Set(const double mv[16], const double proj[16]);
+  bool IsValid(void) const { return mValid; };
+  //
+  //  Tests. Boxes are min xyz then max xyz.
+  //
+  FrustumTest ClassifyBox(const double box[6]) const;
+  FrustumTest Classify(const Frame3D& f) const;
+  FrustumTest ClassifySphere(const double c[3], double radius) const;
+  bool Visible(const Frame3D& f) const
+    { return Classify(f) != kFrustumOutside; };
+  bool Visible(const Rect3D& r) const;
+  //
+  //  Distance of p in front of the camera along its axis, 0 for an
+  //  unset Frustum.
+  //
+  double Depth(const double p[3]) const
+    { return mValid ? mDepth[0] * p[0] + mDepth[1] * p[1] +
+                      mDepth[2] * p[2] + mDepth[3] : 0.0; };
+};
 
+#endif
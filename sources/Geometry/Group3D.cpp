@@ -81,6 +81,8 @@ bool Group3D::WriteToFile(FILE* ofp) {
 //	Recursively work through the list.
 //
 void Group3D::Update() {
+	mBounds.Clear();
+	AddToBounds(&mBounds);
 	if (mNumElem > 0) {
 		mList.Start();
 		RunMaterial();
@@ -92,6 +94,28 @@ void Group3D::Update() {
 		mList.End();
 	}
 }
+//
+//	If the whole group is on screen then the display list is quickest.
+//	If only part of it is then each member gets a chance to drop out.
+//
+void Group3D::DrawCulled(const Frustum& f) {
+	if (mNumElem <= 0) {
+		return;
+	}
+	switch (f.Classify(mBounds)) {
+		case kFrustumOutside:
+			break;
+		case kFrustumInside:
+			Draw();
+			break;
+		case kFrustumPartial:
+			RunMaterial();
+			for (int i = 0; i < mNumElem; ++i) {
+				mElems[i]->DrawCulled(f);
+			}
+			break;
+	}
+}
 #endif
 //
 //  AddToBounds sends in a bounding box and expects us to
@@ -0,0 +1,502 @@
+/*
+ *  Picker.cpp
+ *  FieldViewer
+ *
+ *  A CPicker answers the question "what lies under the mouse" without
+ *  going near OpenGL. Pickable primitives are kept in a bounding volume
+ *  hierarchy and a pick line is tested against the whole lot.
+ *
+ *  Created by Brian Collett on 10/19/26.
+ *  Copyright (c) 2026 Brian Collett. All rights reserved.
+ *
+ */
+#include <math.h>
+#include <float.h>
+#include <algorithm>
+#include <thread>
+#include "Picker.h"
+#include "GLACache.h"
+//
+//  Most primitives we can put in a leaf.
+//
+static const int kPickLeafSize = 4;
+//
+//  Subtrees with fewer primitives than this are not worth a thread.
+//
+static const int kPickThreadPrims = 16384;
+//
+//  Deepest tree that Pick's stack can walk. Median splits of an int
+//  count of primitives never get near it; only a damaged cache could.
+//
+static const int kPickMaxDepth = 62;
+//
+//  ctors
+//
+CPicker::CPicker()
+{
+  mBuilt = false;
+}
+CPicker::~CPicker()
+{
+}
+void CPicker::Clear(void)
+{
+  mPrims.clear();
+  mOrder.clear();
+  mNodes.clear();
+  mBuilt = false;
+}
+//
+//  Adders. Each works out the bounding box of its primitive.
+//
+void CPicker::AddRect(const Rect3D* r, int id)
+{
+  if ((nullptr == r) || !r->IsValid()) {
+    return;
+  }
+  Prim p;
+  p.mKind = kPickRect;
+  p.mID = id;
+  p.mRect = r;
+  const Point3D* c[4] = { &r->TopLeft(), &r->TopRight(),
+                          &r->BottomRight(), &r->BottomLeft() };
+  for (int i = 0; i < 3; i++) {
+    p.mBox[i] = p.mBox[i + 3] = c[0]->mCoords[i];
+    for (int k = 1; k < 4; k++) {
+      p.mBox[i] = fmin(p.mBox[i], c[k]->mCoords[i]);
+      p.mBox[i + 3] = fmax(p.mBox[i + 3], c[k]->mCoords[i]);
+    }
+  }
+  AddPrim(p);
+}
+void CPicker::AddTriangle(const double* v, int id)
+{
+  Prim p;
+  p.mKind = kPickTriangle;
+  p.mID = id;
+  p.mRect = nullptr;
+  for (int i = 0; i < 9; i++) {
+    p.mData[i] = v[i];
+  }
+  for (int i = 0; i < 3; i++) {
+    p.mBox[i] = fmin(v[i], fmin(v[i + 3], v[i + 6]));
+    p.mBox[i + 3] = fmax(v[i], fmax(v[i + 3], v[i + 6]));
+  }
+  AddPrim(p);
+}
+void CPicker::AddSphere(const double* c, double radius, int id)
+{
+  Prim p;
+  p.mKind = kPickSphere;
+  p.mID = id;
+  p.mRect = nullptr;
+  for (int i = 0; i < 3; i++) {
+    p.mData[i] = c[i];
+    p.mBox[i] = c[i] - radius;
+    p.mBox[i + 3] = c[i] + radius;
+  }
+  p.mData[3] = radius;
+  AddPrim(p);
+}
+void CPicker::AddCylinder(double x, double y, double zMin, double zMax,
+                          double radius, int id)
+{
+  Prim p;
+  p.mKind = kPickCylinder;
+  p.mID = id;
+  p.mRect = nullptr;
+  if (zMax < zMin) {
+    double t = zMin;
+    zMin = zMax;
+    zMax = t;
+  }
+  p.mData[0] = x;
+  p.mData[1] = y;
+  p.mData[2] = zMin;
+  p.mData[3] = zMax;
+  p.mData[4] = radius;
+  p.mBox[0] = x - radius;
+  p.mBox[1] = y - radius;
+  p.mBox[2] = zMin;
+  p.mBox[3] = x + radius;
+  p.mBox[4] = y + radius;
+  p.mBox[5] = zMax;
+  AddPrim(p);
+}
+void CPicker::AddPrim(const Prim& p)
+{
+  mPrims.push_back(p);
+  mBuilt = false;
+}
+void CPicker::Append(const CPicker& other)
+{
+  mPrims.insert(mPrims.end(), other.mPrims.begin(), other.mPrims.end());
+  mBuilt = false;
+}
+//
+//  Build the tree top down, splitting each node at the median centre
+//  along its longest side.
+//
+void CPicker::Build(int nThreads)
+{
+  int n = (int) mPrims.size();
+  mOrder.resize(n);
+  for (int i = 0; i < n; i++) {
+    mOrder[i] = i;
+  }
+  mNodes.clear();
+  if (n > 0) {
+    mNodes.reserve(2 * (n / kPickLeafSize + 1));
+    mNodes.push_back(Node());
+    //
+    //  Split the top levels here until there is a subtree for each
+    //  thread, then build those subtrees side by side in their own node
+    //  arrays. The subtrees work on separate ranges of mOrder so they
+    //  never touch each other.
+    //
+    int levels = 0;
+    while (((1 << levels) < nThreads) && ((n >> levels) >= kPickThreadPrims)) {
+      ++levels;
+    }
+    if (levels == 0) {
+      BuildNode(mNodes, 0, 0, n);
+    } else {
+      std::vector<Task> tasks;
+      BuildTop(0, 0, n, levels, tasks);
+      std::vector<std::thread> threads;
+      for (size_t t = 0; t < tasks.size(); t++) {
+        Task* task = &tasks[t];
+        threads.push_back(std::thread([this, task]() {
+          task->mNodes.push_back(Node());
+          BuildNode(task->mNodes, 0, task->mFirst, task->mCount);
+        }));
+      }
+      for (size_t t = 0; t < threads.size(); t++) {
+        threads[t].join();
+      }
+      //
+      //  Stitch each subtree in. Its root replaces the node that was
+      //  left for it and the rest go on the end, so every child index
+      //  other than the root's moves along by the same amount.
+      //
+      for (size_t t = 0; t < tasks.size(); t++) {
+        std::vector<Node>& sub = tasks[t].mNodes;
+        int shift = (int) mNodes.size() - 1;
+        for (size_t i = 0; i < sub.size(); i++) {
+          if (sub[i].mCount == 0) {
+            sub[i].mFirst += shift;
+          }
+        }
+        mNodes[tasks[t].mNode] = sub[0];
+        mNodes.insert(mNodes.end(), sub.begin() + 1, sub.end());
+      }
+    }
+  }
+  mBuilt = true;
+}
+//
+//  SplitNode sets the box of a node. If the node is small enough it
+//  becomes a leaf and we return 0, otherwise its primitives are split
+//  at the median and we return the size of the first half.
+//
+int CPicker::SplitNode(std::vector<Node>& nodes, int node, int first,
+                       int count)
+{
+  double box[6] = { DBL_MAX, DBL_MAX, DBL_MAX, -DBL_MAX, -DBL_MAX, -DBL_MAX };
+  for (int i = first; i < first + count; i++) {
+    const double* pb = mPrims[mOrder[i]].mBox;
+    for (int k = 0; k < 3; k++) {
+      box[k] = fmin(box[k], pb[k]);
+      box[k + 3] = fmax(box[k + 3], pb[k + 3]);
+    }
+  }
+  for (int k = 0; k < 6; k++) {
+    nodes[node].mBox[k] = box[k];
+  }
+  if (count <= kPickLeafSize) {
+    nodes[node].mFirst = first;
+    nodes[node].mCount = count;
+    return 0;
+  }
+  int axis = 0;
+  for (int k = 1; k < 3; k++) {
+    if (box[k + 3] - box[k] > box[axis + 3] - box[axis]) {
+      axis = k;
+    }
+  }
+  int half = count / 2;
+  std::nth_element(mOrder.begin() + first, mOrder.begin() + first + half,
+                   mOrder.begin() + first + count,
+                   [this, axis](int a, int b) {
+                     const double* ba = mPrims[a].mBox;
+                     const double* bb = mPrims[b].mBox;
+                     return ba[axis] + ba[axis + 3] < bb[axis] + bb[axis + 3];
+                   });
+  return half;
+}
+void CPicker::BuildNode(std::vector<Node>& nodes, int node, int first,
+                        int count)
+{
+  int half = SplitNode(nodes, node, first, count);
+  if (half == 0) {
+    return;
+  }
+  //
+  //  Children go in adjacent slots. Note that push_back can move the
+  //  nodes so we only ever use indices here.
+  //
+  int child = (int) nodes.size();
+  nodes.push_back(Node());
+  nodes.push_back(Node());
+  nodes[node].mFirst = child;
+  nodes[node].mCount = 0;
+  BuildNode(nodes, child, first, half);
+  BuildNode(nodes, child + 1, first + half, count - half);
+}
+//
+//  BuildTop does the top levels of the tree and leaves a task for
+//  each node at the bottom of them.
+//
+void CPicker::BuildTop(int node, int first, int count, int levels,
+                       std::vector<Task>& tasks)
+{
+  if (levels == 0) {
+    Task task;
+    task.mNode = node;
+    task.mFirst = first;
+    task.mCount = count;
+    tasks.push_back(task);
+    return;
+  }
+  int half = SplitNode(mNodes, node, first, count);
+  if (half == 0) {
+    return;
+  }
+  int child = (int) mNodes.size();
+  mNodes.push_back(Node());
+  mNodes.push_back(Node());
+  mNodes[node].mFirst = child;
+  mNodes[node].mCount = 0;
+  BuildTop(child, first, half, levels - 1, tasks);
+  BuildTop(child + 1, first + half, count - half, levels - 1, tasks);
+}
+//
+//  Pick walks the tree with an explicit stack and tests every primitive
+//  in each leaf whose box the line crosses.
+//
+int CPicker::Pick(const Point3D& start, const Point3D& end,
+                  std::vector<PickHit>& hits) const
+{
+  if (!mBuilt || mNodes.empty()) {
+    return 0;
+  }
+  double o[3], d[3];
+  for (int i = 0; i < 3; i++) {
+    o[i] = start.mCoords[i];
+    d[i] = end.mCoords[i] - start.mCoords[i];
+  }
+  size_t firstHit = hits.size();
+  int stack[kPickMaxDepth + 2];
+  int sp = 0;
+  stack[sp++] = 0;
+  while (sp > 0) {
+    const Node& n = mNodes[stack[--sp]];
+    if (!LineHitsBox(n.mBox, o, d)) {
+      continue;
+    }
+    if (n.mCount == 0) {
+      stack[sp++] = n.mFirst;
+      stack[sp++] = n.mFirst + 1;
+      continue;
+    }
+    for (int i = n.mFirst; i < n.mFirst + n.mCount; i++) {
+      const Prim& p = mPrims[mOrder[i]];
+      double t;
+      if (HitPrim(p, o, d, &t)) {
+        PickHit h;
+        h.mT = t;
+        h.mPoint.Set(o[0] + t * d[0], o[1] + t * d[1], o[2] + t * d[2]);
+        h.mKind = p.mKind;
+        h.mID = p.mID;
+        hits.push_back(h);
+      }
+    }
+  }
+  std::sort(hits.begin() + firstHit, hits.end(),
+            [](const PickHit& a, const PickHit& b) { return a.mT < b.mT; });
+  return (int) (hits.size() - firstHit);
+}
+//
+//  Slab test of the segment o + t d, 0 <= t <= 1, against a box.
+//
+bool CPicker::LineHitsBox(const double* box, const double* o, const double* d)
+{
+  double tMin = 0.0, tMax = 1.0;
+  for (int i = 0; i < 3; i++) {
+    if (d[i] == 0.0) {
+      if ((o[i] < box[i]) || (o[i] > box[i + 3])) {
+        return false;
+      }
+      continue;
+    }
+    double inv = 1.0 / d[i];
+    double t0 = (box[i] - o[i]) * inv;
+    double t1 = (box[i + 3] - o[i]) * inv;
+    if (t0 > t1) {
+      double t = t0;
+      t0 = t1;
+      t1 = t;
+    }
+    if (t0 > tMin) tMin = t0;
+    if (t1 < tMax) tMax = t1;
+    if (tMin > tMax) {
+      return false;
+    }
+  }
+  return true;
+}
+//
+//  Exact tests. Each returns the nearest crossing in 0 <= t <= 1.
+//
+bool CPicker::HitPrim(const Prim& p, const double* o, const double* d,
+                      double* t) const
+{
+  switch (p.mKind) {
+    case kPickRect: {
+      Point3D s(o[0], o[1], o[2]);
+      Point3D e(o[0] + d[0], o[1] + d[1], o[2] + d[2]);
+      return p.mRect->IntersectLine(s, e, t) && (*t >= 0.0) && (*t <= 1.0);
+    }
+    case kPickTriangle: {
+      //
+      //  Moller-Trumbore.
+      //
+      const double* v = p.mData;
+      double e1[3], e2[3], s[3];
+      for (int i = 0; i < 3; i++) {
+        e1[i] = v[i + 3] - v[i];
+        e2[i] = v[i + 6] - v[i];
+        s[i] = o[i] - v[i];
+      }
+      double h[3] = { d[1] * e2[2] - d[2] * e2[1],
+                      d[2] * e2[0] - d[0] * e2[2],
+                      d[0] * e2[1] - d[1] * e2[0] };
+      double a = e1[0] * h[0] + e1[1] * h[1] + e1[2] * h[2];
+      if (fabs(a) < 1e-300) {
+        return false;
+      }
+      double f = 1.0 / a;
+      double u = f * (s[0] * h[0] + s[1] * h[1] + s[2] * h[2]);
+      if ((u < 0.0) || (u > 1.0)) {
+        return false;
+      }
+      double q[3] = { s[1] * e1[2] - s[2] * e1[1],
+                      s[2] * e1[0] - s[0] * e1[2],
+                      s[0] * e1[1] - s[1] * e1[0] };
+      double w = f * (d[0] * q[0] + d[1] * q[1] + d[2] * q[2]);
+      if ((w < 0.0) || (u + w > 1.0)) {
+        return false;
+      }
+      *t = f * (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]);
+      return (*t >= 0.0) && (*t <= 1.0);
+    }
+    case kPickSphere: {
+      double m[3] = { o[0] - p.mData[0], o[1] - p.mData[1], o[2] - p.mData[2] };
+      double a = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+      double b = m[0] * d[0] + m[1] * d[1] + m[2] * d[2];
+      double c = m[0] * m[0] + m[1] * m[1] + m[2] * m[2] -
+                 p.mData[3] * p.mData[3];
+      double disc = b * b - a * c;
+      if ((disc < 0.0) || (a == 0.0)) {
+        return false;
+      }
+      double root = sqrt(disc);
+      double t0 = (-b - root) / a;
+      double t1 = (-b + root) / a;
+      *t = (t0 >= 0.0) ? t0 : t1;
+      return (*t >= 0.0) && (*t <= 1.0);
+    }
+    case kPickCylinder: {
+      //
+      //  Open cylinder, just like gluCylinder draws.
+      //
+      double m[2] = { o[0] - p.mData[0], o[1] - p.mData[1] };
+      double a = d[0] * d[0] + d[1] * d[1];
+      double b = m[0] * d[0] + m[1] * d[1];
+      double c = m[0] * m[0] + m[1] * m[1] - p.mData[4] * p.mData[4];
+      double disc = b * b - a * c;
+      if ((disc < 0.0) || (a == 0.0)) {
+        return false;
+      }
+      double root = sqrt(disc);
+      double ts[2] = { (-b - root) / a, (-b + root) / a };
+      for (int i = 0; i < 2; i++) {
+        double z = o[2] + ts[i] * d[2];
+        if ((ts[i] >= 0.0) && (ts[i] <= 1.0) &&
+            (z >= p.mData[2]) && (z <= p.mData[3])) {
+          *t = ts[i];
+          return true;
+        }
+      }
+      return false;
+    }
+  }
+  return false;
+}
+//
+//  Cache support. The prims, order and nodes go out as they are, so a
+//  read picker needs no Build.
+//
+bool CPicker::Write(FILE* fp) const
+{
+  for (size_t i = 0; i < mPrims.size(); i++) {
+    if (nullptr != mPrims[i].mRect) {
+      return false;
+    }
+  }
+  uint32_t sizes[2] = { (uint32_t) sizeof(Prim), (uint32_t) sizeof(Node) };
+  return mBuilt && (fwrite(sizes, sizeof(sizes), 1, fp) == 1) &&
+         GLACacheWrite(fp, mPrims) && GLACacheWrite(fp, mOrder) &&
+         GLACacheWrite(fp, mNodes);
+}
+bool CPicker::Read(FILE* fp, long end)
+{
+  uint32_t sizes[2];
+  bool ok = (fread(sizes, sizeof(sizes), 1, fp) == 1) &&
+            (sizes[0] == sizeof(Prim)) && (sizes[1] == sizeof(Node)) &&
+            GLACacheRead(fp, end, mPrims) && GLACacheRead(fp, end, mOrder) &&
+            GLACacheRead(fp, end, mNodes) &&
+            (mOrder.size() == mPrims.size()) &&
+            (mNodes.empty() == mPrims.empty());
+  //
+  //  Make sure that a damaged file cannot send Pick out of bounds.
+  //
+  //  Children always come after their parent, so a node's depth is
+  //  settled by the time we reach it and we can pass it on down.
+  //
+  int nPrim = (int) mPrims.size();
+  int nNode = (int) mNodes.size();
+  for (int i = 0; ok && (i < nPrim); i++) {
+    mPrims[i].mRect = nullptr;
+    ok = (mOrder[i] >= 0) && (mOrder[i] < nPrim);
+  }
+  std::vector<int> depth(ok ? nNode : 0, 0);
+  for (int i = 0; ok && (i < nNode); i++) {
+    const Node& n = mNodes[i];
+    ok = (n.mCount > 0) ? ((n.mFirst >= 0) && (n.mFirst <= nPrim - n.mCount))
+                        : ((n.mCount == 0) && (n.mFirst > i) &&
+                           (n.mFirst < nNode - 1) &&
+                           (depth[i] < kPickMaxDepth));
+    if (ok && (n.mCount == 0)) {
+      for (int c = n.mFirst; c <= n.mFirst + 1; c++) {
+        if (depth[c] < depth[i] + 1) depth[c] = depth[i] + 1;
+      }
+    }
+  }
+  if (!ok) {
+    Clear();
+    return false;
+  }
+  mBuilt = true;
+  return true;
+}
@@ -0,0 +1,136 @@
+/*
+ *  Picker.h
+ *  FieldViewer
+ *
+ *  A CPicker answers the question "what lies under the mouse" without
+ *  going near OpenGL. Pickable primitives (rectangles, triangles,
+ *  spheres and z-axis cylinders) are added along with an integer id,
+ *  the picker builds a bounding volume hierarchy over them and then
+ *  a line from the near to the far plane can be tested against the
+ *  lot in roughly log time.
+ *  Pick returns every primitive that the line crosses, sorted from the
+ *  near plane outward, with the exact point at which it was crossed.
+ *
+ *  This replaces the GL_SELECT picking that was slow under Mesa and
+ *  quietly lost hits once its fixed buffer filled up.
+ *
+ *  Created by Brian Collett on 10/19/26.
+ *  Copyright (c) 2026 Brian Collett. All rights reserved.
+ *
+ */
+#ifndef _Picker_H
+#define _Picker_H
+
+#include <stdio.h>
+#include <vector>
+#include "Geometry3d.h"
+
+//
+//  The kinds of thing that we can pick.
+//
+enum PickKind {
+  kPickRect = 0,
+  kPickTriangle,
+  kPickSphere,
+  kPickCylinder
+};
+//
+//  One hit. mT is the fraction of the way from start to end.
+//
+struct PickHit {
+  double mT;
+  Point3D mPoint;
+  PickKind mKind;
+  int mID;
+};
+
+class CPicker {
+protected:
+  //
+  //  A primitive keeps its own bounding box (min xyz then max xyz) and
+  //  enough numbers to describe it. Rects are not copied; the caller
+  //  must rebuild the picker if a rect goes away.
+  //
+  struct Prim {
+    PickKind mKind;
+    int mID;
+    double mBox[6];
+    double mData[9];
+    const Rect3D* mRect;
+  };
+  //
+  //  Flat array of BVH nodes. A leaf has mCount > 0 and covers
+  //  mOrder[mFirst..mFirst+mCount). An interior node's children are
+  //  at mFirst and mFirst + 1.
+  //
+  struct Node {
+    double mBox[6];
+    int mFirst;
+    int mCount;
+  };
+  std::vector<Prim> mPrims;
+  std::vector<int> mOrder;
+  std::vector<Node> mNodes;
+  bool mBuilt;
+public:
+  //
+  //  ctors
+  //
+  CPicker();
+  virtual ~CPicker();
+  //
+  //  Adding primitives invalidates the tree until Build is called.
+  //
+  void Clear(void);
+  void AddRect(const Rect3D* r, int id);
+  void AddTriangle(const double* v, int id);   // v holds 9 coords
+  void AddSphere(const double* c, double radius, int id);
+  void AddCylinder(double x, double y, double zMin, double zMax,
+                   double radius, int id);
+  //
+  //  Append moves another picker's primitives onto the end of ours.
+  //  Build can build the subtrees near the bottom on up to nThreads
+  //  threads; the tree it makes answers every pick just as one built
+  //  on one thread would.
+  //
+  void Append(const CPicker& other);
+  void Build(int nThreads = 1);
+  int GetNPrim(void) const { return (int) mPrims.size(); };
+  //
+  //  Append hits along start->end to hits, sorted by distance. Returns
+  //  the number of hits added.
+  //
+  int Pick(const Point3D& start, const Point3D& end,
+           std::vector<PickHit>& hits) const;
+  //
+  //  Write the built tree to a GLACache file and read it back. A picker
+  //  with rects cannot be written since it does not own them. Read
+  //  leaves the picker empty if it fails.
+  //
+  bool Write(FILE* fp) const;
+  bool Read(FILE* fp, long end);
+protected:
+  //
+  //  Helpers.
+  //
+  void AddPrim(const Prim& p);
+  //
+  //  A piece of the tree left for a thread to build.
+  //
+  struct Task {
+    int mNode;
+    int mFirst;
+    int mCount;
+    std::vector<Node> mNodes;
+  };
+  int SplitNode(std::vector<Node>& nodes, int node, int first, int count);
+  void BuildNode(std::vector<Node>& nodes, int node, int first, int count);
+  void BuildTop(int node, int first, int count, int levels,
+                std::vector<Task>& tasks);
+  static bool LineHitsBox(const double* box, const double* o,
+                          const double* d);
+  bool HitPrim(const Prim& p, const double* o, const double* d,
+               double* t) const;
+};
+
+#endif // _Picker_H
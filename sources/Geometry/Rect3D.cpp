@@ -96,6 +96,52 @@ Point3D Rect3D::Map2D(double x, double y)
   Point3D p = mCorners[3] + mHoriz * (x / mHoriz.Length());
   return p + mVert * (y / mVert.Length());
 }
+//
+//  Line intersection. This is done with raw doubles because it is used
+//  for every mouse move and the Vector3D operators are not cheap.
+//
+bool Rect3D::IntersectLine(const Point3D& start, const Point3D& end,
+                           double* t) const
+{
+  if (!mValid) {
+    return false;
+  }
+  const Real* o = mCorners[3].mCoords;
+  const Real* h = mHoriz.mCoords;
+  const Real* v = mVert.mCoords;
+  double n[3] = { h[1] * v[2] - h[2] * v[1],
+                  h[2] * v[0] - h[0] * v[2],
+                  h[0] * v[1] - h[1] * v[0] };
+  double d[3], w[3];
+  for (int i = 0; i < 3; i++) {
+    d[i] = end.mCoords[i] - start.mCoords[i];
+    w[i] = o[i] - start.mCoords[i];
+  }
+  double denom = d[0] * n[0] + d[1] * n[1] + d[2] * n[2];
+  double nn = n[0] * n[0] + n[1] * n[1] + n[2] * n[2];
+  double dd = d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+  if (denom * denom < 1e-12 * nn * dd) {
+    return false;     // Line (nearly) parallel to the plane.
+  }
+  double lambda = (w[0] * n[0] + w[1] * n[1] + w[2] * n[2]) / denom;
+  //
+  //  Project the hit point relative to the bottom left corner onto the
+  //  two sides.
+  //
+  double hu = 0.0, vu = 0.0, hh = 0.0, vv = 0.0;
+  for (int i = 0; i < 3; i++) {
+    double r = lambda * d[i] - w[i];
+    hu += r * h[i];
+    vu += r * v[i];
+    hh += h[i] * h[i];
+    vv += v[i] * v[i];
+  }
+  if ((hu < 0.0) || (hu > hh) || (vu < 0.0) || (vu > vv)) {
+    return false;
+  }
+  *t = lambda;
+  return true;
+}
 
 //
 //  Internal helpers.
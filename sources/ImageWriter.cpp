@@ -0,0 +1,288 @@
+//
+//  ImageWriter.cpp
+//  FieldViewer
+//
+//  An ImageWriter writes an 8 bit RGB image to a file a row at a time.
+//  See ImageWriter.h.
+//
+//  Created by Brian Collett on 10/19/26.
+//  Copyright (c) 2026 Brian Collett. All rights reserved.
+//
+#include <string.h>
+#include <strings.h>
+#include <limits.h>
+#include "ImageWriter.h"
+//
+//  ctors
+//
+ImageWriter::ImageWriter()
+{
+  mFile = nullptr;
+  mFormat = kImagePNG;
+  mWidth = mHeight = mRow = 0;
+  mOK = false;
+  memset(&mStream, 0, sizeof(mStream));
+}
+ImageWriter::~ImageWriter()
+{
+  if (nullptr != mFile) {
+    Close();
+  }
+}
+bool ImageWriter::Fits(int width, int height, ImageFormat format)
+{
+  if ((width <= 0) || (height <= 0) || (width > INT_MAX / 3)) {
+    return false;
+  }
+  if (format == kImageTIFF) {
+    double bytes = 3.0 * width * height;
+    return bytes <= 4294967295.0 - 1024.0;
+  }
+  return true;
+}
+//
+//  Open writes everything up to the first row.
+//
+bool ImageWriter::Open(const char* path, int width, int height,
+                       ImageFormat format)
+{
+  if (!Fits(width, height, format)) {
+    return false;
+  }
+  mFile = fopen(path, "wb");
+  if (nullptr == mFile) {
+    return false;
+  }
+  mFormat = format;
+  mWidth = width;
+  mHeight = height;
+  mRow = 0;
+  mOK = true;
+  if (mFormat == kImagePPM) {
+    fprintf(mFile, "P6\n%d %d\n255\n", mWidth, mHeight);
+    return true;
+  }
+  if (mFormat == kImageTIFF) {
+    return WriteTIFFHeader();
+  }
+  static const unsigned char sig[8] = { 137, 'P', 'N', 'G', 13, 10, 26, 10 };
+  fwrite(sig, 1, 8, mFile);
+  //
+  //  IHDR: size, 8 bits per channel, truecolour, no interlace.
+  //
+  unsigned char ihdr[13] = {
+    (unsigned char) (width >> 24), (unsigned char) (width >> 16),
+    (unsigned char) (width >> 8), (unsigned char) width,
+    (unsigned char) (height >> 24), (unsigned char) (height >> 16),
+    (unsigned char) (height >> 8), (unsigned char) height,
+    8, 2, 0, 0, 0
+  };
+  WriteChunk("IHDR", ihdr, 13);
+  memset(&mStream, 0, sizeof(mStream));
+  if (deflateInit(&mStream, Z_DEFAULT_COMPRESSION) != Z_OK) {
+    mOK = false;
+  }
+  mOut.resize(kIWChunk);
+  mStream.next_out = &mOut[0];
+  mStream.avail_out = kIWChunk;
+  return mOK;
+}
+//
+//  Each PNG row starts with its filter type. We use none; the fields
+//  are smooth enough that deflate does well without help.
+//
+bool ImageWriter::WriteRow(const unsigned char* rgb)
+{
+  if ((nullptr == mFile) || !mOK || (mRow >= mHeight)) {
+    return false;
+  }
+  mRow++;
+  if (mFormat != kImagePNG) {
+    if (fwrite(rgb, 3, mWidth, mFile) != (size_t) mWidth) {
+      mOK = false;
+    }
+    return mOK;
+  }
+  unsigned char filter = 0;
+  mStream.next_in = &filter;
+  mStream.avail_in = 1;
+  if (!Deflate(Z_NO_FLUSH)) {
+    return false;
+  }
+  mStream.next_in = (Bytef*) rgb;
+  mStream.avail_in = 3 * mWidth;
+  return Deflate(Z_NO_FLUSH);
+}
+bool ImageWriter::Close(void)
+{
+  if (nullptr == mFile) {
+    return false;
+  }
+  if (mFormat == kImagePNG) {
+    if (mOK) {
+      mStream.next_in = nullptr;
+      mStream.avail_in = 0;
+      Deflate(Z_FINISH);
+      WriteChunk("IEND", nullptr, 0);
+    }
+    deflateEnd(&mStream);
+  }
+  if (mRow != mHeight) {
+    mOK = false;
+  }
+  if (fclose(mFile) != 0) {
+    mOK = false;
+  }
+  mFile = nullptr;
+  return mOK;
+}
+//
+//  TIFF header and directory, little-endian. The tags must go in
+//  numerical order. BitsPerSample and the resolutions do not fit in
+//  their entries so they follow the directory, then the one strip.
+//
+static void PutShort(unsigned char* p, unsigned int v)
+{
+  p[0] = (unsigned char) v;
+  p[1] = (unsigned char) (v >> 8);
+}
+static void PutLong(unsigned char* p, unsigned int v)
+{
+  PutShort(p, v & 0xFFFF);
+  PutShort(p + 2, v >> 16);
+}
+static void PutEntry(unsigned char* p, unsigned int tag, unsigned int type,
+                     unsigned int count, unsigned int value)
+{
+  PutShort(p, tag);
+  PutShort(p + 2, type);
+  PutLong(p + 4, count);
+  if ((type == 3) && (count == 1)) {
+    PutShort(p + 8, value);     // SHORTs sit at the front of the field
+    PutShort(p + 10, 0);
+  } else {
+    PutLong(p + 8, value);
+  }
+}
+bool ImageWriter::WriteTIFFHeader(void)
+{
+  double bytes = 3.0 * mWidth * mHeight;     // Fits keeps it under 4GB
+  const unsigned int kShort = 3, kLong = 4, kRational = 5;
+  const int nEntry = 13;
+  const unsigned int ifd = 8;
+  const unsigned int bps = ifd + 2 + 12 * nEntry + 4;
+  const unsigned int xRes = bps + 6;
+  const unsigned int yRes = xRes + 8;
+  const unsigned int strip = yRes + 8;
+  unsigned char head[strip];
+  memset(head, 0, strip);
+  head[0] = head[1] = 'I';
+  PutShort(head + 2, 42);
+  PutLong(head + 4, ifd);
+  PutShort(head + ifd, nEntry);
+  unsigned char* e = head + ifd + 2;
+  PutEntry(e, 256, kLong, 1, mWidth);           e += 12; // ImageWidth
+  PutEntry(e, 257, kLong, 1, mHeight);          e += 12; // ImageLength
+  PutEntry(e, 258, kShort, 3, bps);             e += 12; // BitsPerSample
+  PutEntry(e, 259, kShort, 1, 1);               e += 12; // no compression
+  PutEntry(e, 262, kShort, 1, 2);               e += 12; // RGB
+  PutEntry(e, 273, kLong, 1, strip);            e += 12; // StripOffsets
+  PutEntry(e, 277, kShort, 1, 3);               e += 12; // SamplesPerPixel
+  PutEntry(e, 278, kLong, 1, mHeight);          e += 12; // RowsPerStrip
+  PutEntry(e, 279, kLong, 1, (unsigned int) bytes); e += 12; // StripByteCounts
+  PutEntry(e, 282, kRational, 1, xRes);         e += 12; // XResolution
+  PutEntry(e, 283, kRational, 1, yRes);         e += 12; // YResolution
+  PutEntry(e, 284, kShort, 1, 1);               e += 12; // chunky pixels
+  PutEntry(e, 296, kShort, 1, 2);               e += 12; // inches
+  PutLong(e, 0);                                         // no next IFD
+  for (int k = 0; k < 3; k++) {
+    PutShort(head + bps + 2 * k, 8);
+  }
+  PutLong(head + xRes, 72);
+  PutLong(head + xRes + 4, 1);
+  PutLong(head + yRes, 72);
+  PutLong(head + yRes + 4, 1);
+  if (fwrite(head, 1, strip, mFile) != strip) {
+    mOK = false;
+  }
+  return mOK;
+}
+//
+//  Deflate whatever is waiting and send out full buffers as IDAT
+//  chunks. Z_FINISH also sends the last partial buffer.
+//
+bool ImageWriter::Deflate(int flush)
+{
+  for (;;) {
+    int err = deflate(&mStream, flush);
+    if ((err != Z_OK) && (err != Z_STREAM_END) && (err != Z_BUF_ERROR)) {
+      mOK = false;
+      return false;
+    }
+    bool full = (mStream.avail_out == 0);
+    if (full || ((flush == Z_FINISH) && (mStream.avail_out < (uInt) kIWChunk))) {
+      WriteChunk("IDAT", &mOut[0], kIWChunk - mStream.avail_out);
+      mStream.next_out = &mOut[0];
+      mStream.avail_out = kIWChunk;
+    }
+    if (flush == Z_FINISH) {
+      if (err == Z_STREAM_END) {
+        return mOK;
+      }
+    } else if ((mStream.avail_in == 0) && !full) {
+      return mOK;
+    }
+  }
+}
+bool ImageWriter::WriteChunk(const char* type, const unsigned char* data,
+                             unsigned int len)
+{
+  unsigned char head[8] = {
+    (unsigned char) (len >> 24), (unsigned char) (len >> 16),
+    (unsigned char) (len >> 8), (unsigned char) len,
+    (unsigned char) type[0], (unsigned char) type[1],
+    (unsigned char) type[2], (unsigned char) type[3]
+  };
+  uLong crc = crc32(0L, Z_NULL, 0);
+  crc = crc32(crc, head + 4, 4);
+  if (len > 0) {
+    crc = crc32(crc, data, len);
+  }
+  unsigned char tail[4] = {
+    (unsigned char) (crc >> 24), (unsigned char) (crc >> 16),
+    (unsigned char) (crc >> 8), (unsigned char) crc
+  };
+  if ((fwrite(head, 1, 8, mFile) != 8) ||
+      ((len > 0) && (fwrite(data, 1, len, mFile) != len)) ||
+      (fwrite(tail, 1, 4, mFile) != 4)) {
+    mOK = false;
+  }
+  return mOK;
+}
+//
+//  Whole image, bottom row first in memory.
+//
+bool ImageWriter::Write(const char* path, int width, int height,
+                        const unsigned char* rgb, ImageFormat format)
+{
+  ImageWriter w;
+  if (!w.Open(path, width, height, format)) {
+    return false;
+  }
+  for (int j = height - 1; j >= 0; j--) {
+    w.WriteRow(rgb + (size_t) 3 * width * j);
+  }
+  return w.Close();
+}
+ImageFormat ImageWriter::FormatFor(const char* path)
+{
+  size_t len = strlen(path);
+  if ((len > 4) && (strcasecmp(path + len - 4, ".ppm") == 0)) {
+    return kImagePPM;
+  }
+  if (((len > 4) && (strcasecmp(path + len - 4, ".tif") == 0)) ||
+      ((len > 5) && (strcasecmp(path + len - 5, ".tiff") == 0))) {
+    return kImageTIFF;
+  }
+  return kImagePNG;
+}
@@ -0,0 +1,98 @@
+//
+//  ImageWriter.h
+//  FieldViewer
+//
+//  An ImageWriter writes an 8 bit RGB image to a file a row at a time,
+//  top row first, so that a picture never has to be held in memory in
+//  one piece. PNG files are deflated with zlib as the rows arrive and
+//  go out in IDAT chunks of kIWChunk bytes. TIFF is uncompressed, one
+//  strip, with the directory written up front so that the rows can
+//  follow straight on. PPM is there because any tool at all can read
+//  it.
+//
+//  Nothing here knows about wx or OpenGL so both the viewer and the
+//  batch renderer can use it.
+//
+//  Created by Brian Collett on 10/19/26.
+//  Copyright (c) 2026 Brian Collett. All rights reserved.
+//
+
+#ifndef __FieldViewer__ImageWriter__
+#define __FieldViewer__ImageWriter__
+
+#include <stdio.h>
+#include <vector>
+#include <zlib.h>
+
+enum ImageFormat {
+  kImagePNG = 0,
+  kImagePPM,
+  kImageTIFF
+};
+//
+//  Size of the deflate output buffer and so of each IDAT chunk.
+//
+const int kIWChunk = 65536;
+
+class ImageWriter {
+protected:
+  //
+  //  Instance vars.
+  //
+  FILE* mFile;
+  ImageFormat mFormat;
+  int mWidth;
+  int mHeight;
+  int mRow;             // rows written so far
+  bool mOK;             // false after any write error
+  z_stream mStream;
+  std::vector<unsigned char> mOut;
+public:
+  //
+  //  ctors
+  //
+  ImageWriter();
+  virtual ~ImageWriter();
+  //
+  //  True if we can write an image this size: a row of 3 * width bytes
+  //  must fit in an int and a TIFF must be under 4GB.
+  //
+  static bool Fits(int width, int height, ImageFormat format);
+  //
+  //  Open the file and write the header. Returns false if the image
+  //  does not fit or the file cannot be opened.
+  //
+  bool Open(const char* path, int width, int height,
+            ImageFormat format = kImagePNG);
+  //
+  //  rgb holds 3 * width bytes. Rows go top first.
+  //
+  bool WriteRow(const unsigned char* rgb);
+  //
+  //  Finish off the file. Returns false if anything went wrong on the
+  //  way, including not being given every row.
+  //
+  bool Close(void);
+  //
+  //  Write a whole image in one go. Unlike the row interface the rows of
+  //  rgb run from the bottom up, which is how OpenGL and the field
+  //  samplers lay them out.
+  //
+  static bool Write(const char* path, int width, int height,
+                    const unsigned char* rgb, ImageFormat format);
+  //
+  //  kImagePPM for .ppm, kImageTIFF for .tif or .tiff, otherwise
+  //  kImagePNG.
+  //
+  static ImageFormat FormatFor(const char* path);
+protected:
+  //
+  //  Helpers.
+  //
+  bool Deflate(int flush);
+  bool WriteTIFFHeader(void);
+  bool WriteChunk(const char* type, const unsigned char* data,
+                  unsigned int len);
+};
+
+#endif /* defined(__FieldViewer__ImageWriter__) */
@@ -0,0 +1,123 @@
+//
+//  LineProbe.cpp
+//  FieldViewer
+//
+//  A LineProbe samples a field at evenly spaced points along a straight
+//  segment. All the points are handed to the field in one batched query
+//  and the results are kept so that they can be plotted or written out
+//  as a CSV file.
+//
+//  Created by Brian Collett on 10/19/26.
+//  Copyright (c) 2026 Brian Collett. All rights reserved.
+//
+#include <math.h>
+#include <stdio.h>
+#include "FieldViewerApp.h"
+#include "LineProbe.h"
+//
+//  ctors
+//
+LineProbe::LineProbe(EField* f, const Point3D& start, const Point3D& end,
+                     int nSample)
+{
+  mField = f;
+  mStart = start;
+  mEnd = end;
+  mNSample = (nSample < 2) ? 2 : nSample;
+}
+LineProbe::~LineProbe()
+{
+}
+//
+//  Build the list of points and make a single query for all of them.
+//
+bool LineProbe::Sample(void)
+{
+  mPoints.resize(3 * mNSample);
+  mFields.resize(3 * mNSample);
+  mDist.resize(mNSample);
+  mMag.resize(mNSample);
+  double d[3] = { mEnd.mX - mStart.mX, mEnd.mY - mStart.mY,
+                  mEnd.mZ - mStart.mZ };
+  double len = GetLength();
+  for (int i = 0; i < mNSample; i++) {
+    double t = double(i) / (mNSample - 1);
+    mPoints[3 * i] = mStart.mX + t * d[0];
+    mPoints[3 * i + 1] = mStart.mY + t * d[1];
+    mPoints[3 * i + 2] = mStart.mZ + t * d[2];
+    mDist[i] = t * len;
+  }
+  mField->FieldAtPoints(mNSample, &mPoints[0], &mFields[0]);
+  int nValid = 0;
+  for (int i = 0; i < mNSample; i++) {
+    const double* f = &mFields[3 * i];
+    mMag[i] = sqrt(f[0] * f[0] + f[1] * f[1] + f[2] * f[2]);
+    if (!isnan(mMag[i])) {
+      nValid++;
+    }
+  }
+  iprintf("Probe %d of %d samples in field.\n", nValid, mNSample);
+  return nValid > 0;
+}
+//
+//  Accessors.
+//
+double LineProbe::GetLength(void) const
+{
+  double dx = mEnd.mX - mStart.mX;
+  double dy = mEnd.mY - mStart.mY;
+  double dz = mEnd.mZ - mStart.mZ;
+  return sqrt(dx * dx + dy * dy + dz * dz);
+}
+double LineProbe::GetValue(int i, int comp) const
+{
+  if (comp == 3) {
+    return mMag[i];
+  }
+  return mFields[3 * i + comp];
+}
+bool LineProbe::GetRange(int comp, double* min, double* max) const
+{
+  bool found = false;
+  for (int i = 0; i < (int) mMag.size(); i++) {
+    double v = GetValue(i, comp);
+    if (isnan(v)) {
+      continue;
+    }
+    if (!found) {
+      *min = *max = v;
+      found = true;
+    } else if (v < *min) {
+      *min = v;
+    } else if (v > *max) {
+      *max = v;
+    }
+  }
+  return found;
+}
+//
+//  Samples outside the field are written as empty cells so that a
+//  spreadsheet leaves gaps rather than plotting zeros.
+//
+bool LineProbe::WriteCSV(const char* filename) const
+{
+  FILE* ofp = fopen(filename, "wt");
+  if (nullptr == ofp) {
+    eprintf("LineProbe: Unable to open %s\n", filename);
+    return false;
+  }
+  fprintf(ofp, "s,x,y,z,Ex,Ey,Ez,|E|\n");
+  for (int i = 0; i < (int) mMag.size(); i++) {
+    const double* p = &mPoints[3 * i];
+    const double* f = &mFields[3 * i];
+    fprintf(ofp, "%.9g,%.9g,%.9g,%.9g", mDist[i], p[0], p[1], p[2]);
+    if (isnan(mMag[i])) {
+      fprintf(ofp, ",,,,\n");
+    } else {
+      fprintf(ofp, ",%.9g,%.9g,%.9g,%.9g\n", f[0], f[1], f[2], mMag[i]);
+    }
+  }
+  bool ok = (ferror(ofp) == 0);
+  fclose(ofp);
+  return ok;
+}
@@ -0,0 +1,75 @@
+//
+//  LineProbe.h
+//  FieldViewer
+//
+//  A LineProbe samples a field at evenly spaced points along a straight
+//  segment. All the points are handed to the field in one batched query
+//  and the results are kept so that they can be plotted or written out
+//  as a CSV file.
+//
+//  Created by Brian Collett on 10/19/26.
+//  Copyright (c) 2026 Brian Collett. All rights reserved.
+//
+
+#ifndef __FieldViewer__LineProbe__
+#define __FieldViewer__LineProbe__
+
+#include <vector>
+#include "Geometry/GeometricObjects.h"
+#include "EField.h"
+
+//
+//  Default number of samples along the segment.
+//
+const int kLPDefaultSamples = 200;
+
+class LineProbe {
+protected:
+  //
+  //  Instance vars.
+  //  We do NOT own the field.
+  //
+  EField* mField;
+  Point3D mStart;
+  Point3D mEnd;
+  int mNSample;
+  //
+  //  Sample positions and results, three doubles per sample, plus the
+  //  distance along the segment and |E| for each sample.
+  //
+  std::vector<double> mPoints;
+  std::vector<double> mFields;
+  std::vector<double> mDist;
+  std::vector<double> mMag;
+public:
+  //
+  //  ctors
+  //
+  LineProbe(EField* f, const Point3D& start, const Point3D& end,
+            int nSample = kLPDefaultSamples);
+  virtual ~LineProbe();
+  //
+  //  Sample the field. Returns false if no sample lies in the field.
+  //
+  bool Sample(void);
+  //
+  //  Accessors. Component 0-2 are Ex, Ey, Ez and 3 is |E|.
+  //
+  int GetNSample(void) const { return mNSample; };
+  double GetLength(void) const;
+  double GetDist(int i) const { return mDist[i]; };
+  double GetValue(int i, int comp) const;
+  const Point3D& GetStart(void) const { return mStart; };
+  const Point3D& GetEnd(void) const { return mEnd; };
+  //
+  //  Range of one component over the valid samples. Returns false if
+  //  there are none.
+  //
+  bool GetRange(int comp, double* min, double* max) const;
+  //
+  //  Write s,x,y,z,Ex,Ey,Ez,|E| with a header line.
+  //
+  bool WriteCSV(const char* filename) const;
+};
+
+#endif /* defined(__FieldViewer__LineProbe__) */
@@ -7,10 +7,17 @@
 //  methods that the class must provide, a method to render the
 //  model and a method to respond to clicks in the model.
 //
-//  The click routine gets passed information about the line along
-//  which the click took place and an array of object names that lay
-//  under the click.
-//  The array belongs to the caller and MUST NOT be saved.
+//  The click routine gets passed the line along which the click took
+//  place. It is up to the model to work out what lies on that line;
+//  we no longer use GL_SELECT so there is no array of names.
+//
+//  Hover is the cheap cousin of DoClick. It is called as the mouse
+//  moves over the view and may fill buff with a one line description
+//  of what lies under the mouse. It must never render anything.
+//
+//  Resample is called when the number of pixels the view covers
+//  changes, as it does around an image export, so that anything that
+//  was sampled to suit the screen can be sampled again.
 //
 //  As a mix-in this is an abstract class and its methods must be
 //  implemented by its descendent.
@@ -31,7 +38,10 @@ public:
   virtual ~Model3D(void) {};
   //
   virtual void Render(bool picking) {};
-  virtual void DoClick(GLuint names[], Point3D start, Point3D end) = 0;
+  virtual void DoClick(Point3D start, Point3D end) = 0;
+  virtual bool Hover(const Point3D& start, const Point3D& end,
+                     char* buff, int len) { return false; };
+  virtual void Resample(void) {};
 };
 
 #endif /* defined(__FieldViewerc__Model3D__) */
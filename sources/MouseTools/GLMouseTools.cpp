@@ -39,6 +39,13 @@ void CGLMouseTool::DoLeftDClick(wxMouseEvent& event) {
   mResponder->LeftDClick(mStartX, mStartY);
 }
 void CGLMouseTool::DoLeftRelease(wxMouseEvent& WXUNUSED(event)) {
+  mResponder->EndDrag();
+}
+void CGLMouseTool::DoRelease(wxMouseEvent& WXUNUSED(event)) {
+  mResponder->EndDrag();
+}
+void CGLMouseTool::DoMove(wxMouseEvent& event) {
+  mResponder->Hover((int) event.GetX(), (int) event.GetY());
 }
 //
 //  The Spin tool rotates the view in its drag tool.
@@ -48,6 +48,18 @@ public:
   virtual void StartRegion(float xs, float ys) {};
   virtual void Region(float xe, float ye) {};
   virtual void EndRegion(float xe, float ye) {};
+  //
+  //  EndDrag is called when a button comes up at the end of a drag
+  //  so that the display can tidy up anything it skimped on while the
+  //  view was moving. The display should also call it if it loses the
+  //  mouse in the middle of a drag.
+  //
+  virtual void EndDrag(void) {};
+  //
+  //  Hover reports the mouse position when it moves with no button
+  //  down. It is called a lot so it must be cheap.
+  //
+  virtual void Hover(int x, int y) {};
 };
 //
 //  The top-level class provides the instance var to hold a pointer to
@@ -83,6 +95,8 @@ public:
 	virtual void DoLeftClick(wxMouseEvent& event);
 	virtual void DoLeftDClick(wxMouseEvent& event);
 	virtual void DoLeftRelease(wxMouseEvent& event);
+	virtual void DoRelease(wxMouseEvent& event);
+	virtual void DoMove(wxMouseEvent& event);
 };
 //
 //  The the individual tools.
@@ -45,6 +45,8 @@ void CMouseTool:: DispatchToolEvent(wxMouseEvent& event, CMouseTool* theTool)
 		theTool->DoLeftClick(event);
 	} else if (event.LeftUp()) {
 		theTool->DoLeftRelease(event);
+	} else if (event.ButtonUp()) {
+		theTool->DoRelease(event);
 	} else if (event.Dragging()) {
 		//
 		//	Now should decide which buttons are down during drag
@@ -53,6 +55,7 @@ void CMouseTool:: DispatchToolEvent(wxMouseEvent& event, CMouseTool* theTool)
 		//
 		theTool->DoLeftDrag(event);
 	} else if (event.Moving()) {
+		theTool->DoMove(event);
 	} else if (event.Entering()) {
 	} else if (event.Leaving()) {
 	}
@@ -81,6 +81,12 @@ public:
 	virtual void DoLeftDrag(wxMouseEvent& event) {};
 	virtual void DoLeftRelease(wxMouseEvent& event) {};
 	//
+	//	Any other button coming up. Drags are dispatched to DoLeftDrag
+	//	whichever button is held so this is where they end.
+	//
+	virtual void DoRelease(wxMouseEvent& event) {};
+	virtual void DoMove(wxMouseEvent& event) {};
+	//
 	//	Class method to sort between cases. It is called with a pointer
 	//	to the currently active tool as well as the event data.
 	//
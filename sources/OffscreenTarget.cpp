@@ -0,0 +1,116 @@
+//
+//  OffscreenTarget.cpp
+//  FieldViewer
+//
+//  An OffscreenTarget is a framebuffer object the canvas can draw into
+//  instead of the window. See OffscreenTarget.h.
+//
+//  Created by Brian Collett on 10/19/26.
+//  Copyright (c) 2026 Brian Collett. All rights reserved.
+//
+#define GL_GLEXT_PROTOTYPES 1
+#include <string.h>
+#include "OffscreenTarget.h"
+//
+//  ctors
+//
+OffscreenTarget::OffscreenTarget()
+{
+  mFBO = mColour = mDepth = 0;
+  mWidth = mHeight = 0;
+}
+OffscreenTarget::~OffscreenTarget()
+{
+  Release();
+}
+//
+//  The extension is in the Mac headers and in glext.h everywhere else,
+//  but check anyway so that a bare gl.h still builds.
+//
+int OffscreenTarget::MaxSize(void)
+{
+#ifdef GL_FRAMEBUFFER_EXT
+  const char* ext = (const char*) glGetString(GL_EXTENSIONS);
+  if ((nullptr == ext) || (strstr(ext, "GL_EXT_framebuffer_object") == nullptr)) {
+    return 0;
+  }
+  GLint rb = 0;
+  GLint vp[2] = { 0, 0 };
+  glGetIntegerv(GL_MAX_RENDERBUFFER_SIZE_EXT, &rb);
+  glGetIntegerv(GL_MAX_VIEWPORT_DIMS, vp);
+  int size = rb;
+  if (vp[0] < size) size = vp[0];
+  if (vp[1] < size) size = vp[1];
+  return size;
+#else
+  return 0;
+#endif
+}
+bool OffscreenTarget::Create(int width, int height)
+{
+  Release();
+#ifdef GL_FRAMEBUFFER_EXT
+  glGenFramebuffersEXT(1, &mFBO);
+  glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, mFBO);
+  glGenRenderbuffersEXT(1, &mColour);
+  glBindRenderbufferEXT(GL_RENDERBUFFER_EXT, mColour);
+  glRenderbufferStorageEXT(GL_RENDERBUFFER_EXT, GL_RGBA8, width, height);
+  glFramebufferRenderbufferEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT,
+                               GL_RENDERBUFFER_EXT, mColour);
+  glGenRenderbuffersEXT(1, &mDepth);
+  glBindRenderbufferEXT(GL_RENDERBUFFER_EXT, mDepth);
+  glRenderbufferStorageEXT(GL_RENDERBUFFER_EXT, GL_DEPTH_COMPONENT24,
+                           width, height);
+  glFramebufferRenderbufferEXT(GL_FRAMEBUFFER_EXT, GL_DEPTH_ATTACHMENT_EXT,
+                               GL_RENDERBUFFER_EXT, mDepth);
+  glBindRenderbufferEXT(GL_RENDERBUFFER_EXT, 0);
+  GLenum status = glCheckFramebufferStatusEXT(GL_FRAMEBUFFER_EXT);
+  glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, 0);
+  if (status != GL_FRAMEBUFFER_COMPLETE_EXT) {
+    Release();
+    return false;
+  }
+  mWidth = width;
+  mHeight = height;
+  return true;
+#else
+  return false;
+#endif
+}
+void OffscreenTarget::Bind(void)
+{
+#ifdef GL_FRAMEBUFFER_EXT
+  glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, mFBO);
+#endif
+}
+void OffscreenTarget::Unbind(void)
+{
+#ifdef GL_FRAMEBUFFER_EXT
+  glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, 0);
+#endif
+}
+//
+//  Rows are packed so the caller can index them as 3 * width.
+//
+void OffscreenTarget::Read(int width, int height, unsigned char* rgb)
+{
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, rgb);
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+}
+void OffscreenTarget::Release(void)
+{
+#ifdef GL_FRAMEBUFFER_EXT
+  if (0 != mDepth) {
+    glDeleteRenderbuffersEXT(1, &mDepth);
+  }
+  if (0 != mColour) {
+    glDeleteRenderbuffersEXT(1, &mColour);
+  }
+  if (0 != mFBO) {
+    glDeleteFramebuffersEXT(1, &mFBO);
+  }
+#endif
+  mFBO = mColour = mDepth = 0;
+  mWidth = mHeight = 0;
+}
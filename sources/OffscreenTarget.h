@@ -0,0 +1,65 @@
+//
+//  OffscreenTarget.h
+//  FieldViewer
+//
+//  An OffscreenTarget is a framebuffer object with a colour and a depth
+//  renderbuffer that the canvas can draw into instead of the window, so
+//  that a picture can be bigger than the screen and is not spoilt by
+//  other windows lying on top of the view. It uses EXT_framebuffer_object,
+//  which every Mac and any GL from 2.1 on has.
+//
+//  The target must be made and used with the canvas context current.
+//
+//  Created by Brian Collett on 10/19/26.
+//  Copyright (c) 2026 Brian Collett. All rights reserved.
+//
+
+#ifndef __FieldViewer__OffscreenTarget__
+#define __FieldViewer__OffscreenTarget__
+
+#include "Geometry/GeometricObjects.h"
+
+class OffscreenTarget {
+protected:
+  //
+  //  Instance vars.
+  //
+  GLuint mFBO;
+  GLuint mColour;
+  GLuint mDepth;
+  int mWidth;
+  int mHeight;
+public:
+  //
+  //  ctors
+  //
+  OffscreenTarget();
+  virtual ~OffscreenTarget();
+  //
+  //  The largest width or height we can ask for, the smaller of the
+  //  renderbuffer and viewport limits. 0 if there are no framebuffer
+  //  objects at all.
+  //
+  static int MaxSize(void);
+  //
+  //  Make the buffers. Returns false if the driver will not give us a
+  //  complete framebuffer of that size.
+  //
+  bool Create(int width, int height);
+  int GetWidth(void) const { return mWidth; };
+  int GetHeight(void) const { return mHeight; };
+  //
+  //  Draw into the target rather than the window, and back again.
+  //
+  void Bind(void);
+  static void Unbind(void);
+  //
+  //  Copy the bottom left width x height pixels out as packed RGB bytes,
+  //  bottom row first.
+  //
+  void Read(int width, int height, unsigned char* rgb);
+protected:
+  void Release(void);
+};
+
+#endif /* defined(__FieldViewer__OffscreenTarget__) */
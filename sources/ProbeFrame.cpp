@@ -0,0 +1,181 @@
+//
+//  ProbeFrame.cpp
+//  FieldViewer
+//
+//  A ProbeFrame is a small free-standing window that plots the
+//  Ex, Ey, Ez and |E| profiles of a LineProbe against distance along
+//  the probe and lets the user save the samples as a CSV file.
+//
+//  Created by Brian Collett on 10/19/26.
+//  Copyright (c) 2026 Brian Collett. All rights reserved.
+//
+#include <math.h>
+#include <vector>
+#include "wx/dcclient.h"
+#include "wx/filedlg.h"
+#include "ProbeFrame.h"
+
+//
+//  Plot layout. Margins in pixels and one colour per component.
+//
+static const int kPFMarginL = 70;
+static const int kPFMarginR = 70;
+static const int kPFMarginT = 20;
+static const int kPFMarginB = 40;
+static const char* sCompName[4] = { "Ex", "Ey", "Ez", "|E|" };
+static const unsigned char sCompColour[4][3] = {
+  { 200, 0, 0 }, { 0, 150, 0 }, { 0, 0, 220 }, { 0, 0, 0 }
+};
+
+BEGIN_EVENT_TABLE(ProbePlot, wxPanel)
+EVT_PAINT(ProbePlot::OnPaint)
+EVT_SIZE(ProbePlot::OnSize)
+END_EVENT_TABLE()
+
+BEGIN_EVENT_TABLE(ProbeFrame, wxFrame)
+EVT_MENU(bcID_PROBE_SAVE, ProbeFrame::OnMenuSaveCSV)
+EVT_MENU(wxID_CLOSE, ProbeFrame::OnMenuClose)
+END_EVENT_TABLE()
+//
+///////////////////////////// ProbePlot ///////////////////////
+//
+ProbePlot::ProbePlot(wxWindow* parent, LineProbe* probe)
+  : wxPanel(parent, wxID_ANY)
+{
+  mProbe = probe;
+  SetBackgroundColour(*wxWHITE);
+}
+void ProbePlot::OnSize(wxSizeEvent& event)
+{
+  Refresh();
+  event.Skip();
+}
+//
+//  Draw all four profiles on one set of axes. Samples outside the
+//  field break the curves.
+//
+void ProbePlot::OnPaint(wxPaintEvent& WXUNUSED(event))
+{
+  wxPaintDC dc(this);
+  dc.Clear();
+  int w, h;
+  GetClientSize(&w, &h);
+  int pw = w - kPFMarginL - kPFMarginR;
+  int ph = h - kPFMarginT - kPFMarginB;
+  if ((pw < 10) || (ph < 10)) {
+    return;
+  }
+  //
+  //  Find the common range. Keep zero in view so that the sign of the
+  //  components is obvious.
+  //
+  double vMin = 0.0, vMax = 0.0;
+  bool any = false;
+  for (int c = 0; c < 4; c++) {
+    double cMin, cMax;
+    if (mProbe->GetRange(c, &cMin, &cMax)) {
+      if (cMin < vMin) vMin = cMin;
+      if (cMax > vMax) vMax = cMax;
+      any = true;
+    }
+  }
+  if (!any) {
+    dc.DrawText(wxT("No samples in field"), kPFMarginL, kPFMarginT);
+    return;
+  }
+  if (vMax <= vMin) {
+    vMax = vMin + 1.0;
+  }
+  double len = mProbe->GetLength();
+  if (len <= 0.0) {
+    len = 1.0;
+  }
+  double xScale = pw / len;
+  double yScale = ph / (vMax - vMin);
+  int x0 = kPFMarginL;
+  int yBase = kPFMarginT + ph;
+  //
+  //  Axes, zero line and labels.
+  //
+  dc.SetPen(*wxBLACK_PEN);
+  dc.SetBrush(*wxTRANSPARENT_BRUSH);
+  dc.DrawRectangle(x0, kPFMarginT, pw + 1, ph + 1);
+  int yZero = yBase - int((0.0 - vMin) * yScale + 0.5);
+  dc.SetPen(*wxLIGHT_GREY_PEN);
+  dc.DrawLine(x0, yZero, x0 + pw, yZero);
+  dc.SetTextForeground(*wxBLACK);
+  dc.DrawText(wxString::Format(wxT("%.3g"), vMax), 4, kPFMarginT - 6);
+  dc.DrawText(wxString::Format(wxT("%.3g"), vMin), 4, yBase - 6);
+  dc.DrawText(wxT("0"), 4, yZero - 6);
+  dc.DrawText(wxT("0"), x0, yBase + 4);
+  dc.DrawText(wxString::Format(wxT("%.3g"), len), x0 + pw - 30, yBase + 4);
+  dc.DrawText(wxT("distance along probe"), x0 + pw / 2 - 60, yBase + 20);
+  //
+  //  The curves and a legend down the right hand side.
+  //
+  int n = mProbe->GetNSample();
+  std::vector<wxPoint> run;
+  run.reserve(n);
+  for (int c = 0; c < 4; c++) {
+    wxColour col(sCompColour[c][0], sCompColour[c][1], sCompColour[c][2]);
+    dc.SetPen(wxPen(col, (c == 3) ? 2 : 1));
+    run.clear();
+    for (int i = 0; i <= n; i++) {
+      double v = (i < n) ? mProbe->GetValue(i, c) : NAN;
+      if (isnan(v)) {
+        if (run.size() > 1) {
+          dc.DrawLines((int) run.size(), &run[0]);
+        }
+        run.clear();
+        continue;
+      }
+      run.push_back(wxPoint(x0 + int(mProbe->GetDist(i) * xScale + 0.5),
+                            yBase - int((v - vMin) * yScale + 0.5)));
+    }
+    dc.SetTextForeground(col);
+    dc.DrawText(sCompName[c], x0 + pw + 10, kPFMarginT + 18 * c);
+  }
+}
+//
+///////////////////////////// ProbeFrame ///////////////////////
+//
+ProbeFrame::ProbeFrame(wxWindow* parent, LineProbe* probe,
+                       const wxString& title)
+  : wxFrame(parent, wxID_ANY, title, wxDefaultPosition, wxSize(600, 400))
+{
+  mProbe = probe;
+  wxMenu* fileMenu = new wxMenu;
+  fileMenu->Append(bcID_PROBE_SAVE, wxT("&Save CSV...\tCtrl-S"));
+  fileMenu->AppendSeparator();
+  fileMenu->Append(wxID_CLOSE, wxT("&Close\tCtrl-W"));
+  wxMenuBar* menuBar = new wxMenuBar;
+  menuBar->Append(fileMenu, wxT("&File"));
+  SetMenuBar(menuBar);
+  CreateStatusBar(1);
+  const Point3D& a = mProbe->GetStart();
+  const Point3D& b = mProbe->GetEnd();
+  SetStatusText(wxString::Format(wxT("(%g, %g, %g) to (%g, %g, %g), %d samples"),
+                                 a.mX, a.mY, a.mZ, b.mX, b.mY, b.mZ,
+                                 mProbe->GetNSample()));
+  mPlot = new ProbePlot(this, mProbe);
+}
+ProbeFrame::~ProbeFrame()
+{
+  delete mProbe;
+}
+void ProbeFrame::OnMenuSaveCSV(wxCommandEvent& WXUNUSED(event))
+{
+  wxFileDialog saveFileDialog(this, _("Save probe samples"), "", "probe.csv",
+                              "CSV files (*.csv)|*.csv",
+                              wxFD_SAVE|wxFD_OVERWRITE_PROMPT);
+  if (saveFileDialog.ShowModal() == wxID_CANCEL) {
+    return;
+  }
+  if (!mProbe->WriteCSV(saveFileDialog.GetPath())) {
+    wxMessageBox(wxT("Unable to write probe file."));
+  }
+}
+void ProbeFrame::OnMenuClose(wxCommandEvent& WXUNUSED(event))
+{
+  Close(true);
+}
@@ -0,0 +1,64 @@
+//
+//  ProbeFrame.h
+//  FieldViewer
+//
+//  A ProbeFrame is a small free-standing window that plots the
+//  Ex, Ey, Ez and |E| profiles of a LineProbe against distance along
+//  the probe and lets the user save the samples as a CSV file.
+//
+//  Created by Brian Collett on 10/19/26.
+//  Copyright (c) 2026 Brian Collett. All rights reserved.
+//
+
+#ifndef __FieldViewer__ProbeFrame__
+#define __FieldViewer__ProbeFrame__
+
+#include "wx/wxprec.h"
+
+#ifndef WX_PRECOMP
+#include "wx/wx.h"
+#endif
+
+#include "wx/frame.h"
+#include "wx/panel.h"
+#include "FieldViewerApp.h"
+#include "LineProbe.h"
+
+//
+//  The plot pane. It only draws; the frame owns the probe.
+//
+class ProbePlot : public wxPanel {
+protected:
+  LineProbe* mProbe;
+public:
+  ProbePlot(wxWindow* parent, LineProbe* probe);
+  void OnPaint(wxPaintEvent& event);
+  void OnSize(wxSizeEvent& event);
+protected:
+  DECLARE_EVENT_TABLE()
+};
+
+class ProbeFrame : public wxFrame {
+protected:
+  //
+  //  We own the probe.
+  //
+  LineProbe* mProbe;
+  ProbePlot* mPlot;
+public:
+  //
+  //  ctors
+  //
+  ProbeFrame(wxWindow* parent, LineProbe* probe,
+             const wxString& title = wxT("Line probe"));
+  virtual ~ProbeFrame();
+protected:
+  //
+  //  Menu handlers. Must not be virtual.
+  //
+  void OnMenuSaveCSV(wxCommandEvent& event);
+  void OnMenuClose(wxCommandEvent& event);
+  DECLARE_EVENT_TABLE()
+};
+
+#endif /* defined(__FieldViewer__ProbeFrame__) */
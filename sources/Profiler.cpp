@@ -0,0 +1,242 @@
+//
+//  Profiler.cpp
+//  FieldViewer
+//
+//  The Profiler times the stages of drawing, picking, building field
+//  views and loading files, with CPU clocks and, where the driver has
+//  them, GL timer queries.
+//
+//  Created by Brian Collett on 10/19/26.
+//  Copyright (c) 2026 Brian Collett. All rights reserved.
+//
+#define GL_GLEXT_PROTOTYPES 1
+#include <stdio.h>
+#include <string.h>
+#include "Profiler.h"
+//
+//  GL_TIME_ELAPSED came in with ARB_timer_query. Older headers may only
+//  have the EXT name, and very old ones neither.
+//
+#if defined(GL_TIME_ELAPSED)
+#define kProfTimeElapsed GL_TIME_ELAPSED
+#elif defined(GL_TIME_ELAPSED_EXT)
+#define kProfTimeElapsed GL_TIME_ELAPSED_EXT
+#endif
+
+Profiler gProfiler;
+
+static const char* sStageName[kProfNStage] = {
+  "Paint", "Render", "Model", "FieldViews", "Volume", "Pick", "Hover",
+  "Sample", "ColourMap", "Upload", "LoadModel", "LoadField"
+};
+//
+//  ctors
+//
+Profiler::Profiler()
+{
+  mEnabled = false;
+  mGLTimers = -1;
+  mGLActive = -1;
+  for (int s = 0; s < kProfNStage; s++) {
+    Stage& st = mStages[s];
+    st.mNCPU = st.mNGL = 0;
+    st.mQuery[0] = st.mQuery[1] = 0;
+    st.mPending[0] = st.mPending[1] = false;
+    st.mNext = 0;
+  }
+}
+//
+//  The queries belong to whatever context was current when they were
+//  made and that is long gone by the time static destructors run, so
+//  we let them go with it.
+//
+Profiler::~Profiler()
+{
+}
+void Profiler::SetEnabled(bool on)
+{
+  if (on && !mEnabled) {
+    for (int s = 0; s < kProfNStage; s++) {
+      mStages[s].mNCPU = mStages[s].mNGL = 0;
+    }
+    mLog.clear();
+    mEpoch = Clock::now();
+  }
+  mEnabled = on;
+}
+const char* Profiler::StageName(ProfStage s)
+{
+  return ((s >= 0) && (s < kProfNStage)) ? sStageName[s] : "?";
+}
+//
+//  Timing.
+//
+void Profiler::Begin(ProfStage s, bool gl)
+{
+  if (!mEnabled) {
+    return;
+  }
+  Stage& st = mStages[s];
+  st.mStart = Clock::now();
+  if (!gl || (mGLActive >= 0)) {
+    return;
+  }
+  if (mGLTimers < 0) {
+    CheckGLTimers();
+  }
+#ifdef kProfTimeElapsed
+  if (mGLTimers == 1) {
+    Collect(s, 0);
+    Collect(s, 1);
+    int slot = st.mNext;
+    if (st.mPending[slot]) {
+      return;     // Both still in flight; skip rather than wait
+    }
+    if (st.mQuery[slot] == 0) {
+      glGenQueries(1, &st.mQuery[slot]);
+    }
+    glBeginQuery(kProfTimeElapsed, st.mQuery[slot]);
+    mGLActive = s;
+  }
+#endif
+}
+void Profiler::End(ProfStage s)
+{
+  if (!mEnabled) {
+    return;
+  }
+  Stage& st = mStages[s];
+  std::chrono::duration<double, std::milli> dt = Clock::now() - st.mStart;
+  Add(s, false, dt.count());
+#ifdef kProfTimeElapsed
+  if (mGLActive == s) {
+    glEndQuery(kProfTimeElapsed);
+    st.mPending[st.mNext] = true;
+    st.mNext ^= 1;
+    mGLActive = -1;
+  }
+#endif
+}
+//
+//  Collect picks up a finished query without waiting for one that is
+//  still running.
+//
+void Profiler::Collect(ProfStage s, int slot)
+{
+#ifdef kProfTimeElapsed
+  Stage& st = mStages[s];
+  if (!st.mPending[slot]) {
+    return;
+  }
+  GLuint ready = 0;
+  glGetQueryObjectuiv(st.mQuery[slot], GL_QUERY_RESULT_AVAILABLE, &ready);
+  if (!ready) {
+    return;
+  }
+  GLuint ns = 0;
+  glGetQueryObjectuiv(st.mQuery[slot], GL_QUERY_RESULT, &ns);
+  st.mPending[slot] = false;
+  Add(s, true, 1.0e-6 * ns);
+#endif
+}
+//
+//  Timer queries are core in GL 3.3 and otherwise need an extension.
+//
+void Profiler::CheckGLTimers(void)
+{
+  mGLTimers = 0;
+#ifdef kProfTimeElapsed
+  const char* version = (const char*) glGetString(GL_VERSION);
+  const char* ext = (const char*) glGetString(GL_EXTENSIONS);
+  int major = 0, minor = 0;
+  if ((nullptr != version) && (sscanf(version, "%d.%d", &major, &minor) == 2) &&
+      ((major > 3) || ((major == 3) && (minor >= 3)))) {
+    mGLTimers = 1;
+  } else if ((nullptr != ext) && (strstr(ext, "_timer_query") != nullptr)) {
+    mGLTimers = 1;
+  }
+#endif
+}
+void Profiler::Add(ProfStage s, bool gl, double ms)
+{
+  Stage& st = mStages[s];
+  if (gl) {
+    st.mGL[st.mNGL++ % kProfHistory] = ms;
+  } else {
+    st.mCPU[st.mNCPU++ % kProfHistory] = ms;
+  }
+  if ((int) mLog.size() < kProfLogMax) {
+    LogEntry e;
+    e.mStage = s;
+    e.mGL = gl;
+    std::chrono::duration<double> t = Clock::now() - mEpoch;
+    e.mTime = t.count();
+    e.mMS = ms;
+    mLog.push_back(e);
+  }
+}
+//
+//  Results.
+//
+double Profiler::Average(ProfStage s, bool gl) const
+{
+  const Stage& st = mStages[s];
+  int n = gl ? st.mNGL : st.mNCPU;
+  const double* h = gl ? st.mGL : st.mCPU;
+  if (n > kProfHistory) n = kProfHistory;
+  if (n == 0) {
+    return 0.0;
+  }
+  double sum = 0.0;
+  for (int i = 0; i < n; i++) {
+    sum += h[i];
+  }
+  return sum / n;
+}
+double Profiler::Max(ProfStage s, bool gl) const
+{
+  const Stage& st = mStages[s];
+  int n = gl ? st.mNGL : st.mNCPU;
+  const double* h = gl ? st.mGL : st.mCPU;
+  if (n > kProfHistory) n = kProfHistory;
+  double m = 0.0;
+  for (int i = 0; i < n; i++) {
+    if (h[i] > m) m = h[i];
+  }
+  return m;
+}
+int Profiler::Report(char* buff, int len) const
+{
+  int nLine = 0;
+  int used = snprintf(buff, len, "%-11s %8s %8s %8s\n",
+                      "stage", "cpu ms", "max", "gpu ms");
+  for (int s = 0; (s < kProfNStage) && (used < len); s++) {
+    if (mStages[s].mNCPU == 0) {
+      continue;
+    }
+    ProfStage ps = ProfStage(s);
+    if (mStages[s].mNGL > 0) {
+      used += snprintf(buff + used, len - used, "%-11s %8.2f %8.2f %8.2f\n",
+                       sStageName[s], Average(ps), Max(ps), Average(ps, true));
+    } else {
+      used += snprintf(buff + used, len - used, "%-11s %8.2f %8.2f %8s\n",
+                       sStageName[s], Average(ps), Max(ps), "-");
+    }
+    nLine++;
+  }
+  return nLine;
+}
+bool Profiler::WriteLog(const char* path) const
+{
+  FILE* ofp = fopen(path, "wt");
+  if (nullptr == ofp) {
+    return false;
+  }
+  fprintf(ofp, "time,stage,clock,ms\n");
+  for (size_t i = 0; i < mLog.size(); i++) {
+    const LogEntry& e = mLog[i];
+    fprintf(ofp, "%.6f,%s,%s,%.4f\n", e.mTime, sStageName[e.mStage],
+            e.mGL ? "gpu" : "cpu", e.mMS);
+  }
+  return fclose(ofp) == 0;
+}
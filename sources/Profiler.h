@@ -0,0 +1,134 @@
+//
+//  Profiler.h
+//  FieldViewer
+//
+//  The Profiler times the stages of drawing, picking, building field
+//  views and loading files so that we can see where the time goes. Each
+//  stage keeps the last kProfHistory CPU times and, for stages that do
+//  their work in GL, the GPU times from GL timer queries when the driver
+//  has them. Every sample also goes into a log that can be written out
+//  as a CSV file.
+//  Timing is off until someone turns it on, and then costs a couple of
+//  clock reads per stage. GPU queries are read back a frame late so that
+//  they never stall the pipeline. They cannot nest, so only the inner
+//  stages ask for them.
+//
+//  Created by Brian Collett on 10/19/26.
+//  Copyright (c) 2026 Brian Collett. All rights reserved.
+//
+
+#ifndef __FieldViewer__Profiler__
+#define __FieldViewer__Profiler__
+
+#include <chrono>
+#include <vector>
+#include "Geometry/GeometricObjects.h"
+
+//
+//  The stages that we time.
+//
+enum ProfStage {
+  kProfPaint = 0,     // GLViewerCanvas::OnPaint
+  kProfRender,        // FieldViewerDoc::Render
+  kProfModel,         // The GLA model
+  kProfFieldViews,    // All the FieldViews
+  kProfVolume,        // The volume view
+  kProfPick,          // Clicks
+  kProfHover,         // Status bar readout
+  kProfSample,        // FieldView::ViewType sampling the field
+  kProfColourMap,     // FieldTexture mapping field to colour
+  kProfUpload,        // FieldTexture sending the texture to GL
+  kProfLoadModel,     // Reading a .gla file and its fields
+  kProfLoadField,     // Reading a binary field file
+  kProfNStage
+};
+//
+//  Number of samples in the rolling averages and most log entries kept.
+//
+const int kProfHistory = 60;
+const int kProfLogMax = 200000;
+
+class Profiler {
+protected:
+  typedef std::chrono::steady_clock Clock;
+  //
+  //  Per stage data. Times are in ms. The GL queries are used in turn
+  //  so that one can be in flight while the other is read.
+  //
+  struct Stage {
+    double mCPU[kProfHistory];
+    double mGL[kProfHistory];
+    int mNCPU;
+    int mNGL;
+    Clock::time_point mStart;
+    GLuint mQuery[2];
+    bool mPending[2];
+    int mNext;
+  };
+  struct LogEntry {
+    int mStage;
+    bool mGL;
+    double mTime;     // s since profiling was turned on
+    double mMS;
+  };
+  Stage mStages[kProfNStage];
+  std::vector<LogEntry> mLog;
+  Clock::time_point mEpoch;
+  bool mEnabled;
+  int mGLTimers;      // -1 not yet known, 0 none, 1 available
+  int mGLActive;      // Stage with a query running or -1
+public:
+  //
+  //  ctors
+  //
+  Profiler();
+  virtual ~Profiler();
+  //
+  //  Turning profiling on clears the history and the log.
+  //
+  void SetEnabled(bool on);
+  bool IsEnabled(void) const { return mEnabled; };
+  //
+  //  Bracket a stage. Ask for a GL query only if a GL context is current
+  //  and the stage does not contain another GL stage.
+  //
+  void Begin(ProfStage s, bool gl = false);
+  void End(ProfStage s);
+  //
+  //  Results in ms. A stage with no samples gives zero.
+  //
+  double Average(ProfStage s, bool gl = false) const;
+  double Max(ProfStage s, bool gl = false) const;
+  bool HasGLTimers(void) const { return mGLTimers == 1; };
+  static const char* StageName(ProfStage s);
+  //
+  //  Report writes one line per stage that has samples into buff and
+  //  returns the number of lines. WriteLog writes the log as CSV.
+  //
+  int Report(char* buff, int len) const;
+  bool WriteLog(const char* path) const;
+protected:
+  //
+  //  Helpers.
+  //
+  void Add(ProfStage s, bool gl, double ms);
+  void Collect(ProfStage s, int slot);
+  void CheckGLTimers(void);
+};
+//
+//  There is only one profiler.
+//
+extern Profiler gProfiler;
+//
+//  A ProfScope times the block that it lives in.
+//
+class ProfScope {
+protected:
+  ProfStage mStage;
+public:
+  ProfScope(ProfStage s, bool gl = false) : mStage(s)
+    { gProfiler.Begin(s, gl); };
+  ~ProfScope() { gProfiler.End(mStage); };
+};
+
+#endif /* defined(__FieldViewer__Profiler__) */
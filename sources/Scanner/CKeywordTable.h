@@ -0,0 +1,165 @@
+/*
+ *  CKeywordTable.h
+ *  FieldViewer
+ *
+ *  A CKeywordTable is a perfect hash table of keywords that is worked
+ *  out entirely by the compiler from one constexpr list of them. Each
+ *  keyword hashes to a slot of its own, so looking a word up is one
+ *  hash of three of its characters and its length, one load and one
+ *  compare. Matching ignores case.
+ *
+ *  The word does not need to be a C string, so CTextScanner can look
+ *  a word up where it lies in the text, see CTextScanner::NextKeyword.
+ *
+ *  To make a table, list the keywords in lower case in a constexpr
+ *  array of CKeyword and describe it with a struct like
+ *
+ *    constexpr CKeyword kMyWords[] = { { "red", 1 }, { "green", 2 } };
+ *    struct MyWords {
+ *      static constexpr const CKeyword* Words() { return kMyWords; };
+ *      static constexpr int kNWords = 2;
+ *      static constexpr int kNSlots = 4;          // a power of two
+ *    };
+ *    constexpr CKeywordTable kMyTable = CKMakeTable<MyWords>();
+ *
+ *  CKMakeTable fails to compile if the list has a keyword that is not
+ *  lower case or if no hash in the first kCKMaxSeed keeps the keywords
+ *  apart, in which case kNSlots wants doubling. This is all C++11
+ *  constexpr, so every function is a single return statement.
+ *
+ *  Created by Brian Collett on 10/19/26.
+ *  Copyright (c) 2026 Brian Collett. All rights reserved.
+ *
+ */
+#ifndef _CKeywordTable_H
+#define _CKeywordTable_H
+
+#include <stddef.h>
+
+struct CKeyword {
+  const char* mName;            // lower case
+  short mSym;
+};
+//
+//  The hash is a seed times the first character plus the middle and
+//  last characters and the length. Only the seed is searched for.
+//
+const unsigned kCKMaxSeed = 256;
+
+constexpr unsigned CKFold(char c)
+{
+  return (unsigned char) c | 0x20;      // upper to lower for letters
+}
+constexpr unsigned CKHash(const char* w, size_t len, unsigned seed)
+{
+  return CKFold(w[0]) * seed + CKFold(w[len / 2]) * 31 + CKFold(w[len - 1]) +
+         (unsigned) len;
+}
+constexpr size_t CKLength(const char* s)
+{
+  return (*s == 0) ? 0 : 1 + CKLength(s + 1);
+}
+constexpr unsigned CKSlotOf(const CKeyword* words, int k, unsigned seed,
+                            unsigned mask)
+{
+  return CKHash(words[k].mName, CKLength(words[k].mName), seed) & mask;
+}
+//
+//  Compile time checks and searches.
+//
+constexpr bool CKIsLower(const char* s)
+{
+  return (*s == 0) || ((CKFold(*s) == (unsigned char) *s) && CKIsLower(s + 1));
+}
+constexpr bool CKAllLower(const CKeyword* words, int n)
+{
+  return (n == 0) || ((CKLength(words[n - 1].mName) > 0) &&
+                      CKIsLower(words[n - 1].mName) && CKAllLower(words, n - 1));
+}
+constexpr bool CKClashes(const CKeyword* words, int k, int j, unsigned seed,
+                         unsigned mask)
+{
+  return (j < k) && ((CKSlotOf(words, j, seed, mask) ==
+                      CKSlotOf(words, k, seed, mask)) ||
+                     CKClashes(words, k, j + 1, seed, mask));
+}
+constexpr bool CKDistinct(const CKeyword* words, int n, unsigned seed,
+                          unsigned mask)
+{
+  return (n == 0) || (!CKClashes(words, n - 1, 0, seed, mask) &&
+                      CKDistinct(words, n - 1, seed, mask));
+}
+constexpr unsigned CKFindSeed(const CKeyword* words, int n, unsigned mask,
+                              unsigned seed)
+{
+  return ((seed >= kCKMaxSeed) || CKDistinct(words, n, seed, mask)) ? seed :
+         CKFindSeed(words, n, mask, seed + 1);
+}
+constexpr signed char CKSlot(const CKeyword* words, int n, unsigned seed,
+                             unsigned mask, unsigned slot, int k)
+{
+  return (k >= n) ? -1 : ((CKSlotOf(words, k, seed, mask) == slot) ?
+                          (signed char) k :
+                          CKSlot(words, n, seed, mask, slot, k + 1));
+}
+//
+//  What the scanner uses. Find returns the keyword or nullptr.
+//
+struct CKeywordTable {
+  const CKeyword* mWords;
+  const signed char* mSlots;    // index into mWords, or -1
+  unsigned mSeed;
+  unsigned mMask;
+  const CKeyword* Find(const char* word, size_t len) const {
+    if (len == 0) {
+      return nullptr;
+    }
+    int k = mSlots[CKHash(word, len, mSeed) & mMask];
+    if (k < 0) {
+      return nullptr;
+    }
+    const char* name = mWords[k].mName;
+    for (size_t i = 0; i < len; i++) {
+      if (CKFold(word[i]) != (unsigned char) name[i]) {
+        return nullptr;             // includes running off the end of name
+      }
+    }
+    return (name[len] == 0) ? &mWords[k] : nullptr;
+  };
+};
+//
+//  The slots are filled in by expanding a pack of slot numbers, which
+//  C++11 makes us build by hand.
+//
+template<int... I> struct CKSeq {};
+template<int N, int... I> struct CKMakeSeq : CKMakeSeq<N - 1, N - 1, I...> {};
+template<int... I> struct CKMakeSeq<0, I...> { typedef CKSeq<I...> type; };
+
+template<class List, class Seq = typename CKMakeSeq<List::kNSlots>::type>
+struct CKSlots;
+template<class List, int... I>
+struct CKSlots<List, CKSeq<I...> > {
+  static constexpr unsigned kMask = List::kNSlots - 1;
+  static constexpr unsigned kSeed = CKFindSeed(List::Words(), List::kNWords,
+                                               kMask, 1);
+  static_assert((List::kNSlots & kMask) == 0, "kNSlots must be a power of two");
+  static_assert(List::kNSlots < 128, "too many slots for a signed char index");
+  static_assert(CKAllLower(List::Words(), List::kNWords),
+                "keywords must be lower case");
+  static_assert(kSeed < kCKMaxSeed, "no perfect hash, double kNSlots");
+  static const signed char sSlots[sizeof...(I)];
+};
+template<class List, int... I>
+const signed char CKSlots<List, CKSeq<I...> >::sSlots[sizeof...(I)] = {
+  CKSlot(List::Words(), List::kNWords, CKSlots<List, CKSeq<I...> >::kSeed,
+         CKSlots<List, CKSeq<I...> >::kMask, I, 0)...
+};
+
+template<class List>
+constexpr CKeywordTable CKMakeTable()
+{
+  return CKeywordTable{ List::Words(), CKSlots<List>::sSlots,
+                        CKSlots<List>::kSeed, CKSlots<List>::kMask };
+}
+
+#endif // _CKeywordTable_H
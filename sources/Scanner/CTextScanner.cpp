@@ -12,10 +12,18 @@
  *
  *	BCollett 2/95
  *  Slightly reworked BCollett 2/14 to use FILE I/O.
+ *  BCollett 10/19/26 Scan a mapping of the file when we can.
+ *  BCollett 10/19/26 Scan a piece of text that someone else owns.
+ *  BCollett 10/19/26 NextKeyword.
  */
 #include <math.h>
 #include <ctype.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 #include "CTextScanner.h"
 
 //
@@ -47,24 +55,126 @@
 //
 //#define WantMPrims
 //
+//	Comment out the next line to always read a line at a time.
+//
+#define WantMapping 1
+//
+//	Numbers keep at most kNumDigits significant digits in an integer
+//	mantissa, which is all a 64 bit integer can hold. Any mantissa up to
+//	2^53 with a power of ten up to 22 either way is converted exactly by
+//	one multiply or divide because both are exact doubles (Clinger's fast
+//	path). Where the compiler has 128 bit integers, longer mantissas with
+//	a power of ten up to kNumScale either way are scaled exactly in
+//	integers and rounded once, see ScaleExact. That covers numbers
+//	written to full double precision. Anything else goes to strtod, which
+//	is correctly rounded too but much slower.
+//
+const int kNumDigits = 19;
+const unsigned long long kNumExact = 1ULL << 53;
+static const double sPow10[23] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+#ifdef __SIZEOF_INT128__
+const int kNumScale = 27;				// 5^27 is the largest power below 2^63
+static const unsigned long long sPow5[kNumScale + 1] = {
+	1ULL, 5ULL, 25ULL, 125ULL,
+	625ULL, 3125ULL, 15625ULL, 78125ULL,
+	390625ULL, 1953125ULL, 9765625ULL, 48828125ULL,
+	244140625ULL, 1220703125ULL, 6103515625ULL, 30517578125ULL,
+	152587890625ULL, 762939453125ULL, 3814697265625ULL, 19073486328125ULL,
+	95367431640625ULL, 476837158203125ULL, 2384185791015625ULL, 11920928955078125ULL,
+	59604644775390625ULL, 298023223876953125ULL, 1490116119384765625ULL, 7450580596923828125ULL
+};
+//
+//	Round q, plus a little more if sticky, to 53 bits, nearest even,
+//	and scale by 2^exp2.
+//
+static double RoundBits(unsigned __int128 q, bool sticky, int exp2)
+{
+	unsigned long long hi = (unsigned long long) (q >> 64);
+	unsigned long long lo = (unsigned long long) q;
+	int bits = (hi != 0) ? 128 - __builtin_clzll(hi) : ((lo != 0) ? 64 - __builtin_clzll(lo) : 0);
+	if (bits <= 53) {
+		return ldexp((double) (unsigned long long) q, exp2);
+	}
+	int shift = bits - 53;
+	unsigned long long top = (unsigned long long) (q >> shift);
+	unsigned __int128 rest = q & ((((unsigned __int128) 1) << shift) - 1);
+	unsigned __int128 half = ((unsigned __int128) 1) << (shift - 1);
+	if ((rest > half) || ((rest == half) && (sticky || (top & 1)))) {
+		++top;						// 2^53 is still exact
+	}
+	return ldexp((double) top, shift + exp2);
+}
+//
+//	mant * 10^dExp is mant * 5^dExp * 2^dExp. Going up, the product
+//	fits in 128 bits. Going down, we shift mant up as far as it will go
+//	before dividing so that the quotient has over 63 bits, and the
+//	remainder tells us whether anything was lost below them.
+//
+static bool ScaleExact(unsigned long long mant, int dExp, double* value)
+{
+	if ((dExp > kNumScale) || (dExp < -kNumScale)) {
+		return false;
+	}
+	if (dExp >= 0) {
+		*value = RoundBits((unsigned __int128) mant * sPow5[dExp], false, dExp);
+		return true;
+	}
+	int shift = 64 + __builtin_clzll(mant);		// mant is not 0
+	unsigned __int128 n = ((unsigned __int128) mant) << shift;
+	unsigned long long d = sPow5[-dExp];
+	*value = RoundBits(n / d, (n % d) != 0, dExp - shift);
+	return true;
+}
+#endif
+//
 //	Constructor is initialised with the text we scan through.
 //	We keep a pointer to the text but we do not own it.
 //
-CTextScanner::CTextScanner(FILE* fp)
+CTextScanner::CTextScanner(FILE* fp, bool map)
 {
   mIfp = fp;
 	mText = new char[CTLineLength];
-	mNextChar = mText;
+	mText[0] = 0;
+	mNextChar = mEnd = mText;
+	mLineNumber = 0;
+	mEOF[0] = mEOF[1] = 0;
+	mMap = NULL;
+	mMapSize = 0;
+	mStart = mCounted = NULL;
+	mOwnMap = false;
+	currLex.lex = LError;
+	pushedBack = false;
+#ifdef WantMapping
+	if (map) {
+		Map();
+	}
+#endif
+}
+CTextScanner::CTextScanner(const char* text, size_t length)
+{
+	mIfp = NULL;
+	mText = new char[CTLineLength];
 	mText[0] = 0;
 	mLineNumber = 0;
+	mEOF[0] = mEOF[1] = 0;
+	mMap = (char*) text;
+	mMapSize = length;
+	mStart = mCounted = mNextChar = text;
+	mEnd = text + length;
+	mOwnMap = false;
 	currLex.lex = LError;
 	pushedBack = false;
 }
 //
-//	The destructor has to dispose of the text buffer.
+//	The destructor has to dispose of the text buffer and the mapping.
+//	It must not touch the FILE, which is often closed by now.
 //
 CTextScanner::~CTextScanner()
 {
+	Unmap();
 	delete[] mText;
 }
 //
@@ -76,14 +186,18 @@ Lexeme *CTextScanner::NextLex()
 	char ch;                  // The current character
 	CClass cc;                // The class of the current character
 	char *tokp = TokenBuff;		// build tokens here
-	unsigned char nChar;			// counts number of chars in a string/word
-	double fVal = 0.0,				// denominator fractional part of a number
-	fScale = 1.0,             // numerator of fraction part of number
-	dVal = 0.0,               // Complete value of a number
-	exponent = 0.0,           // Exponent of a number
-	eSign = 1.0;              // Sign of exponent
+	char *tokEnd = TokenBuff + sizeof(TokenBuff) - 1;
+	int nChar;								// counts number of chars in a string/word
+	unsigned long long mant = 0;	// significant digits of a number
+	int nDigit = 0,						// how many of them there are
+	maxDigit,									// and how many there can be
+	dExp = 0,									// power of the base that goes with mant
+	exponent = 0,							// Exponent of a number
+	eSign = 1;								// Sign of exponent
+	double fVal;							// Complete value of a number
 	short neg = false,				// tells us to change sign of a number
-	isInteger = true;         // tells us if number is an integer
+	isInteger = true,         // tells us if number is an integer
+	exact = true;							// false once we drop a non-zero digit
 	/*
 	*	First see if we can just return the old one else make sure 
 	*  PushedBack is FALSE.
@@ -102,6 +216,7 @@ Lexeme *CTextScanner::NextLex()
 	currLex.lex = LError;			// Default response for if nothing better happens
 	while (true) {
 		mBase = 10;						// default numbers to decimal
+		maxDigit = kNumDigits;
 		/*
 		*	First skip white space.
 		*/
@@ -134,8 +249,10 @@ Lexeme *CTextScanner::NextLex()
 					*tokp++ = toupper(ch);		// Put first char into word
 					nChar = 1;
 					while (CharClass[ch = NextChar()] & LAlphaBit) {
-						*tokp++ = toupper(ch);
-						++nChar;
+						if (nChar < (int) sizeof(TokenBuff) - 1) {	// lines are unlimited, words are not
+							*tokp++ = toupper(ch);
+							++nChar;
+						}
 			        }
 					*tokp = 0;
 					BackUp();						// Return the unused char
@@ -156,10 +273,8 @@ Lexeme *CTextScanner::NextLex()
 			        }
 					else if (ch == '.') {
 						ch = NextChar();      // that read the '.'
-						ch = Peek();          // and that looked ahead still further
-						if (ch >= '0' && ch <= '9') {
+						if (Peek() >= '0' && Peek() <= '9') {	// and that looked ahead still further
 							neg = true;
-							ch = NextChar();    // ch is now the first digit
 							goto HavePeriod;		// and we handle the rest of the number
 						}
 						else {
@@ -180,7 +295,7 @@ Lexeme *CTextScanner::NextLex()
 #ifdef WantReals
 				case LPeriod:ch = Peek();		// Rare enough not to NextChar
 					if (ch >= '0' && ch <= '9') {
-						ch = NextChar();
+						ch = '.';
 						goto HavePeriod;
 					}
 					else {
@@ -202,35 +317,53 @@ Lexeme *CTextScanner::NextLex()
 					//	Else falls through to number
 					//
 					mBase = 16;
+					maxDigit = 16;
 #endif
 				/*
 				*	Numbers can only begin with digits but have a fairly complex 
-				*  structure once they get started. I convert them into values 
-				*  as I go. Note that tests in inner loops are all with CDigit, 
-				*  the code WITH the 0x*0 bit set since it has not been stripped.
+				*  structure once they get started. I gather the digits into an
+				*  integer mantissa as I go and keep the text in TokenBuff in case
+				*  the fast path cannot finish the job, see kNumDigits. Note that
+				*  tests in inner loops are all with CDigit, the code WITH the
+				*  0x*0 bit set since it has not been stripped.
 				*/
 				case LDigit:
         StartNum:
-					dVal = DigitValue(ch);		// Start accumulating the number
+					*tokp++ = ch;
+					mant = DigitValue(ch);
+					nDigit = (mant != 0);
 					while (IsDigit(ch = NextChar())) {
-						dVal *= mBase;
-						dVal += DigitValue(ch);
+						if (tokp < tokEnd) *tokp++ = ch;
+						if (nDigit < maxDigit) {
+							mant = mant * mBase + DigitValue(ch);
+							nDigit += (mant != 0);
+						} else {
+							++dExp;											// Dropped a digit
+							exact = exact && (ch == '0');
+						}
 					}
 #ifdef WantReals
 					if (ch == '.' && Peek() != '.') {		// Do fractional part
         HavePeriod:
 						isInteger = false;
+						if (tokp < tokEnd) *tokp++ = '.';
 						while (IsDigit(ch = NextChar())) {
-							fVal *= mBase;
-							fScale *= mBase;
-							fVal += ch - '0';
+							if (tokp < tokEnd) *tokp++ = ch;
+							if (nDigit < maxDigit) {
+								mant = mant * 10 + (ch - '0');
+								nDigit += (mant != 0);
+								--dExp;
+							} else {
+								exact = exact && (ch == '0');
+							}
 						}
-						dVal += fVal / fScale;			// Complete fraction is added in
 					}
 					if (ch == 'e' || ch == 'E') {					// It has an exponent
 						isInteger = false;
+						if (tokp < tokEnd) *tokp++ = ch;
 						if ((ch =  NextChar()) == '-') {		// How about a sign
 							eSign = -1;
+							if (tokp < tokEnd) *tokp++ = ch;
 							ch =  NextChar();
 						}
 						else if (ch == '+') {
@@ -242,10 +375,13 @@ Lexeme *CTextScanner::NextLex()
 							currLex.sVal = "Missing exponent value";
 							return &currLex;
 						}
-						exponent = (double) ch - '0';						// Build exponent
+						exponent = ch - '0';									// Build exponent
+						if (tokp < tokEnd) *tokp++ = ch;
 						while (CharClass[(ch = NextChar())] == CDigit) {
-							exponent *= 10.0;
-							exponent += (double) ch - '0';
+							if (tokp < tokEnd) *tokp++ = ch;
+							if (exponent < 10000) {
+								exponent = exponent * 10 + (ch - '0');
+							}
 						}
 						if (exponent > 300) {						// Check range
 							BackUp();
@@ -255,9 +391,32 @@ Lexeme *CTextScanner::NextLex()
 						}
 					} // End if exp sign
 					BackUp();
-					exponent *= eSign;
+					dExp += eSign * exponent;
+#endif
+					*tokp = 0;
+					if (mant == 0) {
+						fVal = 0.0;
+					}
+#ifdef WantHex
+					else if (mBase != 10) {
+						fVal = ldexp((double) mant, 4 * dExp);
+					}
+#endif
+					else if (exact && (dExp == 0)) {					// Rounds on conversion
+						fVal = (double) mant;
+					}
+					else if (exact && (mant <= kNumExact) && (dExp >= -22) && (dExp <= 22)) {
+						fVal = (dExp < 0) ? (double) mant / sPow10[-dExp] : (double) mant * sPow10[dExp];
+					}
+#ifdef __SIZEOF_INT128__
+					else if (exact && ScaleExact(mant, dExp, &fVal)) {
+					}
 #endif
-					fVal = (isInteger) ? dVal : dVal * pow(mBase,exponent);
+					else if (tokp < tokEnd) {							// Have all the text
+						fVal = strtod(TokenBuff, NULL);
+					} else {																// Over 255 chars!
+						fVal = (double) mant * pow(10.0, dExp);
+					}
 					currLex.lex = (isInteger) ? LInteger : LReal;
 					currLex.nVal =  (neg) ? -fVal : fVal;		// Finish Number
 					return &currLex;
@@ -346,6 +505,43 @@ Lexeme *CTextScanner::NextLex()
 	}	// End of outer loop
 }	// End of NextSym
 //
+//	NextKeyword looks for the word in the text we already have. If it
+//	is not all there, because it runs into the end of a line buffer, or
+//	it is not a keyword or not a word at all, NextLex does the job as
+//	usual and we look up what it made.
+//
+Lexeme *CTextScanner::NextKeyword(const CKeywordTable& table,
+                                  const CKeyword** keyword)
+{
+	*keyword = NULL;
+	if (!pushedBack) {
+		const char* first = mNextChar;
+		while ((first < mEnd) && (CharClass[(unsigned char) *first] == LSpace)) {
+			++first;
+		}
+		const char* last = first;
+		if ((last < mEnd) && ((CharClass[(unsigned char) *last] & 0x3F) == LAlpha)) {
+			while ((last < mEnd) && (CharClass[(unsigned char) *last] & LAlphaBit)) {
+				++last;
+			}
+			if ((last < mEnd) || (mMap != NULL)) {
+				*keyword = table.Find(first, last - first);
+			}
+		}
+		if (*keyword != NULL) {
+			mNextChar = last;
+			currLex.lex = LWord;
+			currLex.sVal = (*keyword)->mName;
+			return &currLex;
+		}
+	}
+	Lexeme* lex = NextLex();
+	if (lex->lex == LWord) {
+		*keyword = table.Find(lex->sVal, strlen(lex->sVal));
+	}
+	return lex;
+}
+//
 //	The other operation the parser needs is to push a symbol back when
 //	it has read more than it needs. The scanner supports 1 symbol of
 //	push-back.
@@ -367,54 +563,181 @@ void CTextScanner::CleanLine()
 }
 //
 //	Down here live the helpers.
-//	First are the ones for getting characters from the text cell (and for putting
-//	them back again!).
+//	First are the ones for getting characters from the text (and for putting
+//	them back again!). NextChar, Peek and BackUp are inline and work on the
+//	range from mNextChar to mEnd. NextLine is called when that runs out.
 //	Note that we always bump the character pointer until we are past the end of
 //	the buffer. That way if BackUp is called nextChar will still be fine.
 //
-char CTextScanner::NextChar()
+char CTextScanner::NextLine()
 {
-	char ch = *mNextChar;
-	if (ch != 0) {			// Still have chars to read
-		mNextChar++;
-	} else {				// Used up a line.
+	char* text = NULL;
+	if (mMap == NULL) {
 		//
 		//	Get a new line and set up access to it.
 		//
-		char* text = fgets(mText, CTLineLength - 2, mIfp);
-		if (text != NULL) {
-			++mLineNumber;
-			mNextChar = mText;
-			ch = *mNextChar++;
-		} else {
-			//
-			//	Reached end-of-file. Make sure we return it.
-			//	Actually build a dummy line with an EOF in it
-			//	so that a potential pushback is handled correctly.
-			//
-			ch = 0;
-			mText[0] = 0;
-			mText[1] = 0;
-			mNextChar = &mText[1];
+		text = fgets(mText, CTLineLength - 2, mIfp);
+	}
+	if (text != NULL) {
+		++mLineNumber;
+		mNextChar = mText;
+		mEnd = mText + strlen(mText);
+		if (mNextChar < mEnd) {
+			return *mNextChar++;
+		}
+	}
+	//
+	//	Reached end-of-file, or the end of the mapping, which is the
+	//	same thing. Make sure we return it.
+	//	Actually build a dummy line with an EOF in it
+	//	so that a potential pushback is handled correctly.
+	//
+	mEOF[0] = mEOF[1] = 0;
+	mNextChar = mEnd = &mEOF[1];
+	return 0;
+}
+//
+//	Map the rest of the file from wherever the FILE is now. We map the
+//	whole file because the offset must be a multiple of the page size.
+//	Anything but a non-empty plain file stays with fgets.
+//
+bool CTextScanner::Map()
+{
+	struct stat st;
+	int fd = fileno(mIfp);
+	if ((fd < 0) || (fstat(fd, &st) != 0) || !S_ISREG(st.st_mode)) {
+		return false;
+	}
+	long start = ftell(mIfp);
+	if ((start < 0) || (st.st_size <= start)) {
+		return false;
+	}
+	void* map = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (map == MAP_FAILED) {
+		return false;
+	}
+	madvise(map, (size_t) st.st_size, MADV_SEQUENTIAL);
+	mMap = (char*) map;
+	mMapSize = (size_t) st.st_size;
+	mOwnMap = true;
+	mStart = mCounted = mNextChar = mMap + start;
+	mEnd = mMap + mMapSize;
+	mLineNumber = 0;
+	return true;
+}
+void CTextScanner::Unmap()
+{
+	if (mMap != NULL) {
+		if (mOwnMap) {
+			munmap(mMap, mMapSize);
 		}
+		mMap = NULL;
+		mOwnMap = false;
+		mMapSize = 0;
+		mStart = mCounted = NULL;
+		mNextChar = mEnd = &mEOF[1];
 	}
-	return ch;
 }
 //
-//	This one does not move the pointer forward.
+//	Where we are in the mapping, just past the last character handed out.
+//	At end of file we are in mEOF, which counts as the end of the mapping.
 //
-char CTextScanner::Peek()
+const char* CTextScanner::Position()
+{
+	if ((mNextChar >= mStart) && (mNextChar <= mMap + mMapSize)) {
+		return mNextChar;
+	}
+	return mMap + mMapSize;
+}
+size_t CTextScanner::Offset()
+{
+	if (mMap != NULL) {
+		return Position() - mMap;
+	}
+	long pos = (mIfp != NULL) ? ftell(mIfp) : -1;
+	return (pos < 0) ? 0 : (size_t) pos;
+}
+void CTextScanner::Sync()
 {
-	char ch = *mNextChar;
-	return ch;
+	if ((mMap != NULL) && (mIfp != NULL)) {
+		fseek(mIfp, (long) (Position() - mMap), SEEK_SET);
+	}
 }
 //
-//	But this one pushes it back so that we can re-read a character.
+//	Rest and SkipTo let a caller work on the mapping directly. Skipping
+//	drops any pushback and leaves us just as if we had scanned up to p.
 //
-//inline
-void CTextScanner::BackUp()
+const char* CTextScanner::Rest(size_t* length)
 {
-	--mNextChar;
+	if ((mMap == NULL) || pushedBack) {	// a pushed back symbol is not in the text
+		return NULL;
+	}
+	const char* pos = Position();
+	*length = (mMap + mMapSize) - pos;
+	return pos;
+}
+void CTextScanner::SkipTo(const char* p)
+{
+	if ((mMap == NULL) || (p < mStart) || (p > mMap + mMapSize)) {
+		return;
+	}
+	pushedBack = false;
+	mNextChar = p;
+	mEnd = mMap + mMapSize;
+}
+//
+//	Reading a line at a time we count lines as we go. For a mapping
+//	we count the '\n's before the last character handed out, starting
+//	from where we got to last time, so that the scan itself never has
+//	to look for them.
+//
+unsigned long CTextScanner::LineNumber()
+{
+	if (mMap == NULL) {
+		return mLineNumber;
+	}
+	const char* pos = Position();
+	if (pos == mStart) {
+		return 0;
+	}
+	const char* last = pos - 1;
+	if (last < mCounted) {
+		mCounted = mStart;
+		mLineNumber = 0;
+	}
+	for (const char* p = mCounted; p < last; p++) {
+		if (*p == '\n') {
+			++mLineNumber;
+		}
+	}
+	mCounted = last;
+	return mLineNumber + 1;
+}
+//
+//	For a mapping we copy the line holding the last character handed out
+//	into mText, as much of it as will fit.
+//
+const char* CTextScanner::GetLine()
+{
+	if (mMap == NULL) {
+		return mText;
+	}
+	const char* end = mMap + mMapSize;
+	const char* pos = Position();
+	const char* first = (pos > mStart) ? pos - 1 : mStart;
+	while ((first > mStart) && (first[-1] != '\n')) {
+		--first;
+	}
+	const char* last = first;
+	while ((last < end) && (*last++ != '\n')) {
+	}
+	size_t len = last - first;
+	if (len > CTLineLength - 1) {
+		len = CTLineLength - 1;
+	}
+	memcpy(mText, first, len);
+	mText[len] = 0;
+	return mText;
 }
 //
 //	This one is used to read charactes within strings. It knows how to
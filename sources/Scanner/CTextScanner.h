@@ -17,12 +17,25 @@
  *
  *  BCollett 2/20/14 Remove CArchive dependence. Return to plain old
  *  stream input.
+ *
+ *  BCollett 10/19/26 Map the file into memory when we can and hand
+ *  out characters straight from the mapping. There is then no copy
+ *  and no limit on the length of a line. Pipes and the like still go
+ *  a line at a time through fgets. Either way the current text is the
+ *  range mNextChar to mEnd, so NextChar is one test on the fast path.
+ *  A mapping does not move the FILE on, so Sync puts it just after the
+ *  last character we handed out for anyone who reads on from there.
+ *  BCollett 10/19/26 A scanner can also be made over a piece of a
+ *  mapping so that a big file can be scanned in pieces on several
+ *  threads at once.
+ *  BCollett 10/19/26 Match keywords from a CKeywordTable in place.
  */
 #ifndef _H_CTextScanner_H
 #define _H_CTextScanner_H
 #include <stdio.h>
 #include "Lexemes.h"
 #include "CSymbolTable.h"
+#include "CKeywordTable.h"
 //
 //	First we have the representation of a symbol. This is the thing that
 //	we pass back to the interpreter.
@@ -54,8 +67,21 @@ protected:
 	//
 	FILE* mIfp;
 	char *mText;
-	char  *mNextChar;
+	const char  *mNextChar;
+	const char  *mEnd;				// just past the last char we may hand out
 	unsigned long mLineNumber;
+	char mEOF[2];					// the dummy line we hand out at end of file
+	//
+	//	When the file is mapped mMap is the whole file, mStart is where
+	//	the FILE was when we took it over and mEnd is the end of the file.
+	//	The line number is only worked out when it is asked for, counting
+	//	on from the last time.
+	//
+	char *mMap;
+	size_t mMapSize;
+	const char *mStart;
+	const char *mCounted;		// mLineNumber counts the '\n's before here
+	bool mOwnMap;				// false for a piece of someone else's text
 	//
 	//	We build the symbols in our internal Lexeme and actually pass pointers to
 	//	this one real symbol around. This makes pushback very easy to support since
@@ -82,14 +108,47 @@ public:
 	//
 	//	Constructor is initialised with the archive that we scan.
 	//
-	CTextScanner(FILE* fp);
+	//	map false forces the old line at a time reading.
+	//
+	CTextScanner(FILE* fp, bool map = true);
+	//
+	//	Or over length characters of text that somebody else owns and
+	//	that must outlive us. text should start at the start of a line.
+	//	It is treated just like a mapping of a file with no FILE behind
+	//	it, so line numbers count from the start of the text.
+	//
+	CTextScanner(const char* text, size_t length);
 	~CTextScanner();
 	//
+	//	True if we are scanning a mapping of the file.
+	//
+	bool IsMapped() { return mMap != NULL; };
+	//
+	//	How far into the text we have got, in bytes. When the file is not
+	//	mapped this is only as good as the last line read.
+	//
+	size_t Offset();
+	//
+	//	For a mapping, the text that we have not handed out yet and a way
+	//	to skip to a point further on in it. Rest returns NULL when the
+	//	file is not mapped or a symbol has been pushed back.
+	//
+	const char* Rest(size_t* length);
+	void SkipTo(const char* p);
+	//
 	//	The scanner is the externally visible thing that does the real work.
 	//	Every time the parser wants a symbol it calls this.
 	//
 	Lexeme *NextLex();
 	//
+	//	NextKeyword is NextLex for the start of a command. If the symbol
+	//	is a word in table then keyword is set to its entry, otherwise to
+	//	NULL. The word is matched where it lies in the text, so a keyword
+	//	is never copied out and upper cased as NextLex would. sVal is then
+	//	the keyword's own name.
+	//
+	Lexeme *NextKeyword(const CKeywordTable& table, const CKeyword** keyword);
+	//
 	//	The next operation the parser needs is to push a symbol back when
 	//	it has read more than it needs. The scanner supports 1 symbol of
 	//	push-back.
@@ -98,11 +157,17 @@ public:
 	//
 	//	We may also need to tell the parser what line we are on.
 	//
-	unsigned long LineNumber() { return mLineNumber; };
+	unsigned long LineNumber();
   //
   //  and what the line was.
   //
-  const char* GetLine() { return mText; };
+  const char* GetLine();
+  //
+  //  Move the FILE to just after the last character we handed out.
+  //  Reading a line at a time already leaves it after the current line
+  //  so this only does anything for a mapping.
+  //
+  void Sync();
 	//
 	//	This can be called after an error to clean up the rest of a line.
 	//
@@ -120,9 +185,13 @@ protected:
 	//	routine to peel off one character from the STextCell and the special
 	//	one used to read characters in strings.
 	//
-	char NextChar();
-	char Peek();
-	void BackUp();
+	char NextChar() { return (mNextChar < mEnd) ? *mNextChar++ : NextLine(); };
+	char NextLine();
+	char Peek() { return (mNextChar < mEnd) ? *mNextChar : 0; };
+	void BackUp() { --mNextChar; };
+	bool Map();
+	void Unmap();
+	const char* Position();
 	char ReadStrch();
 	void ResetVars();
 	bool IsDigit(char ch);
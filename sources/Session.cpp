@@ -0,0 +1,438 @@
+//
+//  Session.cpp
+//  FieldViewer
+//
+//  A Session is what the viewer saves so that it can be put back as it
+//  was. See Session.h for the format.
+//
+//  Created by Brian Collett on 10/19/26.
+//  Copyright (c) 2026 Brian Collett. All rights reserved.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <zlib.h>
+#include "FieldViewerApp.h"
+#include "FieldSlice.h"
+#include "Session.h"
+//
+//  Names for the components and colour maps, in enum order. The first
+//  name is the one we write; the rest are also accepted.
+//
+static const char* sCompNames[kSliceNComponent][3] = {
+  { "Ex", "x", nullptr },
+  { "Ey", "y", nullptr },
+  { "Ez", "z", nullptr },
+  { "Er", "radial", "r" },
+  { "E", "total", "mag" }
+};
+static const char* sColourNames[3] = { "grey", "heat", "rainbow" };
+static const char* sDelims = " \t\r\n";
+//
+//  Most samples we will believe a view has, well beyond any texture.
+//
+static const long kSessionMaxSamples = 1L << 28;
+//
+//  The byte order of this machine, as the session line puts it.
+//
+static const char* ByteOrder(void)
+{
+  const uint16_t one = 1;
+  return (*(const unsigned char*) &one == 1) ? "little" : "big";
+}
+static uint32_t CheckSum(const double* data, size_t n)
+{
+  uLong sum = adler32(0L, Z_NULL, 0);
+  return (uint32_t) adler32(sum, (const Bytef*) data,
+                            (uInt) (n * sizeof(double)));
+}
+//
+//  If line is a model or field directive, where it has the path. Paths
+//  can have spaces and # in them so they take the rest of the line.
+//
+static char* PathOf(char* line)
+{
+  char* rest = line + strspn(line, sDelims);
+  if ((strcspn(rest, sDelims) != 5) || ((strncasecmp(rest, "model", 5) != 0) &&
+                                        (strncasecmp(rest, "field", 5) != 0))) {
+    return nullptr;
+  }
+  return rest + 5 + strspn(rest + 5, sDelims);
+}
+//
+//  ctors
+//
+Session::Session()
+{
+  mHaveCamera = false;
+  memset(&mCamera, 0, sizeof(mCamera));
+  mColours = kSliceHeat;
+  mLinear = true;
+  mVersion = 0;
+  mOtherOrder = false;
+  mCurrent.mLegend = false;
+  mCurrent.mComponent = kSliceTotal;
+  mCurrent.mSpacing = 0.0;
+  mCurrent.mFixRange = false;
+  mCurrent.mVMin = mCurrent.mVMax = 0.0;
+  mCurrent.mNAcross = mCurrent.mNDown = 0;
+  mCurrent.mCheck = 0;
+}
+//
+//  Read the text a line at a time up to the end line, then the samples
+//  that follow it.
+//
+bool Session::Read(const char* path)
+{
+  FILE* ifp = fopen(path, "rb");
+  if (nullptr == ifp) {
+    eprintf("%s: unable to open session.\n", path);
+    return false;
+  }
+  char line[1024];
+  int lineNo = 0;
+  bool ok = true;
+  bool ended = false;
+  while (!ended && (fgets(line, sizeof(line), ifp) != nullptr)) {
+    lineNo++;
+    char* hash = (nullptr == PathOf(line)) ? strchr(line, '#') : nullptr;
+    if (nullptr != hash) {
+      *hash = '\0';
+    }
+    char word[16];
+    if ((sscanf(line, "%15s", word) == 1) && (strcasecmp(word, "end") == 0)) {
+      ended = true;
+      continue;
+    }
+    char copy[sizeof(line)];
+    strcpy(copy, line);
+    if (!ParseLine(line)) {
+      copy[strcspn(copy, "\r\n")] = '\0';
+      eprintf("%s:%d: cannot use \"%s\"\n", path, lineNo, copy);
+      ok = false;
+      if (0 == mVersion) {
+        break;                  // not a session at all
+      }
+    }
+  }
+  if (ok && !ended) {
+    eprintf("%s: no end line.\n", path);
+    ok = false;
+  }
+  if (ok && mModel.empty()) {
+    eprintf("%s: needs a model.\n", path);
+    ok = false;
+  }
+  ok = ok && ReadSamples(ifp, path);
+  fclose(ifp);
+  if (!ok) {
+    return false;
+  }
+  std::string dir(path);
+  size_t slash = dir.rfind('/');
+  dir = (slash == std::string::npos) ? std::string() : dir.substr(0, slash + 1);
+  mModel = FromDir(dir, mModel.c_str());
+  for (size_t i = 0; i < mFields.size(); i++) {
+    mFields[i] = FromDir(dir, mFields[i].c_str());
+  }
+  return true;
+}
+//
+//  ParseLine handles one directive. It is destructive, strtok chops
+//  the line up as it goes.
+//
+bool Session::ParseLine(char* line)
+{
+  char* path = PathOf(line);
+  if (nullptr != path) {
+    if (0 == mVersion) return false;
+    size_t len = strlen(path);
+    while ((len > 0) && (strchr(sDelims, path[len - 1]) != nullptr)) {
+      path[--len] = '\0';
+    }
+    if (0 == len) return false;
+    if (tolower(line[strspn(line, sDelims)]) == 'm') {
+      mModel = path;
+    } else {
+      mFields.push_back(path);
+    }
+    return true;
+  }
+  char* word = strtok(line, sDelims);
+  if (nullptr == word) {
+    return true;        // blank or comment
+  }
+  char* args[16];
+  int nArg = 0;
+  char* a;
+  while ((nArg < 16) && ((a = strtok(nullptr, sDelims)) != nullptr)) {
+    args[nArg++] = a;
+  }
+  double v[12];
+  if (strcasecmp(word, "session") == 0) {
+    if ((nArg != 2) || (0 != mVersion)) return false;
+    mVersion = atoi(args[0]);
+    if (mVersion != kSessionVersion) {
+      eprintf("Session version %d, we read version %d.\n", mVersion,
+              kSessionVersion);
+      mVersion = 0;
+      return false;
+    }
+    if ((strcasecmp(args[1], "little") != 0) &&
+        (strcasecmp(args[1], "big") != 0)) {
+      return false;
+    }
+    mOtherOrder = (strcasecmp(args[1], ByteOrder()) != 0);
+    return true;
+  }
+  if (0 == mVersion) {
+    return false;       // the session line has to come first
+  }
+  if (strcasecmp(word, "camera") == 0) {
+    if (nArg != 11) return false;
+    for (int i = 0; i < 11; i++) {
+      char* end;
+      v[i] = strtod(args[i], &end);
+      if (*end != '\0') return false;
+    }
+    for (int i = 0; i < 3; i++) {
+      mCamera.mLookAt[i] = v[i];
+    }
+    for (int i = 0; i < 4; i++) {
+      mCamera.mSpin[i] = v[3 + i];
+    }
+    mCamera.mAngle = v[7];
+    mCamera.mDist = v[8];
+    mCamera.mNearDist = v[9];
+    mCamera.mFarDist = v[10];
+    mHaveCamera = (mCamera.mAngle > 0.0) &&
+                  (mCamera.mFarDist > mCamera.mNearDist) &&
+                  (mCamera.mNearDist > 0.0);
+    return mHaveCamera;
+  } else if ((strcasecmp(word, "colours") == 0) ||
+             (strcasecmp(word, "colors") == 0)) {
+    if (nArg != 1) return false;
+    for (int c = 0; c < 3; c++) {
+      if (strcasecmp(args[0], sColourNames[c]) == 0) {
+        mColours = c;
+        return true;
+      }
+    }
+    return false;
+  } else if (strcasecmp(word, "map") == 0) {
+    if (nArg != 1) return false;
+    if (strcasecmp(args[0], "linear") == 0) {
+      mLinear = true;
+    } else if (strcasecmp(args[0], "log") == 0) {
+      mLinear = false;
+    } else {
+      return false;
+    }
+  } else if (strcasecmp(word, "component") == 0) {
+    if (nArg != 1) return false;
+    for (int c = 0; c < kSliceNComponent; c++) {
+      for (int k = 0; (k < 3) && (nullptr != sCompNames[c][k]); k++) {
+        if (strcasecmp(args[0], sCompNames[c][k]) == 0) {
+          mCurrent.mComponent = c;
+          return true;
+        }
+      }
+    }
+    char* end;
+    long c = strtol(args[0], &end, 10);
+    if ((*end != '\0') || (c < 0) || (c >= kSliceNComponent)) {
+      return false;
+    }
+    mCurrent.mComponent = (int) c;
+  } else if (strcasecmp(word, "spacing") == 0) {
+    if (nArg != 1) return false;
+    mCurrent.mSpacing = atof(args[0]);
+    return mCurrent.mSpacing >= 0.0;
+  } else if (strcasecmp(word, "range") == 0) {
+    if ((nArg == 1) && (strcasecmp(args[0], "auto") == 0)) {
+      mCurrent.mFixRange = false;
+      return true;
+    }
+    if (nArg != 2) return false;
+    mCurrent.mVMin = atof(args[0]);
+    mCurrent.mVMax = atof(args[1]);
+    mCurrent.mFixRange = true;
+    return mCurrent.mVMax > mCurrent.mVMin;
+  } else if (strcasecmp(word, "view") == 0) {
+    if ((nArg < 12) || (nArg > 13)) return false;
+    for (int i = 0; i < 12; i++) {
+      char* end;
+      v[i] = strtod(args[i], &end);
+      if (*end != '\0') return false;
+    }
+    SessionView s = mCurrent;
+    for (int c = 0; c < 4; c++) {
+      s.mCorners[c] = Point3D(v[3 * c], v[3 * c + 1], v[3 * c + 2]);
+    }
+    s.mLegend = (nArg == 13);
+    if (s.mLegend && (strcasecmp(args[12], "legend") != 0)) {
+      return false;
+    }
+    mViews.push_back(s);
+  } else if (strcasecmp(word, "samples") == 0) {
+    if ((nArg != 3) || mViews.empty() || (mViews.back().mNAcross > 0)) {
+      return false;
+    }
+    long across = atol(args[0]);
+    long down = atol(args[1]);
+    if ((across < 1) || (down < 1) || (across > kSessionMaxSamples / down)) {
+      return false;
+    }
+    mViews.back().mNAcross = (int) across;
+    mViews.back().mNDown = (int) down;
+    mViews.back().mCheck = (uint32_t) strtoul(args[2], nullptr, 10);
+  } else {
+    return false;
+  }
+  return true;
+}
+//
+//  The samples come straight after the end line. Ones we cannot use
+//  are dropped, leaving their views to be sampled again.
+//
+bool Session::ReadSamples(FILE* ifp, const char* path)
+{
+  bool any = false;
+  for (size_t i = 0; i < mViews.size(); i++) {
+    any = any || (mViews[i].mNAcross > 0);
+  }
+  if (any && mOtherOrder) {
+    wprintf("%s: samples are in the other byte order, sampling again.\n",
+            path);
+  }
+  bool dropRest = mOtherOrder;
+  for (size_t i = 0; i < mViews.size(); i++) {
+    SessionView& s = mViews[i];
+    if (0 == s.mNAcross) {
+      continue;
+    }
+    if (!dropRest) {
+      s.mData.resize((size_t) s.mNAcross * s.mNDown);
+      if (fread(&s.mData[0], sizeof(double), s.mData.size(), ifp) !=
+          s.mData.size()) {
+        wprintf("%s: samples cut short, sampling again.\n", path);
+        dropRest = true;
+      } else if (CheckSum(&s.mData[0], s.mData.size()) != s.mCheck) {
+        wprintf("%s: samples for view %d are damaged, sampling again.\n",
+                path, (int) i + 1);
+        s.mData.clear();
+      }
+    }
+    if (dropRest) {
+      s.mData.clear();
+    }
+    if (s.mData.empty()) {
+      s.mNAcross = s.mNDown = 0;
+    }
+  }
+  return true;
+}
+//
+//  The text goes first, then the samples in view order. Like a grid
+//  file it is written beside the old one and renamed over it so that
+//  nobody ever sees half a session.
+//
+bool Session::Write(const char* path,
+                    const std::vector<const double*>& samples)
+{
+  char pid[32];
+  snprintf(pid, sizeof(pid), ".%d", (int) getpid());
+  std::string tmpPath = std::string(path) + pid;
+  FILE* ofp = fopen(tmpPath.c_str(), "wb");
+  if (nullptr == ofp) {
+    eprintf("%s: unable to create.\n", path);
+    return false;
+  }
+  fprintf(ofp, "session    %d %s\n", kSessionVersion, ByteOrder());
+  fprintf(ofp, "model      %s\n", mModel.c_str());
+  for (size_t i = 0; i < mFields.size(); i++) {
+    fprintf(ofp, "field      %s\n", mFields[i].c_str());
+  }
+  if (mHaveCamera) {
+    const GLViewState& c = mCamera;
+    fprintf(ofp, "camera     %.17g %.17g %.17g  %.17g %.17g %.17g %.17g"
+                 "  %.17g %.17g %.17g %.17g\n",
+            c.mLookAt[0], c.mLookAt[1], c.mLookAt[2], c.mSpin[0], c.mSpin[1],
+            c.mSpin[2], c.mSpin[3], c.mAngle, c.mDist, c.mNearDist,
+            c.mFarDist);
+  }
+  fprintf(ofp, "colours    %s\n", sColourNames[mColours]);
+  fprintf(ofp, "map        %s\n", mLinear ? "linear" : "log");
+  for (size_t i = 0; i < mViews.size(); i++) {
+    const double* data = (i < samples.size()) ? samples[i] : nullptr;
+    if (nullptr != data) {
+      mViews[i].mCheck = CheckSum(data, (size_t) mViews[i].mNAcross *
+                                        mViews[i].mNDown);
+    }
+    WriteView(ofp, mViews[i], data);
+  }
+  fprintf(ofp, "end\n");
+  bool ok = true;
+  for (size_t i = 0; ok && (i < mViews.size()); i++) {
+    if ((i < samples.size()) && (nullptr != samples[i])) {
+      size_t n = (size_t) mViews[i].mNAcross * mViews[i].mNDown;
+      ok = (fwrite(samples[i], sizeof(double), n, ofp) == n);
+    }
+  }
+  ok = (fclose(ofp) == 0) && ok;
+  if (ok) {
+    ok = (rename(tmpPath.c_str(), path) == 0);
+  }
+  if (!ok) {
+    eprintf("%s: unable to write.\n", path);
+    remove(tmpPath.c_str());
+  }
+  return ok;
+}
+void Session::WriteView(FILE* ofp, const SessionView& v, const double* data)
+{
+  fprintf(ofp, "component  %s\n", sCompNames[v.mComponent][0]);
+  fprintf(ofp, "spacing    %.17g\n", v.mSpacing);
+  if (v.mFixRange) {
+    fprintf(ofp, "range      %.17g %.17g\n", v.mVMin, v.mVMax);
+  } else {
+    fprintf(ofp, "range      auto\n");
+  }
+  fprintf(ofp, "view      ");
+  for (int c = 0; c < 4; c++) {
+    const Real* p = v.mCorners[c].mCoords;
+    fprintf(ofp, "%s%.17g %.17g %.17g", (0 == c) ? " " : "  ", p[0], p[1],
+            p[2]);
+  }
+  fprintf(ofp, v.mLegend ? "  legend\n" : "\n");
+  if (nullptr != data) {
+    fprintf(ofp, "samples    %d %d %lu\n", v.mNAcross, v.mNDown,
+            (unsigned long) v.mCheck);
+  }
+}
+bool Session::IsSession(const char* path)
+{
+  FILE* fp = fopen(path, "rb");
+  if (nullptr == fp) {
+    return false;
+  }
+  char word[16];
+  bool is = (fscanf(fp, "%15s", word) == 1) &&
+            (strcasecmp(word, "session") == 0);
+  fclose(fp);
+  return is;
+}
+//
+//  A path in a session is taken from the session's own directory unless
+//  it is absolute.
+//
+std::string Session::FromDir(const std::string& dir, const char* path)
+{
+  if (('/' == path[0]) || dir.empty()) {
+    return path;
+  }
+  return dir + path;
+}
@@ -0,0 +1,122 @@
+//
+//  Session.h
+//  FieldViewer
+//
+//  A Session is what the viewer saves so that it can be put back as it
+//  was: the model and field files, the camera and every field view.
+//  Like a batch job it is plain text, one directive per line with #
+//  starting a comment, and views can optionally bring their samples
+//  with them so that they show at once without touching the field.
+//  A model or field line takes the whole of the rest of the line as
+//  its path, # and all, so it cannot carry a comment.
+//
+//    session    1 little          always first: version, order of samples
+//    model      run42.gla
+//    field      extra.fvg         once for each field file added later
+//    camera     cx cy cz  q0 q1 q2 q3  angle dist near far
+//    colours    heat | rainbow | grey
+//    map        linear | log
+//    component  Ex | Ey | Ez | Er | E    or the dialog numbers 0-4
+//    spacing    h
+//    range      auto | vmin vmax
+//    view       12 numbers, the corners TL TR BR BL  [legend]
+//    samples    nAcross nDown check
+//    end
+//
+//  component, spacing and range are sticky, as in a job file, and each
+//  view line takes them as they stand. A samples line belongs to the
+//  view before it. After the end line come the samples themselves, raw
+//  doubles in the byte order of the session line, one block for each
+//  view that has a samples line, in order. check is the adler32 of the
+//  block. Paths that are not absolute are taken from the directory the
+//  session is in.
+//
+//  Created by Brian Collett on 10/19/26.
+//  Copyright (c) 2026 Brian Collett. All rights reserved.
+//
+
+#ifndef __FieldViewer__Session__
+#define __FieldViewer__Session__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "Geometry/Geometry3d.h"
+#include "GLViewerCanvas.h"
+
+//
+//  The version we write and the only one we read.
+//
+const int kSessionVersion = 1;
+//
+//  One field view. mNAcross by mNDown samples, or none if they are 0.
+//
+struct SessionView {
+  Point3D mCorners[4];
+  bool mLegend;
+  int mComponent;
+  double mSpacing;
+  bool mFixRange;
+  double mVMin, mVMax;
+  int mNAcross, mNDown;
+  uint32_t mCheck;
+  std::vector<double> mData;
+};
+
+class Session {
+public:
+  //
+  //  Instance vars.
+  //
+  std::string mModel;
+  std::vector<std::string> mFields;
+  bool mHaveCamera;
+  GLViewState mCamera;
+  int mColours;         // SliceColours
+  bool mLinear;
+  std::vector<SessionView> mViews;
+protected:
+  //
+  //  The settings that the next view will get.
+  //
+  SessionView mCurrent;
+  int mVersion;         // 0 until the session line
+  bool mOtherOrder;     // the samples are in the other byte order
+public:
+  //
+  //  ctors
+  //
+  Session();
+  virtual ~Session() {};
+  //
+  //  Read a session, samples and all. Problems with the text are put
+  //  on the log with their line number and make Read fail. Samples
+  //  that do not check out are only dropped, with a warning, and those
+  //  views will have to be sampled again.
+  //
+  bool Read(const char* path);
+  //
+  //  Write the session. samples holds the data for each of mViews, or
+  //  nullptr for a view that is to be sampled again when it is read.
+  //
+  bool Write(const char* path, const std::vector<const double*>& samples);
+  //
+  //  Write the lines for one view, with a samples line if data is not
+  //  nullptr.
+  //
+  static void WriteView(FILE* ofp, const SessionView& v, const double* data);
+  //
+  //  True if path starts with a session line.
+  //
+  static bool IsSession(const char* path);
+protected:
+  //
+  //  Helpers.
+  //
+  bool ParseLine(char* line);
+  bool ReadSamples(FILE* ifp, const char* path);
+  static std::string FromDir(const std::string& dir, const char* path);
+};
+
+#endif /* defined(__FieldViewer__Session__) */
@@ -0,0 +1,487 @@
+//
+//  VolumeRenderer.cpp
+//  FieldViewer
+//
+//  A VolumeRenderer ray-marches one scalar quantity derived from an
+//  EField through the bounding box of that field and builds an RGBA
+//  image of the result. All the work is done on the CPU.
+//
+//  Created by Brian Collett on 10/19/26.
+//  Copyright (c) 2026 Brian Collett. All rights reserved.
+//
+#include <math.h>
+#include <float.h>
+#include <string.h>
+#include <thread>
+#include "FieldViewerApp.h"
+#include "assert.h"
+#include "VolumeRenderer.h"
+
+//
+//  ctors
+//
+VolumeRenderer::VolumeRenderer(EField* f, int type)
+{
+  mField = f;
+  mType = type;
+  mNX = mNY = mNZ = 0;
+  mBX = mBY = mBZ = 0;
+  mRawMin = DBL_MAX;
+  mRawMax = -DBL_MAX;
+  mCMap = nullptr;
+  mFMap = nullptr;
+  mStepScale = -1.0f;
+  mOpacity = 0.25f;
+  mValid = false;
+}
+VolumeRenderer::~VolumeRenderer()
+{
+  if (mCMap != nullptr) {
+    delete mCMap;
+  }
+  if (mFMap != nullptr) {
+    delete mFMap;
+  }
+}
+//
+//  Extract the quantity we display from a field vector. The type
+//  codes match FieldView::ViewType.
+//
+double VolumeRenderer::Component(const Vector3D& f, int type)
+{
+  switch (type) {
+    case 0:
+      return f.mX;
+    case 1:
+      return f.mY;
+    case 2:
+      return f.mZ;
+    case 3:     // Radial component
+      return sqrt(f.mX * f.mX + f.mY * f.mY);
+    default:    // Total field
+      return sqrt(f.mX * f.mX + f.mY * f.mY + f.mZ * f.mZ);
+  }
+}
+//
+//  Sample the field onto a grid with maxDim cells along its longest
+//  side. The z slices are shared out between threads since FieldAt
+//  is by far the most expensive part of the whole business, but only
+//  for fields that say they can take it. A CD3DField goes through the
+//  COMSOL reader, which is not known to be reentrant.
+//
+bool VolumeRenderer::Sample(int maxDim)
+{
+  assert(maxDim > 1);
+  Box3D* b = mField->GetBounds();
+  const Real* min = b->GetMin().mCoords;
+  const Real* max = b->GetMax().mCoords;
+  double longest = 0.0;
+  for (int k = 0; k < 3; k++) {
+    if (max[k] - min[k] > longest) longest = max[k] - min[k];
+  }
+  if (longest <= 0.0) {
+    return false;
+  }
+  double h = longest / maxDim;
+  int n[3];
+  for (int k = 0; k < 3; k++) {
+    double span = max[k] - min[k];
+    n[k] = (int) ceil(span / h) + 1;
+    if (n[k] < 2) n[k] = 2;
+    mDelta[k] = (span > 0.0) ? span / (n[k] - 1) : h;
+    mOrigin[k] = min[k];
+  }
+  mNX = n[0];
+  mNY = n[1];
+  mNZ = n[2];
+  mRaw.assign((size_t) mNX * mNY * mNZ, NAN);
+  //
+  //  Each thread keeps its own range so there is nothing to lock.
+  //
+  unsigned nThread = mField->IsThreadSafe() ?
+                     std::thread::hardware_concurrency() : 1;
+  if (nThread < 1) nThread = 1;
+  if (nThread > (unsigned) mNZ) nThread = mNZ;
+  std::vector<double> range(2 * nThread);
+  std::vector<std::thread> pool;
+  std::atomic<int> nextSlice(0);
+  for (unsigned t = 1; t < nThread; t++) {
+    pool.push_back(std::thread(&VolumeRenderer::SampleSlices, this,
+                               &nextSlice, &range[2 * t]));
+  }
+  SampleSlices(&nextSlice, &range[0]);
+  for (size_t t = 0; t < pool.size(); t++) {
+    pool[t].join();
+  }
+  mRawMin = DBL_MAX;
+  mRawMax = -DBL_MAX;
+  for (unsigned t = 0; t < nThread; t++) {
+    if (range[2 * t] < mRawMin) mRawMin = range[2 * t];
+    if (range[2 * t + 1] > mRawMax) mRawMax = range[2 * t + 1];
+  }
+  iprintf("Volume grid %d x %d x %d, range %g to %g\n",
+          mNX, mNY, mNZ, mRawMin, mRawMax);
+  return mRawMin <= mRawMax;
+}
+//
+//  Thread body for Sample.
+//
+void VolumeRenderer::SampleSlices(std::atomic<int>* nextSlice, double* range)
+{
+  double lo = DBL_MAX;
+  double hi = -DBL_MAX;
+  int k;
+  while ((k = nextSlice->fetch_add(1)) < mNZ) {
+    float* slice = &mRaw[(size_t) k * mNX * mNY];
+    for (int j = 0; j < mNY; j++) {
+      for (int i = 0; i < mNX; i++) {
+        Point3D p(mOrigin[0] + i * mDelta[0],
+                  mOrigin[1] + j * mDelta[1],
+                  mOrigin[2] + k * mDelta[2]);
+        double v = Component(mField->FieldAt(p), mType);
+        slice[j * mNX + i] = (float) v;
+        if (!isnan(v)) {
+          if (v < lo) lo = v;
+          if (v > hi) hi = v;
+        }
+      }
+    }
+  }
+  range[0] = lo;
+  range[1] = hi;
+}
+//
+//  Install the maps. We own them once they are installed.
+//
+void VolumeRenderer::InstallMaps(ColorMapper* cm, FieldMapper* fm)
+{
+  assert(cm != nullptr);
+  assert(fm != nullptr);
+  if (mCMap != nullptr) {
+    delete mCMap;
+  }
+  if (mFMap != nullptr) {
+    delete mFMap;
+  }
+  mCMap = cm;
+  mFMap = fm;
+  if (mRaw.empty()) {
+    return;
+  }
+  mGrid.resize(mRaw.size());
+  for (size_t i = 0; i < mRaw.size(); i++) {
+    mGrid[i] = (float) mFMap->Map(mRaw[i]);
+  }
+  BuildBricks();
+  BuildLUT();
+  mValid = true;
+}
+void VolumeRenderer::SetOpacity(float opacity)
+{
+  mOpacity = opacity;
+  if (mCMap != nullptr) {
+    BuildLUT();
+  }
+}
+//
+//  Find the range of mapped values in each brick. A brick covers
+//  kVRBrick cells and so kVRBrick+1 nodes in each direction because
+//  interpolation inside its last cell reads the next brick's first node.
+//
+void VolumeRenderer::BuildBricks(void)
+{
+  mBX = (mNX - 2) / kVRBrick + 1;
+  mBY = (mNY - 2) / kVRBrick + 1;
+  mBZ = (mNZ - 2) / kVRBrick + 1;
+  size_t nBrick = (size_t) mBX * mBY * mBZ;
+  mBrickMin.assign(nBrick, FLT_MAX);
+  mBrickMax.assign(nBrick, -FLT_MAX);
+  mBrickEmpty.assign(nBrick, 1);
+  for (int bk = 0; bk < mBZ; bk++) {
+    for (int bj = 0; bj < mBY; bj++) {
+      for (int bi = 0; bi < mBX; bi++) {
+        size_t b = ((size_t) bk * mBY + bj) * mBX + bi;
+        float lo = FLT_MAX;
+        float hi = -FLT_MAX;
+        int kEnd = (bk + 1) * kVRBrick;
+        int jEnd = (bj + 1) * kVRBrick;
+        int iEnd = (bi + 1) * kVRBrick;
+        if (kEnd > mNZ - 1) kEnd = mNZ - 1;
+        if (jEnd > mNY - 1) jEnd = mNY - 1;
+        if (iEnd > mNX - 1) iEnd = mNX - 1;
+        for (int k = bk * kVRBrick; k <= kEnd; k++) {
+          for (int j = bj * kVRBrick; j <= jEnd; j++) {
+            const float* row = &mGrid[((size_t) k * mNY + j) * mNX];
+            for (int i = bi * kVRBrick; i <= iEnd; i++) {
+              float v = row[i];
+              if (!isnan(v)) {
+                if (v < lo) lo = v;
+                if (v > hi) hi = v;
+              }
+            }
+          }
+        }
+        mBrickMin[b] = lo;
+        mBrickMax[b] = hi;
+      }
+    }
+  }
+}
+//
+//  Helper to turn a mapped value into a table index.
+//
+static inline int LUTIndex(float v)
+{
+  int idx = (int) ((v + 1.0f) * (0.5f * (kVRLUTSize - 1)) + 0.5f);
+  if (idx < 0) idx = 0;
+  if (idx >= kVRLUTSize) idx = kVRLUTSize - 1;
+  return idx;
+}
+//
+//  Build the transfer function. Colour comes straight from the
+//  ColorMapper. For signed components opacity grows with the magnitude
+//  of the mapped value; for magnitudes it grows from the bottom of the
+//  range. Anything too faint to show is made exactly transparent so
+//  that whole bricks of it can be skipped.
+//
+void VolumeRenderer::BuildLUT(void)
+{
+  bool isSigned = (mType < 3);
+  for (int n = 0; n < kVRLUTSize; n++) {
+    double v = -1.0 + 2.0 * double(n) / double(kVRLUTSize - 1);
+    RGBColour c = mCMap->Map(v);
+    mColour[n][0] = c._m._comps[0];
+    mColour[n][1] = c._m._comps[1];
+    mColour[n][2] = c._m._comps[2];
+    double ramp = isSigned ? fabs(v) : 0.5 * (v + 1.0);
+    float a = (float) (mOpacity * ramp * ramp);
+    if (a < 1.0f / 255.0f) a = 0.0f;
+    mBaseAlpha[n] = a;
+  }
+  //
+  //  Mark the bricks that are transparent everywhere.
+  //
+  for (size_t b = 0; b < mBrickEmpty.size(); b++) {
+    unsigned char empty = 1;
+    if (mBrickMin[b] <= mBrickMax[b]) {
+      int hi = LUTIndex(mBrickMax[b]);
+      for (int n = LUTIndex(mBrickMin[b]); n <= hi; n++) {
+        if (mBaseAlpha[n] > 0.0f) {
+          empty = 0;
+          break;
+        }
+      }
+    }
+    mBrickEmpty[b] = empty;
+  }
+  mStepScale = -1.0f;
+  SetStepScale(1.0f);
+}
+//
+//  The table alpha is for a step of one grid cell. Longer steps must
+//  see more opacity per step or the image would fade as the step grows.
+//
+void VolumeRenderer::SetStepScale(float stepScale)
+{
+  if (stepScale == mStepScale) {
+    return;
+  }
+  mStepScale = stepScale;
+  for (int n = 0; n < kVRLUTSize; n++) {
+    float a = mBaseAlpha[n];
+    if (a > 0.0f) {
+      a = 1.0f - powf(1.0f - a, stepScale);
+    }
+    mLUT[n][0] = mColour[n][0] * a;
+    mLUT[n][1] = mColour[n][1] * a;
+    mLUT[n][2] = mColour[n][2] * a;
+    mLUT[n][3] = a;
+  }
+}
+//
+//  Render an image of width x height RGBA bytes. Tiles are handed out
+//  through an atomic counter so that threads that draw cheap (empty)
+//  tiles simply pick up more of them.
+//
+void VolumeRenderer::Render(const VRCamera& cam, int width, int height,
+                            unsigned char* rgba, float stepScale)
+{
+  assert(rgba != nullptr);
+  if (!mValid) {
+    memset(rgba, 0, (size_t) width * height * 4);
+    return;
+  }
+  SetStepScale(stepScale);
+  int nAcross = (width + kVRTile - 1) / kVRTile;
+  int nTile = nAcross * ((height + kVRTile - 1) / kVRTile);
+  unsigned nThread = std::thread::hardware_concurrency();
+  if (nThread < 1) nThread = 1;
+  if (nThread > (unsigned) nTile) nThread = nTile;
+  std::atomic<int> nextTile(0);
+  std::vector<std::thread> pool;
+  for (unsigned t = 1; t < nThread; t++) {
+    pool.push_back(std::thread(&VolumeRenderer::RenderTiles, this,
+                               std::cref(cam), width, height, rgba,
+                               nTile, nAcross, &nextTile));
+  }
+  RenderTiles(cam, width, height, rgba, nTile, nAcross, &nextTile);
+  for (size_t t = 0; t < pool.size(); t++) {
+    pool[t].join();
+  }
+}
+//
+//  Thread body for Render.
+//
+void VolumeRenderer::RenderTiles(const VRCamera& cam, int width, int height,
+                                 unsigned char* rgba, int nTile, int nAcross,
+                                 std::atomic<int>* nextTile)
+{
+  int tile;
+  double start[3], end[3];
+  while ((tile = nextTile->fetch_add(1)) < nTile) {
+    int i0 = (tile % nAcross) * kVRTile;
+    int j0 = (tile / nAcross) * kVRTile;
+    int i1 = (i0 + kVRTile < width) ? i0 + kVRTile : width;
+    int j1 = (j0 + kVRTile < height) ? j0 + kVRTile : height;
+    for (int j = j0; j < j1; j++) {
+      double y = j + 0.5;
+      for (int i = i0; i < i1; i++) {
+        double x = i + 0.5;
+        for (int k = 0; k < 3; k++) {
+          start[k] = cam.mNear.mCoords[k] + x * cam.mNearDX.mCoords[k] +
+                     y * cam.mNearDY.mCoords[k];
+          end[k] = cam.mFar.mCoords[k] + x * cam.mFarDX.mCoords[k] +
+                   y * cam.mFarDY.mCoords[k];
+        }
+        RenderRay(start, end, &rgba[((size_t) j * width + i) * 4]);
+      }
+    }
+  }
+}
+//
+//  March a single ray front to back. Everything is done in grid
+//  coordinates, where node (i,j,k) sits at (i,j,k).
+//
+void VolumeRenderer::RenderRay(const double* start, const double* end,
+                               unsigned char* pixel) const
+{
+  double g0[3], gd[3];
+  double len2 = 0.0;
+  double t0 = 0.0;
+  double t1 = 1.0;
+  pixel[0] = pixel[1] = pixel[2] = pixel[3] = 0;
+  int nNode[3] = { mNX, mNY, mNZ };
+  for (int k = 0; k < 3; k++) {
+    double d = end[k] - start[k];
+    len2 += d * d;
+    g0[k] = (start[k] - mOrigin[k]) / mDelta[k];
+    gd[k] = d / mDelta[k];
+    //
+    //  Clip to the grid, slab by slab.
+    //
+    double hi = nNode[k] - 1;
+    if (gd[k] == 0.0) {
+      if ((g0[k] < 0.0) || (g0[k] > hi)) return;
+    } else {
+      double ta = -g0[k] / gd[k];
+      double tb = (hi - g0[k]) / gd[k];
+      if (ta > tb) {
+        double tmp = ta;
+        ta = tb;
+        tb = tmp;
+      }
+      if (ta > t0) t0 = ta;
+      if (tb < t1) t1 = tb;
+    }
+  }
+  if (t0 >= t1) {
+    return;
+  }
+  double cell = mDelta[0];
+  if (mDelta[1] < cell) cell = mDelta[1];
+  if (mDelta[2] < cell) cell = mDelta[2];
+  double dt = mStepScale * cell / sqrt(len2);
+  float r = 0.0f, g = 0.0f, b = 0.0f, a = 0.0f;
+  for (double t = t0 + 0.5 * dt; t < t1; t += dt) {
+    double gx = g0[0] + t * gd[0];
+    double gy = g0[1] + t * gd[1];
+    double gz = g0[2] + t * gd[2];
+    int bi = (int) (gx / kVRBrick);
+    int bj = (int) (gy / kVRBrick);
+    int bk = (int) (gz / kVRBrick);
+    if (bi >= mBX) bi = mBX - 1;
+    if (bj >= mBY) bj = mBY - 1;
+    if (bk >= mBZ) bk = mBZ - 1;
+    if (mBrickEmpty[((size_t) bk * mBY + bj) * mBX + bi]) {
+      //
+      //  Empty space. Jump to the last sample before we leave the
+      //  brick; the loop increment then takes us out of it. Staying
+      //  on the same lattice of samples keeps the image stable.
+      //
+      int bc[3] = { bi, bj, bk };
+      double tExit = t1;
+      for (int k = 0; k < 3; k++) {
+        if (gd[k] > 0.0) {
+          double te = ((bc[k] + 1) * kVRBrick - g0[k]) / gd[k];
+          if (te < tExit) tExit = te;
+        } else if (gd[k] < 0.0) {
+          double te = (bc[k] * kVRBrick - g0[k]) / gd[k];
+          if (te < tExit) tExit = te;
+        }
+      }
+      if (tExit > t) {
+        t += floor((tExit - t) / dt) * dt;
+      }
+      continue;
+    }
+    float v = SampleAt(gx, gy, gz);
+    if (isnan(v)) {
+      continue;
+    }
+    const float* e = mLUT[LUTIndex(v)];
+    if (e[3] <= 0.0f) {
+      continue;
+    }
+    float w = 1.0f - a;
+    r += w * e[0];
+    g += w * e[1];
+    b += w * e[2];
+    a += w * e[3];
+    if (a >= kVROpaque) {
+      break;      // Nothing behind here can show.
+    }
+  }
+  pixel[0] = (unsigned char) (255.0f * (r > 1.0f ? 1.0f : r) + 0.5f);
+  pixel[1] = (unsigned char) (255.0f * (g > 1.0f ? 1.0f : g) + 0.5f);
+  pixel[2] = (unsigned char) (255.0f * (b > 1.0f ? 1.0f : b) + 0.5f);
+  pixel[3] = (unsigned char) (255.0f * (a > 1.0f ? 1.0f : a) + 0.5f);
+}
+//
+//  Trilinear interpolation in the mapped grid. Any NaN corner makes
+//  the sample NaN, which is treated as empty.
+//
+float VolumeRenderer::SampleAt(double gx, double gy, double gz) const
+{
+  int i = (int) gx;
+  int j = (int) gy;
+  int k = (int) gz;
+  if (i > mNX - 2) i = mNX - 2;
+  if (j > mNY - 2) j = mNY - 2;
+  if (k > mNZ - 2) k = mNZ - 2;
+  if (i < 0) i = 0;
+  if (j < 0) j = 0;
+  if (k < 0) k = 0;
+  float fx = (float) (gx - i);
+  float fy = (float) (gy - j);
+  float fz = (float) (gz - k);
+  const float* p = &mGrid[((size_t) k * mNY + j) * mNX + i];
+  size_t sy = mNX;
+  size_t sz = (size_t) mNX * mNY;
+  float c00 = p[0] + fx * (p[1] - p[0]);
+  float c10 = p[sy] + fx * (p[sy + 1] - p[sy]);
+  float c01 = p[sz] + fx * (p[sz + 1] - p[sz]);
+  float c11 = p[sz + sy] + fx * (p[sz + sy + 1] - p[sz + sy]);
+  float c0 = c00 + fy * (c10 - c00);
+  float c1 = c01 + fy * (c11 - c01);
+  return c0 + fz * (c1 - c0);
+}
@@ -0,0 +1,155 @@
+//
+//  VolumeRenderer.h
+//  FieldViewer
+//
+//  A VolumeRenderer ray-marches one scalar quantity derived from an
+//  EField through the bounding box of that field and builds an RGBA
+//  image of the result. All the work is done on the CPU. Our machines
+//  render OpenGL through Mesa so there is nothing to be gained by
+//  trying to push this onto the graphics card.
+//
+//  The field is sampled once onto a regular grid (FieldAt is far too
+//  slow to call at every step of every ray) and the grid is then broken
+//  into bricks of kVRBrick cells. Each brick remembers the range of
+//  values that it holds so that bricks that the transfer function makes
+//  completely transparent can be skipped in a single step.
+//  Colour comes from the same ColorMapper/FieldMapper pair as a FieldView
+//  and opacity from a ramp on the mapped value. Rays stop as soon as
+//  they become (nearly) opaque.
+//
+//  Rendering is split into square tiles that are handed out to a pool
+//  of threads, one per core.
+//
+//  Created by Brian Collett on 10/19/26.
+//  Copyright (c) 2026 Brian Collett. All rights reserved.
+//
+
+#ifndef __FieldViewer__VolumeRenderer__
+#define __FieldViewer__VolumeRenderer__
+
+#include <vector>
+#include <atomic>
+#include "Geometry/GeometricObjects.h"
+#include "EField.h"
+#include "ColorMapper.h"
+#include "FieldMapper.h"
+
+//
+//  Tuning constants.
+//  kVRGridDim is the number of grid cells along the longest side of the
+//  field bounds, kVRBrick the number of cells along the side of a brick,
+//  kVRTile the side of a render tile in pixels and kVRLUTSize the number
+//  of entries in the transfer function table.
+//
+const int kVRGridDim = 128;
+const int kVRBrick = 8;
+const int kVRTile = 32;
+const int kVRLUTSize = 256;
+const float kVROpaque = 0.98f;
+
+//
+//  A VRCamera describes the rays through an image of a given size.
+//  The ray for pixel (i, j) runs from mNear + mNearDX * (i + 0.5) +
+//  mNearDY * (j + 0.5) to the corresponding point on the far plane.
+//  Row 0 is the bottom of the image, as OpenGL likes it.
+//
+struct VRCamera {
+  Point3D mNear;
+  Vector3D mNearDX;
+  Vector3D mNearDY;
+  Point3D mFar;
+  Vector3D mFarDX;
+  Vector3D mFarDY;
+};
+
+class VolumeRenderer {
+protected:
+  //
+  //  Instance vars.
+  //  We do NOT own the field.
+  //
+  EField* mField;
+  int mType;
+  //
+  //  Grid description and mapped samples. Values are already run through
+  //  the FieldMapper so they lie on -1->1, or are NaN outside the field.
+  //
+  int mNX, mNY, mNZ;
+  double mOrigin[3];
+  double mDelta[3];
+  double mRawMin, mRawMax;
+  std::vector<float> mRaw;
+  std::vector<float> mGrid;
+  //
+  //  Brick occupancy. A brick is empty if every value in it maps to a
+  //  transparent entry in the transfer function.
+  //
+  int mBX, mBY, mBZ;
+  std::vector<float> mBrickMin;
+  std::vector<float> mBrickMax;
+  std::vector<unsigned char> mBrickEmpty;
+  //
+  //  Transfer function. Colour is premultiplied by alpha and alpha is
+  //  corrected for the current step length.
+  //
+  ColorMapper* mCMap;
+  FieldMapper* mFMap;
+  float mColour[kVRLUTSize][3];
+  float mLUT[kVRLUTSize][4];
+  float mBaseAlpha[kVRLUTSize];
+  float mStepScale;
+  float mOpacity;
+  bool mValid;
+public:
+  //
+  //  ctors
+  //
+  VolumeRenderer(EField* f, int type);
+  virtual ~VolumeRenderer();
+  //
+  //  Sample the field onto a grid with maxDim cells along its longest
+  //  side. This is slow so it is done once when the view is created.
+  //  Returns false if the field has no usable values.
+  //
+  bool Sample(int maxDim = kVRGridDim);
+  //
+  //  Range of the raw samples, used to build the FieldMapper.
+  //
+  double GetMin(void) const { return mRawMin; };
+  double GetMax(void) const { return mRawMax; };
+  //
+  //  Install the maps. We own them once they are installed. Installing
+  //  a FieldMapper re-maps the grid.
+  //
+  void InstallMaps(ColorMapper* cm, FieldMapper* fm);
+  void SetOpacity(float opacity);
+  bool IsValid(void) const { return mValid; };
+  //
+  //  Render an image of width x height RGBA bytes. stepScale multiplies
+  //  the basic step of one grid cell; the low resolution pass uses a
+  //  coarser step as well as fewer pixels.
+  //
+  void Render(const VRCamera& cam, int width, int height,
+              unsigned char* rgba, float stepScale = 1.0f);
+  //
+  //  Extract the quantity we display from a field vector. The type
+  //  codes match FieldView::ViewType.
+  //
+  static double Component(const Vector3D& f, int type);
+protected:
+  //
+  //  Helpers.
+  //
+  void SampleSlices(std::atomic<int>* nextSlice, double* range);
+  void BuildBricks(void);
+  void BuildLUT(void);
+  void SetStepScale(float stepScale);
+  void RenderTiles(const VRCamera& cam, int width, int height,
+                   unsigned char* rgba, int nTile, int nAcross,
+                   std::atomic<int>* nextTile);
+  void RenderRay(const double* start, const double* end,
+                 unsigned char* pixel) const;
+  float SampleAt(double gx, double gy, double gz) const;
+};
+
+#endif /* defined(__FieldViewer__VolumeRenderer__) */
@@ -0,0 +1,218 @@
+//
+//  VolumeView.cpp
+//  FieldViewer
+//
+//  A VolumeView shows a whole field as a translucent cloud. It uses a
+//  VolumeRenderer to ray-march the field for the current camera of the
+//  GLViewerCanvas and then pastes the result over the scene as a single
+//  screen-sized FieldTexture.
+//
+//  Created by Brian Collett on 10/19/26.
+//  Copyright (c) 2026 Brian Collett. All rights reserved.
+//
+#include "wx/wxprec.h"
+
+#ifndef WX_PRECOMP
+#include "wx/wx.h"
+#endif
+
+#include <math.h>
+#include <string.h>
+
+#include "FieldViewerDoc.h"
+#include "VolumeView.h"
+#include "RainbowMapper.h"
+#include "CoolWarmMapper.h"
+#include "LinFieldMapper.h"
+#include "LogFieldMapper.h"
+//
+//  ctors
+//
+VolumeView::VolumeView(GLViewerCanvas* theCanvas, EField* f, FieldViewerDoc* d)
+{
+  mCanvas = theCanvas;
+  mField = f;
+  mDoc = d;
+  mType = 4;
+  mRenderer = nullptr;
+  mTex = nullptr;
+  mImage = nullptr;
+  mImageSize = 0;
+  mWidth = mHeight = 0;
+  mLowRes = false;
+  mValid = false;
+}
+VolumeView::~VolumeView()
+{
+  if (nullptr != mRenderer) {
+    delete mRenderer;
+  }
+  if (nullptr != mTex) {
+    delete mTex;
+  }
+  if (nullptr != mImage) {
+    delete [] mImage;
+  }
+}
+//
+//  Sample the field and build the transfer function. We pick the maps
+//  the same way as a FieldView but signed components get a range that
+//  is symmetric about zero so that zero field is always transparent.
+//
+bool VolumeView::ViewType(int type)
+{
+  mType = type;
+  mRenderer = new VolumeRenderer(mField, type);
+  if (!mRenderer->Sample()) {
+    return false;
+  }
+  double fMin = mRenderer->GetMin();
+  double fMax = mRenderer->GetMax();
+  if (type < 3) {
+    double max = (fabs(fMax) > fabs(fMin)) ? fabs(fMax) : fabs(fMin);
+    fMin = -max;
+    fMax = max;
+  }
+  FieldMapper* fm;
+  if (mDoc->IsLinear()) {
+    fm = new LinFieldMapper(fMin, fMax);
+  } else {
+    fm = new LogFieldMapper(fMin, fMax);
+  }
+  ColorMapper* cm;
+  if (mDoc->GetNColorCycle() == 1) {
+    cm = new CoolWarmMapper(1);
+  } else if (mDoc->GetNColorCycle() == 2) {
+    cm = new RainbowMapper(1);
+  } else {
+    cm = new ColorMapper();
+  }
+  mRenderer->InstallMaps(cm, fm);
+  mTex = new FieldTexture();
+  mValid = mRenderer->IsValid();
+  return mValid;
+}
+//
+//  Draw marches a new image only when the camera has moved since the
+//  last one or when the last one was a low resolution stand-in and
+//  the user has let go of the mouse. Otherwise it just re-pastes the
+//  texture that we already have.
+//
+void VolumeView::Draw()
+{
+  if (!mValid) {
+    return;
+  }
+  GLdouble mv[16], proj[16];
+  GLint vp[4];
+  if (!mCanvas->GetCamera(mv, proj, vp)) {
+    return;
+  }
+  bool lowRes = mCanvas->IsInteracting();
+  int scale = lowRes ? kVVLowResScale : 1;
+  int width = (vp[2] + scale - 1) / scale;
+  int height = (vp[3] + scale - 1) / scale;
+  if ((width < 1) || (height < 1)) {
+    return;
+  }
+  if (CameraChanged(mv, proj, vp) || (mLowRes && !lowRes) ||
+      (width != mWidth) || (height != mHeight)) {
+    size_t size = (size_t) width * height * 4;
+    if (size > mImageSize) {
+      if (nullptr != mImage) {
+        delete [] mImage;
+      }
+      mImage = new unsigned char[size];
+      mImageSize = size;
+    }
+    memcpy(mMVMatrix, mv, sizeof(mMVMatrix));
+    memcpy(mProjMatrix, proj, sizeof(mProjMatrix));
+    memcpy(mViewport, vp, sizeof(mViewport));
+    VRCamera cam;
+    if (!BuildCamera(cam, width, height)) {
+      return;
+    }
+    mRenderer->Render(cam, width, height, mImage,
+                      lowRes ? kVVLowResStep : 1.0f);
+    mTex->InstallImage(width, height, mImage);
+    mLowRes = lowRes;
+    mWidth = width;
+    mHeight = height;
+  }
+  //
+  //  Paste the image over the whole viewport. The colours are already
+  //  multiplied by alpha so the blend is ONE, ONE_MINUS_SRC_ALPHA.
+  //
+  Call(glMatrixMode(GL_PROJECTION));
+  Call(glPushMatrix());
+  Call(glLoadIdentity());
+  Call(gluOrtho2D(0.0, 1.0, 0.0, 1.0));
+  Call(glMatrixMode(GL_MODELVIEW));
+  Call(glPushMatrix());
+  Call(glLoadIdentity());
+  Call(glPushAttrib(GL_ENABLE_BIT | GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT));
+  Call(glDisable(GL_DEPTH_TEST));
+  Call(glDepthMask(GL_FALSE));
+  Call(glEnable(GL_BLEND));
+  Call(glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
+  Call(glEnable(GL_TEXTURE_2D));
+  Call(glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE));
+  Call(glBindTexture(GL_TEXTURE_2D, mTex->Name()));
+  glBegin(GL_QUADS);
+  glTexCoord2f(0.0f, 0.0f); glVertex2f(0.0f, 0.0f);
+  glTexCoord2f(1.0f, 0.0f); glVertex2f(1.0f, 0.0f);
+  glTexCoord2f(1.0f, 1.0f); glVertex2f(1.0f, 1.0f);
+  glTexCoord2f(0.0f, 1.0f); glVertex2f(0.0f, 1.0f);
+  Call(glEnd());
+  Call(glPopAttrib());
+  Call(glPopMatrix());
+  Call(glMatrixMode(GL_PROJECTION));
+  Call(glPopMatrix());
+  Call(glMatrixMode(GL_MODELVIEW));
+}
+//
+//  Helper to see if the camera has moved since the last image.
+//
+bool VolumeView::CameraChanged(const GLdouble* mv, const GLdouble* proj,
+                               const GLint* vp) const
+{
+  return (memcmp(mv, mMVMatrix, sizeof(mMVMatrix)) != 0) ||
+         (memcmp(proj, mProjMatrix, sizeof(mProjMatrix)) != 0) ||
+         (memcmp(vp, mViewport, sizeof(mViewport)) != 0);
+}
+//
+//  Points on the near (or far) plane are an affine function of window
+//  position so three corners of each plane are enough to describe all
+//  the rays through the image.
+//
+bool VolumeView::BuildCamera(VRCamera& cam, int width, int height)
+{
+  GLdouble x0 = mViewport[0];
+  GLdouble y0 = mViewport[1];
+  GLdouble x1 = x0 + mViewport[2];
+  GLdouble y1 = y0 + mViewport[3];
+  Point3D p00, p10, p01;
+  for (int plane = 0; plane < 2; plane++) {
+    GLdouble z = plane;
+    if ((gluUnProject(x0, y0, z, mMVMatrix, mProjMatrix, mViewport,
+                      &p00.mX, &p00.mY, &p00.mZ) == GL_FALSE) ||
+        (gluUnProject(x1, y0, z, mMVMatrix, mProjMatrix, mViewport,
+                      &p10.mX, &p10.mY, &p10.mZ) == GL_FALSE) ||
+        (gluUnProject(x0, y1, z, mMVMatrix, mProjMatrix, mViewport,
+                      &p01.mX, &p01.mY, &p01.mZ) == GL_FALSE)) {
+      return false;
+    }
+    Vector3D dx = (p10 - p00) / double(width);
+    Vector3D dy = (p01 - p00) / double(height);
+    if (plane == 0) {
+      cam.mNear = p00;
+      cam.mNearDX = dx;
+      cam.mNearDY = dy;
+    } else {
+      cam.mFar = p00;
+      cam.mFarDX = dx;
+      cam.mFarDY = dy;
+    }
+  }
+  return true;
+}
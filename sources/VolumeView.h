@@ -0,0 +1,86 @@
+//
+//  VolumeView.h
+//  FieldViewer
+//
+//  A VolumeView shows a whole field as a translucent cloud. It uses a
+//  VolumeRenderer to ray-march the field for the current camera of the
+//  GLViewerCanvas and then pastes the result over the scene as a single
+//  screen-sized FieldTexture.
+//  While the user is dragging the view around we render a quarter size
+//  image with a coarser step so that the display keeps up; the full
+//  image is made once the mouse is released.
+//
+//  Created by Brian Collett on 10/19/26.
+//  Copyright (c) 2026 Brian Collett. All rights reserved.
+//
+
+#ifndef __FieldViewer__VolumeView__
+#define __FieldViewer__VolumeView__
+
+#include "Geometry/GeometricObjects.h"
+#include "GLViewerCanvas.h"
+#include "EField.h"
+#include "FieldTexture.h"
+#include "VolumeRenderer.h"
+
+class FieldViewerDoc;
+
+//
+//  Divisor for the image size and multiplier for the step during
+//  the low resolution pass.
+//
+const int kVVLowResScale = 4;
+const float kVVLowResStep = 2.0f;
+
+class VolumeView {
+public:
+  //
+  //  Instance vars.
+  //  As for a FieldView we keep refs (which we do NOT own) to the field,
+  //  the canvas and the document.
+  //
+  EField* mField;
+  GLViewerCanvas* mCanvas;
+  FieldViewerDoc* mDoc;
+  int mType;
+protected:
+  VolumeRenderer* mRenderer;
+  FieldTexture* mTex;
+  //
+  //  The image and the camera it was made for. We only march again when
+  //  the camera moves or when we owe the user a full resolution image.
+  //
+  unsigned char* mImage;
+  size_t mImageSize;
+  int mWidth, mHeight;
+  GLdouble mMVMatrix[16];
+  GLdouble mProjMatrix[16];
+  GLint mViewport[4];
+  bool mLowRes;
+  bool mValid;
+public:
+  //
+  //  ctors
+  //
+  VolumeView(GLViewerCanvas* theCanvas, EField* f, FieldViewerDoc* d);
+  virtual ~VolumeView();
+  //
+  //  Sample the field and build the transfer function. The type codes
+  //  match FieldView::ViewType. Returns false if the field is empty.
+  //
+  bool ViewType(int type);
+  //
+  //  Draw must be called with the canvas's context current and its
+  //  camera in place, which is the case inside Model3D::Render.
+  //
+  void Draw();
+protected:
+  //
+  //  Helpers.
+  //
+  bool CameraChanged(const GLdouble* mv, const GLdouble* proj,
+                     const GLint* vp) const;
+  bool BuildCamera(VRCamera& cam, int width, int height);
+};
+
+#endif /* defined(__FieldViewer__VolumeView__) */